@@ -50,7 +50,7 @@ module.exports.handler = async (event, context) => {
       limit: parseInt(limit),
       columns_to_get: [
         'device_id', 'has_motion', 'oss_path_original',
-        'oss_path_thumbnail', 'created_at', 'image_size'
+        'oss_path_thumbnail', 'oss_path_clip', 'clip_duration_ms', 'created_at', 'image_size'
       ]
     };
 
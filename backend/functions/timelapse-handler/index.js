@@ -0,0 +1,150 @@
+// backend/functions/timelapse-handler/index.js
+
+const TableStore = require('tablestore');
+const OSS = require('ali-oss');
+const { AppError, ErrorHandler } = require('../../shared/error-handler');
+const Logger = require('../../shared/logger');
+const { parseMultipart, jsonField } = require('../../shared/multipart');
+
+// 从环境变量获取配置
+const OTS_INSTANCE = process.env.OTS_INSTANCE;
+const OTS_ENDPOINT = process.env.OTS_ENDPOINT || `https://${OTS_INSTANCE}.${process.env.OTS_REGION || 'cn-hangzhou'}.ots.aliyuncs.com`;
+const OTS_ACCESS_KEY = process.env.OTS_ACCESS_KEY_ID;
+const OTS_SECRET_KEY = process.env.OTS_SECRET_ACCESS_KEY;
+const OSS_BUCKET = process.env.OSS_BUCKET;
+const OSS_REGION = process.env.OSS_REGION || 'oss-cn-hangzhou';
+
+// Tablestore BatchWriteRow 单次最多 200 行
+const MAX_FRAMES = 200;
+
+// 初始化 TableStore 客户端
+const otsClient = new TableStore.Client({
+  accessKeyId: OTS_ACCESS_KEY,
+  secretAccessKey: OTS_SECRET_KEY,
+  endpoint: OTS_ENDPOINT,
+  instancename: OTS_INSTANCE,
+});
+
+/**
+ * 解析 multipart 请求体：一个 metadata 字段 + 按顺序排列的 frame 文件
+ */
+function parseBatch(event) {
+  const parts = parseMultipart(event);
+  const frames = parts.filter(p => p.name === 'frame' && p.filename).map(p => p.data);
+  if (frames.length > MAX_FRAMES) {
+    throw new AppError(`Too many frames (max ${MAX_FRAMES})`, 400);
+  }
+  return { metadata: jsonField(parts, 'metadata'), frames };
+}
+
+/**
+ * 批量写入图片元数据（一次 BatchWriteRow）
+ */
+function batchWriteImages(rows) {
+  const params = {
+    tables: [{
+      tableName: 'images',
+      rows: rows.map(row => ({
+        type: 'PUT',
+        condition: new TableStore.Condition(TableStore.RowExistenceExpectation.IGNORE, null),
+        primaryKey: [
+          { partition_key: row.device_id },
+          { row_key: row.row_key }
+        ],
+        attributeColumns: [
+          { device_id: row.device_id },
+          { has_motion: false },
+          { source: 'timelapse' },
+          { oss_path_original: row.oss_path_original },
+          { oss_path_thumbnail: '' },
+          { created_at: row.created_at },
+          { image_size: row.image_size }
+        ],
+        returnContent: { returnType: TableStore.ReturnType.Primarykey }
+      }))
+    }]
+  };
+
+  return new Promise((resolve, reject) => {
+    otsClient.batchWriteRow(params, (err, data) => {
+      if (err) return reject(err);
+
+      // BatchWriteRow 按行返回结果，需要逐行检查
+      const failed = (data.tables || []).filter(row => !row.isOk);
+      if (failed.length > 0) {
+        return reject(new AppError(`Failed to write ${failed.length} rows`, 500));
+      }
+      resolve(data);
+    });
+  });
+}
+
+/**
+ * 处理延时摄影批量上传：帧写入 OSS，元数据一次写入 Tablestore
+ */
+module.exports.handler = async (event, context) => {
+  try {
+    const { metadata, frames } = parseBatch(event);
+
+    if (!metadata || !metadata.device_id) {
+      throw new AppError('Missing required field: metadata.device_id', 400);
+    }
+    const frameInfo = Array.isArray(metadata.frames) ? metadata.frames : [];
+    if (frames.length === 0 || frames.length !== frameInfo.length) {
+      throw new AppError('Frame count does not match metadata', 400);
+    }
+
+    const deviceId = metadata.device_id;
+    Logger.info('Time-lapse batch received', { device_id: deviceId, frames: frames.length });
+
+    // 使用函数角色的临时凭证写 OSS
+    const credentials = context.credentials || {};
+    const ossClient = new OSS({
+      region: OSS_REGION,
+      bucket: OSS_BUCKET,
+      accessKeyId: credentials.accessKeyId,
+      accessKeySecret: credentials.accessKeySecret,
+      stsToken: credentials.securityToken
+    });
+
+    // 设备未对时的帧（timestamp 为 0）按接收时间倒推
+    const receivedAt = Date.now();
+    const interval = (metadata.interval || 0) * 1000;
+
+    const rows = frameInfo.map((info, i) => {
+      const createdAt = info.timestamp
+        ? info.timestamp * 1000
+        : receivedAt - (frames.length - 1 - i) * interval;
+      const rowKey = `${createdAt}-${i}-${Math.random().toString(36).substr(2, 6)}`;
+      return {
+        device_id: deviceId,
+        row_key: rowKey,
+        oss_path_original: `devices/${deviceId}/timelapse/${rowKey}.jpg`,
+        created_at: createdAt,
+        image_size: frames[i].length
+      };
+    });
+
+    await Promise.all(rows.map((row, i) =>
+      ossClient.put(row.oss_path_original, frames[i], { mime: 'image/jpeg' })
+    ));
+
+    await batchWriteImages(rows);
+
+    Logger.info('Time-lapse batch saved', { device_id: deviceId, frames: rows.length });
+
+    return {
+      statusCode: 200,
+      body: JSON.stringify({
+        message: 'success',
+        frames: rows.length,
+        row_keys: rows.map(row => row.row_key)
+      }),
+      headers: { 'Content-Type': 'application/json' }
+    };
+
+  } catch (error) {
+    await ErrorHandler.handleError(error, { function: 'timelapse-handler' });
+    return ErrorHandler.response(error);
+  }
+};
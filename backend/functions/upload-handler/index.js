@@ -2,14 +2,18 @@
 
 const TableStore = require('tablestore');
 const axios = require('axios');
+const OSS = require('ali-oss');
 const { AppError, ErrorHandler } = require('../../shared/error-handler');
 const Logger = require('../../shared/logger');
+const { parseMultipart, jsonField } = require('../../shared/multipart');
 
 // 从环境变量获取配置
 const OTS_INSTANCE = process.env.OTS_INSTANCE;
 const OTS_ENDPOINT = process.env.OTS_ENDPOINT || `https://${OTS_INSTANCE}.${process.env.OTS_REGION || 'cn-hangzhou'}.ots.aliyuncs.com`;
 const OTS_ACCESS_KEY = process.env.OTS_ACCESS_KEY_ID;
 const OTS_SECRET_KEY = process.env.OTS_SECRET_ACCESS_KEY;
+const OSS_BUCKET = process.env.OSS_BUCKET;
+const OSS_REGION = process.env.OSS_REGION || 'oss-cn-hangzhou';
 
 // 初始化 TableStore 客户端
 const otsClient = new TableStore.Client({
@@ -50,6 +54,57 @@ async function triggerNotification(imageData) {
   }
 }
 
+/**
+ * 设备直传：metadata 字段 + original（运动区域裁剪图）+ 可选 thumbnail（低分辨率全景图）
+ * + 可选 clip（事件短片，MJPEG AVI）
+ * 文件写入 OSS 后返回与 JSON 上传相同的字段，裁剪信息附加在 crop/frame 中
+ */
+async function storeMultipartUpload(event, context) {
+  const parts = parseMultipart(event);
+  const metadata = jsonField(parts, 'metadata');
+  const original = parts.find(p => p.name === 'original' && p.filename);
+  const thumbnail = parts.find(p => p.name === 'thumbnail' && p.filename);
+  const clip = parts.find(p => p.name === 'clip' && p.filename);
+
+  if (!metadata || !metadata.device_id || !original) {
+    throw new AppError('Missing required fields: metadata.device_id or original', 400);
+  }
+
+  const deviceId = metadata.device_id;
+  const key = `${metadata.timestamp ? metadata.timestamp * 1000 : Date.now()}-${Math.random().toString(36).substr(2, 6)}`;
+  const oss_path_original = `devices/${deviceId}/motion/${key}.jpg`;
+  const oss_path_thumbnail = thumbnail ? `devices/${deviceId}/motion/${key}_ctx.jpg` : '';
+  const oss_path_clip = clip ? `devices/${deviceId}/motion/${key}.avi` : '';
+
+  // 使用函数角色的临时凭证写 OSS
+  const credentials = context.credentials || {};
+  const ossClient = new OSS({
+    region: OSS_REGION,
+    bucket: OSS_BUCKET,
+    accessKeyId: credentials.accessKeyId,
+    accessKeySecret: credentials.accessKeySecret,
+    stsToken: credentials.securityToken
+  });
+
+  await Promise.all([
+    ossClient.put(oss_path_original, original.data, { mime: 'image/jpeg' }),
+    thumbnail && ossClient.put(oss_path_thumbnail, thumbnail.data, { mime: 'image/jpeg' }),
+    clip && ossClient.put(oss_path_clip, clip.data, { mime: 'video/x-msvideo' })
+  ]);
+
+  return {
+    device_id: deviceId,
+    oss_path_original,
+    oss_path_thumbnail,
+    oss_path_clip,
+    has_motion: metadata.has_motion,
+    image_size: original.data.length,
+    crop: metadata.crop,
+    clip: clip ? { ...metadata.clip, size: clip.data.length } : null,
+    frame: metadata.frame_width ? { width: metadata.frame_width, height: metadata.frame_height } : null
+  };
+}
+
 /**
  * 处理图片上传元数据
  */
@@ -57,11 +112,15 @@ module.exports.handler = async (event, context) => {
   try {
     Logger.info('Upload handler invoked', { event });
 
-    // 解析请求体
-    const body = JSON.parse(event.body || '{}');
+    // 解析请求体：设备直传为 multipart，其余为 JSON 元数据
+    const headers = event.headers || {};
+    const contentType = headers['content-type'] || headers['Content-Type'] || '';
+    const body = contentType.startsWith('multipart/form-data')
+      ? await storeMultipartUpload(event, context)
+      : JSON.parse(event.body || '{}');
 
     // 验证必需字段
-    const { device_id, oss_path_original, oss_path_thumbnail, has_motion, image_size } = body;
+    const { device_id, oss_path_original, oss_path_thumbnail, oss_path_clip, has_motion, image_size, crop, frame, clip } = body;
 
     if (!device_id || !oss_path_original) {
       throw new AppError('Missing required fields: device_id or oss_path_original', 400);
@@ -89,6 +148,27 @@ module.exports.handler = async (event, context) => {
       ]
     };
 
+    // 裁剪上传记录裁剪框在原始帧中的位置，便于前端叠加到全景图上
+    if (crop && frame) {
+      params.attributeColumns.push(
+        { name: 'crop_x', value: crop.x },
+        { name: 'crop_y', value: crop.y },
+        { name: 'crop_w', value: crop.width },
+        { name: 'crop_h', value: crop.height },
+        { name: 'frame_w', value: frame.width },
+        { name: 'frame_h', value: frame.height }
+      );
+    }
+
+    // 事件短片
+    if (oss_path_clip) {
+      params.attributeColumns.push(
+        { name: 'oss_path_clip', value: oss_path_clip },
+        { name: 'clip_frames', value: (clip && clip.frames) || 0 },
+        { name: 'clip_duration_ms', value: (clip && clip.duration_ms) || 0 }
+      );
+    }
+
     await new Promise((resolve, reject) => {
       otsClient.putRow(params, (err, data) => {
         if (err) reject(err);
@@ -103,8 +183,10 @@ module.exports.handler = async (event, context) => {
       device_id,
       oss_path_original,
       oss_path_thumbnail,
+      oss_path_clip,
       has_motion,
       image_size,
+      crop,
       created_at: timestamp
     });
 
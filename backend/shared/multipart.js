@@ -0,0 +1,74 @@
+// backend/shared/multipart.js
+
+const { AppError } = require('./error-handler');
+
+/**
+ * 解析 multipart/form-data 请求体（函数计算 HTTP 事件，body 可能为 base64）
+ * 设备端请求体较小且已整体缓存在内存中，这里直接按分隔符切分，不依赖第三方库
+ *
+ * @returns {Array<{name, filename, contentType, data: Buffer}>} 按请求中的顺序排列
+ */
+function parseMultipart(event) {
+  const headers = event.headers || {};
+  const contentType = headers['content-type'] || headers['Content-Type'] || '';
+  const match = contentType.match(/^multipart\/form-data;.*boundary=(?:"([^"]+)"|([^;]+))/i);
+  if (!match) {
+    throw new AppError('Content-Type must be multipart/form-data with a boundary', 400);
+  }
+  const boundary = match[1] || match[2];
+
+  const body = Buffer.from(event.body || '', event.isBase64Encoded ? 'base64' : 'binary');
+  const delimiter = Buffer.from(`--${boundary}`);
+  const separator = Buffer.from(`\r\n--${boundary}`);
+
+  const parts = [];
+  let pos = body.indexOf(delimiter);
+  if (pos < 0) {
+    throw new AppError('Malformed multipart body', 400);
+  }
+  pos += delimiter.length;
+
+  // 每个部分：CRLF + 头 + 空行 + 数据 + CRLF--boundary；结尾为 --boundary--
+  while (body.slice(pos, pos + 2).toString() !== '--') {
+    const headerStart = pos + 2;
+    const headerEnd = body.indexOf('\r\n\r\n', headerStart);
+    if (headerEnd < 0) {
+      throw new AppError('Malformed multipart body', 400);
+    }
+    const dataStart = headerEnd + 4;
+    const dataEnd = body.indexOf(separator, dataStart);
+    if (dataEnd < 0) {
+      throw new AppError('Malformed multipart body', 400);
+    }
+
+    const headerText = body.slice(headerStart, headerEnd).toString('utf8');
+    const name = (headerText.match(/name="([^"]*)"/i) || [])[1];
+    const filename = (headerText.match(/filename="([^"]*)"/i) || [])[1];
+    const partType = (headerText.match(/^content-type:\s*(.+)$/im) || [])[1];
+
+    parts.push({
+      name,
+      filename,
+      contentType: partType ? partType.trim() : undefined,
+      data: body.slice(dataStart, dataEnd)
+    });
+    pos = dataEnd + separator.length;
+  }
+
+  return parts;
+}
+
+/**
+ * 读取 JSON 字段
+ */
+function jsonField(parts, name) {
+  const part = parts.find(p => p.name === name && !p.filename);
+  if (!part) return null;
+  try {
+    return JSON.parse(part.data.toString('utf8'));
+  } catch (err) {
+    throw new AppError(`Invalid JSON in field: ${name}`, 400);
+  }
+}
+
+module.exports = { parseMultipart, jsonField };
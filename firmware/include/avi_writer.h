@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// AVI 输出目标：顺序追加，结束时回写文件头
+// 设备上为 LittleFS 文件（ClipRecorder），主机上为普通文件（tools/avi_clip.cpp）
+class AviSink {
+public:
+    virtual ~AviSink() {}
+    virtual bool write(const uint8_t* data, size_t length) = 0;
+    // 覆盖已写出的字节（文件头中的帧数、长度和帧率）
+    virtual bool writeAt(uint32_t offset, const uint8_t* data, size_t length) = 0;
+};
+
+// 索引项：帧数据相对 'movi' 标识的偏移和长度
+struct AviIndexEntry {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// 已完成文件的头部信息
+struct AviFileInfo {
+    uint16_t width;
+    uint16_t height;
+    uint32_t frames;
+    uint32_t usPerFrame;
+};
+
+// 流式 MJPEG AVI（RIFF AVI 1.0，单视频流，idx1 索引）
+// 每帧 JPEG 写成一个 '00dc' 块直接追加到输出，只有索引（每帧 8 字节）留在内存；
+// finish 时追加 idx1 并回写头部的帧数、帧率和各级长度。未 finish 的文件没有索引，播放器不一定能打开
+class AviWriter {
+public:
+    // 写出占位的文件头
+    // @param index 调用者提供的索引空间，决定最多帧数
+    bool begin(AviSink* sink, uint16_t width, uint16_t height, AviIndexEntry* index, uint16_t maxFrames);
+
+    // @return 索引已满或写入失败时返回 false
+    bool addFrame(const uint8_t* jpeg, size_t length);
+
+    // 追加索引并回写头部
+    // @param usPerFrame 平均帧间隔（微秒），AVI 只有固定帧率
+    bool finish(uint32_t usPerFrame);
+
+    uint16_t getFrames() const { return frames; }
+    uint16_t getWidth() const { return width; }
+    uint16_t getHeight() const { return height; }
+    // 已写出的字节数
+    uint32_t getBytes() const { return bytes; }
+    // 再加入一帧 length 字节的 JPEG 后，finish 得到的文件大小
+    uint32_t sizeWith(size_t length) const;
+    // 按已写帧的平均大小，把 maxBytes 内还能加入的帧均匀摊到 remainingMs 内的帧间隔，不短于 minIntervalMs
+    // 还没有帧或已放不下时返回 minIntervalMs
+    uint32_t spreadInterval(uint32_t maxBytes, uint32_t remainingMs, uint32_t minIntervalMs) const;
+    bool isFull() const { return frames >= maxFrames; }
+
+    // 文件头长度，帧数据从其后开始
+    static const size_t HEADER_BYTES = 224;
+    // 解析本类写出的文件头（至少 HEADER_BYTES 字节），不是 MJPEG AVI 时返回 false
+    static bool parseHeader(const uint8_t* data, size_t length, AviFileInfo& info);
+
+private:
+    AviSink* sink = nullptr;
+    AviIndexEntry* index = nullptr;
+    uint16_t maxFrames = 0;
+    uint16_t frames = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint32_t bytes = 0;
+    uint32_t moviBytes = 0;       // 'movi' 之后的帧块总长
+    uint32_t maxFrameBytes = 0;
+
+    bool writeHeaders(uint32_t usPerFrame);
+};
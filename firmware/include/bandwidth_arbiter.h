@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+struct BandwidthStats {
+    bool enabled;
+    bool liveActive;          // 有人观看（/stream 请求或 RTSP 播放）
+    uint32_t linkBps;         // 链路容量估计（字节/秒）
+    uint32_t liveBps;         // 实时流吞吐，按采样周期平滑
+    uint32_t backgroundBps;   // 后台上传吞吐
+    uint32_t allowanceBps;    // 后台当前配额，0 为不限速
+    uint32_t liveBytes;
+    uint32_t backgroundBytes;
+    uint32_t pacedMs;         // 后台等待令牌的累计时间
+    uint32_t backoffs;        // 观看开始时后台立即降速的次数
+    uint32_t congestions;     // 后台写入阻塞、链路估计下调的次数
+};
+
+// 实时预览与后台上传的带宽仲裁
+// 实时流（/stream、RTSP）不限速，只记录吞吐；后台上传（CloudClient）每次写入前从令牌桶取令牌，
+// 有人观看时令牌按 链路估计 - 实时流预留 补充，只用剩余带宽，无人观看时不限速
+// 链路估计取观测到的总吞吐：后台用满配额且写入不阻塞时按 BW_PROBE_BPS 上调，
+// 写入阻塞（socket 发送缓冲区满）说明链路已饱和，降到本周期实际总吞吐
+// 观看开始时清空令牌并按 BW_LIVE_MIN_RESERVE_BPS 预留，后台在下一次取令牌时就降速
+class BandwidthArbiter {
+public:
+    // 观看者活动（/stream 请求、RTSP 播放中的每一帧）
+    void noteViewer(uint32_t now);
+    // 实时流交给 TCP/UDP 的字节
+    void recordLive(size_t bytes, uint32_t now);
+
+    // 后台写入 bytes（不超过 BW_BUCKET_BYTES）前取令牌
+    // @return 0 表示已扣除、可以写入；否则为建议等待的毫秒数
+    uint32_t reserve(size_t bytes, uint32_t now);
+    // 阻塞到 reserve 成功，每 BW_PACE_POLL_MS 重新判断，观看开始后最迟一个轮询周期内降速
+    void pace(size_t bytes);
+    // 后台写入完成
+    // @param blockedUs 阻塞在 socket 写入中的时间
+    void recordBackground(size_t bytes, uint32_t blockedUs, uint32_t now);
+
+    // 关闭后后台不限速（对照测量），吞吐照常统计
+    void setEnabled(bool enabled);
+    BandwidthStats getStats(uint32_t now);
+
+private:
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    bool enabled = BW_ARBITER_ENABLED;
+    bool viewerSeen = false;
+    uint32_t lastViewerMs = 0;
+
+    // 当前采样周期
+    uint32_t sampleStart = 0;
+    uint32_t windowLive = 0;
+    uint32_t windowBackground = 0;
+    uint32_t windowBlockedUs = 0;
+    bool windowThrottled = false;
+
+    uint32_t linkBps = BW_MIN_LINK_BPS;
+    uint32_t liveBps = 0;
+    uint32_t backgroundBps = 0;
+    uint32_t allowanceBps = 0;
+    uint32_t tokens = 0;
+    uint32_t tokensMs = 0;
+    BandwidthStats stats = {};
+
+    bool isLiveActive(uint32_t now) const;
+    void update(uint32_t now);
+    void refill(uint32_t now);
+    uint32_t liveReserve() const;
+    uint32_t backgroundAllowance() const;
+};
+
+extern BandwidthArbiter bandwidthArbiter;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+
+// 分级 PSRAM 缓冲池
+// 启动时按配置的帧尺寸一次性分配若干固定大小的槽，避免长时间运行后堆碎片化
+// 槽用尽时立即返回 nullptr（不等待、不回退到 malloc），并计入失败次数
+
+enum BufferClass {
+    BUFFER_SMALL,    // 约 1/16 帧：缩略图、累加器
+    BUFFER_MEDIUM,   // 约 1/4 帧：QVGA 级别的输出、JPEG 编码结果
+    BUFFER_LARGE,    // 整帧 + 文件头：BMP 流、整帧拷贝
+    BUFFER_CLASS_COUNT
+};
+
+struct BufferClassStats {
+    size_t slotSize;
+    uint8_t slots;
+    uint8_t inUse;
+    uint8_t highWater;
+    uint32_t acquires;
+    uint32_t failures;
+};
+
+class BufferPool {
+public:
+    // 按帧字节数划分各级槽大小并从 PSRAM 分配
+    bool begin(size_t frameBytes);
+
+    // 取能容纳 size 的最小一级空闲槽；该级用尽时尝试更大一级
+    uint8_t* acquire(size_t size);
+    void release(uint8_t* buffer);
+
+    // 该缓冲区所属槽的容量
+    size_t capacity(const uint8_t* buffer) const;
+
+    BufferClassStats getStats(BufferClass cls) const;
+    size_t getMaxSlotSize() const { return classes[BUFFER_LARGE].slotSize; }
+
+private:
+    struct SizeClass {
+        size_t slotSize = 0;
+        uint8_t slots = 0;
+        uint8_t* base = nullptr;
+        uint32_t freeMask = 0;     // 位为 1 表示空闲，最多 32 个槽
+        uint8_t inUse = 0;
+        uint8_t highWater = 0;
+        uint32_t acquires = 0;
+        uint32_t failures = 0;
+    };
+
+    SizeClass classes[BUFFER_CLASS_COUNT];
+    mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    bool initialized = false;
+
+    int findClass(const uint8_t* buffer) const;
+};
+
+extern BufferPool bufferPool;
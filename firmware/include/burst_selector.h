@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_camera.h>
+#include "config.h"
+#include "image_scaler.h"
+#include "parallel.h"
+
+// 一次连拍的选帧结果，随事件元数据上传
+struct BurstSelection {
+    uint8_t frames;           // 参与评分的帧数
+    uint8_t selected;         // 选中帧的序号，0 为触发帧
+    uint32_t sharpness;       // 选中帧的清晰度
+    uint32_t triggerSharpness;
+    uint32_t scoringUs;       // 平均每帧评分耗时
+};
+
+struct BurstStats {
+    uint32_t bursts;
+    uint32_t frames;          // 评分的帧数
+    uint32_t triggerSelected; // 触发帧本身最清晰的连拍数
+    uint32_t copyFailures;    // 缓冲池无整帧槽，只能保留触发帧
+    uint32_t avgScoringUs;
+    uint32_t maxScoringUs;
+    BurstSelection last;
+};
+
+// 峰值帧连拍选优
+// 触发运动的帧常有运动模糊。触发后连续取 BURST_FRAMES 帧，在触发帧变化区域附近
+// 按抽样亮度平面的拉普拉斯方差评分，最清晰的一帧拷贝到缓冲池整帧槽，连拍结束后只交出这一帧
+// 只由采集任务调用（getStats 除外）
+class BurstSelector {
+public:
+    // 以触发帧开始连拍，触发帧本身作为第 0 帧评分
+    // @param box 触发帧的变化区域，扩展后作为评分区域，连拍期间固定
+    // @return 缓冲池没有整帧槽时返回 false，调用者直接使用触发帧
+    bool start(camera_fb_t* fb, const CropRect& box, uint8_t score);
+    // 连拍中的后续帧
+    // @param box 该帧的变化区域，nullptr 表示沿用评分区域
+    // @return 连拍已满（可以取结果）
+    bool offer(camera_fb_t* fb, const CropRect* box, uint8_t score);
+    bool isActive() const { return active; }
+
+    // 选中的帧（整帧拷贝；拷贝失败时为 nullptr）及其变化区域和运动分数
+    // 调用后到 finish() 之前有效
+    camera_fb_t* getBest(CropRect& box, uint8_t& score);
+    BurstSelection getSelection() const { return selection; }
+    // 释放拷贝，结束连拍
+    void finish();
+
+    BurstStats getStats();
+
+    // 清晰度：区域内每隔 step 像素抽样的亮度做 4 邻域拉普拉斯，返回方差
+    // 传感器 JPEG 无法取像素，同一场景同一质量下压缩后字节数随高频能量增长，以帧长度代替
+    // @param box 已经过 clampCrop 的区域
+    // @param rows 每个核 3 行抽样亮度，scratchSize(box.width, step) 字节
+    static uint32_t sharpness(const camera_fb_t* fb, const CropRect& box, int step, uint8_t* rows);
+    static size_t scratchSize(int width, int step) {
+        return (size_t)ParallelRunner::WORKERS * 3 * ((width + step - 1) / step);
+    }
+
+private:
+    bool active = false;
+    uint8_t index = 0;
+    CropRect scoreBox;
+    BurstSelection selection = {};
+    uint64_t totalScoringUs = 0;
+
+    uint8_t* rows = nullptr;  // 评分用的抽样行，来自缓冲池
+    camera_fb_t best = {};    // buf 指向缓冲池槽
+    CropRect bestBox;
+    uint8_t bestScore = 0;
+
+    BurstStats stats = {};
+    uint64_t statsScoringUs = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    void score(camera_fb_t* fb, const CropRect& box, uint8_t motionScore);
+};
@@ -3,20 +3,169 @@
 
 #include <esp_camera.h>
 #include <Arduino.h>
+#include "latency_tracer.h"
+
+// 驱动采集参数
+struct CaptureConfig {
+    camera_grab_mode_t grabMode;      // LATEST：总是取最新帧；WHEN_EMPTY：按队列顺序，消费慢时帧会过期
+    camera_fb_location_t fbLocation;  // 帧缓冲放在 PSRAM 或内部 DRAM（DRAM 只放得下小分辨率）
+    uint8_t fbCount;
+    uint32_t xclkHz;
+    // RGB565：像素可直接访问；JPEG：传感器压缩输出，运动检测用 DC 系数，
+    // 运动估计（绊线）、帧录制和缩放快照不可用
+    pixformat_t pixelFormat;
+};
+
+// 帧龄：驱动写入的传感器时间戳到被消费的时间
+struct CaptureStats {
+    CaptureConfig config;
+    uint32_t frames;
+    uint32_t failures;        // esp_camera_fb_get 超时
+    float fps;                // 自上次重置以来的平均帧率
+    uint32_t lastAgeUs;
+    uint32_t avgAgeUs;
+    uint32_t maxAgeUs;
+};
+
+struct CaptureBenchmarkResult {
+    CaptureConfig config;
+    bool ok;                  // 初始化失败（如 DRAM 放不下）时为 false
+    float fps;                // 连续取帧的帧率
+    uint32_t avgAgeUs;        // 连续取帧的平均帧龄
+    uint32_t pacedAvgAgeUs;   // 按采集任务的全速帧间隔（1000 / STREAM_FPS）取帧时的平均帧龄
+    uint32_t pacedMaxAgeUs;
+};
+
+// 分辨率切换：提交请求到首个新尺寸帧之间丢弃的帧数与耗时
+struct FrameSizeSwitchStats {
+    uint32_t switches;
+    uint8_t lastFrames;
+    uint8_t maxFrames;
+    uint32_t lastMs;
+    uint32_t maxMs;
+    uint32_t reinits;         // 放大超过驱动缓冲或排空超时时重新初始化驱动
+    uint32_t failures;
+    uint32_t staleFrames;     // capture() 丢弃的尺寸不符/不完整帧
+};
+
+// 传感器开窗：视场为传感器全幅坐标（CAMERA_SENSOR_WIDTH x CAMERA_SENSOR_HEIGHT）中的矩形，
+// 输出仍为当前分辨率，由传感器 DSP 缩放；宽度为 0 表示全幅
+struct SensorWindow {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+};
+
+struct WindowStats {
+    SensorWindow requested;
+    SensorWindow applied;     // 扩展到输出宽高比并对齐后实际读出的视场，未开窗时为全幅
+    uint8_t binning;          // 传感器读出模式：1 全分辨率，2/4 为隔行隔列读出
+    uint32_t frameBytes;      // 最近一帧的字节数
+    uint32_t fullFieldBytes;  // 全幅读出再软件裁剪时，取得相同像素密度所需的整帧字节数
+};
 
 class Camera {
 public:
+    static const uint8_t BENCHMARK_MODES = 6;
+
     bool init();
+    bool init(const CaptureConfig& config);
+    // 取下一帧（调用者不要自行归还）；可能阻塞到传感器出下一帧
+    // 驱动至少有两个帧缓冲时，上一帧保留到 releasePrevious()，取帧期间仍可读取；
+    // 只有一个帧缓冲时先归还上一帧，调用前须放下对它的引用（见 keepsPreviousFrame）
     bool capture();
+    void releasePrevious();
+    bool keepsPreviousFrame() const { return config.fbCount >= 2; }
     camera_fb_t* getBuffer();
     size_t getImageSize();
     uint8_t* getImageData();
 
-    // 设置
-    void setFrameSize(framesize_t size);
     void setQuality(uint8_t quality);
 
+    // 可切换的分辨率：不小于 QQVGA（运动估计的分析平面），不超过 CAMERA_MAX_FRAME_SIZE（缓冲池槽大小）
+    static bool isSupportedFrameSize(framesize_t size);
+    // 名称与 framesize_t 互转，如 "vga"、"qvga"
+    static bool parseFrameSize(const char* name, framesize_t& size);
+    static const char* frameSizeName(framesize_t size);
+    // 输出格式名称："rgb565"、"jpeg"
+    static bool parsePixelFormat(const char* name, pixformat_t& format);
+    static const char* pixelFormatName(pixformat_t format);
+    framesize_t getFrameSize() const { return frameSize; }
+
+    // 默认采集参数（config.h）
+    static CaptureConfig defaultConfig();
+    CaptureConfig getCaptureConfig() const { return config; }
+    // 帧龄（微秒），基于驱动写入的 fb->timestamp
+    static uint32_t frameAgeUs(const camera_fb_t* fb);
+
+    // 当前帧的序号和时间戳（与 getBuffer() 同一帧）
+    FrameTrace getTrace();
+    // 采集任务完成当前帧的分析
+    void markAnalyzed();
+
+    // 以下请求可在任意任务中提交，由采集任务调用 servicePending 执行
+    // 重新初始化驱动期间当前帧失效，调用前须放下所有对当前帧的引用
+    void requestCaptureConfig(const CaptureConfig& next);
+    void requestBenchmark();
+    // 切换分辨率：排空旧尺寸帧后 capture() 只返回新尺寸的帧
+    // @return 不支持的分辨率返回 false
+    bool requestFrameSize(framesize_t size);
+    // 开窗（数字变焦/ROI），切换分辨率后保持视场不变
+    // @return 超出传感器全幅时返回 false
+    bool requestWindow(const SensorWindow& window);
+    bool hasPendingRequest() const { return pendingConfig || pendingBenchmark || pendingFrameSize || pendingWindow; }
+    void servicePending();
+
+    CaptureStats getStats();
+    bool isBenchmarkRunning() const { return benchmarkRunning; }
+    // @return 结果条数，尚未运行过时为 0
+    uint8_t getBenchmarkResults(CaptureBenchmarkResult* out);
+    FrameSizeSwitchStats getSwitchStats();
+    WindowStats getWindowStats();
+
 private:
     camera_fb_t* fb = nullptr;
+    camera_fb_t* previous = nullptr;
     bool initialized = false;
+    CaptureConfig config = {};
+    framesize_t frameSize = FRAMESIZE_INVALID;
+    framesize_t allocatedSize = FRAMESIZE_INVALID;  // 驱动帧缓冲按初始化时的分辨率分配
+
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    volatile bool pendingConfig = false;
+    volatile bool pendingBenchmark = false;
+    volatile bool benchmarkRunning = false;
+    volatile bool pendingFrameSize = false;
+    CaptureConfig nextConfig = {};
+    framesize_t nextFrameSize = FRAMESIZE_INVALID;
+    volatile bool pendingWindow = false;
+    SensorWindow nextWindow = {};
+    SensorWindow window = {};
+    SensorWindow appliedWindow = {};
+    uint8_t binning = 0;
+    uint32_t lastFrameBytes = 0;
+    FrameSizeSwitchStats switchStats = {};
+
+    CaptureBenchmarkResult benchmarkResults[BENCHMARK_MODES] = {};
+    uint8_t benchmarkCount = 0;
+
+    FrameTrace trace = {};
+    uint32_t nextSeq = 0;
+
+    uint32_t frames = 0;
+    uint32_t failures = 0;
+    uint32_t lastAgeUs = 0;
+    uint32_t maxAgeUs = 0;
+    uint64_t totalAgeUs = 0;
+    unsigned long statsSince = 0;
+
+    void release();
+    bool reinit(const CaptureConfig& next);
+    void resetStats();
+    bool matchesFrameSize(const camera_fb_t* frame) const;
+    bool applyFrameSize(framesize_t size);
+    bool applyWindow(const SensorWindow& next);
+    bool writeWindow();
+    void runBenchmark();
 };
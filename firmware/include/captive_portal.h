@@ -1,15 +1,36 @@
 #pragma once
-#include <DNSServer.h>
+#include <AsyncUDP.h>
 #include "config.h"
 
+struct DnsStats {
+    uint32_t queries;
+    uint32_t answered;
+    uint32_t dropped;          // 格式错误或非标准查询
+    uint32_t avgLatencyUs;     // 收到查询到发出应答
+    uint32_t maxLatencyUs;
+};
+
+// 强制门户 DNS：所有 A 查询都解析到 AP 地址
+// 基于 AsyncUDP，在网络栈回调中立即应答，不依赖主循环轮询
 class CaptivePortal {
 private:
-    DNSServer* dnsServer = nullptr;
+    AsyncUDP* udp = nullptr;
     bool enabled = false;
 
+    // 预先构建的应答记录（指向问题名的压缩指针 + A 记录）
+    uint8_t answer[16];
+
+    volatile uint32_t queries = 0;
+    volatile uint32_t answered = 0;
+    volatile uint32_t dropped = 0;
+    volatile uint64_t totalLatencyUs = 0;
+    volatile uint32_t maxLatencyUs = 0;
+
+    void handlePacket(AsyncUDPPacket& packet);
+
 public:
     void begin();
-    void update();
     void stop();
     bool isEnabled() const { return enabled; }
+    DnsStats getStats() const;
 };
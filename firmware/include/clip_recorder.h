@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <esp_camera.h>
+#include "config.h"
+#include "avi_writer.h"
+
+// 已完成的短片
+struct ClipInfo {
+    uint32_t id;
+    uint16_t width;
+    uint16_t height;
+    uint16_t frames;
+    uint32_t bytes;
+    uint32_t durationMs;    // 首帧到末帧
+    bool truncated;         // 达到帧数或字节上限后不再追加
+};
+
+struct ClipStats {
+    bool recording;
+    uint16_t openFrames;
+    uint32_t openBytes;
+    uint32_t clipsFinished;
+    uint32_t clipsAborted;    // 事件被丢弃、没有帧或写入失败
+    uint32_t framesSkipped;   // 编码失败或帧尺寸与短片不一致
+    uint32_t truncated;
+    uint32_t frameIntervalMs; // 正在录制的短片当前的帧间隔
+    uint32_t lastEncodeUs;    // 最近一帧缩放 + 编码 + 写入耗时
+};
+
+// 运动事件短片：事件开始时在 /clips/open.avi 开始写 MJPEG AVI，
+// 每 CLIP_FRAME_INTERVAL_MS 起追加帧，事件结束时补索引并改名为 /clips/<id>.avi
+// 每帧之后按平均帧大小把剩余的 CLIP_MAX_BYTES 摊到 EVENT_MAX_DURATION_MS 内，拉长帧间隔，
+// 传感器 JPEG（每帧几十 KB，原样写入）也能覆盖整个事件
+// 帧直接写入文件，内存中只有索引；上传时同样从文件分块读出
+class ClipRecorder {
+public:
+    // 删除掉电前未完成的短片并找出下一个 ID
+    bool begin();
+
+    // 事件开始（采集任务中调用），超出 CLIP_MAX_STORED 时删除最旧的短片
+    bool start(uint32_t now);
+    bool isRecording() const { return recording; }
+    // 是否到了追加下一帧的时间
+    bool isDue(uint32_t now) const;
+    void addFrame(camera_fb_t* fb, uint32_t now);
+
+    // 事件结束：写索引、回写文件头并改名
+    // @return 没有帧或写入失败时返回 false，文件已删除
+    bool finish(ClipInfo& info);
+    // 事件被丢弃：删除正在写的文件
+    void abort();
+
+    // 已完成的短片，按 ID 升序
+    size_t list(ClipInfo* out, size_t maxCount);
+    bool find(uint32_t id, ClipInfo& info);
+    bool remove(uint32_t id);
+    static String clipPath(uint32_t id);
+
+    ClipStats getStats();
+
+private:
+    // LittleFS 文件输出，回写头部时定位后再回到末尾
+    class FileSink : public AviSink {
+    public:
+        File file;
+        bool write(const uint8_t* data, size_t length) override;
+        bool writeAt(uint32_t offset, const uint8_t* data, size_t length) override;
+    };
+
+    SemaphoreHandle_t mutex = nullptr;     // 目录操作（写入中的文件只由采集任务访问）
+    portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+    FileSink sink;
+    AviWriter writer;
+    AviIndexEntry index[CLIP_MAX_FRAMES];
+    bool recording = false;
+    bool started = false;         // 已按首帧尺寸写出文件头
+    bool truncated = false;
+    uint32_t nextId = 1;
+    uint32_t firstFrameMs = 0;
+    uint32_t lastFrameMs = 0;
+    uint32_t frameIntervalMs = CLIP_FRAME_INTERVAL_MS;
+    ClipStats stats = {};
+
+    size_t encodeFrame(camera_fb_t* fb, uint8_t*& out, uint16_t& width, uint16_t& height);
+    bool appendFrame(const uint8_t* jpeg, size_t length, uint16_t width, uint16_t height);
+    bool readInfo(uint32_t id, ClipInfo& info);
+    void closeOpen();
+    void trimStored(size_t keep);
+};
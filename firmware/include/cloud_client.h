@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+#include "https_pool.h"
+
+// multipart/form-data 请求体：先按各部分长度算出 Content-Length，再流式写出
+class MultipartForm {
+public:
+    MultipartForm();
+
+    const char* getContentType() const { return contentType; }
+
+    // 一个部分的总长度（部分头 + 数据 + 结尾 CRLF）；filename 为 nullptr 时为普通字段
+    size_t partLength(const char* name, const char* filename, const char* type, size_t dataLength) const;
+    // 结束分隔符长度
+    size_t closingLength() const { return strlen(boundary) + 6; }
+
+    bool writePartHeader(const HttpsWriteFn& write, const char* name, const char* filename,
+                         const char* type) const;
+    bool writePartEnd(const HttpsWriteFn& write) const;
+    bool writePart(const HttpsWriteFn& write, const char* name, const char* filename, const char* type,
+                   const uint8_t* data, size_t length) const;
+    bool writeClosing(const HttpsWriteFn& write) const;
+
+private:
+    char boundary[32];
+    char contentType[64];
+
+    size_t formatPartHeader(char* out, size_t size, const char* name, const char* filename,
+                            const char* type) const;
+};
+
+// 云端 API（API 网关）客户端，请求经 HttpsPool 复用连接和 TLS 会话
+class CloudClient {
+public:
+    explicit CloudClient(HttpsPool& pool) : pool(pool) {}
+
+    void begin();
+
+    // 设备 ID：cams3- + MAC 后 6 位
+    const String& getDeviceId() const { return deviceId; }
+
+    // 发送 POST 请求，请求体由 writeBody 流式写入（连接失效重试时会再调用一次）
+    // @param path API 路径（不含 CLOUD_API_BASE_PATH）
+    // @param response 可选，保存响应体（最多 HTTPS_RESPONSE_MAX_BYTES）
+    // @return HTTP 状态码；连接、发送或读取失败时返回负数（HttpsError）
+    int post(const char* path, const char* contentType, size_t contentLength,
+             const HttpsBodyWriter& writeBody, String* response = nullptr);
+
+private:
+    HttpsPool& pool;
+    String deviceId;
+};
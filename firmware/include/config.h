@@ -6,13 +6,53 @@
 // 摄像头配置
 #define CAMERA_MODEL_ESP32S3_EYE
 #define CAMERA_FRAME_SIZE FRAMESIZE_VGA  // 640x480
-#define CAMERA_JPEG_QUALITY 12           // 1-63, 越低质量越高
+#define CAMERA_MAX_FRAME_SIZE FRAMESIZE_VGA   // 运行时可切换的最大分辨率，缓冲池按它分配
+#define CAMERA_SENSOR_WIDTH 1600         // OV2640 全幅（UXGA），开窗坐标以此为准
+#define CAMERA_SENSOR_HEIGHT 1200
+#define CAMERA_SWITCH_MAX_FRAMES 4       // 切换分辨率时最多丢弃的旧尺寸帧数，超过则重新初始化驱动
+#define CAMERA_PIXEL_FORMAT PIXFORMAT_RGB565  // JPEG：传感器硬件压缩，运动检测改用 DC 系数亮度图
+#define CAMERA_JPEG_QUALITY 12           // 1-63, 越低质量越高（JPEG 输出格式时由传感器使用）
 #define CAMERA_FB_COUNT 2                // 双缓冲
+#define CAMERA_GRAB_MODE CAMERA_GRAB_LATEST   // 总是取最新帧，消费慢时不拿到过期帧
+#define CAMERA_FB_LOCATION CAMERA_FB_IN_PSRAM // VGA RGB565 一帧 600KB，只能放 PSRAM
+#define CAMERA_XCLK_FREQ_HZ 20000000
+#define CAMERA_BENCHMARK_FRAMES 30       // 基准测试每种模式连续取帧数
+#define CAMERA_BENCHMARK_PACED_FRAMES 10 // 按采集间隔取帧数
+
+// 缓冲池配置（槽大小按 CAMERA_MAX_FRAME_SIZE 计算）
+#define BUFFER_POOL_SMALL_COUNT 8        // 1/16 帧槽数
+#define BUFFER_POOL_MEDIUM_COUNT 4       // 1/4 帧槽数
+#define BUFFER_POOL_LARGE_COUNT 3        // 整帧槽数（帧拷贝、录制等），另加 STREAM_MAX_VIEWERS 个给 /stream
+#define BUFFER_POOL_HEADROOM 1024        // 文件头等附加空间
+
+// 本地事件存储配置（独立的原始闪存分区，见 partitions.csv）
+#define EVENT_PARTITION_LABEL "events"
+#define EVENT_PARTITION_SUBTYPE 0x40     // 自定义数据分区子类型
+#define EVENT_MAX_BYTES (64 * 1024)      // 单条事件图像上限
+#define EVENT_INDEX_CAPACITY 512         // 内存索引条数
+#define EVENT_JPEG_QUALITY 15            // 事件图像 JPEG 质量
 
 // 网络配置
 #define HTTP_PORT 80
 #define MDNS_NAME "camS3"
 #define STREAM_FPS 3                     // 实时预览 FPS
+#define STREAM_MAX_VIEWERS 2             // 同时在途的 /stream 整帧数，按此预留整帧槽；超出时返回 503
+#define NTP_SERVER "ntp.aliyun.com"
+#define NTP_GMT_OFFSET_SEC (8 * 3600)    // 北京时间
+
+// 云端 API 配置
+#define CLOUD_API_HOST "your-api-gateway-id.cn-hangzhou.aliyuncs.com"
+#define CLOUD_API_PORT 443
+#define CLOUD_API_BASE_PATH "/prod"
+
+// HTTPS 连接池配置
+#define HTTPS_ROOT_CA nullptr            // PEM 根证书（证书固定）；nullptr 时按 IDF 根证书包校验，不会跳过校验
+#define HTTPS_POOL_MAX_CONNECTIONS 2     // 同时保持的连接数（每条约 40KB 堆）
+#define HTTPS_SESSION_CACHE_SIZE 4       // 缓存会话票据的主机数
+#define HTTPS_KEEPALIVE_IDLE_MS 30000    // 空闲连接保持时间
+#define HTTPS_SESSION_MAX_AGE_MS (3600UL * 1000)  // 会话票据有效期
+#define HTTPS_IO_TIMEOUT_MS 15000
+#define HTTPS_RESPONSE_MAX_BYTES 512
 
 // 运动检测配置
 #define MOTION_GRID_ROWS 8
@@ -20,12 +60,130 @@
 #define MOTION_THRESHOLD 30              // 像素变化阈值 (0-255)
 #define MOTION_TRIGGER_COUNT 5           // 触发网格数量阈值
 #define MOTION_CHECK_INTERVAL_MS 200     // 检测间隔
+#define MOTION_EVENT_INTERVAL_MS 2000    // 持续运动时每隔该时间产生一个候选事件帧
+
+// 运动事件上传配置（变化区域全分辨率裁剪图 + 低分辨率全景图）
+#define MOTION_UPLOAD_ENABLED false      // 默认关闭：CLOUD_API_HOST 改成实际网关后再打开
+#define MOTION_CROP_PADDING 24           // 变化区域四周扩展的像素
+#define MOTION_CROP_FULL_FRAME_PCT 60    // 裁剪面积超过整帧该比例时只上传整帧
+#define MOTION_CONTEXT_WIDTH 160         // 全景图宽度
+#define MOTION_CROP_JPEG_QUALITY 12
+#define MOTION_CONTEXT_JPEG_QUALITY 20
+#define MOTION_UPLOAD_QUEUE_DEPTH 2      // 待上传事件数，满时丢弃新事件
+
+// 块匹配运动矢量与绊线（亮度平面为 QVGA 分析帧 2 倍降采样）
+#define MV_ENABLED true
+#define MV_PLANE_WIDTH 160
+#define MV_PLANE_HEIGHT 120
+#define MV_BLOCK_SIZE 8
+#define MV_SEARCH_RANGE 4                // 搜索窗口 ±N 像素（亮度平面坐标）
+// ESP32-S3 上用 PIE 向量指令计算块 SAD，其他目标为标量循环。默认关闭：汇编尚未在 S3 上编译运行并与标量 SAD 核对，
+// 且 IDF 4.4 任务切换不保存 Q 寄存器和 ACCX，同核上其他用到 PIE 的任务（esp-dsp 等）会破坏中间结果
+#define MV_SAD_SIMD false
+#define MV_MIN_BLOCK_SAD 384             // 零位移 SAD 低于该值的块视为静止，不搜索
+#define MV_MAX_MOVING_PCT 50             // 超过该比例的块在动时视为镜头晃动/曝光变化
+#define MV_MAX_TRIPWIRES 4
+#define MV_TRIPWIRE_MIN_BLOCKS 2         // 同方向越线的块数达到该值才触发
+#define MV_TRIPWIRE_COOLDOWN_MS 3000     // 同一绊线两次触发的最小间隔
+
+// 运动事件状态机（K-of-N 开始、静默结束、冷却与限速，每个事件只上传一次峰值帧）
+#define EVENT_START_FRAMES 3             // 最近 EVENT_WINDOW_FRAMES 帧中至少该数量帧有运动才开始事件
+#define EVENT_WINDOW_FRAMES 5            // 不超过 32
+#define EVENT_HOLD_SCORE 2               // 事件进行中分数不低于该值仍算运动（低于触发网格数，形成滞回）
+#define EVENT_QUIET_MS 5000              // 持续无运动该时长后结束事件
+#define EVENT_MIN_DURATION_MS 1000       // 短于该时长的事件丢弃，不上传
+#define EVENT_MAX_DURATION_MS 60000      // 持续运动超过该时长时结束并上报，随后的运动开始新事件
+#define EVENT_COOLDOWN_MS 10000          // 上报后该时长内开始的事件只保存到本地，不上报
+#define EVENT_RATE_LIMIT 12              // EVENT_RATE_WINDOW_MS 内最多上报的事件数，超出的只保存到本地
+#define EVENT_RATE_WINDOW_MS (3600UL * 1000)
+#define EVENT_PEAK_REFRESH_MS 1000       // 峰值帧重新编码的最小间隔
+
+// 峰值帧连拍选优（触发帧起连续取帧，按清晰度只保留最清晰的一帧保存和上传）
+#define BURST_ENABLED true
+#define BURST_FRAMES 5                   // 含触发帧，不超过 32
+#define BURST_SHARPNESS_STEP 2           // 清晰度评分的抽样间隔（像素），VGA 下抽样平面为 320x240
+
+// 事件短片（MJPEG AVI，事件开始时录制到 LittleFS，结束后随峰值帧一起上传）
+#define CLIP_ENABLED true
+#define CLIP_WIDTH 320                   // 帧缩小到该宽度再编码，传感器 JPEG 先缩放解码
+#define CLIP_JPEG_QUALITY 20
+#define CLIP_FRAME_INTERVAL_MS 1000      // 最短帧间隔，帧较大时按 CLIP_MAX_BYTES 拉长
+#define CLIP_MAX_FRAMES 120              // 索引常驻内存，每帧 8 字节
+#define CLIP_MAX_BYTES (128 * 1024)      // 单个短片上限，按该预算覆盖 EVENT_MAX_DURATION_MS，超出时停止追加帧
+#define CLIP_MAX_STORED 2                // 含正在录制的短片，超出时删除最旧的
+
+// 事件帧去重（亮度网格 dHash，56 位）
+#define DEDUP_ENABLED true
+#define DEDUP_MAX_DISTANCE 4             // 汉明距离不超过该值视为重复
+#define DEDUP_HISTORY_SIZE 8             // 保留最近放行的帧数
+#define DEDUP_WINDOW_MS 60000            // 超过该时间的记录不再参与比较
+
+// 低功耗空闲模式配置
+#define POWER_IDLE_ENABLED false         // 默认关闭（市电供电）；电池/太阳能设备建议开启，也可用 POST /api/power 开启
+#define POWER_IDLE_ENTER_AFTER_MS 60000  // 无运动、无观看多久后进入空闲
+#define POWER_IDLE_FRAME_SIZE FRAMESIZE_QQVGA  // 空闲时的监视分辨率 160x120
+#define POWER_IDLE_DETECT_INTERVAL_MS 1000     // 空闲时检测间隔
+
+// 帧序列录制配置
+#define RECORD_DEFAULT_FRAMES 5          // 默认录制帧数（VGA 原始分辨率每帧 600KB）
+#define RECORD_MAX_FRAMES 300            // 最大录制帧数
+#define RECORD_DEFAULT_DECIMATION 1      // 默认不降采样，回放与实时检测看到相同的像素
+
+// 延时摄影配置（批次暂存在 LittleFS，满批或超时后整批上传）
+#define TIMELAPSE_DEFAULT_INTERVAL_SEC 300     // 拍摄间隔
+#define TIMELAPSE_DEFAULT_BATCH_FRAMES 8       // 每批帧数
+#define TIMELAPSE_DEFAULT_BATCH_AGE_SEC 3600   // 批次最长等待时间
+#define TIMELAPSE_MAX_BATCH_FRAMES 100         // 不超过 Tablestore BatchWriteRow 上限
+#define TIMELAPSE_FRAME_BYTES (32 * 1024)      // 单帧预算：RGB565 编码的 VGA 帧约 10-20KB，传感器 JPEG 约 30-45KB
+// 单批字节上限，按默认帧数留足，批次通常因帧数封装；待传 + 正在写入共两批 512KB，与短片一起放在 896KB 的 LittleFS
+#define TIMELAPSE_BATCH_MAX_BYTES (TIMELAPSE_DEFAULT_BATCH_FRAMES * TIMELAPSE_FRAME_BYTES)
+#define TIMELAPSE_JPEG_QUALITY 12
+#define TIMELAPSE_RETRY_MIN_MS 30000           // 上传失败后的首次重试间隔，之后翻倍
+#define TIMELAPSE_RETRY_MAX_MS (10 * 60 * 1000)
+
+// RTSP 服务（RTP/JPEG，供 NVR 拉流）
+#define RTSP_ENABLED true
+#define RTSP_PORT 554
+#define RTSP_RTP_PORT 5004               // UDP 传输的服务端 RTP 端口
+#define RTSP_MAX_SESSIONS 3              // 每个会话发送时都要分包一次
+#define RTSP_FRAME_INTERVAL_MS (1000 / STREAM_FPS)  // 推流帧间隔，受采集任务帧率限制
+#define RTSP_JPEG_QUALITY 12
+#define RTSP_RTP_PACKET_SIZE 1400        // RTP 包上限（含 RTP 头），低于以太网 MTU
+#define RTSP_REQUEST_MAX 1024            // 单条 RTSP 请求上限
+#define RTSP_SEND_TIMEOUT_MS 500         // TCP 发送超时，超时的会话断开
+#define RTSP_POLL_MS 20                  // RTSP 任务等待请求的时长，也是帧提交后的最大发送延迟
+
+// 带宽仲裁（实时预览优先，后台上传以令牌桶限速，只用剩余带宽）
+#define BW_ARBITER_ENABLED true
+#define BW_SAMPLE_MS 250                 // 吞吐采样周期
+#define BW_VIEWER_IDLE_MS 3000           // 超过该时间没有 /stream 请求或 RTSP 播放视为无人观看
+#define BW_LIVE_HEADROOM_PCT 50          // 在测得的实时流吞吐之上预留的余量
+#define BW_LIVE_MIN_RESERVE_BPS (64 * 1024)   // 实时流的最低预留，也是观看开始时的预留
+#define BW_BACKGROUND_MIN_BPS (4 * 1024) // 有人观看时后台的最低配额，上传连接不致超时
+#define BW_MIN_LINK_BPS (32 * 1024)      // 链路估计下限
+#define BW_PROBE_BPS (8 * 1024)          // 后台用满配额且写入不阻塞时，每个采样周期上调的链路估计
+#define BW_CONGESTED_PCT 20              // 后台阻塞在 socket 写入的时间超过采样周期该比例视为链路饱和
+#define BW_BUCKET_BYTES 4096             // 令牌桶深度，也是后台单次写入的上限
+#define BW_PACE_POLL_MS 10               // 后台等待令牌时的轮询间隔
 
 // WiFi 配置
 #define WIFI_TIMEOUT_MS 30000
 #define WIFI_RECONNECT_INTERVAL_MS 5000
 
+// 调度器配置
+#define SCHEDULER_MAX_TIMERS 16
+#define SCHEDULER_MAX_HANDLERS 16
+#define WDT_FEED_INTERVAL_MS 5000        // 看门狗喂狗间隔（超时 10 秒）
+
 // 任务优先级
 #define TASK_CAPTURE_PRIORITY 2
 #define TASK_DETECT_PRIORITY 2
 #define TASK_SERVER_PRIORITY 1
+#define TASK_UPLOAD_PRIORITY 1
+#define TASK_RTSP_PRIORITY 1
+#define TASK_ANALYSIS_PRIORITY 2         // 与采集任务相同，fork-join 期间两边同时推进
+
+// 帧分析并行：采集任务（ARDUINO_RUNNING_CORE）与另一个核上的辅助任务按行带分摊
+// 运动检测网格、运动估计建平面/块匹配和连拍清晰度评分
+#define PARALLEL_ANALYSIS_ENABLED true
+#define PARALLEL_HELPER_CORE 0
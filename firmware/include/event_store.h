@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+#include "ring_store.h"
+
+// 运动事件索引记录（16 字节，定长）
+#pragma pack(push, 1)
+struct EventRecord {
+    uint32_t timestamp;   // Unix 时间（秒）；未对时时为单调递增的开机时间
+    uint16_t score;       // 运动分数（变化网格数）
+    uint16_t flags;
+    uint32_t offset;      // 数据在逻辑日志中的偏移，同时作为事件 ID
+    uint32_t length;      // 图像字节数
+};
+#pragma pack(pop)
+
+struct EventStoreStats {
+    uint32_t events;
+    uint32_t oldestTimestamp; // 最旧、最新事件的时间（没有事件时为 0），两者之差即当前保留的时长
+    uint32_t newestTimestamp;
+    uint32_t bytesUsed;
+    uint32_t capacity;
+    uint32_t sectorErases;
+    uint32_t wearLaps;
+    uint32_t corruptRecords;
+};
+
+// 事件分区（partitions.csv 中的 EVENT_PARTITION_LABEL）上的环形事件日志
+// 图像作为带 CRC 的记录追加到 RingStore，写满后按扇区回收最旧的事件
+// 索引常驻内存，启动时由 RingStore 扫描分区重建，按时间有序，可二分查找
+class EventStore {
+public:
+    bool begin();
+
+    // 追加一条事件（JPEG 图像），回收的旧事件同时移出索引
+    bool append(uint32_t timestamp, uint16_t score, const uint8_t* data, size_t length);
+
+    // 查询 [since, until] 区间内的事件，按时间升序
+    // @param skip 跳过前 skip 条（分页）
+    // @return 写入 out 的条数；total 返回区间内总条数
+    size_t query(uint32_t since, uint32_t until, size_t skip,
+                 EventRecord* out, size_t maxCount, size_t* total);
+
+    bool find(uint32_t id, EventRecord& record);
+
+    // 从分区映射中拷贝事件图像的 [pos, pos + len)，事件已被回收时返回 0
+    size_t readImage(const EventRecord& record, size_t pos, uint8_t* buffer, size_t len);
+
+    // 生成事件时间戳，保证不小于上一条
+    uint32_t now();
+
+    EventStoreStats getStats();
+
+private:
+    RingStore ring;
+    EventRecord index[EVENT_INDEX_CAPACITY];
+    size_t head = 0;          // 最旧记录位置
+    size_t count = 0;
+    SemaphoreHandle_t mutex = nullptr;
+
+    const EventRecord& at(size_t i) const { return index[(head + i) % EVENT_INDEX_CAPACITY]; }
+    size_t lowerBound(uint32_t timestamp) const;
+    size_t upperBound(uint32_t timestamp) const;
+
+    void push(const EventRecord& record);
+    void dropOldest();
+};
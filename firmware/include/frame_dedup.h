@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+struct FrameDedupStats {
+    uint32_t candidates;      // 送检的事件帧
+    uint32_t suppressed;      // 与近期上传帧相似而被丢弃
+    uint8_t lastDistance;     // 最近一次送检与最相似记录的汉明距离（无记录时为 64）
+    uint8_t maxDistance;
+};
+
+// 事件帧感知哈希去重
+// 哈希取自 MotionDetector 的亮度网格（dHash），与最近放行的 DEDUP_HISTORY_SIZE 帧比较，
+// 汉明距离不超过阈值且记录未超过 DEDUP_WINDOW_MS 时判为重复
+class FrameDeduplicator {
+public:
+    // @return true 表示新画面（已记入历史），false 表示重复应丢弃
+    bool check(uint64_t hash, uint32_t nowMs);
+
+    void setMaxDistance(uint8_t distance);
+    FrameDedupStats getStats();
+
+    static uint8_t distance(uint64_t a, uint64_t b) { return __builtin_popcountll(a ^ b); }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        uint32_t timeMs;
+    };
+
+    Entry history[DEDUP_HISTORY_SIZE] = {};
+    uint8_t count = 0;
+    uint8_t next = 0;
+    uint8_t maxDistance = DEDUP_MAX_DISTANCE;
+    FrameDedupStats stats = {};
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
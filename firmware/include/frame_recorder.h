@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_camera.h>
+#include <memory>
+#include "frame_recording.h"
+
+// 从实时采集流水线录制短帧序列（.mcfr 格式），用于离线复现误报
+class FrameRecorder {
+public:
+    enum State {
+        IDLE,
+        RECORDING,
+        COMPLETE
+    };
+
+    bool begin();
+
+    // 开始录制，缓冲区在 PSRAM 中一次性分配
+    // @param frames 帧数
+    // @param decimation 降采样倍数（1 = 传感器原始分辨率）
+    bool start(uint16_t frames, uint8_t decimation, camera_fb_t* reference);
+
+    // 由采集任务在每帧运动检测后调用
+    void addFrame(camera_fb_t* fb, bool liveMotion);
+
+    State getState() const { return state; }
+    uint32_t getRecordedFrames() const { return recordedFrames; }
+    uint32_t getTotalFrames() const { return totalFrames; }
+
+    // 录制完成后的完整文件，未完成时返回空；调用者持有引用期间缓冲区不会被释放
+    std::shared_ptr<uint8_t> getCompleted(size_t& size);
+    size_t getSize() const { return size; }
+
+private:
+    volatile State state = IDLE;
+    std::shared_ptr<uint8_t> data;
+    size_t size = 0;
+    uint32_t totalFrames = 0;
+    volatile uint32_t recordedFrames = 0;
+    uint8_t decimation = 1;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint32_t* scratch = nullptr;
+    SemaphoreHandle_t mutex = nullptr;     // start/addFrame（采集任务）与取出录音（HTTP）互斥
+
+    void abort();
+};
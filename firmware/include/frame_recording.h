@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// 原始帧序列容器格式 (.mcfr)
+// 设备端录制，主机端 tools/motion_replay 回放
+//
+// 布局（小端）：
+//   RecordingHeader
+//   重复 frameCount 次：RecordingFrameHeader + length 字节像素数据
+//
+// 像素数据与传感器输出一致（RGB565 大端），可能按 decimation 降采样
+
+static const char RECORDING_MAGIC[4] = {'M', 'C', 'F', 'R'};
+static const uint16_t RECORDING_VERSION = 1;
+
+// 帧标志
+static const uint8_t RECORDING_FLAG_LIVE_MOTION = 0x01;  // 录制时设备判定为运动
+
+#pragma pack(push, 1)
+struct RecordingHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;     // sizeof(RecordingHeader)，便于以后扩展
+    uint16_t width;          // 存储帧宽度
+    uint16_t height;         // 存储帧高度
+    uint8_t pixformat;       // pixformat_t
+    uint8_t framesize;       // 传感器 framesize_t
+    uint8_t decimation;      // 相对传感器分辨率的降采样倍数
+    uint8_t reserved;
+    uint32_t frameCount;
+    uint32_t frameBytes;     // 每帧像素字节数
+};
+
+struct RecordingFrameHeader {
+    uint32_t timestampMs;    // 传感器时间戳（毫秒）
+    uint32_t length;         // 后续像素字节数
+    uint8_t flags;           // RECORDING_FLAG_*
+    uint8_t reserved[3];
+};
+#pragma pack(pop)
+
+inline void initRecordingHeader(RecordingHeader& header) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.version = RECORDING_VERSION;
+    header.headerSize = sizeof(RecordingHeader);
+}
+
+inline bool isValidRecordingHeader(const RecordingHeader& header) {
+    return memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) == 0 &&
+           header.version == RECORDING_VERSION &&
+           header.headerSize >= sizeof(RecordingHeader);
+}
+
+inline size_t recordingSize(uint32_t frameCount, uint32_t frameBytes) {
+    return sizeof(RecordingHeader) +
+           (size_t)frameCount * (sizeof(RecordingFrameHeader) + frameBytes);
+}
@@ -6,25 +6,85 @@
 #include "camera.h"
 #include "provisioning_manager.h"
 #include "wifi_scanner.h"
+#include "frame_recorder.h"
+#include "power_manager.h"
+#include "event_store.h"
+#include "timelapse_recorder.h"
+#include "https_pool.h"
+#include "motion_uploader.h"
+#include "frame_dedup.h"
+#include "motion_estimator.h"
+#include "motion_event.h"
+#include "motion_detector.h"
+#include "burst_selector.h"
+#include "rtsp_server.h"
+#include "clip_recorder.h"
 
 class HTTPServer {
 private:
     AsyncWebServer server = AsyncWebServer(HTTP_PORT);
     camera_fb_t* currentFb = nullptr;
+    FrameTrace currentTrace = {};   // 发布时的帧时间戳，与 currentFb 同一帧
+    // 请求读取当前帧期间持有，采集任务换帧时持有，保证读到的帧不会中途被驱动改写
+    SemaphoreHandle_t frameMutex = nullptr;
 
     // 新增：依赖注入
+    Camera* camera = nullptr;
     ProvisioningManager* provManager = nullptr;
     WiFiScanner* wifiScanner = nullptr;
+    FrameRecorder* frameRecorder = nullptr;
+    PowerManager* powerManager = nullptr;
+    EventStore* eventStore = nullptr;
+    TimelapseRecorder* timelapse = nullptr;
+    HttpsPool* httpsPool = nullptr;
+    MotionUploader* motionUploader = nullptr;
+    FrameDeduplicator* frameDedup = nullptr;
+    MotionEstimator* motionEstimator = nullptr;
+    MotionEventEngine* motionEvents = nullptr;
+    MotionDetector* motionDetector = nullptr;
+    BurstSelector* burstSelector = nullptr;
+    RtspServer* rtspServer = nullptr;
+    ClipRecorder* clipRecorder = nullptr;
 
 public:
     void begin();
+    // 采集任务换帧：lockFrame 之后 setBuffer 发布新帧，unlockFrame 之后才归还旧帧
+    void lockFrame();
+    void unlockFrame();
     void setBuffer(camera_fb_t* fb);
 
     // 新增：设置依赖
+    void setCamera(Camera* cam) { camera = cam; }
     void setProvisioningManager(ProvisioningManager* pm) { provManager = pm; }
     void setWiFiScanner(WiFiScanner* scanner) { wifiScanner = scanner; }
+    void setFrameRecorder(FrameRecorder* recorder) { frameRecorder = recorder; }
+    void setPowerManager(PowerManager* pm) { powerManager = pm; }
+    void setEventStore(EventStore* store) { eventStore = store; }
+    void setTimelapseRecorder(TimelapseRecorder* recorder) { timelapse = recorder; }
+    void setHttpsPool(HttpsPool* pool) { httpsPool = pool; }
+    void setMotionUploader(MotionUploader* uploader) { motionUploader = uploader; }
+    void setFrameDeduplicator(FrameDeduplicator* dedup) { frameDedup = dedup; }
+    void setMotionEstimator(MotionEstimator* estimator) { motionEstimator = estimator; }
+    void setMotionEventEngine(MotionEventEngine* engine) { motionEvents = engine; }
+    void setMotionDetector(MotionDetector* detector) { motionDetector = detector; }
+    void setBurstSelector(BurstSelector* selector) { burstSelector = selector; }
+    void setRtspServer(RtspServer* rtsp) { rtspServer = rtsp; }
+    void setClipRecorder(ClipRecorder* recorder) { clipRecorder = recorder; }
 
 private:
     void setupRoutes();
+    void setupCameraRoutes();
+    void setupRecordingRoutes();
+    void setupPowerRoutes();
+    void setupEventRoutes();
+    void handleEventImage(AsyncWebServerRequest* request);
+    void setupClipRoutes();
+    void handleClipFile(AsyncWebServerRequest* request);
+    void setupTimelapseRoutes();
+    void setupHttpsRoutes();
+    void setupRtspRoutes();
+    void setupMotionRoutes();
+    void setupTripwireRoutes();
     void setupProvisioningRoutes();
+    void handleSnapshot(AsyncWebServerRequest* request);
 };
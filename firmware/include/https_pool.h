@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "tls_transport.h"
+
+// 请求体按块写出；写失败返回 false
+typedef std::function<bool(const uint8_t* data, size_t len)> HttpsWriteFn;
+// 请求体生成回调：连接失效重试时会再调用一次，必须可重放
+typedef std::function<bool(const HttpsWriteFn& write)> HttpsBodyWriter;
+
+// 错误码（request 返回负数）
+enum HttpsError {
+    HTTPS_ERR_CONNECT = -1,
+    HTTPS_ERR_SEND = -2,
+    HTTPS_ERR_RESPONSE = -3,
+    HTTPS_ERR_POOL_BUSY = -4
+};
+
+struct HttpsPoolConfig {
+    uint32_t keepAliveIdleMs = HTTPS_KEEPALIVE_IDLE_MS;   // 0 表示每次请求后关闭连接
+    bool sessionCache = true;                             // 缓存会话票据
+    uint32_t sessionMaxAgeMs = HTTPS_SESSION_MAX_AGE_MS;
+    uint32_t ioTimeoutMs = HTTPS_IO_TIMEOUT_MS;
+};
+
+struct HttpsPoolStats {
+    uint32_t requests;
+    uint32_t reusedRequests;       // 在已有 keep-alive 连接上发送的请求
+    uint32_t fullHandshakes;
+    uint32_t resumedHandshakes;
+    uint32_t fullHandshakeMs;      // 累计握手耗时（含 TCP 建连）
+    uint32_t resumedHandshakeMs;
+    uint32_t staleRetries;         // 复用的连接已被服务器关闭，换新连接重发
+    uint32_t failures;
+    uint8_t openConnections;
+};
+
+// HTTPS 连接池
+// 每个主机保持 keep-alive 连接（共 HTTPS_POOL_MAX_CONNECTIONS 条），空闲超时后关闭；
+// 连接关闭后保留会话票据，下次握手走会话恢复
+class HttpsPool {
+public:
+    explicit HttpsPool(TlsTransportFactory factory, const HttpsPoolConfig& config = HttpsPoolConfig())
+        : factory(factory), config(config) {}
+    ~HttpsPool();
+
+    // 发送请求并读取响应
+    // @param extraHeaders 附加请求头（每行以 \r\n 结尾），可为 nullptr
+    // @param response 可选，保存响应体（最多 HTTPS_RESPONSE_MAX_BYTES，超出部分丢弃）
+    // @return HTTP 状态码；失败返回 HttpsError
+    int request(const char* host, uint16_t port, const char* method, const char* path,
+                const char* extraHeaders, const char* contentType, size_t contentLength,
+                const HttpsBodyWriter& body, std::string* response = nullptr);
+
+    // 关闭空闲超时的连接（由调度器定时调用）
+    void closeIdle();
+    void closeAll();
+
+    HttpsPoolStats getStats();
+
+private:
+    struct Connection {
+        TlsTransport* transport = nullptr;
+        std::string host;
+        uint16_t port = 0;
+        bool inUse = false;
+        uint32_t lastUsedMs = 0;
+        // 读缓冲
+        uint8_t rx[512];
+        size_t rxStart = 0;
+        size_t rxEnd = 0;
+        // 写缓冲，合并小块写入，减少 TLS 记录数
+        uint8_t tx[1024];
+        size_t txLen = 0;
+    };
+
+    struct CachedSession {
+        std::string host;
+        uint16_t port = 0;
+        std::vector<uint8_t> data;
+        uint32_t savedMs = 0;
+    };
+
+    TlsTransportFactory factory;
+    HttpsPoolConfig config;
+    std::mutex mutex;
+    Connection connections[HTTPS_POOL_MAX_CONNECTIONS];
+    CachedSession sessions[HTTPS_SESSION_CACHE_SIZE];
+    HttpsPoolStats stats = {};
+
+    Connection* acquire(const char* host, uint16_t port, bool& reused, int& error);
+    void release(Connection* conn, bool keepAlive);
+    void closeConnection(Connection* conn);
+    bool open(Connection* conn, const char* host, uint16_t port);
+
+    CachedSession* findSession(const char* host, uint16_t port);
+    void storeSession(const char* host, uint16_t port, TlsTransport* transport);
+
+    // @return 状态码，发送阶段失败返回 HTTPS_ERR_SEND，未收到响应返回 HTTPS_ERR_RESPONSE
+    int exchange(Connection* conn, const char* host, const char* method, const char* path,
+                 const char* extraHeaders, const char* contentType, size_t contentLength,
+                 const HttpsBodyWriter& body, std::string* response, bool& keepAlive,
+                 bool& gotResponse);
+
+    bool send(Connection* conn, const uint8_t* data, size_t len);
+    bool flush(Connection* conn);
+    int readByte(Connection* conn);
+    bool readLine(Connection* conn, char* line, size_t size);
+    bool readBody(Connection* conn, size_t length, std::string* response);
+};
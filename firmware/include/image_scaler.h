@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 裁剪区域（源图像坐标）
+struct CropRect {
+    int x;
+    int y;
+    int width;
+    int height;
+
+    CropRect() : x(0), y(0), width(0), height(0) {}
+    CropRect(int x, int y, int w, int h) : x(x), y(y), width(w), height(h) {}
+};
+
+// 面积平均缩放器
+// 直接从 RGB565 帧读取，按输出行累加，不产生全尺寸中间缓冲区
+class ImageScaler {
+public:
+    // 传感器输出的 RGB565 为大端字节序（高字节在前），所有按像素读取 RGB565 帧的代码都经过这里
+    static inline uint16_t loadRGB565(const uint8_t* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+    // 将裁剪区域限制在源图像范围内，返回区域是否有效
+    static bool clampCrop(CropRect& crop, int srcWidth, int srcHeight);
+
+    // 根据裁剪区域计算输出尺寸：只给一边时按比例推算，不放大
+    static void fitOutputSize(const CropRect& crop, int& outWidth, int& outHeight);
+
+    // 缩放所需的累加器大小（字节），调用者负责分配
+    static size_t scratchSize(int outWidth) { return (size_t)outWidth * 3 * sizeof(uint32_t); }
+
+    // RGB565 (传感器字节序) -> RGB565，面积平均
+    // @param src 源帧像素
+    // @param srcWidth 源帧宽度（行跨度）
+    // @param crop 已经过 clampCrop 的裁剪区域
+    // @param dst 输出缓冲区，outWidth * outHeight * 2 字节
+    // @param scratch 累加器，scratchSize(outWidth) 字节
+    static void scaleRGB565(const uint8_t* src, int srcWidth, const CropRect& crop,
+                            uint8_t* dst, int outWidth, int outHeight, uint32_t* scratch);
+
+    // RGB565 -> 8 位灰度，面积平均（运动检测、感知哈希等分析用）
+    static void scaleRGB565ToGray(const uint8_t* src, int srcWidth, const CropRect& crop,
+                                  uint8_t* dst, int outWidth, int outHeight, uint32_t* scratch);
+    // 只输出 [rowBegin, rowEnd) 行，各行独立，可分给多个核（每个核一份 scratch，outWidth 个 uint32_t）
+    static void scaleRGB565ToGrayRows(const uint8_t* src, int srcWidth, const CropRect& crop,
+                                      uint8_t* dst, int outWidth, int outHeight,
+                                      int rowBegin, int rowEnd, uint32_t* scratch);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+
+// 基线 JPEG 的 1/8 亮度图：只做熵解码，取每个 8x8 亮度块的 DC 系数（反量化后即块平均亮度），
+// AC 系数按 Huffman 码长跳过，不做 IDCT 和颜色转换
+// 支持任意采样因子（4:2:2、4:2:0、4:4:4、灰度）、重启标记、缺省 DHT（使用标准表）
+
+#define JPEG_DC_MAX_COMPONENTS 4
+#define JPEG_DC_LOOKUP_BITS 9     // Huffman 查表位数，更长的码字逐个码长比较
+
+struct JpegDcInfo {
+    uint16_t width;
+    uint16_t height;
+    uint16_t blocksWide;          // 覆盖图像的亮度块数（不含 MCU 填充块）
+    uint16_t blocksHigh;
+    uint8_t components;
+    uint8_t lumaH;                // 亮度采样因子，4:2:2 为 2x1，4:2:0 为 2x2
+    uint8_t lumaV;
+    uint16_t restartInterval;     // 每多少个 MCU 一个重启标记，0 表示没有
+};
+
+// 每个亮度块调用一次，按熵编码顺序（同一 MCU 内的块先行后列）
+// @param luma 块平均亮度 0-255
+typedef void (*JpegDcBlockFn)(void* arg, uint16_t bx, uint16_t by, uint8_t luma);
+
+class JpegDcDecoder {
+public:
+    // 解析文件头并解码第一个包含亮度分量的扫描
+    // @return 渐进式/算术编码/12 位精度、缺少量化表或数据损坏时返回 false（可能已回调部分块）
+    bool decode(const uint8_t* jpeg, size_t len, JpegDcBlockFn onBlock, void* arg);
+
+    // 最近一次 decode 解析到的帧信息（回调期间已有效）
+    const JpegDcInfo& info() const { return frame; }
+
+private:
+    struct HuffTable {
+        uint16_t lookup[1 << JPEG_DC_LOOKUP_BITS];  // (跳过位数 << 8) | 符号，0 表示码长超过查表位数
+        int32_t maxCode[17];      // 各码长的最大码字，-1 表示没有该码长
+        int32_t valOffset[17];    // 码字 + valOffset[码长] = symbols 下标
+        uint8_t symbols[256];
+        bool defined;
+    };
+
+    struct Component {
+        uint8_t id;
+        uint8_t h;
+        uint8_t v;
+        uint8_t tq;
+    };
+
+    struct ScanComponent {
+        uint8_t index;            // components 下标
+        uint8_t td;               // DC 表
+        uint8_t ta;               // AC 表
+    };
+
+    JpegDcInfo frame = {};
+    Component components[JPEG_DC_MAX_COMPONENTS] = {};
+    ScanComponent scan[JPEG_DC_MAX_COMPONENTS] = {};
+    uint8_t scanCount = 0;
+    uint16_t quantDc[4] = {};     // 各量化表的 DC 步长，0 表示未定义
+    HuffTable dcTables[2];
+    HuffTable acTables[2];
+
+    const uint8_t* parseHeaders(const uint8_t* jpeg, size_t len);
+    bool parseFrame(const uint8_t* seg, size_t len);
+    bool parseScan(const uint8_t* seg, size_t len);
+    bool parseHuffman(const uint8_t* seg, size_t len);
+    bool parseQuant(const uint8_t* seg, size_t len);
+    bool decodeScan(const uint8_t* data, const uint8_t* end, JpegDcBlockFn onBlock, void* arg);
+    static bool buildTable(HuffTable& table, const uint8_t* counts, const uint8_t* symbols, bool ac);
+};
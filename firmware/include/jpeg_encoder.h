@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_camera.h>
+
+// 将像素数据编码为 JPEG，写入调用者提供的缓冲区（通常来自 BufferPool）
+class JpegEncoder {
+public:
+    // @return JPEG 字节数；编码失败或超出 capacity 时返回 0
+    static size_t encode(const uint8_t* pixels, int width, int height, pixformat_t format,
+                         int quality, uint8_t* out, size_t capacity);
+
+    // 编码整帧；传感器已输出 JPEG 时直接拷贝（quality 不起作用）
+    static size_t encodeFrame(const camera_fb_t* fb, int quality, uint8_t* out, size_t capacity);
+
+    // encodeFrame 输出缓冲区的申请大小：JPEG 通常不到原始像素的 1/10，按 1/4 帧申请（缓冲池的中槽，
+    // 整帧槽留给 /stream 和帧拷贝）；传感器 JPEG 按原长
+    static size_t frameOutputSize(const camera_fb_t* fb) {
+        return fb->format == PIXFORMAT_JPEG ? fb->len : fb->len / 4;
+    }
+};
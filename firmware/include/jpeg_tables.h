@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Arduino.h>
+
+// JPEG 标准 Huffman 表（ITU T.81 K.3）：esp32-camera 与 libjpeg 的默认输出都使用这组表
+// BITS 为码长 1-16 的码字个数，VALUES 为按码字顺序排列的符号
+extern const uint8_t JPEG_DC_LUMA_BITS[16];
+extern const uint8_t JPEG_DC_CHROMA_BITS[16];
+extern const uint8_t JPEG_DC_VALUES[12];
+
+extern const uint8_t JPEG_AC_LUMA_BITS[16];
+extern const uint8_t JPEG_AC_LUMA_VALUES[162];
+extern const uint8_t JPEG_AC_CHROMA_BITS[16];
+extern const uint8_t JPEG_AC_CHROMA_VALUES[162];
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+// 帧的时间戳（esp_timer 微秒，开机起单调递增），0 表示该阶段尚未发生
+struct FrameTrace {
+    uint32_t seq;             // capture() 交出的帧序号
+    int64_t sensorUs;         // 驱动写入的 fb->timestamp（帧数据接收完成）
+    int64_t capturedUs;       // capture() 取到帧
+    int64_t analyzedUs;       // 采集任务完成运动检测和运动估计
+};
+
+// 延迟阶段：前两段每帧记录一次（采集任务），其余每个帧响应记录一次
+enum LatencyStage : uint8_t {
+    LATENCY_CAPTURE,          // sensor → captured：帧在驱动队列中的时间
+    LATENCY_ANALYSIS,         // captured → analyzed
+    LATENCY_WAIT,             // analyzed → 开始编码：帧等待请求
+    LATENCY_ENCODE,           // 开始编码 → 编码完成（BMP 拷贝、缩放或 JPEG 编码）
+    LATENCY_FIRST_BYTE,       // 编码完成 → 第一个字节交给 TCP
+    LATENCY_SEND,             // 第一个字节 → 最后一个字节交给 TCP
+    LATENCY_TOTAL,            // sensor → 最后一个字节
+    LATENCY_STAGE_COUNT
+};
+
+// 对数分桶：64 us 以下一个桶，之后 20 个 2 倍区间各分 4 个桶，另有一个溢出桶收纳 2^26 us（约 67 秒）以上
+static const uint8_t LATENCY_BUCKETS = 1 + 20 * 4 + 1;
+
+struct LatencyHistogram {
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t buckets[LATENCY_BUCKETS];
+};
+
+// 各阶段延迟直方图，所有任务可记录
+class LatencyTracer {
+public:
+    // from 或 to 为 0（阶段未发生）时不记录
+    void record(LatencyStage stage, int64_t fromUs, int64_t toUs);
+    LatencyHistogram getHistogram(LatencyStage stage);
+    void reset();
+
+    // 按桶上界估计分位数（p 为 0-100），不超过记录的最大值
+    static uint32_t percentile(const LatencyHistogram& h, float p);
+    static const char* stageName(LatencyStage stage);
+
+private:
+    LatencyHistogram histograms[LATENCY_STAGE_COUNT] = {};
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    static uint8_t bucketIndex(uint32_t us);
+    static uint32_t bucketUpperBound(uint8_t index);
+};
+
+extern LatencyTracer latencyTracer;
@@ -3,20 +3,45 @@
 
 #include <Arduino.h>
 #include <esp_camera.h>
+#include "config.h"
+#include "image_scaler.h"
+#include "jpeg_dc.h"
 
 class MotionDetector {
 public:
     bool init();
     bool detect(camera_fb_t* fb);
+    // 丢弃上一帧基准，下一帧只用于建立基准（分辨率切换后调用）
+    void reset();
     void setThreshold(uint8_t threshold);
     void setTriggerCount(uint8_t count);
+    // 最近一帧变化的网格数（运动分数）
+    uint8_t getLastScore() const { return lastScore; }
+    // 最近一帧亮度网格的差分哈希（dHash）：每行相邻网格比较，共 ROWS*(COLS-1) 位
+    uint64_t getFrameHash() const { return lastHash; }
+    // 最近一帧变化网格的外接矩形（像素坐标），四周各扩展 padding 像素并按 8 对齐
+    // @return 没有变化网格时返回 false
+    bool getMotionBox(int frameWidth, int frameHeight, int padding, CropRect& box) const;
+    // JPEG 帧熵解码失败的次数（该帧不参与检测，基准保持不变）
+    uint32_t getDecodeErrors() const { return decodeErrors; }
 
 private:
     uint8_t prevGrid[MOTION_GRID_ROWS * MOTION_GRID_COLS] = {0};
     bool initialized = false;
+    bool hasBaseline = false;
+    uint8_t lastScore = 0;
+    uint64_t lastHash = 0;
+    // 变化网格的外接范围（网格坐标，闭区间），lastScore 为 0 时无效
+    uint8_t changedRowMin = 0, changedRowMax = 0;
+    uint8_t changedColMin = 0, changedColMax = 0;
     uint8_t threshold = MOTION_THRESHOLD;
     uint8_t triggerCount = MOTION_TRIGGER_COUNT;
+    JpegDcDecoder dcDecoder;
+    uint32_t decodeErrors = 0;
 
-    void processGrid(camera_fb_t* fb, uint8_t* grid);
+    bool processGrid(camera_fb_t* fb, uint8_t* grid);
+    // JPEG 帧：网格亮度取自 8x8 块的 DC 系数
+    bool processJpegGrid(camera_fb_t* fb, uint8_t* grid);
     bool compareGrids(const uint8_t* grid1, const uint8_t* grid2);
+    static uint64_t hashGrid(const uint8_t* grid);
 };
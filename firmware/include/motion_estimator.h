@@ -0,0 +1,119 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_camera.h>
+#include "config.h"
+#include "parallel.h"
+
+// 块运动矢量：该块内容从上一帧到当前帧的位移（亮度平面像素）
+struct MotionVector {
+    int8_t dx;
+    int8_t dy;
+    uint16_t sad;        // 最佳匹配的绝对差之和
+};
+
+enum TripwireDirection : uint8_t {
+    TRIPWIRE_BOTH,
+    TRIPWIRE_FORWARD,    // 从 A→B 的左手侧穿到右手侧（图像坐标，y 向下）
+    TRIPWIRE_BACKWARD,
+};
+
+inline const char* tripwireDirectionName(TripwireDirection dir) {
+    return dir == TRIPWIRE_FORWARD ? "forward" : dir == TRIPWIRE_BACKWARD ? "backward" : "both";
+}
+
+// @return 无法识别时返回 false
+inline bool parseTripwireDirection(const char* name, TripwireDirection& dir) {
+    if (strcmp(name, "both") == 0) dir = TRIPWIRE_BOTH;
+    else if (strcmp(name, "forward") == 0) dir = TRIPWIRE_FORWARD;
+    else if (strcmp(name, "backward") == 0) dir = TRIPWIRE_BACKWARD;
+    else return false;
+    return true;
+}
+
+// 绊线：线段 A-B，坐标为画面宽高的千分比，与分辨率无关
+struct Tripwire {
+    char name[16];
+    uint16_t x0, y0, x1, y1;
+    TripwireDirection direction;
+};
+
+struct TripwireStatus {
+    uint32_t crossings;
+    uint32_t lastCrossMs;
+    TripwireDirection lastDirection;
+};
+
+struct MotionEstimatorStats {
+    uint32_t frames;          // 做过块匹配的帧
+    uint32_t searchedBlocks;  // 累计搜索的块（其余块零位移 SAD 过小，直接视为静止）
+    uint32_t globalMotionFrames;  // 大部分块都在动而忽略的帧
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint16_t movingBlocks;    // 最近一帧非零矢量的块数
+};
+
+// 块匹配运动估计与绊线
+// 分析帧缩小为 MV_PLANE_WIDTH x MV_PLANE_HEIGHT 的亮度平面，按 MV_BLOCK_SIZE 分块，
+// 在上一帧 ±MV_SEARCH_RANGE 窗口内全搜索最小 SAD 得到每块的运动矢量。
+// 矢量经过绊线附近且法向分量方向符合配置时计为越线，同方向块数达到阈值触发
+class MotionEstimator {
+public:
+    static const int BLOCK_COLS = MV_PLANE_WIDTH / MV_BLOCK_SIZE;
+    static const int BLOCK_ROWS = MV_PLANE_HEIGHT / MV_BLOCK_SIZE;
+
+    // 处理一帧（采集任务调用），零位移 SAD 很小的块不搜索，静止画面开销只有建平面
+    // @param nowMs 帧时间，用于绊线冷却
+    // @return 本帧触发的绊线位掩码（第 i 位对应 getTripwires 中的第 i 条）
+    uint32_t process(camera_fb_t* fb, uint32_t nowMs);
+    // 丢弃参考平面（分辨率切换后调用）
+    void reset();
+
+    bool hasTripwires() const { return tripwireCount > 0; }
+    // 按名称新增或替换
+    bool setTripwire(const Tripwire& tripwire);
+    bool removeTripwire(const char* name);
+    uint8_t getTripwires(Tripwire* out, TripwireStatus* status, uint8_t max);
+
+    // 从 LittleFS 载入/保存绊线配置
+    void loadTripwires();
+    bool saveTripwires();
+
+    // 复制最近一帧的运动矢量（BLOCK_COLS * BLOCK_ROWS 个，按行排列）
+    void getVectors(MotionVector* out);
+    MotionEstimatorStats getStats();
+
+    // 8 位灰度块的绝对差之和，超过 limit 后提前返回
+    // 向量实现按 16 字节对齐块读取，每行起点之后 32 字节内须可读（planes 末尾留有余量）
+    static uint32_t blockSad(const uint8_t* a, const uint8_t* b, int stride, uint32_t limit);
+
+private:
+    // 向量 SAD 按 16 字节对齐块加载，行尾之后最多多读 32 字节
+    static const size_t PLANE_BYTES = MV_PLANE_WIDTH * MV_PLANE_HEIGHT + 32;
+    alignas(16) uint8_t planes[2][PLANE_BYTES];
+    uint32_t scratch[ParallelRunner::WORKERS][MV_PLANE_WIDTH];  // 每个核一份缩放累加器
+    uint8_t current = 0;
+    bool hasReference = false;
+
+    MotionVector vectors[BLOCK_COLS * BLOCK_ROWS] = {};
+    MotionVector published[BLOCK_COLS * BLOCK_ROWS] = {};
+
+    Tripwire tripwires[MV_MAX_TRIPWIRES] = {};
+    TripwireStatus status[MV_MAX_TRIPWIRES] = {};
+    // 触发后线附近仍有越线块，等一帧没有越线块后才重新布防（慢速目标只触发一次）
+    bool busy[MV_MAX_TRIPWIRES] = {};
+    uint8_t tripwireCount = 0;
+
+    MotionEstimatorStats stats = {};
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    void buildPlane(camera_fb_t* fb, uint8_t* plane);
+    uint16_t estimate(const uint8_t* cur, const uint8_t* ref);
+    // 一行块的匹配，返回非零矢量的块数，searched 累加搜索过的块数
+    uint16_t estimateRow(const uint8_t* cur, const uint8_t* ref, int br, uint32_t& searched);
+
+    static void planeRows(void* arg, uint8_t worker, int begin, int end);
+    static void blockRows(void* arg, uint8_t worker, int begin, int end);
+    uint32_t checkTripwires(uint32_t nowMs);
+};
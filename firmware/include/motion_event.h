@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+// MotionEventEngine::update 返回的位掩码
+enum MotionEventFlags : uint8_t {
+    MOTION_EVENT_STARTED = 1 << 0,    // 事件开始
+    MOTION_EVENT_PEAK = 1 << 1,       // 本帧是事件的新峰值帧，应替换待上传图像
+    MOTION_EVENT_ENDED = 1 << 2,      // 事件结束（lastEvent()），suppressed 为 false 时应上报
+    MOTION_EVENT_DISCARDED = 1 << 3,  // 事件结束但短于最小时长，丢弃待上传图像
+};
+
+// 合并后的运动事件
+struct MotionEvent {
+    uint32_t startMs;         // 第一帧运动（millis）
+    uint32_t endMs;           // 最后一帧运动
+    uint16_t motionFrames;    // 期间有运动的帧数
+    uint8_t peakScore;
+    bool truncated;           // 因超过最大时长而结束
+    bool suppressed;          // 冷却或限速期间开始、期满前没有转为上报的事件，只保存在本地
+};
+
+struct MotionEventStats {
+    uint32_t onsets;              // 逐帧检测的运动上升沿（未经状态机时每个都是一次事件）
+    uint32_t started;
+    uint32_t reported;
+    uint32_t discarded;           // 短于最小时长
+    uint32_t truncated;
+    uint32_t cooldownSuppressed;  // 冷却期内开始的事件数（期满前结束的不上报）
+    uint32_t rateSuppressed;      // 限速期间开始的事件数
+    bool active;
+    MotionEvent last;             // 最近上报的事件（reported 为 0 时无效）
+};
+
+// 运动事件状态机
+// 最近 N 帧中至少 K 帧有运动才开始事件；进行中按较低的保持分数判断运动（滞回），
+// 持续 EVENT_QUIET_MS 无运动后结束。事件结束时只上报一次（开始、结束、峰值分数），
+// 上报后冷却 EVENT_COOLDOWN_MS，并且 EVENT_RATE_WINDOW_MS 内最多上报 EVENT_RATE_LIMIT 个事件。
+// 冷却和限速只影响上报：期间的运动照常开始事件（本地保存），事件标记为 suppressed，
+// 期满时仍在运动则转为上报
+class MotionEventEngine {
+public:
+    // 每帧调用一次（采集任务）
+    // @param motion MotionDetector::detect 的结果
+    // @param score 变化网格数
+    // @return MotionEventFlags 位掩码
+    uint8_t update(bool motion, uint8_t score, uint32_t nowMs);
+
+    bool isActive() const { return active; }
+    // 当前（或刚结束的）事件不上报
+    bool isSuppressed() const { return event.suppressed; }
+    const MotionEvent& lastEvent() const { return event; }
+
+    MotionEventStats getStats();
+
+private:
+    uint32_t window = 0;          // 最近帧的运动位，最低位为当前帧
+    uint32_t frameTimes[EVENT_WINDOW_FRAMES] = {};  // 窗口内各帧的时间（环形，与 window 对应）
+    uint8_t framePos = 0;         // 当前帧在 frameTimes 中的位置
+    uint8_t windowPeak = 0;       // 窗口非空以来的最高分数
+    bool lastMotion = false;
+
+    bool active = false;
+    MotionEvent event = {};
+    uint8_t imageScore = 0;       // 待上传图像对应的分数
+    uint32_t imageMs = 0;
+
+    bool hasReported = false;
+    uint32_t lastReportMs = 0;
+    uint32_t reportTimes[EVENT_RATE_LIMIT] = {};  // 最近上报时间（环形）
+    uint8_t reportCount = 0;
+    uint8_t reportNext = 0;
+
+    MotionEventStats stats = {};
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    bool coolingDown(uint32_t nowMs) const;
+    bool rateLimited(uint32_t nowMs) const;
+    uint8_t finish(uint32_t nowMs, bool truncated);
+};
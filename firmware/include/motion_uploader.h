@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_camera.h>
+#include "config.h"
+#include "cloud_client.h"
+#include "image_scaler.h"
+#include "burst_selector.h"
+#include "motion_event.h"
+#include "clip_recorder.h"
+
+struct MotionUploadStats {
+    uint32_t events;          // 提交的事件（绊线事件和状态机合并的事件）
+    uint32_t uploaded;
+    uint32_t dropped;         // 队列满或编码失败
+    uint32_t failures;        // 上传失败（事件仍保存在本地事件日志）
+    uint32_t croppedEvents;   // 以裁剪图上传的事件（其余为整帧）
+    uint32_t bytesUploaded;   // 裁剪图 + 全景图
+    uint32_t fullFrameBytes;  // 同一批事件整帧 JPEG 的字节数，用于对照
+    uint32_t clipsUploaded;
+    uint32_t clipBytes;       // 短片字节数（不计入 bytesUploaded）
+    int lastStatus;
+};
+
+// 运动事件上传
+// 采集任务中把变化区域编码为全分辨率裁剪图，整帧缩小为低分辨率全景图，
+// 由上传任务以一个 multipart 请求发送到 /api/v1/images/upload，元数据带裁剪几何信息
+// 传感器输出 JPEG 时不裁剪，原样上传整帧
+// 事件带短片时，短片作为 "clip" 部分从 LittleFS 分块读出附在同一请求中，上传成功后删除
+class MotionUploader {
+public:
+    explicit MotionUploader(CloudClient& cloud) : cloud(cloud) {}
+
+    bool begin();
+
+    // 上传成功后由 recorder 删除短片
+    void setClipRecorder(ClipRecorder* recorder) { clips = recorder; }
+
+    // 编码并排队上传（采集任务中调用）
+    // @param box 变化区域（MotionDetector::getMotionBox）
+    // @param fullFrameBytes 同一帧整帧 JPEG 的大小，仅用于统计，未知时为 0
+    bool submit(camera_fb_t* fb, const CropRect& box, uint8_t score, size_t fullFrameBytes);
+
+    // 编码为进行中事件的待上传图像，替换之前保存的峰值帧（采集任务中调用）
+    // @param burst 连拍选出的帧附带选帧结果，未连拍时为 nullptr
+    bool hold(camera_fb_t* fb, const CropRect& box, uint8_t score, size_t fullFrameBytes,
+              const BurstSelection* burst);
+    // 事件结束：带上开始、结束和峰值分数排队上传待上传图像
+    // @param clip 事件短片，没有时为 nullptr
+    bool submitHeld(const MotionEvent& event, const ClipInfo* clip = nullptr);
+    // 事件被丢弃：释放待上传图像
+    void discardHeld();
+
+    MotionUploadStats getStats();
+
+private:
+    // 队列中的上传任务，缓冲区来自 BufferPool，由上传任务释放
+    struct Job {
+        uint8_t* crop;
+        size_t cropBytes;
+        uint8_t* context;         // 整帧上传时为 nullptr
+        size_t contextBytes;
+        CropRect box;
+        uint16_t frameWidth;
+        uint16_t frameHeight;
+        uint16_t contextWidth;
+        uint16_t contextHeight;
+        uint8_t score;
+        uint32_t timestamp;
+        uint32_t fullFrameBytes;
+        // 合并事件（绊线事件 hasEvent 为 false）
+        bool hasEvent;
+        bool truncated;
+        uint8_t peakScore;
+        uint16_t motionFrames;
+        uint32_t eventStart;      // Unix 时间，未对时时为 0
+        uint32_t durationMs;
+        bool hasBurst;
+        BurstSelection burst;
+        bool hasClip;
+        ClipInfo clip;
+    };
+
+    CloudClient& cloud;
+    ClipRecorder* clips = nullptr;
+    QueueHandle_t queue = nullptr;
+    portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+    MotionUploadStats stats = {};
+    Job held = {};            // 进行中事件的峰值帧，只由采集任务访问
+
+    bool encodeJob(camera_fb_t* fb, const CropRect& box, uint8_t score, size_t fullFrameBytes, Job& job);
+    void drop();
+    size_t encodeCrop(camera_fb_t* fb, const CropRect& box, uint8_t*& out);
+    size_t encodeContext(camera_fb_t* fb, int width, int height, uint8_t*& out);
+    static void releaseJob(Job& job);
+
+    static void uploadTaskEntry(void* parameter);
+    void uploadLoop();
+    int upload(const Job& job);
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+// 分段函数：处理 [begin, end) 的条目（通常是行带），worker 为执行者编号（0 为调用者）
+// 不同条目写不同的输出，或写 worker 自己的部分结果，由调用者在 run 返回后按 worker 顺序归约
+typedef void (*ParallelFn)(void* arg, uint8_t worker, int begin, int end);
+
+struct ParallelStats {
+    bool enabled;
+    uint32_t runs;            // 两个核一起执行的次数
+    uint32_t soloRuns;        // 已唤醒辅助任务，但它加入前调用者已做完全部条目
+    uint32_t inlineRuns;      // 未启用或条目不足两组时在调用者中顺序执行
+    uint32_t items;           // 分段执行（runs + soloRuns）的条目总数
+    uint32_t helperItems;     // 其中由辅助任务处理的条目
+};
+
+// 帧分析 fork-join
+// 调用者（采集任务）和固定在另一个核上的辅助任务按 grain 个条目一组动态领取，
+// 另一个核被 WiFi 等任务占用时调用者多做一些。各条目的结果与领取顺序无关，
+// 整数部分结果按 worker 顺序归约，输出与顺序执行完全相同
+// 同一时间只能有一个调用者
+class ParallelRunner {
+public:
+    static const uint8_t WORKERS = 2;
+
+    // 创建固定在 helperCore 上的辅助任务
+    bool begin(BaseType_t helperCore);
+    // 执行 count 个条目，全部完成后返回
+    void run(ParallelFn fn, void* arg, int count, int grain = 1);
+
+    // 关闭后所有分析在调用者中顺序执行（对照测量）
+    void setEnabled(bool enabled);
+    ParallelStats getStats();
+
+private:
+    TaskHandle_t helper = nullptr;
+    SemaphoreHandle_t done = nullptr;
+    volatile bool enabled = true;
+
+    // 当前任务，run 返回前不变
+    ParallelFn fn = nullptr;
+    void* arg = nullptr;
+    int count = 0;
+    int grain = 1;
+    int next = 0;             // 下一组的起始条目
+    bool open = false;        // 本次任务仍可加入
+    bool joined = false;      // 辅助任务已加入本次任务
+    int helperItems = 0;
+    portMUX_TYPE claimLock = portMUX_INITIALIZER_UNLOCKED;
+
+    ParallelStats stats = {};
+    portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
+    int work(uint8_t worker);
+    static void helperEntry(void* parameter);
+    void helperLoop();
+};
+
+extern ParallelRunner parallelRunner;
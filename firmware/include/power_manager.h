@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_camera.h>
+#include "config.h"
+#include "camera.h"
+#include "wifi_manager.h"
+
+enum PowerState {
+    POWER_ACTIVE,
+    POWER_IDLE,
+    POWER_STATE_COUNT
+};
+
+struct PowerStats {
+    PowerState state;
+    unsigned long residencyMs[POWER_STATE_COUNT];
+    uint32_t wakeCount;
+    unsigned long lastWakeMs;      // 触发到首个全分辨率帧的耗时
+    unsigned long maxWakeMs;
+    uint8_t lastWakeFrames;        // 唤醒切换时丢弃的低分辨率帧数
+    uint8_t maxWakeFrames;
+};
+
+// 低功耗空闲模式
+// 长时间无运动、无观看者时：传感器降到小分辨率、降低检测频率、WiFi 进入 modem sleep
+// 检测到运动或有观看请求时恢复全分辨率和全帧率
+class PowerManager {
+private:
+    Camera& camera;
+    WiFiManager& wifiManager;
+
+    volatile PowerState state = POWER_ACTIVE;
+    bool idleEnabled = POWER_IDLE_ENABLED;
+    volatile bool activityPending = false;
+    volatile framesize_t activeFrameSize = CAMERA_FRAME_SIZE;
+    volatile bool frameSizeChanged = false;
+    unsigned long lastActivity = 0;
+    unsigned long stateSince = 0;
+    unsigned long residencyMs[POWER_STATE_COUNT] = {0};
+
+    // 唤醒过程
+    bool waking = false;
+    unsigned long wakeStart = 0;
+    uint32_t wakeCount = 0;
+    unsigned long lastWakeMs = 0;
+    unsigned long maxWakeMs = 0;
+    uint8_t lastWakeFrames = 0;
+    uint8_t maxWakeFrames = 0;
+
+public:
+    PowerManager(Camera& cam, WiFiManager& wm)
+        : camera(cam), wifiManager(wm) {}
+
+    void begin();
+
+    // 由采集任务每帧调用（在运动检测之后）
+    // @return false 表示该帧是唤醒过程中残留的低分辨率帧，不应交给下游
+    bool onFrame(camera_fb_t* fb, bool motion);
+
+    // 观看请求等外部活动（可在任意任务中调用），在下一帧处理
+    void notifyActivity() { activityPending = true; }
+
+    void setIdleEnabled(bool enabled);
+    bool isIdleEnabled() const { return idleEnabled; }
+
+    // 活动状态下的分辨率（可在任意任务中调用），在下一帧处理；空闲时到唤醒才切换
+    // @return 不支持的分辨率返回 false
+    bool setActiveFrameSize(framesize_t size);
+    framesize_t getActiveFrameSize() const { return activeFrameSize; }
+
+    PowerState getState() const { return state; }
+    unsigned long getFrameIntervalMs() const;
+    PowerStats getStats() const;
+
+private:
+    void enterIdle();
+    void wake();
+    void setState(PowerState next);
+};
@@ -3,6 +3,7 @@
 #include "config_storage.h"
 #include "wifi_manager.h"
 #include "captive_portal.h"
+#include "scheduler.h"
 
 enum ProvisioningState {
     STARTUP,
@@ -19,6 +20,7 @@ private:
     CaptivePortal captivePortal;
     ProvisioningState state = STARTUP;
     unsigned long stateStartTime = 0;
+    TimerId timeoutTimer = INVALID_TIMER;
 
     static const unsigned long STA_TIMEOUT_MS = 30000;
     static const unsigned long SWITCHING_TIMEOUT_MS = 30000;
@@ -28,8 +30,9 @@ public:
         : storage(s), wifiManager(wm) {}
 
     bool begin();
-    void update();
     ProvisioningState getState() const { return state; }
+    bool isPortalActive() const { return captivePortal.isEnabled(); }
+    DnsStats getDnsStats() const { return captivePortal.getStats(); }
 
     // API 方法
     bool saveAndConnect(const char* ssid, const char* password);
@@ -38,4 +41,7 @@ public:
 private:
     void enterAPMode();
     bool tryConnectSaved();
+    void enterState(ProvisioningState next, unsigned long timeoutMs);
+    void onWiFiConnected();
+    void onTimeout();
 };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <functional>
+
+// 环形日志的记录头（32 字节），记录整体按 RingStore::ALIGN 对齐
+#pragma pack(push, 1)
+struct RingRecordHeader {
+    uint32_t magic;
+    uint32_t length;      // 数据字节数
+    uint64_t offset;      // 记录在逻辑日志中的偏移，只增不减（跨越回收和重启）
+    uint32_t timestamp;
+    uint16_t tag;
+    uint16_t flags;
+    uint32_t dataCrc;     // 数据的 CRC32
+    uint32_t headerCrc;   // 以上 28 字节的 CRC32
+};
+#pragma pack(pop)
+
+struct RingStoreStats {
+    uint32_t capacity;        // 分区字节数
+    uint32_t bytesUsed;       // 回收边界到写入位置（其间的记录都完好）
+    uint32_t sectorErases;    // 本次开机擦除的扇区数
+    uint32_t wearLaps;        // 写入位置绕分区的圈数：每个扇区已擦除 wearLaps 或 wearLaps + 1 次
+    uint32_t corruptRecords;  // 启动扫描时头部完好、数据 CRC 不符的记录
+    uint32_t failedWrites;
+};
+
+// 原始闪存分区上的环形日志
+// 记录依次追加到逻辑日志末尾，物理位置为逻辑偏移对分区大小取模，单条记录不跨分区末尾；
+// 写入位置进入新扇区前擦除该扇区，回收最旧一圈中位于该扇区的记录，扇区按顺序每圈擦除一次
+// 先写数据后写头，头和数据各带 CRC，掉电时写了一半的记录在启动扫描时跳过
+// 读取经 esp_partition_mmap 映射整个分区（esp_partition_write/erase 会刷新映射区域的 cache），
+// 直接从映射地址拷贝到调用者的缓冲区，不经过文件系统
+class RingStore {
+public:
+    static const uint32_t MAGIC = 0x31474E52;   // "RNG1"
+    static const size_t ALIGN = sizeof(RingRecordHeader);
+
+    typedef std::function<void(uint32_t id, const RingRecordHeader& header)> RecordFn;
+
+    // 映射分区并扫描现存记录，按逻辑偏移升序对每条完好的记录调用 onRecord
+    // 写入位置从最新记录之后的下一个扇区开始，不回到分区开头
+    bool begin(const char* label, esp_partition_subtype_t subtype, const RecordFn& onRecord);
+
+    // 追加一条记录，期间擦除的扇区中的旧记录随之失效（isLive 返回 false）
+    // @param id 返回记录 ID（逻辑偏移的低 32 位）
+    bool append(uint32_t timestamp, uint16_t tag, const uint8_t* data, size_t length, uint32_t& id);
+
+    // 记录所在扇区尚未被回收
+    bool isLive(uint32_t id);
+
+    // 从记录数据的 pos 处拷贝至多 len 字节
+    // 持锁拷贝，期间不会擦除记录所在扇区；记录已被回收时返回 0
+    size_t read(uint32_t id, size_t pos, uint8_t* buffer, size_t len);
+
+    // 单条记录数据的上限（分区的 1/4）
+    size_t maxRecordBytes() const;
+
+    RingStoreStats getStats();
+
+private:
+    const esp_partition_t* partition = nullptr;
+    const uint8_t* base = nullptr;             // 整个分区的映射地址
+    spi_flash_mmap_handle_t mapHandle = 0;
+    uint32_t size = 0;
+    SemaphoreHandle_t lock = nullptr;          // 保护 head/erasedUpTo 和读取拷贝
+    SemaphoreHandle_t writeLock = nullptr;     // 串行化追加，擦除期间不阻塞读取
+
+    uint64_t head = 0;          // 下一条记录的逻辑偏移
+    uint64_t erasedUpTo = 0;    // 已擦除到的逻辑偏移（扇区对齐），其前一整个分区大小以内的记录完好
+    RingStoreStats stats = {};
+
+    uint64_t tail() const { return erasedUpTo > size ? erasedUpTo - size : 0; }
+    bool locate(uint32_t id, uint64_t& offset) const;
+    bool eraseNextSector();
+
+    static size_t recordBytes(size_t length);
+    static uint32_t headerCrc(const RingRecordHeader& header);
+};
+
+// CRC-32（IEEE 802.3），crc 为上一段的结果，首段传 0
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len);
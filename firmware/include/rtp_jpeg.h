@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+// RTP/JPEG 负载（RFC 2435）
+// 接收端按负载头中的类型、尺寸和量化表重建 JPEG 文件头，并固定使用标准 Huffman 表，
+// 所以只能发送标准表编码的基线 JPEG（esp32-camera 与 libjpeg 的默认输出）
+
+// 交织传输（RTP over RTSP TCP）的 '$' 前缀，packetize 在每个包前预留这段空间
+#define RTP_INTERLEAVED_PREFIX 4
+#define RTP_HEADER_SIZE 12
+
+struct RtpJpegFrame {
+    uint8_t type;             // 0: 4:2:2，1: 4:2:0；带重启间隔时加 64
+    uint16_t width;
+    uint16_t height;
+    uint16_t restartInterval;
+    const uint8_t* tables[2]; // 8 位量化表（亮度、色度，DQT 中的锯齿序）
+    const uint8_t* scan;      // SOS 之后的熵编码数据，不含 EOI
+    size_t scanBytes;
+};
+
+// 每个 RTP 流的状态（每个会话一份）
+struct RtpStream {
+    uint32_t ssrc;
+    uint16_t seq;
+};
+
+// @param packet RTP 包起始地址，前面有 RTP_INTERLEAVED_PREFIX 字节可写
+// @return false 时中止本帧
+typedef bool (*RtpPacketSink)(uint8_t* packet, size_t len, void* arg);
+
+class RtpJpeg {
+public:
+    static const uint8_t PAYLOAD_TYPE = 26;
+    static const uint32_t CLOCK_RATE = 90000;
+
+    // 从 JPEG 文件中取出负载所需字段（指针指向 jpeg 内部）
+    // @return 渐进式、非标准 Huffman 表、16 位量化表、尺寸不是 8 的倍数等无法发送时返回 false
+    static bool parse(const uint8_t* jpeg, size_t len, RtpJpegFrame& frame);
+
+    // 按 maxPacket（含 RTP 头）把一帧分包，最后一包置 marker 位
+    // @param buffer 至少 RTP_INTERLEAVED_PREFIX + maxPacket 字节
+    // @return 发出的包数，sink 中止时返回 -1
+    static int packetize(const RtpJpegFrame& frame, uint32_t timestamp, RtpStream& stream,
+                         size_t maxPacket, uint8_t* buffer, RtpPacketSink sink, void* arg);
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Arduino.h>
+#include <netinet/in.h>
+#include "config.h"
+#include "rtp_jpeg.h"
+
+struct RtspStats {
+    uint8_t sessions;         // 当前 RTSP 连接
+    uint8_t playing;
+    uint32_t connections;     // 累计接受的连接
+    uint32_t rejected;        // 超过 RTSP_MAX_SESSIONS 被拒绝的连接
+    uint32_t framesSubmitted;
+    uint32_t framesSent;      // 每个会话发出一帧计一次
+    uint32_t framesDropped;   // 发出前被新帧替换
+    uint32_t framesInvalid;   // 无法按 RFC 2435 发送的 JPEG
+    uint32_t packetsSent;
+    uint32_t bytesSent;
+    uint32_t sendErrors;      // 发送失败或超时而断开的会话
+};
+
+// 最小 RTSP 服务（OPTIONS/DESCRIBE/SETUP/PLAY/TEARDOWN/GET_PARAMETER），
+// 以 RTP/JPEG 通过 UDP 或 RTSP 连接内交织的 TCP 推送，供 NVR 直接拉流
+// 会话随 RTSP 连接结束；基于 BSD socket，设备上是 lwIP，主机上是 POSIX
+class RtspServer {
+public:
+    // 帧缓冲的释放函数（设备上归还 BufferPool）
+    typedef void (*FrameRelease)(uint8_t* jpeg);
+
+    explicit RtspServer(FrameRelease release) : releaseFrame(release) {}
+
+    bool begin(uint16_t port = RTSP_PORT, uint16_t udpPort = RTSP_RTP_PORT);
+
+    // 处理连接和请求、发送待发帧，最多阻塞 timeoutMs（RTSP 任务循环调用）
+    void poll(uint32_t timeoutMs);
+
+    // 有会话在播放且距上一帧已满 RTSP_FRAME_INTERVAL_MS（采集任务每帧调用）
+    bool wantsFrame(uint32_t nowMs) const;
+    bool isPlaying() const { return playingCount > 0; }
+
+    // 提交一帧 JPEG，所有权转交；上一帧尚未发出时丢弃上一帧
+    // @param nowMs 采集时间，换算为 90 kHz RTP 时间戳
+    void submitFrame(uint8_t* jpeg, size_t len, uint32_t nowMs);
+
+    RtspStats getStats();
+
+private:
+    struct Session {
+        int sock = -1;
+        bool playing = false;
+        bool ready = false;       // 已 SETUP
+        bool interleaved = false;
+        uint8_t channel = 0;
+        sockaddr_in rtpAddr = {};
+        uint32_t id = 0;
+        RtpStream rtp = {};
+        char request[RTSP_REQUEST_MAX];
+        size_t buffered = 0;
+        size_t skip = 0;          // 待丢弃的交织数据（客户端发来的 RTCP）
+    };
+
+    FrameRelease releaseFrame;
+    int listenSock = -1;
+    int rtpSock = -1;
+    int rtcpSock = -1;        // rtpPort + 1，只接收并丢弃客户端的 RTCP 接收报告
+    uint16_t rtpPort = 0;
+    Session sessions[RTSP_MAX_SESSIONS];
+    uint8_t packet[RTP_INTERLEAVED_PREFIX + RTSP_RTP_PACKET_SIZE];
+
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    uint8_t* pendingFrame = nullptr;
+    size_t pendingBytes = 0;
+    uint32_t pendingTimestamp = 0;
+    uint32_t lastSubmitMs = 0;
+    volatile uint8_t playingCount = 0;
+    RtspStats stats = {};
+
+    void acceptClient();
+    void receive(Session& s);
+    void drainUdp(int sock);
+    bool handleRequest(Session& s, const char* request);
+    void respond(Session& s, int status, const char* cseq, const char* extraHeaders,
+                 const char* body = nullptr);
+    bool setupTransport(Session& s, const char* transport, char* reply, size_t replySize);
+    void closeSession(Session& s);
+    void sendFrame(const uint8_t* jpeg, size_t len, uint32_t timestamp);
+    bool sendAll(int sock, const uint8_t* data, size_t len);
+    static bool sendPacket(uint8_t* packet, size_t len, void* arg);
+    static uint32_t randomId();
+    void updatePlaying();
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "config.h"
+
+// 调度器事件，每个事件占用任务通知的一位
+enum SchedulerEvent {
+    EVENT_WIFI_CONNECTED,
+    EVENT_WIFI_DISCONNECTED,
+    EVENT_COUNT
+};
+
+typedef std::function<void()> SchedulerHandler;
+typedef int32_t TimerId;
+static const TimerId INVALID_TIMER = -1;
+
+struct SchedulerStats {
+    uint32_t wakeups;
+    uint32_t events;
+    uint32_t timersFired;
+    uint8_t activeTimers;
+};
+
+// 事件/定时器调度器
+// 运行在主循环任务中：没有到期的定时器和待处理事件时阻塞在任务通知上，CPU 可进入空闲
+// 事件可在任意任务（或中断）中投递，定时器用哈希时间轮管理
+class Scheduler {
+public:
+    // 绑定到当前任务（在 setup() 中调用）
+    void begin();
+
+    // 等待并分发一轮事件和到期定时器
+    void run();
+
+    void post(SchedulerEvent event);
+    void postFromISR(SchedulerEvent event);
+
+    // 注册事件处理函数（只在 begin 之后、同一任务中调用）
+    bool on(SchedulerEvent event, SchedulerHandler handler);
+
+    // 在 delayMs 后执行 handler；periodMs > 0 时周期执行。可在任意任务中调用
+    TimerId schedule(uint32_t delayMs, SchedulerHandler handler, uint32_t periodMs = 0);
+    // 取消定时器并把 id 置为 INVALID_TIMER
+    void cancel(TimerId& id);
+
+    SchedulerStats getStats() const;
+
+private:
+    static const uint32_t WHEEL_SLOTS = 256;
+    static const uint32_t TICK_MS = 8;          // 2^32 ms 可被 TICK_MS * WHEEL_SLOTS 整除
+    static const uint32_t RESCHEDULE_BIT = 1u << 31;
+
+    struct Timer {
+        SchedulerHandler handler;
+        uint32_t deadline = 0;
+        uint32_t period = 0;
+        uint16_t generation = 0;
+        int16_t next = -1;       // 同一槽中的下一个定时器
+        bool active = false;
+    };
+
+    struct EventHandler {
+        SchedulerEvent event;
+        SchedulerHandler handler;
+    };
+
+    TaskHandle_t task = nullptr;
+    SemaphoreHandle_t mutex = nullptr;
+
+    Timer timers[SCHEDULER_MAX_TIMERS];
+    int16_t wheel[WHEEL_SLOTS];
+    uint32_t lastTick = 0;
+
+    EventHandler handlers[SCHEDULER_MAX_HANDLERS];
+    uint8_t handlerCount = 0;
+
+    uint32_t wakeups = 0;
+    uint32_t eventsDispatched = 0;
+    uint32_t timersFired = 0;
+
+    static uint32_t tickOf(uint32_t ms) { return ms / TICK_MS; }
+    void link(int16_t index);
+    void unlink(int16_t index);
+    TickType_t ticksUntilNextTimer();
+    void runExpiredTimers();
+};
+
+extern Scheduler scheduler;
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_camera.h>
+#include "config.h"
+#include "cloud_client.h"
+#include "scheduler.h"
+
+// 批次文件中的帧记录头，后跟 length 字节 JPEG
+#pragma pack(push, 1)
+struct TimelapseFrameHeader {
+    uint32_t timestamp;   // Unix 时间（秒）；未对时为 0，由云端按接收时间补齐
+    uint32_t length;
+};
+#pragma pack(pop)
+
+struct TimelapseConfig {
+    bool enabled;
+    uint32_t intervalSec;
+    uint16_t batchFrames;
+    uint32_t batchAgeSec;
+};
+
+struct TimelapseStats {
+    uint16_t openFrames;      // 正在写入的批次
+    uint32_t openBytes;
+    bool batchPending;        // 有已封装、等待上传的批次
+    uint32_t batchesUploaded;
+    uint32_t framesUploaded;
+    uint32_t bytesUploaded;
+    uint32_t framesDropped;   // 待传批次未清空时溢出的帧
+    uint32_t uploadFailures;
+    int lastStatus;           // 最近一次上传的 HTTP 状态码（<0 为网络错误）
+    uint32_t lastUploadMs;    // 最近一次成功上传的耗时
+};
+
+// 延时摄影：按间隔拍摄 JPEG，追加到 LittleFS 上的批次文件（/timelapse/open.bin）
+// 满批或超时后改名为 ready.bin，由上传任务以一个 multipart 请求整批发送
+// 最多同时存在两批，批次之间不建立任何连接
+class TimelapseRecorder {
+public:
+    explicit TimelapseRecorder(CloudClient& cloud) : cloud(cloud) {}
+
+    // 载入配置、恢复掉电前的批次并启动上传任务（在调度器 begin 之后调用）
+    bool begin();
+
+    // 是否到了拍摄时间（采集任务每帧调用）
+    bool isDue() const;
+    void addFrame(camera_fb_t* fb);
+
+    // 立即封装当前批次并上传；当前批次为空时返回 false
+    bool flush();
+
+    TimelapseConfig getConfig() const { return config; }
+    // 校验并保存配置
+    bool setConfig(const TimelapseConfig& next);
+
+    TimelapseStats getStats();
+
+private:
+    CloudClient& cloud;
+    TimelapseConfig config;
+    SemaphoreHandle_t mutex = nullptr;
+    TaskHandle_t uploadTask = nullptr;
+    TimerId ageTimer = INVALID_TIMER;
+
+    unsigned long lastCaptureMs = 0;
+    bool captured = false;
+    bool openExpired = false;   // 超时但因待传批次未清空而未能封装
+    TimelapseStats stats = {};
+
+    void loadConfig();
+    bool saveConfig();
+    void recoverBatches();
+
+    void appendFrame(uint32_t timestamp, const uint8_t* jpg, size_t length);
+    bool isOpenFull(size_t nextBytes) const;
+    bool sealOpenBatch();
+    void onBatchAged();
+
+    static void uploadTaskEntry(void* parameter);
+    void uploadLoop();
+    // @return HTTP 状态码，<0 为网络或文件错误
+    int uploadReadyBatch(uint32_t& frames, uint32_t& bytes);
+};
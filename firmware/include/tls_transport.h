@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// TLS 连接抽象，HttpsPool 通过它收发数据
+// 设备上由 mbedTLS 实现（src/tls_transport_mbedtls.cpp），主机上由 OpenSSL 实现（tools/host/）
+// 会话以序列化字节保存，连接池不依赖具体 TLS 库
+class TlsTransport {
+public:
+    virtual ~TlsTransport() {}
+
+    // 建立 TCP 连接并完成握手；session 非空时尝试恢复该会话
+    virtual bool connect(const char* host, uint16_t port,
+                         const uint8_t* session, size_t sessionLen, uint32_t timeoutMs) = 0;
+
+    // 上一次握手是否恢复了会话（省去证书交换和密钥协商）
+    virtual bool sessionResumed() const = 0;
+
+    // 导出当前会话（含服务器下发的会话票据）
+    virtual bool saveSession(std::vector<uint8_t>& out) = 0;
+
+    // @return 写入的字节数，<0 为错误
+    virtual int write(const uint8_t* data, size_t len) = 0;
+
+    // 最多等待 timeoutMs
+    // @return 读到的字节数，0 为对端关闭，<0 为错误或超时
+    virtual int read(uint8_t* data, size_t len, uint32_t timeoutMs) = 0;
+
+    // 不阻塞地检查空闲连接是否仍可用（对端未关闭且没有多余数据）
+    virtual bool isAlive() = 0;
+
+    virtual void close() = 0;
+};
+
+typedef TlsTransport* (*TlsTransportFactory)();
+
+// 平台默认实现
+TlsTransport* createTlsTransport();
@@ -3,16 +3,22 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include "scheduler.h"
 
 class WiFiManager {
 public:
+    // 注册 WiFi 事件（在调度器 begin 之后调用一次）
+    void init();
     bool begin(const char* ssid, const char* password);
     bool isConnected();
-    void update();
     String getIP();
     String getMAC();
 
+    // modem sleep：空闲时开启以降低射频功耗，仅 STA 模式有效
+    void setPowerSave(bool enabled);
+
 private:
-    unsigned long lastReconnectAttempt = 0;
+    TimerId reconnectTimer = INVALID_TIMER;
+    void scheduleReconnect();
     void reconnect();
 };
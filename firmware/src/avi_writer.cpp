@@ -0,0 +1,250 @@
+#include "avi_writer.h"
+#include <string.h>
+
+// 文件头：RIFF / LIST hdrl (avih, LIST strl (strh, strf)) / LIST movi，各字段小端
+#pragma pack(push, 1)
+struct AviHeaders {
+    char riff[4];
+    uint32_t riffSize;
+    char avi[4];
+
+    char hdrlList[4];
+    uint32_t hdrlSize;
+    char hdrl[4];
+
+    char avihId[4];
+    uint32_t avihSize;
+    uint32_t microSecPerFrame;
+    uint32_t maxBytesPerSec;
+    uint32_t paddingGranularity;
+    uint32_t flags;
+    uint32_t totalFrames;
+    uint32_t initialFrames;
+    uint32_t streams;
+    uint32_t suggestedBufferSize;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved[4];
+
+    char strlList[4];
+    uint32_t strlSize;
+    char strl[4];
+
+    char strhId[4];
+    uint32_t strhSize;
+    char fccType[4];
+    char fccHandler[4];
+    uint32_t streamFlags;
+    uint16_t priority;
+    uint16_t language;
+    uint32_t streamInitialFrames;
+    uint32_t scale;
+    uint32_t rate;
+    uint32_t start;
+    uint32_t length;
+    uint32_t streamSuggestedBufferSize;
+    uint32_t quality;
+    uint32_t sampleSize;
+    int16_t frameLeft;
+    int16_t frameTop;
+    int16_t frameRight;
+    int16_t frameBottom;
+
+    char strfId[4];
+    uint32_t strfSize;
+    uint32_t biSize;
+    int32_t biWidth;
+    int32_t biHeight;
+    uint16_t biPlanes;
+    uint16_t biBitCount;
+    char biCompression[4];
+    uint32_t biSizeImage;
+    int32_t biXPelsPerMeter;
+    int32_t biYPelsPerMeter;
+    uint32_t biClrUsed;
+    uint32_t biClrImportant;
+
+    char moviList[4];
+    uint32_t moviSize;
+    char movi[4];
+};
+
+struct AviChunkHeader {
+    char id[4];
+    uint32_t size;
+};
+
+struct AviIdx1Entry {
+    char id[4];
+    uint32_t flags;
+    uint32_t offset;
+    uint32_t length;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(AviHeaders) == AviWriter::HEADER_BYTES, "AVI header layout");
+
+static const uint32_t AVIF_HASINDEX = 0x10;
+static const uint32_t AVIIF_KEYFRAME = 0x10;
+// 'movi' 标识在文件中的偏移，idx1 的偏移以它为基准
+static const uint32_t MOVI_OFFSET = offsetof(AviHeaders, movi);
+
+static inline void fourcc(char* out, const char* id) {
+    memcpy(out, id, 4);
+}
+
+bool AviWriter::begin(AviSink* sink, uint16_t width, uint16_t height, AviIndexEntry* index, uint16_t maxFrames) {
+    this->sink = sink;
+    this->index = index;
+    this->maxFrames = maxFrames;
+    this->width = width;
+    this->height = height;
+    frames = 0;
+    bytes = 0;
+    moviBytes = 0;
+    maxFrameBytes = 0;
+    return sink && index && maxFrames > 0 && writeHeaders(0);
+}
+
+bool AviWriter::writeHeaders(uint32_t usPerFrame) {
+    AviHeaders h;
+    memset(&h, 0, sizeof(h));
+
+    fourcc(h.riff, "RIFF");
+    // 结束前为 0：finish 之后才是完整文件
+    h.riffSize = frames ? bytes - 8 : 0;
+    fourcc(h.avi, "AVI ");
+
+    fourcc(h.hdrlList, "LIST");
+    h.hdrlSize = offsetof(AviHeaders, moviList) - offsetof(AviHeaders, hdrl);
+    fourcc(h.hdrl, "hdrl");
+
+    fourcc(h.avihId, "avih");
+    h.avihSize = offsetof(AviHeaders, strlList) - offsetof(AviHeaders, microSecPerFrame);
+    h.microSecPerFrame = usPerFrame;
+    h.maxBytesPerSec = usPerFrame ? (uint32_t)((uint64_t)maxFrameBytes * 1000000 / usPerFrame) : 0;
+    h.flags = AVIF_HASINDEX;
+    h.totalFrames = frames;
+    h.streams = 1;
+    h.suggestedBufferSize = maxFrameBytes;
+    h.width = width;
+    h.height = height;
+
+    fourcc(h.strlList, "LIST");
+    h.strlSize = offsetof(AviHeaders, moviList) - offsetof(AviHeaders, strl);
+    fourcc(h.strl, "strl");
+
+    // 帧率 = rate / scale，scale 取微秒使任意帧间隔都能精确表示
+    fourcc(h.strhId, "strh");
+    h.strhSize = offsetof(AviHeaders, strfId) - offsetof(AviHeaders, fccType);
+    fourcc(h.fccType, "vids");
+    fourcc(h.fccHandler, "MJPG");
+    h.scale = usPerFrame;
+    h.rate = 1000000;
+    h.length = frames;
+    h.streamSuggestedBufferSize = maxFrameBytes;
+    h.quality = 0xFFFFFFFF;
+    h.frameRight = width;
+    h.frameBottom = height;
+
+    fourcc(h.strfId, "strf");
+    h.strfSize = offsetof(AviHeaders, moviList) - offsetof(AviHeaders, biSize);
+    h.biSize = h.strfSize;
+    h.biWidth = width;
+    h.biHeight = height;
+    h.biPlanes = 1;
+    h.biBitCount = 24;
+    fourcc(h.biCompression, "MJPG");
+    h.biSizeImage = (uint32_t)width * height * 3;
+
+    fourcc(h.moviList, "LIST");
+    h.moviSize = 4 + moviBytes;
+    fourcc(h.movi, "movi");
+
+    if (bytes == 0) {
+        if (!sink->write((const uint8_t*)&h, sizeof(h))) return false;
+        bytes = sizeof(h);
+        return true;
+    }
+    return sink->writeAt(0, (const uint8_t*)&h, sizeof(h));
+}
+
+uint32_t AviWriter::sizeWith(size_t length) const {
+    uint32_t chunk = sizeof(AviChunkHeader) + ((length + 1) & ~1u);
+    return bytes + chunk + sizeof(AviChunkHeader) + (uint32_t)(frames + 1) * sizeof(AviIdx1Entry);
+}
+
+uint32_t AviWriter::spreadInterval(uint32_t maxBytes, uint32_t remainingMs, uint32_t minIntervalMs) const {
+    uint32_t finished = bytes + sizeof(AviChunkHeader) + (uint32_t)frames * sizeof(AviIdx1Entry);
+    if (frames == 0 || finished >= maxBytes) return minIntervalMs;
+
+    uint32_t perFrame = moviBytes / frames + sizeof(AviIdx1Entry);
+    uint32_t fit = (maxBytes - finished) / perFrame;
+    if (fit > (uint32_t)(maxFrames - frames)) fit = maxFrames - frames;
+    if (fit == 0) return minIntervalMs;
+    uint32_t interval = remainingMs / fit;
+    return interval > minIntervalMs ? interval : minIntervalMs;
+}
+
+bool AviWriter::addFrame(const uint8_t* jpeg, size_t length) {
+    if (!sink || isFull()) return false;
+
+    // 块按 2 字节对齐，奇数长度补一个 0
+    AviChunkHeader chunk;
+    fourcc(chunk.id, "00dc");
+    chunk.size = length;
+    static const uint8_t pad = 0;
+    bool odd = length & 1;
+    if (!sink->write((const uint8_t*)&chunk, sizeof(chunk)) || !sink->write(jpeg, length) ||
+        (odd && !sink->write(&pad, 1))) {
+        return false;
+    }
+
+    index[frames].offset = bytes - MOVI_OFFSET;
+    index[frames].length = length;
+    frames++;
+    uint32_t written = sizeof(chunk) + length + (odd ? 1 : 0);
+    bytes += written;
+    moviBytes += written;
+    if (length > maxFrameBytes) maxFrameBytes = length;
+    return true;
+}
+
+bool AviWriter::finish(uint32_t usPerFrame) {
+    if (!sink) return false;
+
+    AviChunkHeader chunk;
+    fourcc(chunk.id, "idx1");
+    chunk.size = (uint32_t)frames * sizeof(AviIdx1Entry);
+    if (!sink->write((const uint8_t*)&chunk, sizeof(chunk))) return false;
+    bytes += sizeof(chunk);
+
+    for (uint16_t i = 0; i < frames; i++) {
+        AviIdx1Entry entry;
+        fourcc(entry.id, "00dc");
+        entry.flags = AVIIF_KEYFRAME;
+        entry.offset = index[i].offset;
+        entry.length = index[i].length;
+        if (!sink->write((const uint8_t*)&entry, sizeof(entry))) return false;
+        bytes += sizeof(entry);
+    }
+
+    bool ok = writeHeaders(usPerFrame ? usPerFrame : 1);
+    sink = nullptr;
+    return ok;
+}
+
+bool AviWriter::parseHeader(const uint8_t* data, size_t length, AviFileInfo& info) {
+    if (length < sizeof(AviHeaders)) return false;
+    AviHeaders h;
+    memcpy(&h, data, sizeof(h));
+    if (memcmp(h.riff, "RIFF", 4) != 0 || memcmp(h.avi, "AVI ", 4) != 0 ||
+        memcmp(h.fccHandler, "MJPG", 4) != 0 || memcmp(h.movi, "movi", 4) != 0) {
+        return false;
+    }
+    info.width = h.width;
+    info.height = h.height;
+    info.frames = h.totalFrames;
+    info.usPerFrame = h.microSecPerFrame;
+    return true;
+}
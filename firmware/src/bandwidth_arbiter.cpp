@@ -0,0 +1,144 @@
+#include "bandwidth_arbiter.h"
+
+BandwidthArbiter bandwidthArbiter;
+
+bool BandwidthArbiter::isLiveActive(uint32_t now) const {
+    return viewerSeen && now - lastViewerMs < BW_VIEWER_IDLE_MS;
+}
+
+uint32_t BandwidthArbiter::liveReserve() const {
+    uint32_t reserve = (uint32_t)((uint64_t)liveBps * (100 + BW_LIVE_HEADROOM_PCT) / 100);
+    return max<uint32_t>(reserve, BW_LIVE_MIN_RESERVE_BPS);
+}
+
+// 有人观看时后台的配额
+uint32_t BandwidthArbiter::backgroundAllowance() const {
+    uint32_t reserve = liveReserve();
+    return linkBps > reserve + BW_BACKGROUND_MIN_BPS ? linkBps - reserve : BW_BACKGROUND_MIN_BPS;
+}
+
+// 调用者持有 lock
+void BandwidthArbiter::update(uint32_t now) {
+    uint32_t elapsed = now - sampleStart;
+    if (elapsed < BW_SAMPLE_MS) return;
+
+    uint32_t live = (uint32_t)((uint64_t)windowLive * 1000 / elapsed);
+    uint32_t background = (uint32_t)((uint64_t)windowBackground * 1000 / elapsed);
+    liveBps = (liveBps + live) / 2;
+    backgroundBps = (backgroundBps + background) / 2;
+
+    // 后台大部分时间卡在 socket 写入：发送缓冲区排满，本周期的总吞吐就是链路当前能承载的
+    uint32_t total = live + background;
+    if ((uint64_t)windowBlockedUs * 100 > (uint64_t)elapsed * 1000 * BW_CONGESTED_PCT) {
+        if (total < linkBps) stats.congestions++;
+        linkBps = total;
+    } else if (windowThrottled) {
+        linkBps += BW_PROBE_BPS;
+    }
+    linkBps = max<uint32_t>(max(linkBps, total), BW_MIN_LINK_BPS);
+
+    allowanceBps = enabled && isLiveActive(now) ? backgroundAllowance() : 0;
+
+    sampleStart = now;
+    windowLive = 0;
+    windowBackground = 0;
+    windowBlockedUs = 0;
+    windowThrottled = false;
+}
+
+void BandwidthArbiter::refill(uint32_t now) {
+    uint32_t elapsed = now - tokensMs;
+    tokensMs = now;
+    uint64_t next = tokens + (uint64_t)allowanceBps * elapsed / 1000;
+    tokens = next > BW_BUCKET_BYTES ? BW_BUCKET_BYTES : (uint32_t)next;
+}
+
+void BandwidthArbiter::noteViewer(uint32_t now) {
+    portENTER_CRITICAL(&lock);
+    if (!isLiveActive(now)) {
+        // 观看开始：实时流吞吐还没测到，先按最低预留降速并清空令牌
+        viewerSeen = true;
+        liveBps = 0;
+        tokens = 0;
+        tokensMs = now;
+        if (enabled) {
+            allowanceBps = backgroundAllowance();
+            stats.backoffs++;
+        }
+    }
+    lastViewerMs = now;
+    portEXIT_CRITICAL(&lock);
+}
+
+void BandwidthArbiter::recordLive(size_t bytes, uint32_t now) {
+    portENTER_CRITICAL(&lock);
+    update(now);
+    windowLive += bytes;
+    stats.liveBytes += bytes;
+    portEXIT_CRITICAL(&lock);
+}
+
+uint32_t BandwidthArbiter::reserve(size_t bytes, uint32_t now) {
+    portENTER_CRITICAL(&lock);
+    update(now);
+    uint32_t wait = 0;
+    if (enabled && isLiveActive(now)) {
+        refill(now);
+        if (tokens >= bytes) {
+            tokens -= bytes;
+        } else {
+            windowThrottled = true;
+            wait = (uint32_t)((uint64_t)(bytes - tokens) * 1000 / allowanceBps) + 1;
+        }
+    } else {
+        // 不限速期间令牌保持满，观看开始时再清空
+        tokens = BW_BUCKET_BYTES;
+        tokensMs = now;
+    }
+    portEXIT_CRITICAL(&lock);
+    return wait;
+}
+
+void BandwidthArbiter::pace(size_t bytes) {
+    uint32_t start = millis();
+    uint32_t wait;
+    while ((wait = reserve(bytes, millis())) > 0) {
+        delay(min<uint32_t>(wait, BW_PACE_POLL_MS));
+    }
+    uint32_t waited = millis() - start;
+    if (waited) {
+        portENTER_CRITICAL(&lock);
+        stats.pacedMs += waited;
+        portEXIT_CRITICAL(&lock);
+    }
+}
+
+void BandwidthArbiter::recordBackground(size_t bytes, uint32_t blockedUs, uint32_t now) {
+    portENTER_CRITICAL(&lock);
+    update(now);
+    windowBackground += bytes;
+    windowBlockedUs += blockedUs;
+    stats.backgroundBytes += bytes;
+    portEXIT_CRITICAL(&lock);
+}
+
+void BandwidthArbiter::setEnabled(bool next) {
+    portENTER_CRITICAL(&lock);
+    enabled = next;
+    allowanceBps = enabled ? backgroundAllowance() : 0;
+    portEXIT_CRITICAL(&lock);
+}
+
+BandwidthStats BandwidthArbiter::getStats(uint32_t now) {
+    portENTER_CRITICAL(&lock);
+    update(now);
+    BandwidthStats copy = stats;
+    copy.enabled = enabled;
+    copy.liveActive = isLiveActive(now);
+    copy.linkBps = linkBps;
+    copy.liveBps = liveBps;
+    copy.backgroundBps = backgroundBps;
+    copy.allowanceBps = enabled && copy.liveActive ? allowanceBps : 0;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
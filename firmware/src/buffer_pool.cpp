@@ -0,0 +1,123 @@
+#include "buffer_pool.h"
+#include "config.h"
+#include "logger.h"
+
+BufferPool bufferPool;
+
+// 槽大小按 64 字节对齐，便于 DMA 和缓存行访问
+static size_t alignSlot(size_t size) {
+    return (size + 63) & ~(size_t)63;
+}
+
+bool BufferPool::begin(size_t frameBytes) {
+    if (initialized) return true;
+
+    const size_t sizes[BUFFER_CLASS_COUNT] = {
+        frameBytes / 16,
+        frameBytes / 4 + BUFFER_POOL_HEADROOM,
+        frameBytes + BUFFER_POOL_HEADROOM,
+    };
+    const uint8_t counts[BUFFER_CLASS_COUNT] = {
+        BUFFER_POOL_SMALL_COUNT,
+        BUFFER_POOL_MEDIUM_COUNT,
+        BUFFER_POOL_LARGE_COUNT + STREAM_MAX_VIEWERS,
+    };
+
+    for (int i = 0; i < BUFFER_CLASS_COUNT; i++) {
+        SizeClass& c = classes[i];
+        c.slotSize = alignSlot(sizes[i]);
+        c.slots = min<uint8_t>(counts[i], 32);
+        c.base = (uint8_t*)heap_caps_malloc(c.slotSize * c.slots, MALLOC_CAP_SPIRAM);
+        if (!c.base) {
+            Logger::error("POOL", "Failed to allocate %u x %u bytes",
+                          (unsigned)c.slots, (unsigned)c.slotSize);
+            return false;
+        }
+        c.freeMask = c.slots == 32 ? 0xFFFFFFFF : ((1u << c.slots) - 1);
+        Logger::info("POOL", "Class %d: %u x %u bytes", i, (unsigned)c.slots, (unsigned)c.slotSize);
+    }
+
+    initialized = true;
+    return true;
+}
+
+uint8_t* BufferPool::acquire(size_t size) {
+    if (!initialized) return nullptr;
+
+    uint8_t* buffer = nullptr;
+    int requested = -1;
+
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < BUFFER_CLASS_COUNT; i++) {
+        SizeClass& c = classes[i];
+        if (c.slotSize < size) continue;
+        if (requested < 0) requested = i;
+        if (c.freeMask == 0) continue;
+
+        int slot = __builtin_ctz(c.freeMask);
+        c.freeMask &= ~(1u << slot);
+        c.inUse++;
+        if (c.inUse > c.highWater) c.highWater = c.inUse;
+        c.acquires++;
+        buffer = c.base + slot * c.slotSize;
+        break;
+    }
+    if (!buffer && requested >= 0) {
+        classes[requested].failures++;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (!buffer) {
+        Logger::warn("POOL", "No free slot for %u bytes", (unsigned)size);
+    }
+    return buffer;
+}
+
+void BufferPool::release(uint8_t* buffer) {
+    if (!buffer) return;
+
+    int i = findClass(buffer);
+    if (i < 0) {
+        Logger::error("POOL", "Release of foreign buffer %p", buffer);
+        return;
+    }
+
+    SizeClass& c = classes[i];
+    int slot = (buffer - c.base) / c.slotSize;
+
+    portENTER_CRITICAL(&lock);
+    if (!(c.freeMask & (1u << slot))) {
+        c.freeMask |= (1u << slot);
+        c.inUse--;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+size_t BufferPool::capacity(const uint8_t* buffer) const {
+    int i = findClass(buffer);
+    return i < 0 ? 0 : classes[i].slotSize;
+}
+
+BufferClassStats BufferPool::getStats(BufferClass cls) const {
+    BufferClassStats stats;
+    portENTER_CRITICAL(&lock);
+    const SizeClass& c = classes[cls];
+    stats.slotSize = c.slotSize;
+    stats.slots = c.slots;
+    stats.inUse = c.inUse;
+    stats.highWater = c.highWater;
+    stats.acquires = c.acquires;
+    stats.failures = c.failures;
+    portEXIT_CRITICAL(&lock);
+    return stats;
+}
+
+int BufferPool::findClass(const uint8_t* buffer) const {
+    for (int i = 0; i < BUFFER_CLASS_COUNT; i++) {
+        const SizeClass& c = classes[i];
+        if (c.base && buffer >= c.base && buffer < c.base + c.slotSize * c.slots) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,199 @@
+#include "burst_selector.h"
+#include "buffer_pool.h"
+#include "parallel.h"
+#include <string.h>
+
+// 与运动检测相同的感知灰度 (r + 2g + b) / 4
+static inline uint8_t lumaAt(const uint8_t* p) {
+    uint16_t pixel = ImageScaler::loadRGB565(p);
+    uint32_t r = (pixel >> 11) & 0x1F;
+    uint32_t g = (pixel >> 5) & 0x3F;
+    uint32_t b = pixel & 0x1F;
+    return (uint8_t)(((r << 3) + (g << 3) + (b << 3)) >> 2);
+}
+
+// 抽样一行亮度
+static void sampleRow(const uint8_t* src, int srcWidth, int y, const CropRect& box, int step,
+                      uint8_t* out, int count) {
+    const uint8_t* p = src + ((size_t)y * srcWidth + box.x) * 2;
+    size_t stride = (size_t)step * 2;
+    for (int i = 0; i < count; i++, p += stride) {
+        out[i] = lumaAt(p);
+    }
+}
+
+namespace {
+
+struct SharpnessBands {
+    const camera_fb_t* fb;
+    CropRect box;
+    int step;
+    int cols;
+    uint8_t* rows;
+    // 各 worker 的部分和，返回后按 worker 顺序相加
+    int64_t sum[ParallelRunner::WORKERS];
+    uint64_t sumSq[ParallelRunner::WORKERS];
+};
+
+}  // namespace
+
+// 条目 i 为以第 i+1 个抽样行为中心的拉普拉斯行，每段先补上两行邻居
+static void sharpnessRows(void* arg, uint8_t worker, int begin, int end) {
+    SharpnessBands* job = static_cast<SharpnessBands*>(arg);
+    const CropRect& box = job->box;
+    int step = job->step;
+    int cols = job->cols;
+
+    // 三行滚动：up/mid/down 轮换，每个抽样点只转换一次亮度
+    uint8_t* up = job->rows + (size_t)worker * 3 * cols;
+    uint8_t* mid = up + cols;
+    uint8_t* down = mid + cols;
+    sampleRow(job->fb->buf, job->fb->width, box.y + begin * step, box, step, up, cols);
+    sampleRow(job->fb->buf, job->fb->width, box.y + (begin + 1) * step, box, step, mid, cols);
+
+    int64_t sum = 0;
+    uint64_t sumSq = 0;
+    for (int line = begin + 2; line < end + 2; line++) {
+        sampleRow(job->fb->buf, job->fb->width, box.y + line * step, box, step, down, cols);
+
+        // 一行的平方和不超过 2^32（|L| <= 1020，每行最多 4096 点），按行累加到 64 位
+        int32_t rowSum = 0;
+        uint32_t rowSq = 0;
+        for (int x = 1; x < cols - 1; x++) {
+            int32_t l = (int32_t)up[x] + down[x] + mid[x - 1] + mid[x + 1] - 4 * (int32_t)mid[x];
+            rowSum += l;
+            rowSq += (uint32_t)(l * l);
+        }
+        sum += rowSum;
+        sumSq += rowSq;
+
+        uint8_t* t = up;
+        up = mid;
+        mid = down;
+        down = t;
+    }
+    job->sum[worker] += sum;
+    job->sumSq[worker] += sumSq;
+}
+
+uint32_t BurstSelector::sharpness(const camera_fb_t* fb, const CropRect& box, int step, uint8_t* rows) {
+    if (fb->format == PIXFORMAT_JPEG) return fb->len;
+    if (fb->format != PIXFORMAT_RGB565) return 0;
+
+    int cols = (box.width + step - 1) / step;
+    int lines = (box.height + step - 1) / step;
+    if (cols < 3 || lines < 3) return 0;
+
+    // 每段多抽两行，分成约 4 段在两个核之间平衡
+    SharpnessBands job = {fb, box, step, cols, rows, {}, {}};
+    int count = lines - 2;
+    parallelRunner.run(sharpnessRows, &job, count, max(1, count / 4));
+
+    int64_t sum = 0;
+    uint64_t sumSq = 0;
+    for (uint8_t w = 0; w < ParallelRunner::WORKERS; w++) {
+        sum += job.sum[w];
+        sumSq += job.sumSq[w];
+    }
+    uint32_t n = (uint32_t)(cols - 2) * count;
+    uint64_t meanSq = (uint64_t)((sum / (int64_t)n) * (sum / (int64_t)n));
+    uint64_t meanOfSq = sumSq / n;
+    return meanOfSq > meanSq ? (uint32_t)(meanOfSq - meanSq) : 0;
+}
+
+bool BurstSelector::start(camera_fb_t* fb, const CropRect& box, uint8_t score) {
+    finish();
+
+    // 变化区域向四周各扩展一半：连拍期间目标继续移动，评分区域须仍包含它，
+    // 否则后面的帧只因目标移出区域而得分偏低
+    scoreBox = CropRect(box.x - box.width / 2, box.y - box.height / 2, box.width * 2, box.height * 2);
+    ImageScaler::clampCrop(scoreBox, fb->width, fb->height);
+    best.buf = bufferPool.acquire(fb->len);
+    rows = bufferPool.acquire(scratchSize(scoreBox.width, BURST_SHARPNESS_STEP));
+    if (!best.buf || !rows) {
+        finish();
+        portENTER_CRITICAL(&lock);
+        stats.copyFailures++;
+        portEXIT_CRITICAL(&lock);
+        return false;
+    }
+
+    active = true;
+    index = 0;
+    selection = {};
+    totalScoringUs = 0;
+    this->score(fb, box, score);
+    return true;
+}
+
+bool BurstSelector::offer(camera_fb_t* fb, const CropRect* box, uint8_t score) {
+    if (!active) return false;
+    // 连拍中途分辨率或格式变化（正常由采集任务先结束连拍）：用已评分的帧结束
+    if (fb->width != best.width || fb->height != best.height || fb->format != best.format ||
+        fb->len > bufferPool.capacity(best.buf)) {
+        return true;
+    }
+    this->score(fb, box ? *box : scoreBox, score);
+    return index >= BURST_FRAMES;
+}
+
+void BurstSelector::score(camera_fb_t* fb, const CropRect& box, uint8_t motionScore) {
+    unsigned long startUs = micros();
+    uint32_t value = sharpness(fb, scoreBox, BURST_SHARPNESS_STEP, rows);
+    uint32_t elapsed = micros() - startUs;
+    totalScoringUs += elapsed;
+
+    portENTER_CRITICAL(&lock);
+    stats.frames++;
+    statsScoringUs += elapsed;
+    stats.avgScoringUs = (uint32_t)(statsScoringUs / stats.frames);
+    if (elapsed > stats.maxScoringUs) stats.maxScoringUs = elapsed;
+    portEXIT_CRITICAL(&lock);
+
+    if (index == 0) selection.triggerSharpness = value;
+    // 清晰度相同时保留较早的帧，少拷贝一次
+    if (index == 0 || value > selection.sharpness) {
+        memcpy(best.buf, fb->buf, fb->len);
+        best.len = fb->len;
+        best.width = fb->width;
+        best.height = fb->height;
+        best.format = fb->format;
+        best.timestamp = fb->timestamp;
+        bestBox = box;
+        bestScore = motionScore;
+        selection.selected = index;
+        selection.sharpness = value;
+    }
+    index++;
+    selection.frames = index;
+    selection.scoringUs = (uint32_t)(totalScoringUs / index);
+}
+
+camera_fb_t* BurstSelector::getBest(CropRect& box, uint8_t& score) {
+    if (!active || selection.frames == 0) return nullptr;
+    box = bestBox;
+    score = bestScore;
+    return &best;
+}
+
+void BurstSelector::finish() {
+    if (active) {
+        portENTER_CRITICAL(&lock);
+        stats.bursts++;
+        if (selection.selected == 0) stats.triggerSelected++;
+        stats.last = selection;
+        portEXIT_CRITICAL(&lock);
+    }
+    if (best.buf) bufferPool.release(best.buf);
+    if (rows) bufferPool.release(rows);
+    best = {};
+    rows = nullptr;
+    active = false;
+}
+
+BurstStats BurstSelector::getStats() {
+    portENTER_CRITICAL(&lock);
+    BurstStats copy = stats;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
@@ -2,6 +2,7 @@
 #include "camera.h"
 #include "config.h"
 #include <esp_camera.h>
+#include <esp_timer.h>
 
 // CamS3 (ESP32S3_EYE) 引脚配置
 #define PWDN_GPIO_NUM     -1
@@ -22,8 +23,92 @@
 #define HREF_GPIO_NUM     7
 #define PCLK_GPIO_NUM     11
 
+// 基准测试依次比较的模式：旧的队列模式作为对照
+static const CaptureConfig BENCHMARK_CONFIGS[Camera::BENCHMARK_MODES] = {
+    {CAMERA_GRAB_WHEN_EMPTY, CAMERA_FB_IN_PSRAM, 2, 20000000},
+    {CAMERA_GRAB_LATEST, CAMERA_FB_IN_PSRAM, 1, 20000000},
+    {CAMERA_GRAB_LATEST, CAMERA_FB_IN_PSRAM, 2, 20000000},
+    {CAMERA_GRAB_LATEST, CAMERA_FB_IN_PSRAM, 3, 20000000},
+    {CAMERA_GRAB_LATEST, CAMERA_FB_IN_PSRAM, 2, 10000000},
+    {CAMERA_GRAB_LATEST, CAMERA_FB_IN_DRAM, 1, 20000000},
+};
+
+// 分辨率名称（HTTP 接口使用）
+static const struct {
+    const char* name;
+    framesize_t size;
+} FRAME_SIZE_NAMES[] = {
+    {"qqvga", FRAMESIZE_QQVGA}, {"hqvga", FRAMESIZE_HQVGA}, {"240x240", FRAMESIZE_240X240},
+    {"qvga", FRAMESIZE_QVGA}, {"cif", FRAMESIZE_CIF}, {"hvga", FRAMESIZE_HVGA},
+    {"vga", FRAMESIZE_VGA}, {"svga", FRAMESIZE_SVGA}, {"xga", FRAMESIZE_XGA},
+    {"hd", FRAMESIZE_HD}, {"sxga", FRAMESIZE_SXGA}, {"uxga", FRAMESIZE_UXGA},
+};
+
+static size_t framePixels(framesize_t size) {
+    return (size_t)resolution[size].width * resolution[size].height;
+}
+
+// OV2640 读出模式：窗口寄存器使用该模式的坐标（全幅坐标除以 scale），隔行隔列读出的模式帧率更高
+struct SensorMode {
+    uint8_t id;         // set_res_raw 的 startX：0 UXGA，1 SVGA，2 CIF
+    uint8_t scale;
+    uint16_t height;    // 模式的有效行数
+};
+
+static const SensorMode SENSOR_MODES[] = {{2, 4, 296}, {1, 2, 600}, {0, 1, 1200}};
+
+// 与驱动 set_framesize 相同的模式选择（全幅视场时的读出方式）
+static uint8_t fullFieldScale(framesize_t size) {
+    return size <= FRAMESIZE_CIF ? 4 : size <= FRAMESIZE_SVGA ? 2 : 1;
+}
+
+// 把请求的视场调整为传感器能输出的窗口：
+// - 扩展到输出宽高比（只扩展，不裁掉请求的区域），且不小于输出尺寸（DSP 只能缩小）
+// - 选仍不小于输出尺寸的最大 scale，读出的行列最少
+// - 模式坐标中的宽高按 4 对齐（寄存器以 4 像素为单位）
+// @param fitted 全幅坐标中实际读出的视场；modeWindow 为模式坐标
+static const SensorMode& fitWindow(const SensorWindow& request, int outWidth, int outHeight,
+                                   SensorWindow& fitted, SensorWindow& modeWindow) {
+    int w = request.width;
+    int h = request.height;
+    if ((long)w * outHeight < (long)h * outWidth) {
+        w = (int)(((long)h * outWidth + outHeight - 1) / outHeight);
+    } else {
+        h = (int)(((long)w * outHeight + outWidth - 1) / outWidth);
+    }
+    w = constrain(max(w, outWidth), 0, CAMERA_SENSOR_WIDTH);
+    h = constrain(max(h, outHeight), 0, CAMERA_SENSOR_HEIGHT);
+    int x = constrain(request.x + request.width / 2 - w / 2, 0, CAMERA_SENSOR_WIDTH - w);
+    int y = constrain(request.y + request.height / 2 - h / 2, 0, CAMERA_SENSOR_HEIGHT - h);
+
+    const SensorMode* mode = &SENSOR_MODES[sizeof(SENSOR_MODES) / sizeof(SENSOR_MODES[0]) - 1];
+    for (const SensorMode& m : SENSOR_MODES) {
+        if (w / m.scale >= outWidth && h / m.scale >= outHeight && (y + h) / m.scale <= m.height) {
+            mode = &m;
+            break;
+        }
+    }
+
+    modeWindow.x = x / mode->scale;
+    modeWindow.y = y / mode->scale;
+    modeWindow.width = (w / mode->scale) & ~3;
+    modeWindow.height = (h / mode->scale) & ~3;
+    fitted = {(uint16_t)(modeWindow.x * mode->scale), (uint16_t)(modeWindow.y * mode->scale),
+              (uint16_t)(modeWindow.width * mode->scale), (uint16_t)(modeWindow.height * mode->scale)};
+    return *mode;
+}
+
+CaptureConfig Camera::defaultConfig() {
+    return {CAMERA_GRAB_MODE, CAMERA_FB_LOCATION, CAMERA_FB_COUNT, CAMERA_XCLK_FREQ_HZ, CAMERA_PIXEL_FORMAT};
+}
+
 bool Camera::init() {
-    camera_config_t config;
+    return init(defaultConfig());
+}
+
+bool Camera::init(const CaptureConfig& mode) {
+    // 所有字段显式赋值，未列出的新字段为 0
+    camera_config_t config = {};
     config.ledc_channel = LEDC_CHANNEL_0;
     config.ledc_timer = LEDC_TIMER_0;
     config.pin_d0 = Y2_GPIO_NUM;
@@ -40,17 +125,22 @@ bool Camera::init() {
     config.pin_href = HREF_GPIO_NUM;
     config.pin_sccb_sda = SIOD_GPIO_NUM;
     config.pin_sccb_scl = SIOC_GPIO_NUM;
+    config.sccb_i2c_port = -1;
     config.pin_pwdn = PWDN_GPIO_NUM;
     config.pin_reset = RESET_GPIO_NUM;
-    config.xclk_freq_hz = 20000000;
-    // 使用 RGB565 格式以便运动检测能直接访问像素数据
-    // JPEG 格式会导致像素访问错误（压缩数据不能直接访问）
-    config.pixel_format = PIXFORMAT_RGB565;
+    config.xclk_freq_hz = mode.xclkHz;
+    // RGB565 供运动检测/估计直接访问像素；JPEG 由传感器压缩，运动检测只熵解码 DC 系数
+    config.pixel_format = mode.pixelFormat;
 
-    // 初始化为高分辨率用于运动检测
-    config.frame_size = CAMERA_FRAME_SIZE;
-    // RGB565 不需要 jpeg_quality 设置
-    config.fb_count = CAMERA_FB_COUNT;
+    // 初始化为高分辨率用于运动检测（空闲模式下重新初始化时保持小分辨率）
+    if (frameSize == FRAMESIZE_INVALID) frameSize = CAMERA_FRAME_SIZE;
+    config.frame_size = frameSize;
+    allocatedSize = frameSize;
+    // JPEG 输出时传感器按此质量压缩（RGB565 不使用）
+    config.jpeg_quality = CAMERA_JPEG_QUALITY;
+    config.fb_count = mode.fbCount;
+    config.fb_location = mode.fbLocation;
+    config.grab_mode = mode.grabMode;
 
     // 初始化摄像头
     esp_err_t err = esp_camera_init(&config);
@@ -59,21 +149,470 @@ bool Camera::init() {
         return false;
     }
 
+    this->config = mode;
     initialized = true;
-    Serial.println("Camera initialized successfully");
+    writeWindow();
+    resetStats();
+    Serial.printf("Camera initialized: %s, %s, %u fb in %s, XCLK %u MHz\n", pixelFormatName(mode.pixelFormat),
+                  mode.grabMode == CAMERA_GRAB_LATEST ? "latest" : "queued", mode.fbCount,
+                  mode.fbLocation == CAMERA_FB_IN_DRAM ? "DRAM" : "PSRAM",
+                  (unsigned)(mode.xclkHz / 1000000));
     return true;
 }
 
 bool Camera::capture() {
     if (!initialized) return false;
 
-    // 释放旧缓冲区
+    releasePrevious();
+    if (keepsPreviousFrame()) {
+        previous = fb;
+        fb = nullptr;
+    } else {
+        release();
+    }
+
+    fb = esp_camera_fb_get();
+    if (!fb) {
+        portENTER_CRITICAL(&lock);
+        failures++;
+        portEXIT_CRITICAL(&lock);
+        return false;
+    }
+
+    // 切换前已在队列中的旧尺寸帧、长度不足的残帧不交给下游
+    if (!matchesFrameSize(fb)) {
+        esp_camera_fb_return(fb);
+        fb = nullptr;
+        portENTER_CRITICAL(&lock);
+        switchStats.staleFrames++;
+        portEXIT_CRITICAL(&lock);
+        return false;
+    }
+
+    uint32_t age = frameAgeUs(fb);
+    int64_t now = esp_timer_get_time();
+    int64_t sensorUs = (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+    portENTER_CRITICAL(&lock);
+    frames++;
+    lastFrameBytes = fb->len;
+    lastAgeUs = age;
+    maxAgeUs = max(maxAgeUs, age);
+    totalAgeUs += age;
+    trace = {++nextSeq, sensorUs, now, 0};
+    portEXIT_CRITICAL(&lock);
+    latencyTracer.record(LATENCY_CAPTURE, sensorUs, now);
+    return true;
+}
+
+FrameTrace Camera::getTrace() {
+    portENTER_CRITICAL(&lock);
+    FrameTrace copy = trace;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
+
+void Camera::markAnalyzed() {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&lock);
+    trace.analyzedUs = now;
+    int64_t capturedUs = trace.capturedUs;
+    portEXIT_CRITICAL(&lock);
+    latencyTracer.record(LATENCY_ANALYSIS, capturedUs, now);
+}
+
+void Camera::releasePrevious() {
+    if (previous != nullptr) {
+        esp_camera_fb_return(previous);
+        previous = nullptr;
+    }
+}
+
+void Camera::release() {
+    releasePrevious();
     if (fb != nullptr) {
         esp_camera_fb_return(fb);
+        fb = nullptr;
     }
+}
 
-    fb = esp_camera_fb_get();
-    return fb != nullptr;
+bool Camera::matchesFrameSize(const camera_fb_t* frame) const {
+    if (frame->width != resolution[frameSize].width || frame->height != resolution[frameSize].height) {
+        return false;
+    }
+    return frame->format != PIXFORMAT_RGB565 || frame->len >= framePixels(frameSize) * 2;
+}
+
+uint32_t Camera::frameAgeUs(const camera_fb_t* frame) {
+    int64_t captured = (int64_t)frame->timestamp.tv_sec * 1000000 + frame->timestamp.tv_usec;
+    int64_t age = esp_timer_get_time() - captured;
+    return age > 0 ? (uint32_t)age : 0;
+}
+
+bool Camera::reinit(const CaptureConfig& next) {
+    release();
+    if (initialized) {
+        esp_camera_deinit();
+        initialized = false;
+    }
+    return init(next);
+}
+
+void Camera::resetStats() {
+    portENTER_CRITICAL(&lock);
+    frames = 0;
+    failures = 0;
+    lastAgeUs = 0;
+    maxAgeUs = 0;
+    totalAgeUs = 0;
+    statsSince = millis();
+    portEXIT_CRITICAL(&lock);
+}
+
+CaptureStats Camera::getStats() {
+    CaptureStats stats;
+    portENTER_CRITICAL(&lock);
+    stats.config = config;
+    stats.frames = frames;
+    stats.failures = failures;
+    stats.lastAgeUs = lastAgeUs;
+    stats.maxAgeUs = maxAgeUs;
+    stats.avgAgeUs = frames ? (uint32_t)(totalAgeUs / frames) : 0;
+    unsigned long elapsed = millis() - statsSince;
+    stats.fps = elapsed ? frames * 1000.0f / elapsed : 0.0f;
+    portEXIT_CRITICAL(&lock);
+    return stats;
+}
+
+void Camera::requestCaptureConfig(const CaptureConfig& next) {
+    portENTER_CRITICAL(&lock);
+    nextConfig = next;
+    pendingConfig = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+void Camera::requestBenchmark() {
+    pendingBenchmark = true;
+}
+
+void Camera::servicePending() {
+    portENTER_CRITICAL(&lock);
+    bool applyConfig = pendingConfig;
+    bool benchmark = pendingBenchmark;
+    CaptureConfig next = nextConfig;
+    pendingConfig = false;
+    pendingBenchmark = false;
+    portEXIT_CRITICAL(&lock);
+
+    if (applyConfig) {
+        CaptureConfig previous = config;
+        if (!reinit(next)) {
+            Serial.println("Capture config rejected, restoring previous");
+            reinit(previous);
+        }
+    }
+    if (benchmark) {
+        runBenchmark();
+    }
+
+    portENTER_CRITICAL(&lock);
+    bool applySize = pendingFrameSize;
+    framesize_t size = nextFrameSize;
+    pendingFrameSize = false;
+    portEXIT_CRITICAL(&lock);
+
+    if (applySize && size != frameSize) {
+        applyFrameSize(size);
+    }
+
+    portENTER_CRITICAL(&lock);
+    bool applyView = pendingWindow;
+    SensorWindow view = nextWindow;
+    pendingWindow = false;
+    portEXIT_CRITICAL(&lock);
+
+    if (applyView) {
+        applyWindow(view);
+    }
+}
+
+bool Camera::requestFrameSize(framesize_t size) {
+    if (!isSupportedFrameSize(size)) return false;
+    portENTER_CRITICAL(&lock);
+    nextFrameSize = size;
+    pendingFrameSize = true;
+    portEXIT_CRITICAL(&lock);
+    return true;
+}
+
+bool Camera::applyFrameSize(framesize_t size) {
+    release();
+    unsigned long start = millis();
+    framesize_t previous = frameSize;
+    frameSize = size;
+
+    // 驱动帧缓冲按初始化分辨率分配，放大超过它时只能重新初始化
+    bool reinitialized = false;
+    sensor_t* s = esp_camera_sensor_get();
+    // set_framesize 恢复全幅视场，开窗时按新的输出尺寸重新写入窗口（重新初始化时由 init 写入）
+    if (framePixels(size) > framePixels(allocatedSize) || !s || s->set_framesize(s, size) != 0) {
+        reinitialized = true;
+        if (!reinit(config)) {
+            Serial.printf("Frame size %s rejected, restoring %s\n", frameSizeName(size), frameSizeName(previous));
+            frameSize = previous;
+            reinit(config);
+            portENTER_CRITICAL(&lock);
+            switchStats.failures++;
+            portEXIT_CRITICAL(&lock);
+            return false;
+        }
+    } else {
+        writeWindow();
+    }
+
+    // 排空队列中切换前采集的帧，直到拿到第一个完整的新尺寸帧
+    uint8_t dropped = 0;
+    bool ready = false;
+    while (!ready) {
+        camera_fb_t* frame = esp_camera_fb_get();
+        if (!frame) break;
+        ready = matchesFrameSize(frame);
+        esp_camera_fb_return(frame);
+        if (ready) break;
+        if (++dropped >= CAMERA_SWITCH_MAX_FRAMES) {
+            // 传感器没有按预期切换，重新初始化保证之后的帧尺寸一致
+            Serial.printf("Frame size switch exceeded %d frames, reinitializing\n", CAMERA_SWITCH_MAX_FRAMES);
+            reinitialized = true;
+            ready = reinit(config);
+            break;
+        }
+    }
+
+    uint32_t elapsed = millis() - start;
+    portENTER_CRITICAL(&lock);
+    switchStats.switches++;
+    switchStats.lastFrames = dropped;
+    switchStats.maxFrames = max(switchStats.maxFrames, dropped);
+    switchStats.lastMs = elapsed;
+    switchStats.maxMs = max(switchStats.maxMs, elapsed);
+    if (reinitialized) switchStats.reinits++;
+    if (!ready) switchStats.failures++;
+    portEXIT_CRITICAL(&lock);
+
+    Serial.printf("Frame size %s -> %s in %u ms, %u frames dropped%s\n", frameSizeName(previous),
+                  frameSizeName(size), (unsigned)elapsed, dropped, reinitialized ? " (reinit)" : "");
+    return ready;
+}
+
+bool Camera::requestWindow(const SensorWindow& next) {
+    if (next.width > 0 && (next.height == 0 || next.x + next.width > CAMERA_SENSOR_WIDTH ||
+                           next.y + next.height > CAMERA_SENSOR_HEIGHT)) {
+        return false;
+    }
+    portENTER_CRITICAL(&lock);
+    nextWindow = next.width > 0 ? next : SensorWindow{};
+    pendingWindow = true;
+    portEXIT_CRITICAL(&lock);
+    return true;
+}
+
+// 按当前输出尺寸写入窗口寄存器，未开窗时只记录全幅视场
+// 调用前传感器须处于 set_framesize 之后的全幅状态
+bool Camera::writeWindow() {
+    SensorWindow fitted = {0, 0, CAMERA_SENSOR_WIDTH, CAMERA_SENSOR_HEIGHT};
+    uint8_t scale = fullFieldScale(frameSize);
+    bool ok = true;
+
+    if (window.width > 0) {
+        int outWidth = resolution[frameSize].width;
+        int outHeight = resolution[frameSize].height;
+        SensorWindow modeWindow;
+        SensorWindow candidate;
+        const SensorMode& mode = fitWindow(window, outWidth, outHeight, candidate, modeWindow);
+        sensor_t* s = esp_camera_sensor_get();
+        ok = s && s->set_res_raw &&
+             s->set_res_raw(s, mode.id, 0, 0, 0, modeWindow.x, modeWindow.y, modeWindow.width,
+                            modeWindow.height, outWidth, outHeight, false, false) == 0;
+        if (ok) {
+            fitted = candidate;
+            scale = mode.scale;
+        } else {
+            // 写了一半的窗口寄存器可能使输出尺寸与驱动不一致，恢复全幅
+            Serial.println("Sensor window rejected, using full field");
+            if (s) s->set_framesize(s, frameSize);
+        }
+    }
+
+    portENTER_CRITICAL(&lock);
+    appliedWindow = fitted;
+    binning = scale;
+    portEXIT_CRITICAL(&lock);
+    return ok;
+}
+
+// 改变视场不改变帧尺寸，capture() 无法区分新旧视场的帧：丢弃写寄存器时已在队列和正在读出的帧
+bool Camera::applyWindow(const SensorWindow& next) {
+    release();
+    unsigned long start = millis();
+    portENTER_CRITICAL(&lock);
+    window = next;
+    portEXIT_CRITICAL(&lock);
+
+    sensor_t* s = esp_camera_sensor_get();
+    bool ok = s && s->set_framesize(s, frameSize) == 0 && writeWindow();
+
+    uint8_t dropped = 0;
+    for (uint8_t i = 0; i <= config.fbCount; i++) {
+        camera_fb_t* frame = esp_camera_fb_get();
+        if (!frame) break;
+        esp_camera_fb_return(frame);
+        dropped++;
+    }
+
+    uint32_t elapsed = millis() - start;
+    portENTER_CRITICAL(&lock);
+    switchStats.switches++;
+    switchStats.lastFrames = dropped;
+    switchStats.maxFrames = max(switchStats.maxFrames, dropped);
+    switchStats.lastMs = elapsed;
+    switchStats.maxMs = max(switchStats.maxMs, elapsed);
+    if (!ok) switchStats.failures++;
+    SensorWindow fitted = appliedWindow;
+    uint8_t scale = binning;
+    portEXIT_CRITICAL(&lock);
+
+    Serial.printf("Sensor window %u,%u %ux%u (1/%u readout) -> %s in %u ms, %u frames dropped\n", fitted.x,
+                  fitted.y, fitted.width, fitted.height, scale, frameSizeName(frameSize), (unsigned)elapsed,
+                  dropped);
+    return ok;
+}
+
+WindowStats Camera::getWindowStats() {
+    WindowStats stats;
+    portENTER_CRITICAL(&lock);
+    stats.requested = window;
+    stats.applied = appliedWindow;
+    stats.binning = binning;
+    stats.frameBytes = lastFrameBytes;
+    portEXIT_CRITICAL(&lock);
+
+    uint32_t area = (uint32_t)stats.applied.width * stats.applied.height;
+    stats.fullFieldBytes = area ? (uint32_t)((uint64_t)stats.frameBytes * CAMERA_SENSOR_WIDTH *
+                                             CAMERA_SENSOR_HEIGHT / area) : stats.frameBytes;
+    return stats;
+}
+
+FrameSizeSwitchStats Camera::getSwitchStats() {
+    portENTER_CRITICAL(&lock);
+    FrameSizeSwitchStats copy = switchStats;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
+
+bool Camera::isSupportedFrameSize(framesize_t size) {
+    if ((unsigned)size >= FRAMESIZE_INVALID) return false;
+    return resolution[size].width >= resolution[FRAMESIZE_QQVGA].width &&
+           resolution[size].height >= resolution[FRAMESIZE_QQVGA].height &&
+           framePixels(size) <= framePixels(CAMERA_MAX_FRAME_SIZE);
+}
+
+bool Camera::parseFrameSize(const char* name, framesize_t& size) {
+    for (const auto& entry : FRAME_SIZE_NAMES) {
+        if (strcmp(entry.name, name) == 0) {
+            size = entry.size;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Camera::frameSizeName(framesize_t size) {
+    for (const auto& entry : FRAME_SIZE_NAMES) {
+        if (entry.size == size) return entry.name;
+    }
+    return "unknown";
+}
+
+bool Camera::parsePixelFormat(const char* name, pixformat_t& format) {
+    if (strcmp(name, "rgb565") == 0) format = PIXFORMAT_RGB565;
+    else if (strcmp(name, "jpeg") == 0) format = PIXFORMAT_JPEG;
+    else return false;
+    return true;
+}
+
+const char* Camera::pixelFormatName(pixformat_t format) {
+    return format == PIXFORMAT_JPEG ? "jpeg" : format == PIXFORMAT_RGB565 ? "rgb565" : "unknown";
+}
+
+void Camera::runBenchmark() {
+    benchmarkRunning = true;
+    CaptureConfig previous = config;
+    CaptureBenchmarkResult results[BENCHMARK_MODES] = {};
+
+    for (uint8_t m = 0; m < BENCHMARK_MODES; m++) {
+        CaptureBenchmarkResult& r = results[m];
+        r.config = BENCHMARK_CONFIGS[m];
+        r.config.pixelFormat = previous.pixelFormat;  // 只比较采集参数，输出格式保持当前设置
+        r.ok = reinit(r.config);
+        if (!r.ok) continue;
+
+        // 预热：自动曝光收敛、队列填满
+        for (int i = 0; i < 5; i++) {
+            camera_fb_t* frame = esp_camera_fb_get();
+            if (frame) esp_camera_fb_return(frame);
+        }
+
+        // 连续取帧：驱动能提供的帧率和最小帧龄
+        uint64_t ageSum = 0;
+        uint32_t n = 0;
+        unsigned long start = micros();
+        for (int i = 0; i < CAMERA_BENCHMARK_FRAMES; i++) {
+            camera_fb_t* frame = esp_camera_fb_get();
+            if (!frame) continue;
+            ageSum += frameAgeUs(frame);
+            n++;
+            esp_camera_fb_return(frame);
+        }
+        unsigned long elapsed = micros() - start;
+        r.fps = elapsed ? n * 1000000.0f / elapsed : 0.0f;
+        r.avgAgeUs = n ? (uint32_t)(ageSum / n) : 0;
+
+        // 按采集任务的帧间隔取帧：消费者拿到的帧有多旧
+        ageSum = 0;
+        n = 0;
+        for (int i = 0; i < CAMERA_BENCHMARK_PACED_FRAMES; i++) {
+            vTaskDelay(pdMS_TO_TICKS(1000 / STREAM_FPS));
+            camera_fb_t* frame = esp_camera_fb_get();
+            if (!frame) continue;
+            uint32_t age = frameAgeUs(frame);
+            ageSum += age;
+            r.pacedMaxAgeUs = max(r.pacedMaxAgeUs, age);
+            n++;
+            esp_camera_fb_return(frame);
+        }
+        r.pacedAvgAgeUs = n ? (uint32_t)(ageSum / n) : 0;
+
+        Serial.printf("Benchmark %s/%u fb/%s/%u MHz: %.1f fps, age %u us, paced age %u us (max %u)\n",
+                      r.config.grabMode == CAMERA_GRAB_LATEST ? "latest" : "queued", r.config.fbCount,
+                      r.config.fbLocation == CAMERA_FB_IN_DRAM ? "DRAM" : "PSRAM",
+                      (unsigned)(r.config.xclkHz / 1000000), r.fps, (unsigned)r.avgAgeUs,
+                      (unsigned)r.pacedAvgAgeUs, (unsigned)r.pacedMaxAgeUs);
+    }
+
+    reinit(previous);
+
+    portENTER_CRITICAL(&lock);
+    memcpy(benchmarkResults, results, sizeof(results));
+    benchmarkCount = BENCHMARK_MODES;
+    portEXIT_CRITICAL(&lock);
+    benchmarkRunning = false;
+}
+
+uint8_t Camera::getBenchmarkResults(CaptureBenchmarkResult* out) {
+    portENTER_CRITICAL(&lock);
+    uint8_t n = benchmarkCount;
+    memcpy(out, benchmarkResults, sizeof(CaptureBenchmarkResult) * n);
+    portEXIT_CRITICAL(&lock);
+    return n;
 }
 
 camera_fb_t* Camera::getBuffer() {
@@ -88,13 +627,6 @@ uint8_t* Camera::getImageData() {
     return fb ? fb->buf : nullptr;
 }
 
-void Camera::setFrameSize(framesize_t size) {
-    sensor_t* s = esp_camera_sensor_get();
-    if (s) {
-        s->set_framesize(s, size);
-    }
-}
-
 void Camera::setQuality(uint8_t quality) {
     sensor_t* s = esp_camera_sensor_get();
     if (s) {
@@ -1,27 +1,119 @@
 #include "captive_portal.h"
 #include "logger.h"
+#include <WiFi.h>
+
+static const uint16_t DNS_PORT = 53;
+static const size_t DNS_HEADER_SIZE = 12;
+static const size_t DNS_MAX_PACKET = 512;
+static const uint16_t DNS_TYPE_A = 1;
+static const uint16_t DNS_TYPE_ANY = 255;
+static const uint32_t DNS_TTL_SEC = 60;
 
 void CaptivePortal::begin() {
-    if (dnsServer) return;
+    if (udp) return;
+
+    // A 记录：名称指针 0xC00C（指向问题区），类型 A，类 IN，TTL，4 字节地址
+    IPAddress ip = WiFi.softAPIP();
+    const uint8_t record[16] = {
+        0xC0, 0x0C,
+        0x00, 0x01,
+        0x00, 0x01,
+        (uint8_t)(DNS_TTL_SEC >> 24), (uint8_t)(DNS_TTL_SEC >> 16),
+        (uint8_t)(DNS_TTL_SEC >> 8), (uint8_t)DNS_TTL_SEC,
+        0x00, 0x04,
+        ip[0], ip[1], ip[2], ip[3]
+    };
+    memcpy(answer, record, sizeof(answer));
+
+    udp = new AsyncUDP();
+    if (!udp->listen(DNS_PORT)) {
+        Logger::error("CAPTIVE", "Failed to listen on UDP %d", DNS_PORT);
+        delete udp;
+        udp = nullptr;
+        return;
+    }
+    udp->onPacket([this](AsyncUDPPacket& packet) {
+        handlePacket(packet);
+    });
 
-    dnsServer = new DNSServer();
-    dnsServer->start(53, "*", WiFi.softAPIP());
     enabled = true;
     Logger::info("CAPTIVE", "DNS server started");
 }
 
-void CaptivePortal::update() {
-    if (dnsServer && enabled) {
-        dnsServer->processNextRequest();
+void CaptivePortal::handlePacket(AsyncUDPPacket& packet) {
+    unsigned long start = micros();
+    queries++;
+
+    const uint8_t* query = packet.data();
+    size_t length = packet.length();
+
+    // 只处理标准查询（QR=0，OPCODE=0）且至少有一个问题
+    if (length < DNS_HEADER_SIZE || length > DNS_MAX_PACKET ||
+        (query[2] & 0xF8) != 0 || ((query[4] << 8) | query[5]) == 0) {
+        dropped++;
+        return;
+    }
+
+    // 跳过第一个问题的名称
+    size_t pos = DNS_HEADER_SIZE;
+    while (pos < length && query[pos] != 0) {
+        if (query[pos] & 0xC0) {
+            dropped++;
+            return;
+        }
+        pos += query[pos] + 1;
+    }
+    pos++;  // 结束符
+    if (pos + 4 > length) {
+        dropped++;
+        return;
     }
+    uint16_t qtype = (query[pos] << 8) | query[pos + 1];
+    size_t questionEnd = pos + 4;
+
+    // 应答 = 请求头 + 第一个问题 + 缓存的 A 记录
+    uint8_t response[DNS_MAX_PACKET + sizeof(answer)];
+    memcpy(response, query, questionEnd);
+    bool hasAnswer = qtype == DNS_TYPE_A || qtype == DNS_TYPE_ANY;
+
+    response[2] = 0x84 | (query[2] & 0x01);  // QR=1，AA=1，保留 RD
+    response[3] = 0x00;                      // RCODE=NOERROR
+    response[4] = 0x00;
+    response[5] = 0x01;                      // QDCOUNT=1
+    response[6] = 0x00;
+    response[7] = hasAnswer ? 1 : 0;         // ANCOUNT
+    memset(response + 8, 0, 4);              // NSCOUNT、ARCOUNT（丢弃 EDNS）
+
+    size_t responseLength = questionEnd;
+    if (hasAnswer) {
+        memcpy(response + questionEnd, answer, sizeof(answer));
+        responseLength += sizeof(answer);
+    }
+
+    packet.write(response, responseLength);
+    answered++;
+
+    uint32_t latency = micros() - start;
+    totalLatencyUs += latency;
+    if (latency > maxLatencyUs) maxLatencyUs = latency;
 }
 
 void CaptivePortal::stop() {
-    if (dnsServer) {
-        dnsServer->stop();
-        delete dnsServer;
-        dnsServer = nullptr;
+    if (udp) {
+        udp->close();
+        delete udp;
+        udp = nullptr;
     }
     enabled = false;
     Logger::info("CAPTIVE", "DNS server stopped");
 }
+
+DnsStats CaptivePortal::getStats() const {
+    DnsStats stats;
+    stats.queries = queries;
+    stats.answered = answered;
+    stats.dropped = dropped;
+    stats.avgLatencyUs = answered ? totalLatencyUs / answered : 0;
+    stats.maxLatencyUs = maxLatencyUs;
+    return stats;
+}
@@ -0,0 +1,340 @@
+#include "clip_recorder.h"
+#include <img_converters.h>
+#include "buffer_pool.h"
+#include "image_scaler.h"
+#include "jpeg_encoder.h"
+#include "logger.h"
+
+static const char* CLIP_DIR = "/clips";
+static const char* OPEN_PATH = "/clips/open.avi";
+
+String ClipRecorder::clipPath(uint32_t id) {
+    char path[32];
+    snprintf(path, sizeof(path), "/clips/%u.avi", (unsigned)id);
+    return String(path);
+}
+
+bool ClipRecorder::FileSink::write(const uint8_t* data, size_t length) {
+    return file.write(data, length) == length;
+}
+
+bool ClipRecorder::FileSink::writeAt(uint32_t offset, const uint8_t* data, size_t length) {
+    size_t end = file.position();
+    bool ok = file.seek(offset) && file.write(data, length) == length;
+    return file.seek(end) && ok;
+}
+
+bool ClipRecorder::begin() {
+    mutex = xSemaphoreCreateMutex();
+    if (!mutex) return false;
+
+    if (!LittleFS.exists(CLIP_DIR) && !LittleFS.mkdir(CLIP_DIR)) {
+        Logger::error("CLIP", "Failed to create %s", CLIP_DIR);
+        return false;
+    }
+
+    // 掉电前未完成的短片没有索引，直接删除
+    if (LittleFS.exists(OPEN_PATH)) {
+        LittleFS.remove(OPEN_PATH);
+        Logger::warn("CLIP", "Removed unfinished clip");
+    }
+
+    size_t stored = 0;
+    File dir = LittleFS.open(CLIP_DIR);
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        const char* name = f.name();
+        const char* base = strrchr(name, '/');
+        unsigned id;
+        if (sscanf(base ? base + 1 : name, "%u.avi", &id) == 1) {
+            if (id >= nextId) nextId = id + 1;
+            stored++;
+        }
+    }
+
+    Logger::info("CLIP", "Clip recorder ready: %u stored, %u x %u ms frames max",
+                 (unsigned)stored, CLIP_MAX_FRAMES, CLIP_FRAME_INTERVAL_MS);
+    return true;
+}
+
+void ClipRecorder::trimStored(size_t keep) {
+    // ID 递增，最小的即最旧的
+    while (true) {
+        size_t count = 0;
+        uint32_t oldest = UINT32_MAX;
+        File dir = LittleFS.open(CLIP_DIR);
+        for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+            const char* name = f.name();
+            const char* base = strrchr(name, '/');
+            unsigned id;
+            if (sscanf(base ? base + 1 : name, "%u.avi", &id) == 1) {
+                count++;
+                if (id < oldest) oldest = id;
+            }
+        }
+        if (count <= keep || !LittleFS.remove(clipPath(oldest))) return;
+        Logger::info("CLIP", "Removed clip %u to make room", (unsigned)oldest);
+    }
+}
+
+bool ClipRecorder::start(uint32_t now) {
+    if (!mutex) return false;
+    if (recording) abort();
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    trimStored(CLIP_MAX_STORED - 1);
+    sink.file = LittleFS.open(OPEN_PATH, "w");
+    xSemaphoreGive(mutex);
+    if (!sink.file) {
+        Logger::warn("CLIP", "Failed to open %s", OPEN_PATH);
+        return false;
+    }
+
+    recording = true;
+    started = false;
+    truncated = false;
+    firstFrameMs = now;
+    lastFrameMs = 0;
+    frameIntervalMs = CLIP_FRAME_INTERVAL_MS;
+    return true;
+}
+
+bool ClipRecorder::isDue(uint32_t now) const {
+    return recording && !truncated && (!started || now - lastFrameMs >= frameIntervalMs);
+}
+
+// 帧缩小到 CLIP_WIDTH 后编码，输出来自缓冲池
+// 传感器 JPEG 先按 1/2、1/4、1/8 中不小于 CLIP_WIDTH 的最小尺寸解码为 RGB565：原样写入时 VGA 每帧
+// 几十 KB，CLIP_MAX_BYTES 只够几帧
+size_t ClipRecorder::encodeFrame(camera_fb_t* fb, uint8_t*& out, uint16_t& width, uint16_t& height) {
+    int srcWidth = fb->width;
+    int srcHeight = fb->height;
+    const uint8_t* src = fb->buf;
+    uint8_t* decoded = nullptr;
+    if (fb->format == PIXFORMAT_JPEG) {
+        int scale = JPG_SCALE_NONE;
+        while (scale < JPG_SCALE_MAX && (srcWidth >> (scale + 1)) >= CLIP_WIDTH) scale++;
+        srcWidth >>= scale;
+        srcHeight >>= scale;
+        decoded = bufferPool.acquire((size_t)srcWidth * srcHeight * 2);
+        if (!decoded) return 0;
+        if (!jpg2rgb565(fb->buf, fb->len, decoded, (jpg_scale_t)scale)) {
+            bufferPool.release(decoded);
+            return 0;
+        }
+        src = decoded;
+    }
+
+    CropRect full(0, 0, srcWidth, srcHeight);
+    int outWidth = CLIP_WIDTH;
+    int outHeight = 0;
+    ImageScaler::fitOutputSize(full, outWidth, outHeight);
+
+    const uint8_t* pixels = src;
+    uint8_t* scaled = nullptr;
+    if (outWidth != srcWidth) {
+        scaled = bufferPool.acquire((size_t)outWidth * outHeight * 2);
+        uint32_t* scratch = (uint32_t*)bufferPool.acquire(ImageScaler::scratchSize(outWidth));
+        if (scaled && scratch) {
+            ImageScaler::scaleRGB565(src, srcWidth, full, scaled, outWidth, outHeight, scratch);
+        }
+        if (scratch) bufferPool.release((uint8_t*)scratch);
+        if (!scratch && scaled) {
+            bufferPool.release(scaled);
+            scaled = nullptr;
+        }
+        if (!scaled) {
+            if (decoded) bufferPool.release(decoded);
+            return 0;
+        }
+        pixels = scaled;
+    }
+
+    size_t n = 0;
+    out = bufferPool.acquire((size_t)outWidth * outHeight);
+    if (out) {
+        n = JpegEncoder::encode(pixels, outWidth, outHeight, PIXFORMAT_RGB565, CLIP_JPEG_QUALITY,
+                                out, bufferPool.capacity(out));
+        if (n == 0) {
+            bufferPool.release(out);
+            out = nullptr;
+        }
+    }
+    if (scaled) bufferPool.release(scaled);
+    if (decoded) bufferPool.release(decoded);
+    width = outWidth;
+    height = outHeight;
+    return n;
+}
+
+bool ClipRecorder::appendFrame(const uint8_t* jpeg, size_t length, uint16_t width, uint16_t height) {
+    // 尺寸以首帧为准（AVI 只有一个尺寸），分辨率切换后的帧跳过
+    if (!started) {
+        if (!writer.begin(&sink, width, height, index, CLIP_MAX_FRAMES)) return false;
+        started = true;
+    } else if (width != writer.getWidth() || height != writer.getHeight()) {
+        return false;
+    }
+
+    if (writer.isFull() || writer.sizeWith(length) > CLIP_MAX_BYTES) {
+        truncated = true;
+        portENTER_CRITICAL(&statsLock);
+        stats.truncated++;
+        portEXIT_CRITICAL(&statsLock);
+        Logger::info("CLIP", "Clip limit reached at %u frames", writer.getFrames());
+        return true;
+    }
+    return writer.addFrame(jpeg, length);
+}
+
+void ClipRecorder::addFrame(camera_fb_t* fb, uint32_t now) {
+    if (!recording) return;
+    uint32_t t0 = micros();
+
+    bool ok = false;
+    if (fb->format == PIXFORMAT_JPEG || fb->format == PIXFORMAT_RGB565) {
+        uint8_t* jpeg = nullptr;
+        uint16_t width = 0;
+        uint16_t height = 0;
+        size_t n = encodeFrame(fb, jpeg, width, height);
+        ok = n > 0 && appendFrame(jpeg, n, width, height);
+        if (jpeg) bufferPool.release(jpeg);
+    }
+    if (ok && !truncated) {
+        if (writer.getFrames() == 1) firstFrameMs = now;
+        lastFrameMs = now;
+        uint32_t elapsed = now - firstFrameMs;
+        uint32_t remainingMs = elapsed < EVENT_MAX_DURATION_MS ? EVENT_MAX_DURATION_MS - elapsed : 0;
+        frameIntervalMs = writer.spreadInterval(CLIP_MAX_BYTES, remainingMs, CLIP_FRAME_INTERVAL_MS);
+    }
+
+    portENTER_CRITICAL(&statsLock);
+    if (!ok) stats.framesSkipped++;
+    stats.lastEncodeUs = micros() - t0;
+    portEXIT_CRITICAL(&statsLock);
+}
+
+void ClipRecorder::closeOpen() {
+    sink.file.close();
+    recording = false;
+    started = false;
+}
+
+bool ClipRecorder::finish(ClipInfo& info) {
+    if (!recording) return false;
+
+    uint16_t frames = started ? writer.getFrames() : 0;
+    // 帧间隔取实际平均值，AVI 按固定帧率回放
+    uint32_t usPerFrame = frames > 1 ? (lastFrameMs - firstFrameMs) * 1000 / (frames - 1)
+                                     : CLIP_FRAME_INTERVAL_MS * 1000;
+    bool ok = frames > 0 && writer.finish(usPerFrame);
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    closeOpen();
+    uint32_t id = nextId;
+    if (ok) ok = LittleFS.rename(OPEN_PATH, clipPath(id).c_str());
+    if (ok) nextId++;
+    else LittleFS.remove(OPEN_PATH);
+    xSemaphoreGive(mutex);
+
+    portENTER_CRITICAL(&statsLock);
+    if (ok) stats.clipsFinished++;
+    else stats.clipsAborted++;
+    portEXIT_CRITICAL(&statsLock);
+    if (!ok) return false;
+
+    info.id = id;
+    info.width = writer.getWidth();
+    info.height = writer.getHeight();
+    info.frames = frames;
+    info.bytes = writer.getBytes();
+    info.durationMs = (uint32_t)((uint64_t)frames * usPerFrame / 1000);
+    info.truncated = truncated;
+    Logger::info("CLIP", "Clip %u: %u frames %ux%u, %u bytes, %u ms", (unsigned)id, frames,
+                 info.width, info.height, (unsigned)info.bytes, (unsigned)info.durationMs);
+    return true;
+}
+
+void ClipRecorder::abort() {
+    if (!recording) return;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    closeOpen();
+    LittleFS.remove(OPEN_PATH);
+    xSemaphoreGive(mutex);
+
+    portENTER_CRITICAL(&statsLock);
+    stats.clipsAborted++;
+    portEXIT_CRITICAL(&statsLock);
+}
+
+bool ClipRecorder::readInfo(uint32_t id, ClipInfo& info) {
+    File file = LittleFS.open(clipPath(id), "r");
+    if (!file) return false;
+    uint8_t header[AviWriter::HEADER_BYTES];
+    AviFileInfo avi;
+    bool ok = file.read(header, sizeof(header)) == sizeof(header) &&
+              AviWriter::parseHeader(header, sizeof(header), avi);
+    info.id = id;
+    info.bytes = file.size();
+    file.close();
+    if (!ok) return false;
+
+    info.width = avi.width;
+    info.height = avi.height;
+    info.frames = avi.frames;
+    info.durationMs = (uint32_t)((uint64_t)avi.frames * avi.usPerFrame / 1000);
+    info.truncated = false;   // 不记录在文件中
+    return true;
+}
+
+size_t ClipRecorder::list(ClipInfo* out, size_t maxCount) {
+    if (!mutex) return 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    size_t n = 0;
+    File dir = LittleFS.open(CLIP_DIR);
+    for (File f = dir.openNextFile(); f && n < maxCount; f = dir.openNextFile()) {
+        const char* name = f.name();
+        const char* base = strrchr(name, '/');
+        unsigned id;
+        if (sscanf(base ? base + 1 : name, "%u.avi", &id) == 1 && readInfo(id, out[n])) {
+            n++;
+        }
+    }
+    xSemaphoreGive(mutex);
+
+    // 目录顺序不固定，按 ID 排序（条数很少）
+    for (size_t i = 1; i < n; i++) {
+        for (size_t j = i; j > 0 && out[j].id < out[j - 1].id; j--) {
+            ClipInfo tmp = out[j];
+            out[j] = out[j - 1];
+            out[j - 1] = tmp;
+        }
+    }
+    return n;
+}
+
+bool ClipRecorder::find(uint32_t id, ClipInfo& info) {
+    if (!mutex) return false;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool ok = readInfo(id, info);
+    xSemaphoreGive(mutex);
+    return ok;
+}
+
+bool ClipRecorder::remove(uint32_t id) {
+    if (!mutex) return false;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool ok = LittleFS.remove(clipPath(id));
+    xSemaphoreGive(mutex);
+    return ok;
+}
+
+ClipStats ClipRecorder::getStats() {
+    portENTER_CRITICAL(&statsLock);
+    ClipStats copy = stats;
+    portEXIT_CRITICAL(&statsLock);
+    copy.recording = recording;
+    copy.openFrames = started ? writer.getFrames() : 0;
+    copy.openBytes = started ? writer.getBytes() : 0;
+    copy.frameIntervalMs = frameIntervalMs;
+    return copy;
+}
@@ -0,0 +1,94 @@
+#include "cloud_client.h"
+#include "logger.h"
+#include "bandwidth_arbiter.h"
+#include <WiFi.h>
+
+MultipartForm::MultipartForm() {
+    snprintf(boundary, sizeof(boundary), "mycam%08x%08x", (unsigned)esp_random(), (unsigned)millis());
+    snprintf(contentType, sizeof(contentType), "multipart/form-data; boundary=%s", boundary);
+}
+
+size_t MultipartForm::formatPartHeader(char* out, size_t size, const char* name, const char* filename,
+                                       const char* type) const {
+    int n;
+    if (filename) {
+        n = snprintf(out, size,
+                     "--%s\r\nContent-Disposition: form-data; name=\"%s\"; filename=\"%s\"\r\n"
+                     "Content-Type: %s\r\n\r\n",
+                     boundary, name, filename, type);
+    } else {
+        n = snprintf(out, size,
+                     "--%s\r\nContent-Disposition: form-data; name=\"%s\"\r\n"
+                     "Content-Type: %s\r\n\r\n",
+                     boundary, name, type);
+    }
+    return n > 0 ? (size_t)n : 0;
+}
+
+size_t MultipartForm::partLength(const char* name, const char* filename, const char* type,
+                                 size_t dataLength) const {
+    char header[192];
+    return formatPartHeader(header, sizeof(header), name, filename, type) + dataLength + 2;
+}
+
+bool MultipartForm::writePartHeader(const HttpsWriteFn& write, const char* name, const char* filename,
+                                    const char* type) const {
+    char header[192];
+    size_t n = formatPartHeader(header, sizeof(header), name, filename, type);
+    return n < sizeof(header) && write((const uint8_t*)header, n);
+}
+
+bool MultipartForm::writePartEnd(const HttpsWriteFn& write) const {
+    return write((const uint8_t*)"\r\n", 2);
+}
+
+bool MultipartForm::writePart(const HttpsWriteFn& write, const char* name, const char* filename,
+                              const char* type, const uint8_t* data, size_t length) const {
+    return writePartHeader(write, name, filename, type) && write(data, length) && writePartEnd(write);
+}
+
+bool MultipartForm::writeClosing(const HttpsWriteFn& write) const {
+    char closing[48];
+    int n = snprintf(closing, sizeof(closing), "--%s--\r\n", boundary);
+    return write((const uint8_t*)closing, n);
+}
+
+void CloudClient::begin() {
+    String mac = WiFi.macAddress();
+    String suffix = mac.substring(mac.length() - 8);
+    suffix.replace(":", "");
+    suffix.toLowerCase();
+    deviceId = "cams3-" + suffix;
+}
+
+int CloudClient::post(const char* path, const char* contentType, size_t contentLength,
+                      const HttpsBodyWriter& writeBody, String* response) {
+    String fullPath = String(CLOUD_API_BASE_PATH) + path;
+    std::string body;
+
+    // 请求体都是后台上传：按令牌分块写入，有人观看实时流时只用剩余带宽
+    HttpsBodyWriter pacedBody = [&writeBody](const HttpsWriteFn& write) {
+        return writeBody([&write](const uint8_t* data, size_t len) {
+            while (len > 0) {
+                size_t n = min(len, (size_t)BW_BUCKET_BYTES);
+                bandwidthArbiter.pace(n);
+                uint32_t start = micros();
+                if (!write(data, n)) return false;
+                bandwidthArbiter.recordBackground(n, micros() - start, millis());
+                data += n;
+                len -= n;
+            }
+            return true;
+        });
+    };
+    int status = pool.request(CLOUD_API_HOST, CLOUD_API_PORT, "POST", fullPath.c_str(), nullptr,
+                              contentType, contentLength, writeBody ? pacedBody : writeBody,
+                              response ? &body : nullptr);
+    if (status < 0) {
+        Logger::warn("CLOUD", "POST %s failed (%d)", path, status);
+    }
+    if (response) {
+        *response = body.c_str();
+    }
+    return status;
+}
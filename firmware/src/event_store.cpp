@@ -0,0 +1,153 @@
+#include "event_store.h"
+#include "logger.h"
+#include <time.h>
+
+bool EventStore::begin() {
+    mutex = xSemaphoreCreateMutex();
+    if (!mutex) return false;
+
+    // 扫描按逻辑偏移升序回调，时间戳也是升序（now() 保证不回退）
+    bool ok = ring.begin(EVENT_PARTITION_LABEL, (esp_partition_subtype_t)EVENT_PARTITION_SUBTYPE,
+                         [this](uint32_t id, const RingRecordHeader& header) {
+        EventRecord record;
+        record.timestamp = header.timestamp;
+        record.score = header.tag;
+        record.flags = header.flags;
+        record.offset = id;
+        record.length = header.length;
+        push(record);
+    });
+    if (!ok) return false;
+
+    RingStoreStats stats = ring.getStats();
+    Logger::info("EVENTS", "Event store ready: %u events, %u bytes", (unsigned)count, (unsigned)stats.bytesUsed);
+    return true;
+}
+
+uint32_t EventStore::now() {
+    time_t t = time(nullptr);
+    // 未对时（1970 年附近）时退化为开机时间
+    uint32_t ts = t > 1600000000 ? (uint32_t)t : millis() / 1000;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (count > 0 && ts < at(count - 1).timestamp) {
+        ts = at(count - 1).timestamp;
+    }
+    xSemaphoreGive(mutex);
+    return ts;
+}
+
+bool EventStore::append(uint32_t timestamp, uint16_t score, const uint8_t* data, size_t length) {
+    if (!mutex || length == 0 || length > EVENT_MAX_BYTES) return false;
+
+    // 擦除和写入期间不持有索引锁，查询和图像读取照常进行
+    uint32_t id;
+    if (!ring.append(timestamp, score, data, length, id)) {
+        Logger::error("EVENTS", "Failed to write event data");
+        return false;
+    }
+
+    EventRecord record;
+    record.timestamp = timestamp;
+    record.score = score;
+    record.flags = 0;
+    record.offset = id;
+    record.length = length;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    while (count > 0 && !ring.isLive(at(0).offset)) {
+        dropOldest();
+    }
+    push(record);
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+void EventStore::push(const EventRecord& record) {
+    if (count == EVENT_INDEX_CAPACITY) {
+        dropOldest();
+    }
+    index[(head + count) % EVENT_INDEX_CAPACITY] = record;
+    count++;
+}
+
+void EventStore::dropOldest() {
+    head = (head + 1) % EVENT_INDEX_CAPACITY;
+    count--;
+}
+
+size_t EventStore::lowerBound(uint32_t timestamp) const {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (at(mid).timestamp < timestamp) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+size_t EventStore::upperBound(uint32_t timestamp) const {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (at(mid).timestamp <= timestamp) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+size_t EventStore::query(uint32_t since, uint32_t until, size_t skip,
+                         EventRecord* out, size_t maxCount, size_t* total) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    size_t first = lowerBound(since);
+    size_t last = upperBound(until);
+    size_t matches = last > first ? last - first : 0;
+
+    // skip 来自请求参数，先与匹配数比较，避免 first + skip 溢出
+    size_t n = 0;
+    if (skip < matches) {
+        for (size_t i = first + skip; i < last && n < maxCount; i++) {
+            out[n++] = at(i);
+        }
+    }
+    xSemaphoreGive(mutex);
+
+    if (total) *total = matches;
+    return n;
+}
+
+bool EventStore::find(uint32_t id, EventRecord& record) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    // 偏移随追加单调递增，按到最旧记录的距离二分（ID 回绕后仍有序）
+    size_t lo = 0, hi = count;
+    uint32_t base = count > 0 ? at(0).offset : 0;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (at(mid).offset - base < id - base) lo = mid + 1;
+        else hi = mid;
+    }
+    bool found = lo < count && at(lo).offset == id;
+    if (found) record = at(lo);
+    xSemaphoreGive(mutex);
+    return found;
+}
+
+size_t EventStore::readImage(const EventRecord& record, size_t pos, uint8_t* buffer, size_t len) {
+    return ring.read(record.offset, pos, buffer, len);
+}
+
+EventStoreStats EventStore::getStats() {
+    RingStoreStats ringStats = ring.getStats();
+    EventStoreStats stats;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    stats.events = count;
+    stats.oldestTimestamp = count > 0 ? at(0).timestamp : 0;
+    stats.newestTimestamp = count > 0 ? at(count - 1).timestamp : 0;
+    xSemaphoreGive(mutex);
+    stats.bytesUsed = ringStats.bytesUsed;
+    stats.capacity = ringStats.capacity;
+    stats.sectorErases = ringStats.sectorErases;
+    stats.wearLaps = ringStats.wearLaps;
+    stats.corruptRecords = ringStats.corruptRecords;
+    return stats;
+}
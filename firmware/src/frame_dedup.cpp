@@ -0,0 +1,38 @@
+#include "frame_dedup.h"
+
+bool FrameDeduplicator::check(uint64_t hash, uint32_t nowMs) {
+    uint8_t nearest = 64;
+    for (uint8_t i = 0; i < count; i++) {
+        if (nowMs - history[i].timeMs > DEDUP_WINDOW_MS) continue;
+        nearest = min(nearest, distance(hash, history[i].hash));
+    }
+
+    portENTER_CRITICAL(&lock);
+    bool duplicate = nearest <= maxDistance;
+    stats.candidates++;
+    stats.lastDistance = nearest;
+    if (duplicate) stats.suppressed++;
+    portEXIT_CRITICAL(&lock);
+
+    if (duplicate) return false;
+
+    // 只记录放行的帧，持续相似画面在窗口过期后重新上传一次
+    history[next] = {hash, nowMs};
+    next = (next + 1) % DEDUP_HISTORY_SIZE;
+    if (count < DEDUP_HISTORY_SIZE) count++;
+    return true;
+}
+
+void FrameDeduplicator::setMaxDistance(uint8_t distance) {
+    portENTER_CRITICAL(&lock);
+    maxDistance = distance;
+    portEXIT_CRITICAL(&lock);
+}
+
+FrameDedupStats FrameDeduplicator::getStats() {
+    portENTER_CRITICAL(&lock);
+    FrameDedupStats copy = stats;
+    copy.maxDistance = maxDistance;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
@@ -0,0 +1,135 @@
+#include "frame_recorder.h"
+#include "config.h"
+#include "image_scaler.h"
+#include "logger.h"
+#include "buffer_pool.h"
+
+static void freePsram(uint8_t* p) {
+    heap_caps_free(p);
+}
+
+bool FrameRecorder::begin() {
+    mutex = xSemaphoreCreateMutex();
+    return mutex != nullptr;
+}
+
+bool FrameRecorder::start(uint16_t frames, uint8_t dec, camera_fb_t* reference) {
+    if (!reference || reference->format != PIXFORMAT_RGB565) return false;
+    if (frames == 0 || dec == 0) return false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (state == RECORDING) {
+        xSemaphoreGive(mutex);
+        return false;
+    }
+
+    // 先分配新缓冲区，成功后再替换：分配失败时上一段录音保持可下载
+    uint16_t newWidth = reference->width / dec;
+    uint16_t newHeight = reference->height / dec;
+    uint32_t frameBytes = (uint32_t)newWidth * newHeight * 2;
+    size_t newSize = recordingSize(frames, frameBytes);
+
+    uint8_t* buffer = (uint8_t*)heap_caps_malloc(newSize, MALLOC_CAP_SPIRAM);
+    if (!buffer) {
+        Logger::error("REC", "Failed to allocate %u bytes for recording", (unsigned)newSize);
+        xSemaphoreGive(mutex);
+        return false;
+    }
+
+    bufferPool.release((uint8_t*)scratch);
+    scratch = (uint32_t*)bufferPool.acquire(ImageScaler::scratchSize(newWidth));
+    if (!scratch) {
+        heap_caps_free(buffer);
+        xSemaphoreGive(mutex);
+        return false;
+    }
+
+    // 释放上一段录音（正在下载的响应仍持有引用）
+    data = std::shared_ptr<uint8_t>(buffer, freePsram);
+    size = newSize;
+    width = newWidth;
+    height = newHeight;
+    decimation = dec;
+    totalFrames = frames;
+    recordedFrames = 0;
+
+    RecordingHeader header;
+    initRecordingHeader(header);
+    header.width = width;
+    header.height = height;
+    header.pixformat = reference->format;
+    sensor_t* s = esp_camera_sensor_get();
+    header.framesize = s ? s->status.framesize : CAMERA_FRAME_SIZE;
+    header.decimation = decimation;
+    header.frameCount = frames;
+    header.frameBytes = frameBytes;
+    memcpy(buffer, &header, sizeof(header));
+
+    state = RECORDING;
+    xSemaphoreGive(mutex);
+    Logger::info("REC", "Recording %u frames at %ux%u", frames, width, height);
+    return true;
+}
+
+// 调用者持有 mutex
+void FrameRecorder::abort() {
+    bufferPool.release((uint8_t*)scratch);
+    scratch = nullptr;
+    state = IDLE;
+}
+
+void FrameRecorder::addFrame(camera_fb_t* fb, bool liveMotion) {
+    if (state != RECORDING || !fb) return;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (state != RECORDING) {
+        xSemaphoreGive(mutex);
+        return;
+    }
+
+    // 录制期间分辨率或输出格式变化则放弃本段录音
+    if (fb->width / decimation != width || fb->height / decimation != height || fb->format != PIXFORMAT_RGB565) {
+        Logger::warn("REC", "Frame size or format changed, recording aborted");
+        abort();
+        xSemaphoreGive(mutex);
+        return;
+    }
+
+    uint32_t frameBytes = (uint32_t)width * height * 2;
+    uint8_t* slot = data.get() + recordingSize(recordedFrames, frameBytes);
+
+    RecordingFrameHeader frameHeader;
+    memset(&frameHeader, 0, sizeof(frameHeader));
+    frameHeader.timestampMs = fb->timestamp.tv_sec * 1000 + fb->timestamp.tv_usec / 1000;
+    frameHeader.length = frameBytes;
+    frameHeader.flags = liveMotion ? RECORDING_FLAG_LIVE_MOTION : 0;
+    memcpy(slot, &frameHeader, sizeof(frameHeader));
+
+    uint8_t* pixels = slot + sizeof(frameHeader);
+    if (decimation == 1) {
+        memcpy(pixels, fb->buf, frameBytes);
+    } else {
+        CropRect crop(0, 0, width * decimation, height * decimation);
+        ImageScaler::scaleRGB565(fb->buf, fb->width, crop, pixels, width, height, scratch);
+    }
+
+    recordedFrames = recordedFrames + 1;
+    if (recordedFrames >= totalFrames) {
+        bufferPool.release((uint8_t*)scratch);
+        scratch = nullptr;
+        state = COMPLETE;
+        Logger::info("REC", "Recording complete: %u bytes", (unsigned)size);
+    }
+    xSemaphoreGive(mutex);
+}
+
+std::shared_ptr<uint8_t> FrameRecorder::getCompleted(size_t& length) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    std::shared_ptr<uint8_t> copy;
+    if (state == COMPLETE) {
+        copy = data;
+        length = size;
+    }
+    xSemaphoreGive(mutex);
+    return copy;
+}
@@ -5,26 +5,215 @@
 #include "provisioning_manager.h"
 #include "wifi_scanner.h"
 #include "logger.h"
+#include "image_scaler.h"
+#include "frame_recorder.h"
+#include "buffer_pool.h"
+#include "jpeg_encoder.h"
+#include "latency_tracer.h"
+#include "parallel.h"
+#include "bandwidth_arbiter.h"
 #include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <memory>
 
 // 外部引用运动检测状态
 extern bool g_motionDetected;
 
+static const size_t BMP_HEADER_SIZE = 54;
+
+// 构建 16 位自顶向下 BMP 文件头
+static void writeBmpHeader(uint8_t* header, int width, int height) {
+    memset(header, 0, BMP_HEADER_SIZE);
+    header[0] = 'B';
+    header[1] = 'M';
+    uint32_t fileSize = width * height * 2 + BMP_HEADER_SIZE;
+    memcpy(header + 2, &fileSize, 4);
+    header[10] = BMP_HEADER_SIZE;  // offset to pixel data
+    header[14] = 40;  // BITMAPINFOHEADER size
+    int32_t w = width;
+    int32_t h = -height;  // negative for top-down
+    memcpy(header + 18, &w, 4);
+    memcpy(header + 22, &h, 4);
+    header[26] = 1;  // planes
+    header[28] = 16;  // bits per pixel (RGB565)
+}
+
+// 帧响应的时间戳：帧自身的 FrameTrace 加上本次请求的编码起止
+struct ResponseTrace {
+    FrameTrace frame;
+    int64_t encodeStartUs;
+    int64_t encodedUs;
+};
+
+static void appendTiming(String& header, const char* name, int64_t fromUs, int64_t toUs) {
+    if (fromUs == 0 || toUs == 0) return;
+    char entry[40];
+    snprintf(entry, sizeof(entry), "%s%s;dur=%.3f", header.length() ? ", " : "", name, (toUs - fromUs) / 1000.0);
+    header += entry;
+}
+
+// 帧序号、传感器时间戳和各阶段耗时（Server-Timing，浏览器开发者工具可直接显示）
+static void addTraceHeaders(AsyncWebServerResponse* response, const ResponseTrace& trace) {
+    const FrameTrace& f = trace.frame;
+    response->addHeader("X-Frame-Seq", String(f.seq));
+    char stamp[24];
+    snprintf(stamp, sizeof(stamp), "%lld", (long long)f.sensorUs);
+    response->addHeader("X-Frame-Timestamp", stamp);
+
+    String timing;
+    appendTiming(timing, "capture", f.sensorUs, f.capturedUs);
+    appendTiming(timing, "analysis", f.capturedUs, f.analyzedUs);
+    appendTiming(timing, "wait", f.analyzedUs, trace.encodeStartUs);
+    appendTiming(timing, "encode", trace.encodeStartUs, trace.encodedUs);
+    response->addHeader("Server-Timing", timing);
+}
+
+// 分块发送共享缓冲区，响应销毁时释放引用（包括客户端中途断开）
+// @param trace 帧响应带上时间戳响应头，并记录编码和发送阶段的延迟
+static void sendSharedBuffer(AsyncWebServerRequest* request, const char* contentType,
+                             std::shared_ptr<uint8_t> data, size_t size,
+                             const ResponseTrace* trace = nullptr) {
+    ResponseTrace t = trace ? *trace : ResponseTrace{};
+    int64_t firstByteUs = 0;
+    AsyncWebServerResponse* response = request->beginResponse(
+        contentType,
+        size,
+        [data, size, t, firstByteUs](uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+            if (index >= size) {
+                return 0;
+            }
+            size_t toSend = size - index;
+            if (toSend > maxLen) {
+                toSend = maxLen;
+            }
+            memcpy(buffer, data.get() + index, toSend);
+
+            // 时间点是数据交给 TCP 发送缓冲区，不是到达对端
+            if (t.encodedUs) {
+                bandwidthArbiter.recordLive(toSend, millis());
+                int64_t now = esp_timer_get_time();
+                if (index == 0) {
+                    firstByteUs = now;
+                    latencyTracer.record(LATENCY_FIRST_BYTE, t.encodedUs, now);
+                }
+                if (index + toSend >= size) {
+                    latencyTracer.record(LATENCY_SEND, firstByteUs, now);
+                    latencyTracer.record(LATENCY_TOTAL, t.frame.sensorUs, now);
+                }
+            }
+            return toSend;
+        }
+    );
+    response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate");
+    if (trace) {
+        latencyTracer.record(LATENCY_WAIT, trace->frame.analyzedUs, trace->encodeStartUs);
+        latencyTracer.record(LATENCY_ENCODE, trace->encodeStartUs, trace->encodedUs);
+        addTraceHeaders(response, *trace);
+    }
+    request->send(response);
+}
+
+// 发送缓冲池中的缓冲区，发送完成后归还
+static void sendPooledBuffer(AsyncWebServerRequest* request, const char* contentType,
+                             uint8_t* data, size_t size, const ResponseTrace* trace = nullptr) {
+    std::shared_ptr<uint8_t> owned(data, [](uint8_t* p) { bufferPool.release(p); });
+    sendSharedBuffer(request, contentType, owned, size, trace);
+}
+
+// /stream 的整帧缓冲区：整帧槽按 STREAM_MAX_VIEWERS 预留，用尽时返回空（计入缓冲池 failures），
+// 调用者回 503，不回退到逐帧 malloc
+static std::shared_ptr<uint8_t> acquireStreamBuffer(size_t size) {
+    uint8_t* buffer = bufferPool.acquire(size);
+    if (!buffer) return nullptr;
+    return std::shared_ptr<uint8_t>(buffer, [](uint8_t* p) { bufferPool.release(p); });
+}
+
+// 传感器输出的 JPEG 帧拷贝到缓冲池，调用者持有帧锁
+static uint8_t* copyToPool(const camera_fb_t* fb) {
+    uint8_t* copy = bufferPool.acquire(fb->len);
+    if (copy) memcpy(copy, fb->buf, fb->len);
+    return copy;
+}
+
+static int intParam(AsyncWebServerRequest* request, const char* name, int defaultValue) {
+    if (!request->hasParam(name)) return defaultValue;
+    return request->getParam(name)->value().toInt();
+}
+
+static uint32_t uintParam(AsyncWebServerRequest* request, const char* name, uint32_t defaultValue) {
+    if (!request->hasParam(name)) return defaultValue;
+    return strtoul(request->getParam(name)->value().c_str(), nullptr, 10);
+}
+
+// 路由按前缀匹配，带子路径的父路由用它只接受完整路径，不依赖注册顺序
+// 已知长度的响应体中途读不出数据时由填充回调调用，返回 0。
+// 不能在回调里 close()：连接的释放回调会删除 _ack 仍在使用的请求和响应；
+// 返回 0 时响应既不结束也不再有数据，改为设 1 秒接收超时，由 AsyncTCP 自己的轮询在回调之外关闭连接
+static size_t endBodyShort(AsyncWebServerRequest* request) {
+    request->client()->setRxTimeout(1);
+    return 0;
+}
+
+static ArRequestFilterFunction exactPath(const char* path) {
+    return [path](AsyncWebServerRequest* request) { return request->url() == path; };
+}
+
+static void addWindow(JsonObject parent, const char* key, const SensorWindow& window) {
+    JsonObject obj = parent.createNestedObject(key);
+    obj["x"] = window.x;
+    obj["y"] = window.y;
+    obj["width"] = window.width;
+    obj["height"] = window.height;
+}
+
+// 解析单区间 Range 头：bytes=a-b / bytes=a- / bytes=-n
+// @return false 表示区间无法满足（416）
+static bool parseRange(const String& header, size_t total, size_t& start, size_t& end) {
+    const char* p = header.c_str();
+    if (strncmp(p, "bytes=", 6) != 0 || strchr(p, ',')) return false;
+    p += 6;
+
+    char* dash = nullptr;
+    if (*p == '-') {
+        size_t suffix = strtoul(p + 1, nullptr, 10);
+        if (suffix == 0) return false;
+        start = suffix >= total ? 0 : total - suffix;
+        end = total - 1;
+        return true;
+    }
+
+    start = strtoul(p, &dash, 10);
+    if (!dash || *dash != '-' || start >= total) return false;
+    end = dash[1] ? strtoul(dash + 1, nullptr, 10) : total - 1;
+    if (end >= total) end = total - 1;
+    return end >= start;
+}
+
 void HTTPServer::begin() {
+    frameMutex = xSemaphoreCreateMutex();
     setupRoutes();
     server.begin();
     Serial.println("HTTP Server started");
     Serial.printf("Stream URL: http://%s/stream\n", WiFi.localIP().toString().c_str());
 }
 
+void HTTPServer::lockFrame() {
+    if (frameMutex) xSemaphoreTake(frameMutex, portMAX_DELAY);
+}
+
+void HTTPServer::unlockFrame() {
+    if (frameMutex) xSemaphoreGive(frameMutex);
+}
+
 void HTTPServer::setBuffer(camera_fb_t* fb) {
     currentFb = fb;
+    currentTrace = fb && camera ? camera->getTrace() : FrameTrace{};
 }
 
 void HTTPServer::setupRoutes() {
     // WiFi 配置页面
     server.on("/provision", HTTP_GET, [](AsyncWebServerRequest* request) {
-        const char* html = R"(
+        const char* html = R"rawliteral(
 <!DOCTYPE html>
 <html>
 <head>
@@ -192,17 +381,17 @@ void HTTPServer::setupRoutes() {
     </script>
 </body>
 </html>
-        )";
+        )rawliteral";
         request->send(200, "text/html", html);
     });
 
     // AP 模式下重定向根路径到配置页
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest* request) {
+    server.on("/", HTTP_GET, [this](AsyncWebServerRequest* request) {
         if (provManager && provManager->getState() == AP_PROVISIONING) {
             request->redirect("/provision");
         } else {
             // 原有的预览页面
-            const char* html = R"(
+            const char* html = R"rawliteral(
 <!DOCTYPE html>
 <html>
 <head>
@@ -223,66 +412,63 @@ void HTTPServer::setupRoutes() {
     </script>
 </body>
 </html>
-            )";
+            )rawliteral";
             request->send(200, "text/html", html);
         }
     });
 
-    // 实时视频流端点 (RGB565 格式，浏览器兼容)
+    // 实时视频流端点 (RGB565 输出为 BMP，JPEG 输出原样转发，浏览器兼容)
     server.on("/stream", HTTP_GET, [this](AsyncWebServerRequest* request) {
-        if (!currentFb) {
+        if (powerManager) powerManager->notifyActivity();
+        bandwidthArbiter.noteViewer(millis());
+
+        // 拷贝期间持有当前帧，尺寸与像素来自同一帧
+        lockFrame();
+        camera_fb_t* fb = currentFb;
+        if (!fb) {
+            unlockFrame();
             request->send(503, "text/plain", "No image available");
             return;
         }
 
+        ResponseTrace trace = {currentTrace, esp_timer_get_time(), 0};
+
+        if (fb->format == PIXFORMAT_JPEG) {
+            size_t jpgSize = fb->len;
+            std::shared_ptr<uint8_t> jpgBuffer = acquireStreamBuffer(jpgSize);
+            if (jpgBuffer) memcpy(jpgBuffer.get(), fb->buf, jpgSize);
+            unlockFrame();
+            if (!jpgBuffer) {
+                request->send(503, "text/plain", "Memory allocation failed");
+                return;
+            }
+            trace.encodedUs = esp_timer_get_time();
+            sendSharedBuffer(request, "image/jpeg", jpgBuffer, jpgSize, &trace);
+            return;
+        }
+
         // RGB565 格式：width * height * 2 字节
-        size_t bmpDataSize = currentFb->width * currentFb->height * 2 + 54;  // +54 for BMP header
-        uint8_t* bmpBuffer = (uint8_t*)malloc(bmpDataSize);
+        size_t pixelSize = (size_t)fb->width * fb->height * 2;
+        size_t bmpDataSize = pixelSize + BMP_HEADER_SIZE;
+        std::shared_ptr<uint8_t> bmpBuffer = acquireStreamBuffer(bmpDataSize);
         if (!bmpBuffer) {
+            unlockFrame();
             request->send(503, "text/plain", "Memory allocation failed");
             return;
         }
 
-        // 构建 BMP 文件头
-        uint8_t header[54] = {0};
-        header[0] = 'B';
-        header[1] = 'M';
-        uint32_t fileSize = bmpDataSize;
-        memcpy(header + 2, &fileSize, 4);
-        header[10] = 54;  // offset to pixel data
-        header[14] = 40;  // BITMAPINFOHEADER size
-        int32_t width = currentFb->width;
-        int32_t height = -currentFb->height;  // negative for top-down
-        memcpy(header + 18, &width, 4);
-        memcpy(header + 22, &height, 4);
-        header[26] = 1;  // planes
-        header[28] = 16;  // bits per pixel (RGB565)
-
-        memcpy(bmpBuffer, header, 54);
-        memcpy(bmpBuffer + 54, currentFb->buf, currentFb->len);
-
-        AsyncWebServerResponse* response = request->beginResponse(
-            "image/bmp",
-            bmpDataSize,
-            [bmpBuffer](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
-                if (index >= bmpDataSize) {
-                    free(bmpBuffer);
-                    return 0;
-                }
-                size_t toSend = bmpDataSize - index;
-                if (toSend > maxLen) {
-                    toSend = maxLen;
-                }
-                memcpy(buffer, bmpBuffer + index, toSend);
-                if (index + toSend >= bmpDataSize) {
-                    free(bmpBuffer);
-                }
-                return toSend;
-            }
-        );
-        response->addHeader("Content-Type", "image/bmp");
-        response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate");
-        request->send(response);
+        writeBmpHeader(bmpBuffer.get(), fb->width, fb->height);
+        memcpy(bmpBuffer.get() + BMP_HEADER_SIZE, fb->buf, min(pixelSize, fb->len));
+        unlockFrame();
+        trace.encodedUs = esp_timer_get_time();
+
+        sendSharedBuffer(request, "image/bmp", bmpBuffer, bmpDataSize, &trace);
+    });
+
+    // 按需缩放/裁剪快照端点
+    // 参数：w/h 输出尺寸，x/y/cw/ch 裁剪区域，format=bmp|jpeg，q JPEG 质量
+    server.on("/snapshot", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleSnapshot(request);
     });
 
     // 运动状态端点
@@ -292,19 +478,1012 @@ void HTTPServer::setupRoutes() {
         request->send(200, "application/json", json);
     });
 
+    // 内存与缓冲池统计
+    server.on("/api/memory", HTTP_GET, [](AsyncWebServerRequest* request) {
+        static const char* classNames[BUFFER_CLASS_COUNT] = {"small", "medium", "large"};
+        StaticJsonDocument<768> doc;
+        doc["heap_size"] = ESP.getHeapSize();
+        doc["free_heap"] = ESP.getFreeHeap();
+        doc["min_free_heap"] = ESP.getMinFreeHeap();
+        doc["psram_size"] = ESP.getPsramSize();
+        doc["free_psram"] = ESP.getFreePsram();
+        doc["min_free_psram"] = ESP.getMinFreePsram();
+        JsonArray pool = doc.createNestedArray("pool");
+        for (int i = 0; i < BUFFER_CLASS_COUNT; i++) {
+            BufferClassStats stats = bufferPool.getStats((BufferClass)i);
+            JsonObject cls = pool.createNestedObject();
+            cls["class"] = classNames[i];
+            cls["slot_size"] = stats.slotSize;
+            cls["slots"] = stats.slots;
+            cls["in_use"] = stats.inUse;
+            cls["high_water"] = stats.highWater;
+            cls["acquires"] = stats.acquires;
+            cls["failures"] = stats.failures;
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // 帧延迟直方图（/stream、/snapshot 的各阶段，单位微秒）
+    server.on("/api/latency", HTTP_GET, [](AsyncWebServerRequest* request) {
+        DynamicJsonDocument doc(1536);
+        JsonArray stages = doc.createNestedArray("stages");
+        for (int i = 0; i < LATENCY_STAGE_COUNT; i++) {
+            LatencyHistogram h = latencyTracer.getHistogram((LatencyStage)i);
+            JsonObject stage = stages.createNestedObject();
+            stage["stage"] = LatencyTracer::stageName((LatencyStage)i);
+            stage["count"] = h.count;
+            stage["avg_us"] = h.count ? (uint32_t)(h.totalUs / h.count) : 0;
+            stage["p50_us"] = LatencyTracer::percentile(h, 50);
+            stage["p90_us"] = LatencyTracer::percentile(h, 90);
+            stage["p99_us"] = LatencyTracer::percentile(h, 99);
+            stage["max_us"] = h.maxUs;
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    server.on("/api/latency", HTTP_DELETE, [](AsyncWebServerRequest* request) {
+        latencyTracer.reset();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // 帧分析双核分段：关闭后与 /api/latency 的 analysis 阶段对照
+    server.on("/api/parallel", HTTP_GET, [](AsyncWebServerRequest* request) {
+        ParallelStats stats = parallelRunner.getStats();
+        StaticJsonDocument<256> doc;
+        doc["enabled"] = stats.enabled;
+        doc["runs"] = stats.runs;
+        doc["solo_runs"] = stats.soloRuns;
+        doc["inline_runs"] = stats.inlineRuns;
+        doc["items"] = stats.items;
+        doc["helper_items"] = stats.helperItems;
+        doc["helper_share"] = stats.items ? (float)stats.helperItems / stats.items : 0.0f;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    server.on("/api/parallel", HTTP_POST, [](AsyncWebServerRequest* request) {
+        if (!request->hasParam("enabled", true)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"MISSING_PARAMS\"}");
+            return;
+        }
+        parallelRunner.setEnabled(request->getParam("enabled", true)->value() == "true");
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // 实时预览与后台上传的带宽分配：关闭后后台不限速，对照 live_bps 与 /stream 帧延迟
+    server.on("/api/bandwidth", HTTP_GET, [](AsyncWebServerRequest* request) {
+        BandwidthStats stats = bandwidthArbiter.getStats(millis());
+        StaticJsonDocument<384> doc;
+        doc["enabled"] = stats.enabled;
+        doc["live_active"] = stats.liveActive;
+        doc["link_bps"] = stats.linkBps;
+        doc["allowance_bps"] = stats.allowanceBps;
+        JsonObject live = doc.createNestedObject("live");
+        live["bps"] = stats.liveBps;
+        live["bytes"] = stats.liveBytes;
+        JsonObject background = doc.createNestedObject("background");
+        background["bps"] = stats.backgroundBps;
+        background["bytes"] = stats.backgroundBytes;
+        background["paced_ms"] = stats.pacedMs;
+        doc["backoffs"] = stats.backoffs;
+        doc["congestions"] = stats.congestions;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    server.on("/api/bandwidth", HTTP_POST, [](AsyncWebServerRequest* request) {
+        if (!request->hasParam("enabled", true)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"MISSING_PARAMS\"}");
+            return;
+        }
+        bandwidthArbiter.setEnabled(request->getParam("enabled", true)->value() == "true");
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
     // 健康检查
     server.on("/health", HTTP_GET, [](AsyncWebServerRequest* request) {
         request->send(200, "application/json", "{\"status\":\"ok\"}");
     });
 
+    setupRecordingRoutes();
+    setupPowerRoutes();
+    setupEventRoutes();
+    setupClipRoutes();
+    setupTimelapseRoutes();
+    setupHttpsRoutes();
+    setupRtspRoutes();
+    setupMotionRoutes();
+    setupTripwireRoutes();
+    setupCameraRoutes();
     setupProvisioningRoutes();
 }
 
+void HTTPServer::handleSnapshot(AsyncWebServerRequest* request) {
+    if (powerManager) powerManager->notifyActivity();
+
+    // 缩放完成前持有当前帧
+    lockFrame();
+    camera_fb_t* fb = currentFb;
+    if (!fb) {
+        unlockFrame();
+        request->send(503, "text/plain", "No image available");
+        return;
+    }
+
+    ResponseTrace trace = {currentTrace, esp_timer_get_time(), 0};
+
+    // 传感器 JPEG 只能整帧原样返回，缩放、裁剪和格式转换需要 RGB565 输出
+    bool wholeFrame = !request->hasParam("w") && !request->hasParam("h") && !request->hasParam("x") &&
+                      !request->hasParam("y") && !request->hasParam("cw") && !request->hasParam("ch");
+    if (fb->format == PIXFORMAT_JPEG && wholeFrame &&
+        (!request->hasParam("format") || request->getParam("format")->value() == "jpeg")) {
+        size_t jpgSize = fb->len;
+        uint8_t* jpgBuffer = copyToPool(fb);
+        unlockFrame();
+        if (!jpgBuffer) {
+            request->send(503, "text/plain", "Buffer pool exhausted");
+            return;
+        }
+        trace.encodedUs = esp_timer_get_time();
+        sendPooledBuffer(request, "image/jpeg", jpgBuffer, jpgSize, &trace);
+        return;
+    }
+    if (fb->format != PIXFORMAT_RGB565) {
+        unlockFrame();
+        request->send(503, "text/plain", "Unsupported frame format");
+        return;
+    }
+
+    CropRect crop(intParam(request, "x", 0), intParam(request, "y", 0),
+                  intParam(request, "cw", 0), intParam(request, "ch", 0));
+    if (!ImageScaler::clampCrop(crop, fb->width, fb->height)) {
+        unlockFrame();
+        request->send(400, "application/json", "{\"error\":\"INVALID_CROP\"}");
+        return;
+    }
+
+    int outWidth = intParam(request, "w", 0);
+    int outHeight = intParam(request, "h", 0);
+    ImageScaler::fitOutputSize(crop, outWidth, outHeight);
+
+    bool jpeg = request->hasParam("format") && request->getParam("format")->value() == "jpeg";
+    int quality = constrain(intParam(request, "q", CAMERA_JPEG_QUALITY), 1, 63);
+
+    // 只占用输出尺寸的缓冲区（BMP 头预留在前面）
+    size_t pixelSize = (size_t)outWidth * outHeight * 2;
+    uint8_t* outBuffer = bufferPool.acquire(pixelSize + BMP_HEADER_SIZE);
+    uint8_t* scratch = bufferPool.acquire(ImageScaler::scratchSize(outWidth));
+    if (!outBuffer || !scratch) {
+        unlockFrame();
+        bufferPool.release(outBuffer);
+        bufferPool.release(scratch);
+        request->send(503, "text/plain", "Buffer pool exhausted");
+        return;
+    }
+
+    uint8_t* pixels = outBuffer + BMP_HEADER_SIZE;
+    ImageScaler::scaleRGB565(fb->buf, fb->width, crop, pixels, outWidth, outHeight, (uint32_t*)scratch);
+    unlockFrame();
+    bufferPool.release(scratch);
+
+    if (!jpeg) {
+        writeBmpHeader(outBuffer, outWidth, outHeight);
+        trace.encodedUs = esp_timer_get_time();
+        sendPooledBuffer(request, "image/bmp", outBuffer, pixelSize + BMP_HEADER_SIZE, &trace);
+        return;
+    }
+
+    // JPEG 结果不会超过原始像素大小，编码到同级的另一个槽
+    uint8_t* jpgBuffer = bufferPool.acquire(pixelSize);
+    if (!jpgBuffer) {
+        bufferPool.release(outBuffer);
+        request->send(503, "text/plain", "Buffer pool exhausted");
+        return;
+    }
+    size_t jpgSize = JpegEncoder::encode(pixels, outWidth, outHeight, PIXFORMAT_RGB565,
+                                         quality, jpgBuffer, bufferPool.capacity(jpgBuffer));
+    bufferPool.release(outBuffer);
+    if (jpgSize == 0) {
+        bufferPool.release(jpgBuffer);
+        request->send(500, "text/plain", "JPEG encode failed");
+        return;
+    }
+    trace.encodedUs = esp_timer_get_time();
+    sendPooledBuffer(request, "image/jpeg", jpgBuffer, jpgSize, &trace);
+}
+
+void HTTPServer::setupRecordingRoutes() {
+    if (!frameRecorder) return;
+
+    // 开始录制：frames 帧数，scale 降采样倍数
+    server.on("/api/record/start", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        int frames = constrain(intParam(request, "frames", RECORD_DEFAULT_FRAMES), 1, RECORD_MAX_FRAMES);
+        int scale = constrain(intParam(request, "scale", RECORD_DEFAULT_DECIMATION), 1, 8);
+
+        if (frameRecorder->getState() == FrameRecorder::RECORDING) {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"BUSY\"}");
+            return;
+        }
+        lockFrame();
+        bool started = frameRecorder->start(frames, scale, currentFb);
+        unlockFrame();
+        if (!started) {
+            request->send(503, "application/json", "{\"success\":false,\"error\":\"START_FAILED\"}");
+            return;
+        }
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // 录制进度
+    server.on("/api/record/status", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        static const char* stateNames[] = {"idle", "recording", "complete"};
+        char json[128];
+        snprintf(json, sizeof(json), "{\"state\":\"%s\",\"frames\":%u,\"total\":%u,\"bytes\":%u}",
+                 stateNames[frameRecorder->getState()],
+                 (unsigned)frameRecorder->getRecordedFrames(),
+                 (unsigned)frameRecorder->getTotalFrames(),
+                 (unsigned)frameRecorder->getSize());
+        request->send(200, "application/json", json);
+    });
+
+    // 下载 .mcfr 文件
+    server.on("/api/record/download", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        size_t size = 0;
+        std::shared_ptr<uint8_t> data = frameRecorder->getCompleted(size);
+        if (!data) {
+            request->send(404, "application/json", "{\"error\":\"NO_RECORDING\"}");
+            return;
+        }
+        sendSharedBuffer(request, "application/octet-stream", data, size);
+    });
+}
+
+void HTTPServer::setupPowerRoutes() {
+    if (!powerManager) return;
+
+    // 功耗状态驻留时间与唤醒延迟
+    server.on("/api/power", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        PowerStats stats = powerManager->getStats();
+        unsigned long total = stats.residencyMs[POWER_ACTIVE] + stats.residencyMs[POWER_IDLE];
+
+        StaticJsonDocument<512> doc;
+        doc["state"] = stats.state == POWER_IDLE ? "idle" : "active";
+        doc["idle_enabled"] = powerManager->isIdleEnabled();
+        doc["active_ms"] = stats.residencyMs[POWER_ACTIVE];
+        doc["idle_ms"] = stats.residencyMs[POWER_IDLE];
+        doc["idle_percent"] = total ? stats.residencyMs[POWER_IDLE] * 100.0 / total : 0.0;
+        doc["wake_count"] = stats.wakeCount;
+        doc["last_wake_ms"] = stats.lastWakeMs;
+        doc["max_wake_ms"] = stats.maxWakeMs;
+        doc["last_wake_frames"] = stats.lastWakeFrames;
+        doc["max_wake_frames"] = stats.maxWakeFrames;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // 开关空闲模式（市电供电的设备可关闭）
+    server.on("/api/power", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        if (!request->hasParam("idle", true)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"MISSING_PARAMS\"}");
+            return;
+        }
+        powerManager->setIdleEnabled(request->getParam("idle", true)->value() == "true");
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+}
+
+void HTTPServer::setupEventRoutes() {
+    if (!eventStore) return;
+
+    // 路由按前缀匹配（"/api/events" 也匹配 "/api/events/stats"），子路径先注册，父路由再加 exactPath
+
+    // 事件图像，支持 Range 断点续传
+    server.on("/api/events/image", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleEventImage(request);
+    });
+
+    server.on("/api/events/stats", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        EventStoreStats stats = eventStore->getStats();
+        char json[256];
+        snprintf(json, sizeof(json),
+                 "{\"events\":%u,\"oldest\":%u,\"newest\":%u,\"bytes_used\":%u,\"capacity\":%u,"
+                 "\"sector_erases\":%u,\"wear_laps\":%u,\"corrupt_records\":%u}",
+                 (unsigned)stats.events, (unsigned)stats.oldestTimestamp, (unsigned)stats.newestTimestamp,
+                 (unsigned)stats.bytesUsed, (unsigned)stats.capacity,
+                 (unsigned)stats.sectorErases, (unsigned)stats.wearLaps, (unsigned)stats.corruptRecords);
+        request->send(200, "application/json", json);
+    });
+
+    // 按时间区间查询本地事件：since/until 为 Unix 秒（闭区间），offset/limit 分页
+    server.on("/api/events", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        uint32_t since = uintParam(request, "since", 0);
+        uint32_t until = uintParam(request, "until", UINT32_MAX);
+        size_t skip = uintParam(request, "offset", 0);
+        size_t limit = constrain(intParam(request, "limit", 50), 1, 100);
+
+        EventRecord records[100];
+        size_t total = 0;
+        size_t n = eventStore->query(since, until, skip, records, limit, &total);
+
+        DynamicJsonDocument doc(256 + n * 96);
+        doc["total"] = total;
+        JsonArray arr = doc.createNestedArray("events");
+        for (size_t i = 0; i < n; i++) {
+            JsonObject ev = arr.createNestedObject();
+            ev["id"] = records[i].offset;
+            ev["timestamp"] = records[i].timestamp;
+            ev["score"] = records[i].score;
+            ev["size"] = records[i].length;
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    }).setFilter(exactPath("/api/events"));
+}
+
+void HTTPServer::handleEventImage(AsyncWebServerRequest* request) {
+    EventRecord record;
+    if (!request->hasParam("id") || !eventStore->find(uintParam(request, "id", 0), record)) {
+        request->send(404, "application/json", "{\"error\":\"EVENT_NOT_FOUND\"}");
+        return;
+    }
+
+    size_t start = 0;
+    size_t end = record.length - 1;
+    bool partial = request->hasHeader("Range");
+    if (partial && !parseRange(request->getHeader("Range")->value(), record.length, start, end)) {
+        AsyncWebServerResponse* response = request->beginResponse(416);
+        response->addHeader("Content-Range", String("bytes */") + String(record.length));
+        request->send(response);
+        return;
+    }
+
+    // 直接从分区映射拷贝到发送缓冲区，每块在环形存储锁内校验记录头。
+    // 发送途中事件被回收时已无法凑满 Content-Length，由 endBodyShort 断开连接让客户端重试
+    size_t length = end - start + 1;
+    EventStore* store = eventStore;
+    AsyncWebServerResponse* response = request->beginResponse(
+        "image/jpeg",
+        length,
+        [request, store, record, start, length](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            if (index >= length) return 0;
+            size_t n = store->readImage(record, start + index, buffer, min(maxLen, length - index));
+            return n > 0 ? n : endBodyShort(request);
+        }
+    );
+    response->addHeader("Accept-Ranges", "bytes");
+    if (partial) {
+        char range[64];
+        snprintf(range, sizeof(range), "bytes %u-%u/%u",
+                 (unsigned)start, (unsigned)end, (unsigned)record.length);
+        response->setCode(206);
+        response->addHeader("Content-Range", range);
+    }
+    request->send(response);
+}
+
+void HTTPServer::setupClipRoutes() {
+    if (!clipRecorder) return;
+
+    // 路由按前缀匹配（"/api/clips" 也匹配 "/api/clips/file"），子路径先注册，父路由再加 exactPath
+
+    // 短片文件（MJPEG AVI），支持 Range
+    server.on("/api/clips/file", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleClipFile(request);
+    });
+
+    // 本地短片列表与录制统计（上传成功的短片已删除）
+    server.on("/api/clips", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        ClipInfo clips[CLIP_MAX_STORED];
+        size_t n = clipRecorder->list(clips, CLIP_MAX_STORED);
+        ClipStats stats = clipRecorder->getStats();
+
+        StaticJsonDocument<768> doc;
+        doc["recording"] = stats.recording;
+        doc["open_frames"] = stats.openFrames;
+        doc["open_bytes"] = stats.openBytes;
+        doc["clips_finished"] = stats.clipsFinished;
+        doc["clips_aborted"] = stats.clipsAborted;
+        doc["frames_skipped"] = stats.framesSkipped;
+        doc["truncated"] = stats.truncated;
+        doc["frame_interval_ms"] = stats.frameIntervalMs;
+        doc["last_encode_us"] = stats.lastEncodeUs;
+        JsonArray arr = doc.createNestedArray("clips");
+        for (size_t i = 0; i < n; i++) {
+            JsonObject clip = arr.createNestedObject();
+            clip["id"] = clips[i].id;
+            clip["width"] = clips[i].width;
+            clip["height"] = clips[i].height;
+            clip["frames"] = clips[i].frames;
+            clip["duration_ms"] = clips[i].durationMs;
+            clip["size"] = clips[i].bytes;
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    }).setFilter(exactPath("/api/clips"));
+
+    server.on("/api/clips", HTTP_DELETE, [this](AsyncWebServerRequest* request) {
+        if (!request->hasParam("id") || !clipRecorder->remove(uintParam(request, "id", 0))) {
+            request->send(404, "application/json", "{\"success\":false,\"error\":\"CLIP_NOT_FOUND\"}");
+            return;
+        }
+        request->send(200, "application/json", "{\"success\":true}");
+    }).setFilter(exactPath("/api/clips"));
+}
+
+void HTTPServer::handleClipFile(AsyncWebServerRequest* request) {
+    ClipInfo clip;
+    if (!request->hasParam("id") || !clipRecorder->find(uintParam(request, "id", 0), clip)) {
+        request->send(404, "application/json", "{\"error\":\"CLIP_NOT_FOUND\"}");
+        return;
+    }
+
+    size_t start = 0;
+    size_t end = clip.bytes - 1;
+    bool partial = request->hasHeader("Range");
+    if (partial && !parseRange(request->getHeader("Range")->value(), clip.bytes, start, end)) {
+        AsyncWebServerResponse* response = request->beginResponse(416);
+        response->addHeader("Content-Range", String("bytes */") + String(clip.bytes));
+        request->send(response);
+        return;
+    }
+
+    std::shared_ptr<File> file(new File(LittleFS.open(ClipRecorder::clipPath(clip.id), "r")),
+                               [](File* f) { f->close(); delete f; });
+    if (!*file) {
+        request->send(500, "application/json", "{\"error\":\"READ_FAILED\"}");
+        return;
+    }
+
+    size_t length = end - start + 1;
+    AsyncWebServerResponse* response = request->beginResponse(
+        "video/x-msvideo",
+        length,
+        [request, file, start, length](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            if (index >= length) return 0;
+            size_t toRead = min(maxLen, length - index);
+            size_t n = file->seek(start + index) ? file->read(buffer, toRead) : 0;
+            return n > 0 ? n : endBodyShort(request);
+        }
+    );
+    response->addHeader("Accept-Ranges", "bytes");
+    if (partial) {
+        char range[64];
+        snprintf(range, sizeof(range), "bytes %u-%u/%u",
+                 (unsigned)start, (unsigned)end, (unsigned)clip.bytes);
+        response->setCode(206);
+        response->addHeader("Content-Range", range);
+    }
+    request->send(response);
+}
+
+void HTTPServer::setupTimelapseRoutes() {
+    if (!timelapse) return;
+
+    // 路由按前缀匹配（"/api/timelapse" 也匹配 "/api/timelapse/flush"），子路径先注册，父路由再加 exactPath
+
+    // 立即封装当前批次并上传
+    server.on("/api/timelapse/flush", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        if (!timelapse->flush()) {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"NOTHING_TO_FLUSH\"}");
+            return;
+        }
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // 延时摄影配置与批次上传统计
+    server.on("/api/timelapse", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        TimelapseConfig config = timelapse->getConfig();
+        TimelapseStats stats = timelapse->getStats();
+
+        StaticJsonDocument<512> doc;
+        doc["enabled"] = config.enabled;
+        doc["interval"] = config.intervalSec;
+        doc["batch_frames"] = config.batchFrames;
+        doc["batch_age"] = config.batchAgeSec;
+        doc["open_frames"] = stats.openFrames;
+        doc["open_bytes"] = stats.openBytes;
+        doc["batch_pending"] = stats.batchPending;
+        doc["batches_uploaded"] = stats.batchesUploaded;
+        doc["frames_uploaded"] = stats.framesUploaded;
+        doc["bytes_uploaded"] = stats.bytesUploaded;
+        doc["frames_dropped"] = stats.framesDropped;
+        doc["upload_failures"] = stats.uploadFailures;
+        doc["last_status"] = stats.lastStatus;
+        doc["last_upload_ms"] = stats.lastUploadMs;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    }).setFilter(exactPath("/api/timelapse"));
+
+    // 修改配置，未提供的字段保持不变
+    server.on("/api/timelapse", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        TimelapseConfig config = timelapse->getConfig();
+        if (request->hasParam("enabled", true)) {
+            config.enabled = request->getParam("enabled", true)->value() == "true";
+        }
+        if (request->hasParam("interval", true)) {
+            config.intervalSec = request->getParam("interval", true)->value().toInt();
+        }
+        if (request->hasParam("batch_frames", true)) {
+            config.batchFrames = request->getParam("batch_frames", true)->value().toInt();
+        }
+        if (request->hasParam("batch_age", true)) {
+            config.batchAgeSec = request->getParam("batch_age", true)->value().toInt();
+        }
+
+        if (!timelapse->setConfig(config)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"INVALID_PARAMS\"}");
+            return;
+        }
+        request->send(200, "application/json", "{\"success\":true}");
+    }).setFilter(exactPath("/api/timelapse"));
+}
+
+void HTTPServer::setupHttpsRoutes() {
+    if (!httpsPool) return;
+
+    // 云端连接复用与握手统计
+    server.on("/api/https", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        HttpsPoolStats stats = httpsPool->getStats();
+        uint32_t handshakes = stats.fullHandshakes + stats.resumedHandshakes;
+
+        StaticJsonDocument<512> doc;
+        doc["requests"] = stats.requests;
+        doc["reused_requests"] = stats.reusedRequests;
+        doc["reuse_ratio"] = stats.requests ? (float)stats.reusedRequests / stats.requests : 0.0f;
+        doc["full_handshakes"] = stats.fullHandshakes;
+        doc["resumed_handshakes"] = stats.resumedHandshakes;
+        doc["resumption_ratio"] = handshakes ? (float)stats.resumedHandshakes / handshakes : 0.0f;
+        doc["avg_full_handshake_ms"] = stats.fullHandshakes ? stats.fullHandshakeMs / stats.fullHandshakes : 0;
+        doc["avg_resumed_handshake_ms"] =
+            stats.resumedHandshakes ? stats.resumedHandshakeMs / stats.resumedHandshakes : 0;
+        doc["stale_retries"] = stats.staleRetries;
+        doc["failures"] = stats.failures;
+        doc["open_connections"] = stats.openConnections;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+}
+
+void HTTPServer::setupRtspRoutes() {
+    if (!rtspServer) return;
+
+    // RTSP 会话与推流统计
+    server.on("/api/rtsp", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        RtspStats stats = rtspServer->getStats();
+
+        StaticJsonDocument<512> doc;
+        doc["port"] = RTSP_PORT;
+        doc["sessions"] = stats.sessions;
+        doc["playing"] = stats.playing;
+        doc["connections"] = stats.connections;
+        doc["rejected"] = stats.rejected;
+        doc["frames_submitted"] = stats.framesSubmitted;
+        doc["frames_sent"] = stats.framesSent;
+        doc["frames_dropped"] = stats.framesDropped;
+        doc["frames_invalid"] = stats.framesInvalid;
+        doc["packets_sent"] = stats.packetsSent;
+        doc["bytes_sent"] = stats.bytesSent;
+        doc["send_errors"] = stats.sendErrors;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+}
+
+void HTTPServer::setupMotionRoutes() {
+    if (!motionUploader && !frameDedup && !motionEvents) return;
+
+    // 运动事件统计：状态机合并的事件、裁剪上传相对整帧节省的字节、去重丢弃的比例
+    server.on("/api/motion/stats", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        StaticJsonDocument<1536> doc;
+
+        if (motionDetector) {
+            JsonObject detector = doc.createNestedObject("detector");
+            detector["last_score"] = motionDetector->getLastScore();
+            detector["decode_errors"] = motionDetector->getDecodeErrors();
+        }
+
+        if (motionEvents) {
+            MotionEventStats stats = motionEvents->getStats();
+            JsonObject events = doc.createNestedObject("events");
+            events["active"] = stats.active;
+            events["onsets"] = stats.onsets;
+            events["started"] = stats.started;
+            events["reported"] = stats.reported;
+            events["discarded"] = stats.discarded;
+            events["truncated"] = stats.truncated;
+            events["cooldown_suppressed"] = stats.cooldownSuppressed;
+            events["rate_suppressed"] = stats.rateSuppressed;
+            events["reduction"] = stats.reported ? (float)stats.onsets / stats.reported : 0.0f;
+            if (stats.reported) {
+                JsonObject last = events.createNestedObject("last");
+                last["age_ms"] = millis() - stats.last.endMs;
+                last["duration_ms"] = stats.last.endMs - stats.last.startMs;
+                last["peak_score"] = stats.last.peakScore;
+                last["motion_frames"] = stats.last.motionFrames;
+                last["truncated"] = stats.last.truncated;
+            }
+        }
+
+        if (motionUploader) {
+            MotionUploadStats stats = motionUploader->getStats();
+            JsonObject upload = doc.createNestedObject("upload");
+            upload["events"] = stats.events;
+            upload["uploaded"] = stats.uploaded;
+            upload["dropped"] = stats.dropped;
+            upload["failures"] = stats.failures;
+            upload["cropped_events"] = stats.croppedEvents;
+            upload["bytes_uploaded"] = stats.bytesUploaded;
+            upload["full_frame_bytes"] = stats.fullFrameBytes;
+            upload["clips_uploaded"] = stats.clipsUploaded;
+            upload["clip_bytes"] = stats.clipBytes;
+            upload["bytes_ratio"] = stats.fullFrameBytes ? (float)stats.bytesUploaded / stats.fullFrameBytes : 0.0f;
+            upload["last_status"] = stats.lastStatus;
+        }
+
+        if (burstSelector) {
+            BurstStats stats = burstSelector->getStats();
+            JsonObject burst = doc.createNestedObject("burst");
+            burst["bursts"] = stats.bursts;
+            burst["frames"] = stats.frames;
+            burst["trigger_selected"] = stats.triggerSelected;
+            burst["copy_failures"] = stats.copyFailures;
+            burst["avg_scoring_us"] = stats.avgScoringUs;
+            burst["max_scoring_us"] = stats.maxScoringUs;
+            if (stats.bursts) {
+                JsonObject last = burst.createNestedObject("last");
+                last["frames"] = stats.last.frames;
+                last["selected"] = stats.last.selected;
+                last["sharpness"] = stats.last.sharpness;
+                last["trigger_sharpness"] = stats.last.triggerSharpness;
+                last["scoring_us"] = stats.last.scoringUs;
+            }
+        }
+
+        if (frameDedup) {
+            FrameDedupStats stats = frameDedup->getStats();
+            JsonObject dedup = doc.createNestedObject("dedup");
+            dedup["candidates"] = stats.candidates;
+            dedup["suppressed"] = stats.suppressed;
+            dedup["suppression_rate"] = stats.candidates ? (float)stats.suppressed / stats.candidates : 0.0f;
+            dedup["last_distance"] = stats.lastDistance;
+            dedup["max_distance"] = stats.maxDistance;
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    if (!frameDedup) return;
+
+    // 调整去重阈值（0 只丢弃完全相同的哈希）
+    server.on("/api/motion/dedup", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        if (!request->hasParam("max_distance", true)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"MISSING_PARAMS\"}");
+            return;
+        }
+        int distance = request->getParam("max_distance", true)->value().toInt();
+        frameDedup->setMaxDistance(constrain(distance, 0, 64));
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+}
+
+void HTTPServer::setupTripwireRoutes() {
+    if (!motionEstimator) return;
+
+    // 绊线配置、触发次数与块匹配耗时
+    server.on("/api/tripwires", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        Tripwire list[MV_MAX_TRIPWIRES];
+        TripwireStatus status[MV_MAX_TRIPWIRES];
+        uint8_t n = motionEstimator->getTripwires(list, status, MV_MAX_TRIPWIRES);
+        MotionEstimatorStats stats = motionEstimator->getStats();
+        uint32_t now = millis();
+
+        StaticJsonDocument<1536> doc;
+        JsonArray arr = doc.createNestedArray("tripwires");
+        for (uint8_t i = 0; i < n; i++) {
+            JsonObject item = arr.createNestedObject();
+            item["name"] = list[i].name;
+            item["x0"] = list[i].x0;
+            item["y0"] = list[i].y0;
+            item["x1"] = list[i].x1;
+            item["y1"] = list[i].y1;
+            item["direction"] = tripwireDirectionName(list[i].direction);
+            item["crossings"] = status[i].crossings;
+            if (status[i].crossings) {
+                item["last_direction"] = tripwireDirectionName(status[i].lastDirection);
+                item["last_cross_ago_ms"] = now - status[i].lastCrossMs;
+            }
+        }
+
+        JsonObject estimator = doc.createNestedObject("estimator");
+        estimator["frames"] = stats.frames;
+        estimator["searched_blocks"] = stats.searchedBlocks;
+        estimator["global_motion_frames"] = stats.globalMotionFrames;
+        estimator["moving_blocks"] = stats.movingBlocks;
+        estimator["last_us"] = stats.lastUs;
+        estimator["max_us"] = stats.maxUs;
+        estimator["avg_us"] = stats.frames ? (uint32_t)(stats.totalUs / stats.frames) : 0;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // 新增或替换绊线（按名称），坐标为画面千分比
+    server.on("/api/tripwires", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        const char* fields[] = {"name", "x0", "y0", "x1", "y1"};
+        for (const char* field : fields) {
+            if (!request->hasParam(field, true)) {
+                request->send(400, "application/json", "{\"success\":false,\"error\":\"MISSING_PARAMS\"}");
+                return;
+            }
+        }
+
+        Tripwire tw = {};
+        strlcpy(tw.name, request->getParam("name", true)->value().c_str(), sizeof(tw.name));
+        tw.x0 = constrain(request->getParam("x0", true)->value().toInt(), 0, 1000);
+        tw.y0 = constrain(request->getParam("y0", true)->value().toInt(), 0, 1000);
+        tw.x1 = constrain(request->getParam("x1", true)->value().toInt(), 0, 1000);
+        tw.y1 = constrain(request->getParam("y1", true)->value().toInt(), 0, 1000);
+        String direction = request->hasParam("direction", true) ? request->getParam("direction", true)->value() : "both";
+
+        if (!parseTripwireDirection(direction.c_str(), tw.direction) || !motionEstimator->setTripwire(tw)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"INVALID_PARAMS\"}");
+            return;
+        }
+        motionEstimator->saveTripwires();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    server.on("/api/tripwires", HTTP_DELETE, [this](AsyncWebServerRequest* request) {
+        if (!request->hasParam("name") || !motionEstimator->removeTripwire(request->getParam("name")->value().c_str())) {
+            request->send(404, "application/json", "{\"success\":false,\"error\":\"TRIPWIRE_NOT_FOUND\"}");
+            return;
+        }
+        motionEstimator->saveTripwires();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // 最近一帧的非零运动矢量：[列, 行, dx, dy]，块坐标乘 block 为亮度平面像素
+    server.on("/api/motion/vectors", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        static MotionVector vectors[MotionEstimator::BLOCK_COLS * MotionEstimator::BLOCK_ROWS];
+        motionEstimator->getVectors(vectors);
+
+        size_t moving = 0;
+        for (const MotionVector& mv : vectors) {
+            if (mv.dx || mv.dy) moving++;
+        }
+
+        DynamicJsonDocument doc(256 + moving * 64);
+        doc["width"] = MV_PLANE_WIDTH;
+        doc["height"] = MV_PLANE_HEIGHT;
+        doc["block"] = MV_BLOCK_SIZE;
+        JsonArray arr = doc.createNestedArray("vectors");
+        for (int i = 0; i < MotionEstimator::BLOCK_COLS * MotionEstimator::BLOCK_ROWS; i++) {
+            if (!vectors[i].dx && !vectors[i].dy) continue;
+            JsonArray v = arr.createNestedArray();
+            v.add(i % MotionEstimator::BLOCK_COLS);
+            v.add(i / MotionEstimator::BLOCK_COLS);
+            v.add(vectors[i].dx);
+            v.add(vectors[i].dy);
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+}
+
+void HTTPServer::setupCameraRoutes() {
+    if (!camera) return;
+
+    // 路由按前缀匹配（"/api/camera" 也匹配 "/api/camera/format"），子路径先注册，父路由再加 exactPath
+
+    // 切换分辨率（不保存），由采集任务排空旧尺寸帧后应用；空闲模式下到唤醒时生效
+    server.on("/api/camera/format", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        if (!request->hasParam("frame_size", true)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"MISSING_PARAMS\"}");
+            return;
+        }
+        framesize_t size;
+        String name = request->getParam("frame_size", true)->value();
+        if (!Camera::parseFrameSize(name.c_str(), size) || !Camera::isSupportedFrameSize(size)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"UNSUPPORTED_FRAME_SIZE\"}");
+            return;
+        }
+        if (camera->isBenchmarkRunning()) {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"BUSY\"}");
+            return;
+        }
+        if (powerManager) {
+            powerManager->setActiveFrameSize(size);
+        } else {
+            camera->requestFrameSize(size);
+        }
+        request->send(202, "application/json", "{\"success\":true}");
+    });
+
+    // 传感器开窗（数字变焦/ROI）：x、y、w、h 为传感器全幅坐标，输出保持当前分辨率
+    server.on("/api/camera/window", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        if (!request->hasParam("w", true) || !request->hasParam("h", true)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"MISSING_PARAMS\"}");
+            return;
+        }
+        // 宽高为必填，缺省的 x/y 为 0
+        long x = request->hasParam("x", true) ? request->getParam("x", true)->value().toInt() : 0;
+        long y = request->hasParam("y", true) ? request->getParam("y", true)->value().toInt() : 0;
+        long w = request->getParam("w", true)->value().toInt();
+        long h = request->getParam("h", true)->value().toInt();
+        // 先按 long 检查范围再转成 uint16_t，超出 65535 的值截断后可能落回合法区间
+        if (x < 0 || y < 0 || x >= CAMERA_SENSOR_WIDTH || y >= CAMERA_SENSOR_HEIGHT ||
+            w <= 0 || h <= 0 || w > CAMERA_SENSOR_WIDTH || h > CAMERA_SENSOR_HEIGHT ||
+            !camera->requestWindow(SensorWindow{(uint16_t)x, (uint16_t)y, (uint16_t)w, (uint16_t)h})) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"INVALID_WINDOW\"}");
+            return;
+        }
+        request->send(202, "application/json", "{\"success\":true}");
+    });
+
+    // 恢复全幅视场
+    server.on("/api/camera/window", HTTP_DELETE, [this](AsyncWebServerRequest* request) {
+        camera->requestWindow(SensorWindow{});
+        request->send(202, "application/json", "{\"success\":true}");
+    });
+
+    // 依次测试各采集模式的帧率与帧龄，期间暂停运动检测（约半分钟）
+    server.on("/api/camera/benchmark", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        if (camera->isBenchmarkRunning() || camera->hasPendingRequest()) {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"BUSY\"}");
+            return;
+        }
+        camera->requestBenchmark();
+        request->send(202, "application/json", "{\"success\":true}");
+    });
+
+    server.on("/api/camera/benchmark", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        CaptureBenchmarkResult results[Camera::BENCHMARK_MODES];
+        uint8_t n = camera->getBenchmarkResults(results);
+
+        StaticJsonDocument<1536> doc;
+        doc["running"] = camera->isBenchmarkRunning();
+        JsonArray arr = doc.createNestedArray("results");
+        for (uint8_t i = 0; i < n; i++) {
+            const CaptureBenchmarkResult& r = results[i];
+            JsonObject item = arr.createNestedObject();
+            item["grab_mode"] = r.config.grabMode == CAMERA_GRAB_LATEST ? "latest" : "queued";
+            item["fb_location"] = r.config.fbLocation == CAMERA_FB_IN_DRAM ? "dram" : "psram";
+            item["fb_count"] = r.config.fbCount;
+            item["xclk_hz"] = r.config.xclkHz;
+            item["ok"] = r.ok;
+            if (!r.ok) continue;
+            item["fps"] = r.fps;
+            item["age_us"] = r.avgAgeUs;
+            item["paced_age_us"] = r.pacedAvgAgeUs;
+            item["paced_max_age_us"] = r.pacedMaxAgeUs;
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // 当前采集参数、帧率与帧龄
+    server.on("/api/camera", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        CaptureStats stats = camera->getStats();
+
+        StaticJsonDocument<1024> doc;
+        doc["grab_mode"] = stats.config.grabMode == CAMERA_GRAB_LATEST ? "latest" : "queued";
+        doc["fb_location"] = stats.config.fbLocation == CAMERA_FB_IN_DRAM ? "dram" : "psram";
+        doc["fb_count"] = stats.config.fbCount;
+        doc["xclk_hz"] = stats.config.xclkHz;
+        doc["pixel_format"] = Camera::pixelFormatName(stats.config.pixelFormat);
+        doc["frames"] = stats.frames;
+        doc["failures"] = stats.failures;
+        doc["fps"] = stats.fps;
+        JsonObject age = doc.createNestedObject("frame_age_us");
+        age["last"] = stats.lastAgeUs;
+        age["avg"] = stats.avgAgeUs;
+        age["max"] = stats.maxAgeUs;
+        doc["benchmark_running"] = camera->isBenchmarkRunning();
+
+        framesize_t size = camera->getFrameSize();
+        doc["frame_size"] = Camera::frameSizeName(size);
+        doc["width"] = resolution[size].width;
+        doc["height"] = resolution[size].height;
+        if (powerManager) {
+            doc["active_frame_size"] = Camera::frameSizeName(powerManager->getActiveFrameSize());
+        }
+        FrameSizeSwitchStats sw = camera->getSwitchStats();
+        JsonObject switching = doc.createNestedObject("frame_size_switch");
+        switching["count"] = sw.switches;
+        switching["last_frames"] = sw.lastFrames;
+        switching["max_frames"] = sw.maxFrames;
+        switching["last_ms"] = sw.lastMs;
+        switching["max_ms"] = sw.maxMs;
+        switching["reinits"] = sw.reinits;
+        switching["failures"] = sw.failures;
+        switching["stale_frames"] = sw.staleFrames;
+
+        WindowStats win = camera->getWindowStats();
+        JsonObject window = doc.createNestedObject("window");
+        window["active"] = win.requested.width > 0;
+        if (win.requested.width > 0) addWindow(window, "requested", win.requested);
+        addWindow(window, "applied", win.applied);
+        window["binning"] = win.binning;
+        window["frame_bytes"] = win.frameBytes;
+        window["full_field_bytes"] = win.fullFieldBytes;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    }).setFilter(exactPath("/api/camera"));
+
+    // 修改采集参数（不保存，重启后恢复 config.h 默认值），由采集任务在下一帧前应用
+    server.on("/api/camera", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        CaptureConfig config = camera->getCaptureConfig();
+        bool valid = true;
+        if (request->hasParam("grab_mode", true)) {
+            String mode = request->getParam("grab_mode", true)->value();
+            valid &= mode == "latest" || mode == "queued";
+            config.grabMode = mode == "latest" ? CAMERA_GRAB_LATEST : CAMERA_GRAB_WHEN_EMPTY;
+        }
+        if (request->hasParam("fb_location", true)) {
+            String location = request->getParam("fb_location", true)->value();
+            valid &= location == "psram" || location == "dram";
+            config.fbLocation = location == "dram" ? CAMERA_FB_IN_DRAM : CAMERA_FB_IN_PSRAM;
+        }
+        if (request->hasParam("fb_count", true)) {
+            int count = request->getParam("fb_count", true)->value().toInt();
+            valid &= count >= 1 && count <= 3;
+            config.fbCount = count;
+        }
+        if (request->hasParam("xclk_hz", true)) {
+            long xclk = request->getParam("xclk_hz", true)->value().toInt();
+            valid &= xclk >= 8000000 && xclk <= 24000000;
+            config.xclkHz = xclk;
+        }
+        if (request->hasParam("pixel_format", true)) {
+            String format = request->getParam("pixel_format", true)->value();
+            valid &= Camera::parsePixelFormat(format.c_str(), config.pixelFormat);
+        }
+
+        if (!valid || camera->isBenchmarkRunning()) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"INVALID_PARAMS\"}");
+            return;
+        }
+        camera->requestCaptureConfig(config);
+        request->send(202, "application/json", "{\"success\":true}");
+    }).setFilter(exactPath("/api/camera"));
+}
+
 void HTTPServer::setupProvisioningRoutes() {
     if (!provManager || !wifiScanner) return;
 
     // 扫描 WiFi
-    server.on("/api/wifi/scan", HTTP_GET, [](AsyncWebServerRequest* request) {
+    server.on("/api/wifi/scan", HTTP_GET, [this](AsyncWebServerRequest* request) {
         NetworkInfo networks[20];
         int count = wifiScanner->scan(networks, 20);
 
@@ -344,7 +1523,7 @@ void HTTPServer::setupProvisioningRoutes() {
     });
 
     // 保存配置并连接
-    server.on("/api/wifi/config", HTTP_POST, [](AsyncWebServerRequest* request) {
+    server.on("/api/wifi/config", HTTP_POST, [this](AsyncWebServerRequest* request) {
         if (!request->hasParam("ssid", true) || !request->hasParam("password", true)) {
             request->send(400, "application/json", "{\"success\":false,\"error\":\"MISSING_PARAMS\"}");
             return;
@@ -361,7 +1540,7 @@ void HTTPServer::setupProvisioningRoutes() {
     });
 
     // 重置配置
-    server.on("/api/wifi/reset", HTTP_POST, [](AsyncWebServerRequest* request) {
+    server.on("/api/wifi/reset", HTTP_POST, [this](AsyncWebServerRequest* request) {
         if (provManager->resetConfig()) {
             request->send(200, "application/json", "{\"success\":true}");
         } else {
@@ -370,7 +1549,7 @@ void HTTPServer::setupProvisioningRoutes() {
     });
 
     // 获取状态
-    server.on("/api/wifi/status", HTTP_GET, [](AsyncWebServerRequest* request) {
+    server.on("/api/wifi/status", HTTP_GET, [this](AsyncWebServerRequest* request) {
         StaticJsonDocument<512> doc;
         doc["connected"] = WiFi.isConnected();
         doc["mode"] = (WiFi.getMode() == WIFI_STA) ? "STA" : "AP";
@@ -381,6 +1560,17 @@ void HTTPServer::setupProvisioningRoutes() {
             doc["ip"] = WiFi.softAPIP().toString();
         }
 
+        // 强制门户 DNS 应答统计
+        if (provManager->isPortalActive()) {
+            DnsStats dns = provManager->getDnsStats();
+            JsonObject d = doc.createNestedObject("dns");
+            d["queries"] = dns.queries;
+            d["answered"] = dns.answered;
+            d["dropped"] = dns.dropped;
+            d["avg_latency_us"] = dns.avgLatencyUs;
+            d["max_latency_us"] = dns.maxLatencyUs;
+        }
+
         String response;
         serializeJson(doc, response);
         request->send(200, "application/json", response);
@@ -0,0 +1,390 @@
+#include "https_pool.h"
+#include "logger.h"
+#include <stdarg.h>
+#include <strings.h>
+
+static uint32_t nowMs() {
+    return (uint32_t)millis();
+}
+
+// 追加格式化文本到 buf[len..size)，放不下时返回 false，len 不变
+static bool appendf(char* buf, size_t size, size_t& len, const char* format, ...) {
+    if (len >= size) return false;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf + len, size - len, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= size - len) return false;
+    len += n;
+    return true;
+}
+
+HttpsPool::~HttpsPool() {
+    closeAll();
+}
+
+int HttpsPool::request(const char* host, uint16_t port, const char* method, const char* path,
+                       const char* extraHeaders, const char* contentType, size_t contentLength,
+                       const HttpsBodyWriter& body, std::string* response) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.requests++;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = false;
+        int error = 0;
+        Connection* conn = acquire(host, port, reused, error);
+        if (!conn) {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.failures++;
+            return error;
+        }
+
+        bool keepAlive = false;
+        bool gotResponse = false;
+        int status = exchange(conn, host, method, path, extraHeaders, contentType, contentLength,
+                              body, response, keepAlive, gotResponse);
+        if (status > 0) {
+            release(conn, keepAlive);
+            return status;
+        }
+        release(conn, false);
+
+        // 空闲期间服务器关闭了连接：请求未被处理，换新连接重发一次
+        if (reused && !gotResponse && attempt == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.staleRetries++;
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.failures++;
+        return status;
+    }
+    return HTTPS_ERR_SEND;
+}
+
+HttpsPool::Connection* HttpsPool::acquire(const char* host, uint16_t port, bool& reused, int& error) {
+    Connection* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t now = nowMs();
+
+        // 优先复用同一主机的空闲连接
+        for (Connection& c : connections) {
+            if (!c.transport || c.inUse || c.port != port || c.host != host) continue;
+            if (config.keepAliveIdleMs > 0 && now - c.lastUsedMs < config.keepAliveIdleMs &&
+                c.transport->isAlive()) {
+                c.inUse = true;
+                reused = true;
+                stats.reusedRequests++;
+                return &c;
+            }
+            closeConnection(&c);
+        }
+
+        // 空槽，或淘汰最久未用的空闲连接
+        for (Connection& c : connections) {
+            if (c.inUse) continue;
+            if (!c.transport) {
+                slot = &c;
+                break;
+            }
+            if (!slot || (int32_t)(c.lastUsedMs - slot->lastUsedMs) < 0) slot = &c;
+        }
+        if (!slot) {
+            error = HTTPS_ERR_POOL_BUSY;
+            return nullptr;
+        }
+        closeConnection(slot);
+        slot->inUse = true;
+    }
+
+    // 握手耗时较长，不持锁
+    if (!open(slot, host, port)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        slot->inUse = false;
+        error = HTTPS_ERR_CONNECT;
+        return nullptr;
+    }
+    return slot;
+}
+
+bool HttpsPool::open(Connection* conn, const char* host, uint16_t port) {
+    std::vector<uint8_t> session;
+    if (config.sessionCache) {
+        std::lock_guard<std::mutex> lock(mutex);
+        CachedSession* cached = findSession(host, port);
+        if (cached && nowMs() - cached->savedMs < config.sessionMaxAgeMs) {
+            session = cached->data;
+        }
+    }
+
+    TlsTransport* transport = factory();
+    if (!transport) return false;
+
+    uint32_t start = nowMs();
+    bool ok = transport->connect(host, port, session.empty() ? nullptr : session.data(),
+                                 session.size(), config.ioTimeoutMs);
+    uint32_t elapsed = nowMs() - start;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ok) {
+        delete transport;
+        // 缓存的会话可能导致握手失败，下次走完整握手
+        CachedSession* cached = findSession(host, port);
+        if (cached) cached->data.clear();
+        Logger::warn("HTTPS", "Connect to %s:%u failed", host, port);
+        return false;
+    }
+
+    bool resumed = transport->sessionResumed();
+    if (resumed) {
+        stats.resumedHandshakes++;
+        stats.resumedHandshakeMs += elapsed;
+    } else {
+        stats.fullHandshakes++;
+        stats.fullHandshakeMs += elapsed;
+    }
+    storeSession(host, port, transport);
+
+    conn->transport = transport;
+    conn->host = host;
+    conn->port = port;
+    conn->rxStart = conn->rxEnd = 0;
+    conn->txLen = 0;
+    Logger::debug("HTTPS", "%s handshake with %s in %u ms",
+                  resumed ? "Resumed" : "Full", host, (unsigned)elapsed);
+    return true;
+}
+
+void HttpsPool::release(Connection* conn, bool keepAlive) {
+    std::lock_guard<std::mutex> lock(mutex);
+    conn->inUse = false;
+    conn->lastUsedMs = nowMs();
+    if (!keepAlive || config.keepAliveIdleMs == 0) {
+        closeConnection(conn);
+    }
+}
+
+// 调用方持有 mutex
+void HttpsPool::closeConnection(Connection* conn) {
+    if (conn->transport) {
+        conn->transport->close();
+        delete conn->transport;
+        conn->transport = nullptr;
+    }
+    conn->host.clear();
+    conn->port = 0;
+}
+
+void HttpsPool::closeIdle() {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t now = nowMs();
+    for (Connection& c : connections) {
+        if (c.transport && !c.inUse && now - c.lastUsedMs >= config.keepAliveIdleMs) {
+            closeConnection(&c);
+        }
+    }
+}
+
+void HttpsPool::closeAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Connection& c : connections) {
+        if (!c.inUse) closeConnection(&c);
+    }
+}
+
+HttpsPoolStats HttpsPool::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    HttpsPoolStats copy = stats;
+    copy.openConnections = 0;
+    for (Connection& c : connections) {
+        if (c.transport) copy.openConnections++;
+    }
+    return copy;
+}
+
+// 调用方持有 mutex
+HttpsPool::CachedSession* HttpsPool::findSession(const char* host, uint16_t port) {
+    for (CachedSession& s : sessions) {
+        if (s.port == port && s.host == host) return &s;
+    }
+    return nullptr;
+}
+
+// 调用方持有 mutex
+void HttpsPool::storeSession(const char* host, uint16_t port, TlsTransport* transport) {
+    if (!config.sessionCache) return;
+
+    CachedSession* slot = findSession(host, port);
+    if (!slot) {
+        // 替换最旧的条目
+        slot = &sessions[0];
+        for (CachedSession& s : sessions) {
+            if (s.host.empty()) {
+                slot = &s;
+                break;
+            }
+            if ((int32_t)(s.savedMs - slot->savedMs) < 0) slot = &s;
+        }
+    }
+
+    if (!transport->saveSession(slot->data)) {
+        slot->data.clear();
+        return;
+    }
+    slot->host = host;
+    slot->port = port;
+    slot->savedMs = nowMs();
+}
+
+bool HttpsPool::send(Connection* conn, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        if (conn->txLen == sizeof(conn->tx) && !flush(conn)) return false;
+        size_t n = min(len, sizeof(conn->tx) - conn->txLen);
+        memcpy(conn->tx + conn->txLen, data, n);
+        conn->txLen += n;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool HttpsPool::flush(Connection* conn) {
+    size_t offset = 0;
+    while (offset < conn->txLen) {
+        int n = conn->transport->write(conn->tx + offset, conn->txLen - offset);
+        if (n <= 0) return false;
+        offset += n;
+    }
+    conn->txLen = 0;
+    return true;
+}
+
+int HttpsPool::readByte(Connection* conn) {
+    if (conn->rxStart == conn->rxEnd) {
+        int n = conn->transport->read(conn->rx, sizeof(conn->rx), config.ioTimeoutMs);
+        if (n <= 0) return -1;
+        conn->rxStart = 0;
+        conn->rxEnd = n;
+    }
+    return conn->rx[conn->rxStart++];
+}
+
+bool HttpsPool::readLine(Connection* conn, char* line, size_t size) {
+    size_t n = 0;
+    while (true) {
+        int c = readByte(conn);
+        if (c < 0) return false;
+        if (c == '\n') {
+            if (n > 0 && line[n - 1] == '\r') n--;
+            line[n] = '\0';
+            return true;
+        }
+        // 超长的行截断
+        if (n + 1 < size) line[n++] = (char)c;
+    }
+}
+
+bool HttpsPool::readBody(Connection* conn, size_t length, std::string* response) {
+    while (length > 0) {
+        if (conn->rxStart == conn->rxEnd) {
+            int n = conn->transport->read(conn->rx, sizeof(conn->rx), config.ioTimeoutMs);
+            if (n <= 0) return false;
+            conn->rxStart = 0;
+            conn->rxEnd = n;
+        }
+        size_t n = min(length, conn->rxEnd - conn->rxStart);
+        if (response && response->size() < HTTPS_RESPONSE_MAX_BYTES) {
+            size_t keep = min(n, (size_t)HTTPS_RESPONSE_MAX_BYTES - response->size());
+            response->append((const char*)conn->rx + conn->rxStart, keep);
+        }
+        conn->rxStart += n;
+        length -= n;
+    }
+    return true;
+}
+
+int HttpsPool::exchange(Connection* conn, const char* host, const char* method, const char* path,
+                        const char* extraHeaders, const char* contentType, size_t contentLength,
+                        const HttpsBodyWriter& body, std::string* response, bool& keepAlive,
+                        bool& gotResponse) {
+    conn->txLen = 0;
+    if (response) response->clear();
+
+    // 每次追加前检查剩余空间，请求行过长时不发送
+    char head[384];
+    size_t len = 0;
+    bool fits = appendf(head, sizeof(head), len,
+                        "%s %s HTTP/1.1\r\n"
+                        "Host: %s\r\n"
+                        "Connection: keep-alive\r\n",
+                        method, path, host);
+    if (fits && contentType) {
+        fits = appendf(head, sizeof(head), len, "Content-Type: %s\r\n", contentType);
+    }
+    if (fits && (body || contentLength > 0)) {
+        fits = appendf(head, sizeof(head), len, "Content-Length: %u\r\n", (unsigned)contentLength);
+    }
+    if (!fits) return HTTPS_ERR_SEND;
+
+    bool ok = send(conn, (const uint8_t*)head, len) &&
+              (!extraHeaders || send(conn, (const uint8_t*)extraHeaders, strlen(extraHeaders))) &&
+              send(conn, (const uint8_t*)"\r\n", 2);
+    if (ok && body) {
+        ok = body([this, conn](const uint8_t* data, size_t n) { return send(conn, data, n); });
+    }
+    if (!ok || !flush(conn)) return HTTPS_ERR_SEND;
+
+    // 状态行
+    char line[256];
+    int minor = 0;
+    int status = 0;
+    if (!readLine(conn, line, sizeof(line))) return HTTPS_ERR_RESPONSE;
+    gotResponse = true;
+    if (sscanf(line, "HTTP/1.%d %d", &minor, &status) != 2) return HTTPS_ERR_RESPONSE;
+    keepAlive = minor >= 1;
+
+    // 响应头
+    long length = -1;
+    bool chunked = false;
+    while (true) {
+        if (!readLine(conn, line, sizeof(line))) return HTTPS_ERR_RESPONSE;
+        if (line[0] == '\0') break;
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            length = strtol(line + 15, nullptr, 10);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = strcasestr(line + 18, "chunked") != nullptr;
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            if (strcasestr(line + 11, "close")) keepAlive = false;
+            else if (strcasestr(line + 11, "keep-alive")) keepAlive = true;
+        }
+    }
+
+    // 响应体
+    bool noBody = strcmp(method, "HEAD") == 0 || status < 200 || status == 204 || status == 304;
+    if (noBody) return status;
+
+    if (chunked) {
+        while (true) {
+            if (!readLine(conn, line, sizeof(line))) return HTTPS_ERR_RESPONSE;
+            size_t chunk = strtoul(line, nullptr, 16);
+            if (chunk == 0) break;
+            if (!readBody(conn, chunk, response) || !readLine(conn, line, sizeof(line))) {
+                return HTTPS_ERR_RESPONSE;
+            }
+        }
+        // 跳过 trailer
+        while (readLine(conn, line, sizeof(line)) && line[0] != '\0') {
+        }
+    } else if (length >= 0) {
+        if (!readBody(conn, length, response)) return HTTPS_ERR_RESPONSE;
+    } else {
+        // 没有长度信息，读到连接关闭
+        keepAlive = false;
+        readBody(conn, SIZE_MAX, response);
+    }
+    return status;
+}
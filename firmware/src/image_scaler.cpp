@@ -0,0 +1,122 @@
+#include "image_scaler.h"
+#include <string.h>
+
+static inline void storeRGB565(uint8_t* p, uint32_t r, uint32_t g, uint32_t b) {
+    uint16_t v = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+bool ImageScaler::clampCrop(CropRect& crop, int srcWidth, int srcHeight) {
+    if (crop.width <= 0 || crop.height <= 0) {
+        crop = CropRect(0, 0, srcWidth, srcHeight);
+    }
+    if (crop.x < 0) { crop.width += crop.x; crop.x = 0; }
+    if (crop.y < 0) { crop.height += crop.y; crop.y = 0; }
+    if (crop.x + crop.width > srcWidth) crop.width = srcWidth - crop.x;
+    if (crop.y + crop.height > srcHeight) crop.height = srcHeight - crop.y;
+    return crop.width > 0 && crop.height > 0;
+}
+
+void ImageScaler::fitOutputSize(const CropRect& crop, int& outWidth, int& outHeight) {
+    if (outWidth <= 0 && outHeight <= 0) {
+        outWidth = crop.width;
+        outHeight = crop.height;
+    } else if (outHeight <= 0) {
+        outHeight = (int)((long)outWidth * crop.height / crop.width);
+    } else if (outWidth <= 0) {
+        outWidth = (int)((long)outHeight * crop.width / crop.height);
+    }
+
+    // 只缩小不放大，传输量只取决于请求的尺寸
+    if (outWidth > crop.width) outWidth = crop.width;
+    if (outHeight > crop.height) outHeight = crop.height;
+    if (outWidth < 1) outWidth = 1;
+    if (outHeight < 1) outHeight = 1;
+}
+
+void ImageScaler::scaleRGB565(const uint8_t* src, int srcWidth, const CropRect& crop,
+                              uint8_t* dst, int outWidth, int outHeight, uint32_t* scratch) {
+    uint32_t* accR = scratch;
+    uint32_t* accG = scratch + outWidth;
+    uint32_t* accB = scratch + outWidth * 2;
+
+    for (int oy = 0; oy < outHeight; oy++) {
+        int sy0 = crop.y + (int)((long)oy * crop.height / outHeight);
+        int sy1 = crop.y + (int)((long)(oy + 1) * crop.height / outHeight);
+
+        memset(scratch, 0, scratchSize(outWidth));
+
+        // 按源行累加到每个输出列的盒子里
+        for (int sy = sy0; sy < sy1; sy++) {
+            const uint8_t* row = src + ((size_t)sy * srcWidth + crop.x) * 2;
+            int ox = 0;
+            int nextEdge = (int)((long)crop.width / outWidth);
+            for (int sx = 0; sx < crop.width; sx++) {
+                if (sx >= nextEdge) {
+                    ox++;
+                    nextEdge = (int)((long)(ox + 1) * crop.width / outWidth);
+                }
+                uint16_t pixel = ImageScaler::loadRGB565(row + sx * 2);
+                accR[ox] += (pixel >> 11) & 0x1F;
+                accG[ox] += (pixel >> 5) & 0x3F;
+                accB[ox] += pixel & 0x1F;
+            }
+        }
+
+        // 求平均并写回输出行
+        uint8_t* out = dst + (size_t)oy * outWidth * 2;
+        int rows = sy1 - sy0;
+        for (int ox = 0; ox < outWidth; ox++) {
+            int sx0 = (int)((long)ox * crop.width / outWidth);
+            int sx1 = (int)((long)(ox + 1) * crop.width / outWidth);
+            uint32_t count = (uint32_t)(rows * (sx1 - sx0));
+            uint32_t r5 = accR[ox] / count;
+            uint32_t g6 = accG[ox] / count;
+            uint32_t b5 = accB[ox] / count;
+            storeRGB565(out + ox * 2, (r5 << 3) | (r5 >> 2), (g6 << 2) | (g6 >> 4), (b5 << 3) | (b5 >> 2));
+        }
+    }
+}
+
+void ImageScaler::scaleRGB565ToGray(const uint8_t* src, int srcWidth, const CropRect& crop,
+                                    uint8_t* dst, int outWidth, int outHeight, uint32_t* scratch) {
+    scaleRGB565ToGrayRows(src, srcWidth, crop, dst, outWidth, outHeight, 0, outHeight, scratch);
+}
+
+void ImageScaler::scaleRGB565ToGrayRows(const uint8_t* src, int srcWidth, const CropRect& crop,
+                                        uint8_t* dst, int outWidth, int outHeight,
+                                        int rowBegin, int rowEnd, uint32_t* scratch) {
+    for (int oy = rowBegin; oy < rowEnd; oy++) {
+        int sy0 = crop.y + (int)((long)oy * crop.height / outHeight);
+        int sy1 = crop.y + (int)((long)(oy + 1) * crop.height / outHeight);
+
+        memset(scratch, 0, outWidth * sizeof(uint32_t));
+
+        for (int sy = sy0; sy < sy1; sy++) {
+            const uint8_t* row = src + ((size_t)sy * srcWidth + crop.x) * 2;
+            int ox = 0;
+            int nextEdge = (int)((long)crop.width / outWidth);
+            for (int sx = 0; sx < crop.width; sx++) {
+                if (sx >= nextEdge) {
+                    ox++;
+                    nextEdge = (int)((long)(ox + 1) * crop.width / outWidth);
+                }
+                uint16_t pixel = ImageScaler::loadRGB565(row + sx * 2);
+                uint32_t r5 = (pixel >> 11) & 0x1F;
+                uint32_t g6 = (pixel >> 5) & 0x3F;
+                uint32_t b5 = pixel & 0x1F;
+                // 与运动检测一致的感知灰度：(R + 2G + B) / 4
+                scratch[ox] += ((r5 << 3) + (g6 << 3) + (b5 << 3)) / 4;
+            }
+        }
+
+        uint8_t* out = dst + (size_t)oy * outWidth;
+        int rows = sy1 - sy0;
+        for (int ox = 0; ox < outWidth; ox++) {
+            int sx0 = (int)((long)ox * crop.width / outWidth);
+            int sx1 = (int)((long)(ox + 1) * crop.width / outWidth);
+            out[ox] = (uint8_t)(scratch[ox] / (uint32_t)(rows * (sx1 - sx0)));
+        }
+    }
+}
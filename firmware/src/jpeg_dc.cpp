@@ -0,0 +1,383 @@
+#include "jpeg_dc.h"
+#include "jpeg_tables.h"
+
+static uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+// 查表项：低 8 位为符号，8-12 位为要跳过的位数；AC 表的码字加尾码不超过查表位数时
+// 一并计入跳过的位数并置 LOOKUP_WHOLE，跳过一个系数只需一次查表
+static const uint16_t LOOKUP_WHOLE = 0x8000;
+static const int LOOKUP_SHIFT = 64 - JPEG_DC_LOOKUP_BITS;
+
+namespace {
+
+// 熵编码数据的位读取：去掉 0xFF00 填充，遇到标记或数据结束后补 0
+struct BitReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t bits;            // 高位对齐
+    int count;
+    bool marker;              // p 停在一个标记上
+    uint32_t padBytes;        // 补入的 0 字节数
+
+    // 一次补到 57 位以上，之后解码一个码字加尾码（最多 27 位）不必再检查
+    void fill() {
+        while (count <= 56) {
+            uint64_t b = 0;
+            if (!marker && p < end) {
+                b = *p;
+                if (b != 0xFF) {
+                    p++;
+                } else if (p + 1 < end && p[1] == 0x00) {
+                    p += 2;
+                } else {
+                    marker = true;
+                    b = 0;
+                    padBytes++;
+                }
+            } else {
+                padBytes++;
+            }
+            bits |= b << (56 - count);
+            count += 8;
+        }
+    }
+
+    uint32_t get(int n) {
+        uint32_t v = (uint32_t)(bits >> (64 - n));
+        bits <<= n;
+        count -= n;
+        return v;
+    }
+
+    void skip(int n) {
+        bits <<= n;
+        count -= n;
+    }
+
+    // 已经消耗了补入的位，说明数据提前结束
+    bool overrun() const { return padBytes * 8 > (uint32_t)count; }
+
+    // 丢弃当前字节剩余的位并越过 RSTn
+    bool restart() {
+        if (overrun()) return false;
+        bits = 0;
+        count = 0;
+        padBytes = 0;
+        marker = false;
+        while (p + 1 < end && p[0] == 0xFF && p[1] == 0xFF) p++;
+        if (p + 1 >= end || p[0] != 0xFF || (p[1] & 0xF8) != 0xD0) return false;
+        p += 2;
+        return true;
+    }
+};
+
+}  // namespace
+
+// 超过查表位数的码字逐个码长比较（调用前已 fill）
+static int decodeSlow(BitReader& r, const int32_t* maxCode, const int32_t* valOffset, const uint8_t* symbols) {
+    for (int l = JPEG_DC_LOOKUP_BITS + 1; l <= 16; l++) {
+        int32_t code = (int32_t)(r.bits >> (64 - l));
+        if (code <= maxCode[l]) {
+            r.skip(l);
+            return symbols[code + valOffset[l]];
+        }
+    }
+    return -1;
+}
+
+// 差分编码的类别 s 加 s 位尾码还原为有符号值（T.81 F.2.2.1 EXTEND）
+static int extend(uint32_t v, int s) {
+    return v < (1u << (s - 1)) ? (int)v - (1 << s) + 1 : (int)v;
+}
+
+bool JpegDcDecoder::buildTable(HuffTable& table, const uint8_t* counts, const uint8_t* symbols, bool ac) {
+    int total = 0;
+    for (int i = 0; i < 16; i++) total += counts[i];
+    if (total > 256) return false;
+
+    memset(table.lookup, 0, sizeof(table.lookup));
+    memcpy(table.symbols, symbols, total);
+    uint32_t code = 0;
+    int k = 0;
+    for (int l = 1; l <= 16; l++) {
+        table.valOffset[l] = k - (int32_t)code;
+        int n = counts[l - 1];
+        for (int i = 0; i < n; i++, code++, k++) {
+            if (l > JPEG_DC_LOOKUP_BITS) continue;
+            uint8_t symbol = symbols[k];
+            int size = symbol & 0x0f;
+            uint16_t entry = (uint16_t)(l << 8 | symbol);
+            if (ac && size && l + size <= JPEG_DC_LOOKUP_BITS) entry = (uint16_t)((l + size) << 8 | symbol | LOOKUP_WHOLE);
+            // 以该码字开头的所有查表索引
+            int shift = JPEG_DC_LOOKUP_BITS - l;
+            for (uint32_t j = 0; j < (1u << shift); j++) {
+                table.lookup[(code << shift) | j] = entry;
+            }
+        }
+        table.maxCode[l] = n ? (int32_t)code - 1 : -1;
+        if (code > (1u << l)) return false;  // 码长分布超出码字空间
+        code <<= 1;
+    }
+    table.defined = true;
+    return true;
+}
+
+bool JpegDcDecoder::parseQuant(const uint8_t* seg, size_t len) {
+    while (len > 0) {
+        uint8_t precision = seg[0] >> 4;
+        uint8_t id = seg[0] & 0x0f;
+        size_t size = 1 + 64 * (precision ? 2 : 1);
+        if (id > 3 || precision > 1 || len < size) return false;
+        // 锯齿序第一个就是 DC
+        quantDc[id] = precision ? readU16(seg + 1) : seg[1];
+        seg += size;
+        len -= size;
+    }
+    return true;
+}
+
+bool JpegDcDecoder::parseHuffman(const uint8_t* seg, size_t len) {
+    while (len >= 17) {
+        uint8_t cls = seg[0] >> 4;
+        uint8_t id = seg[0] & 0x0f;
+        if (cls > 1 || id > 1) return false;
+        size_t count = 0;
+        for (int i = 0; i < 16; i++) count += seg[1 + i];
+        if (len < 17 + count) return false;
+        if (!buildTable(cls == 0 ? dcTables[id] : acTables[id], seg + 1, seg + 17, cls == 1)) return false;
+        seg += 17 + count;
+        len -= 17 + count;
+    }
+    return len == 0;
+}
+
+bool JpegDcDecoder::parseFrame(const uint8_t* seg, size_t len) {
+    if (len < 6 || seg[0] != 8) return false;
+    uint8_t n = seg[5];
+    if (n == 0 || n > JPEG_DC_MAX_COMPONENTS || len < 6 + 3 * (size_t)n) return false;
+
+    frame.height = readU16(seg + 1);
+    frame.width = readU16(seg + 3);
+    frame.components = n;
+    if (frame.width == 0 || frame.height == 0) return false;  // DNL 定义高度的文件不支持
+
+    uint8_t hMax = 1, vMax = 1;
+    for (uint8_t i = 0; i < n; i++) {
+        const uint8_t* c = seg + 6 + 3 * i;
+        components[i] = {c[0], (uint8_t)(c[1] >> 4), (uint8_t)(c[1] & 0x0f), c[2]};
+        if (components[i].h < 1 || components[i].h > 4 || components[i].v < 1 || components[i].v > 4 ||
+            components[i].tq > 3) {
+            return false;
+        }
+        hMax = max(hMax, components[i].h);
+        vMax = max(vMax, components[i].v);
+    }
+
+    // 第一个分量为亮度（JFIF），亮度平面按采样因子相对最大因子缩放
+    frame.lumaH = components[0].h;
+    frame.lumaV = components[0].v;
+    uint32_t lumaWidth = ((uint32_t)frame.width * frame.lumaH + hMax - 1) / hMax;
+    uint32_t lumaHeight = ((uint32_t)frame.height * frame.lumaV + vMax - 1) / vMax;
+    frame.blocksWide = (lumaWidth + 7) / 8;
+    frame.blocksHigh = (lumaHeight + 7) / 8;
+    return true;
+}
+
+bool JpegDcDecoder::parseScan(const uint8_t* seg, size_t len) {
+    if (len < 1) return false;
+    uint8_t n = seg[0];
+    if (n == 0 || n > frame.components || len < 1 + 2 * (size_t)n + 3) return false;
+
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t id = seg[1 + 2 * i];
+        uint8_t tables = seg[2 + 2 * i];
+        uint8_t index = 0;
+        while (index < frame.components && components[index].id != id) index++;
+        if (index == frame.components) return false;
+        scan[i] = {index, (uint8_t)(tables >> 4), (uint8_t)(tables & 0x0f)};
+        if (scan[i].td > 1 || scan[i].ta > 1) return false;
+    }
+    scanCount = n;
+    return true;
+}
+
+const uint8_t* JpegDcDecoder::parseHeaders(const uint8_t* jpeg, size_t len) {
+    frame = {};
+    scanCount = 0;
+    memset(quantDc, 0, sizeof(quantDc));
+    for (int i = 0; i < 2; i++) {
+        dcTables[i].defined = false;
+        acTables[i].defined = false;
+    }
+    if (!jpeg || len < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) return nullptr;
+
+    bool haveFrame = false;
+    size_t pos = 2;
+    while (pos + 4 <= len) {
+        if (jpeg[pos] != 0xFF) return nullptr;
+        uint8_t marker = jpeg[pos + 1];
+        if (marker == 0xFF) {  // 填充字节
+            pos++;
+            continue;
+        }
+        size_t segLen = readU16(jpeg + pos + 2);
+        const uint8_t* seg = jpeg + pos + 4;
+        if (segLen < 2 || pos + 2 + segLen > len) return nullptr;
+        size_t bodyLen = segLen - 2;
+
+        switch (marker) {
+        case 0xC0:  // 基线
+        case 0xC1:  // 扩展顺序式（Huffman），8 位精度时与基线解码相同
+            if (!parseFrame(seg, bodyLen)) return nullptr;
+            haveFrame = true;
+            break;
+        case 0xC4:
+            if (!parseHuffman(seg, bodyLen)) return nullptr;
+            break;
+        case 0xDB:
+            if (!parseQuant(seg, bodyLen)) return nullptr;
+            break;
+        case 0xDD:
+            if (bodyLen < 2) return nullptr;
+            frame.restartInterval = readU16(seg);
+            break;
+        case 0xDA:
+            if (!haveFrame || !parseScan(seg, bodyLen)) return nullptr;
+            // 只要亮度图：第一个扫描不含亮度（分量分开扫描且顺序不同）时不处理
+            for (uint8_t i = 0; i < scanCount; i++) {
+                if (scan[i].index == 0) return jpeg + pos + 2 + segLen;
+            }
+            return nullptr;
+        case 0xD9:
+            return nullptr;
+        default:
+            // 渐进式、无损、算术编码
+            if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                return nullptr;
+            }
+            break;
+        }
+        pos += 2 + segLen;
+    }
+    return nullptr;
+}
+
+bool JpegDcDecoder::decodeScan(const uint8_t* data, const uint8_t* end, JpegDcBlockFn onBlock, void* arg) {
+    if (quantDc[components[0].tq] == 0) return false;
+
+    // MJPEG 等省略 DHT 的流使用标准表
+    for (uint8_t i = 0; i < scanCount; i++) {
+        const ScanComponent& sc = scan[i];
+        bool luma = sc.td == 0;
+        if (!dcTables[sc.td].defined) {
+            buildTable(dcTables[sc.td], luma ? JPEG_DC_LUMA_BITS : JPEG_DC_CHROMA_BITS, JPEG_DC_VALUES, false);
+        }
+        luma = sc.ta == 0;
+        if (!acTables[sc.ta].defined) {
+            buildTable(acTables[sc.ta], luma ? JPEG_AC_LUMA_BITS : JPEG_AC_CHROMA_BITS,
+                       luma ? JPEG_AC_LUMA_VALUES : JPEG_AC_CHROMA_VALUES, true);
+        }
+    }
+
+    // 交织扫描的 MCU 覆盖每个分量 h x v 个块；单分量扫描每个 MCU 一个块
+    bool interleaved = scanCount > 1;
+    uint32_t mcusWide, mcusHigh;
+    if (interleaved) {
+        uint8_t hMax = 1, vMax = 1;
+        for (uint8_t i = 0; i < frame.components; i++) {
+            hMax = max(hMax, components[i].h);
+            vMax = max(vMax, components[i].v);
+        }
+        mcusWide = (frame.width + 8 * hMax - 1) / (8 * hMax);
+        mcusHigh = (frame.height + 8 * vMax - 1) / (8 * vMax);
+    } else {
+        mcusWide = frame.blocksWide;
+        mcusHigh = frame.blocksHigh;
+    }
+
+    uint16_t q0 = quantDc[components[0].tq];
+    int pred[JPEG_DC_MAX_COMPONENTS] = {};
+    BitReader r = {data, end, 0, 0, false, 0};
+    uint32_t mcu = 0;
+
+    for (uint32_t my = 0; my < mcusHigh; my++) {
+        for (uint32_t mx = 0; mx < mcusWide; mx++, mcu++) {
+            if (frame.restartInterval && mcu > 0 && mcu % frame.restartInterval == 0) {
+                if (!r.restart()) return false;
+                memset(pred, 0, sizeof(pred));
+            }
+
+            for (uint8_t i = 0; i < scanCount; i++) {
+                const ScanComponent& sc = scan[i];
+                const Component& c = components[sc.index];
+                const HuffTable& dc = dcTables[sc.td];
+                const HuffTable& ac = acTables[sc.ta];
+                uint8_t bh = interleaved ? c.h : 1;
+                uint8_t bv = interleaved ? c.v : 1;
+
+                for (uint8_t v = 0; v < bv; v++) {
+                    for (uint8_t h = 0; h < bh; h++) {
+                        if (r.count < 27) r.fill();
+                        uint16_t entry = dc.lookup[r.bits >> LOOKUP_SHIFT];
+                        int s;
+                        if (entry) {
+                            r.skip((entry >> 8) & 0x1f);
+                            s = entry & 0xff;
+                        } else {
+                            s = decodeSlow(r, dc.maxCode, dc.valOffset, dc.symbols);
+                        }
+                        if (s < 0 || s > 11) return false;
+                        if (s) pred[i] += extend(r.get(s), s);
+
+                        // 跳过 63 个 AC 系数：只解码游程/类别，尾码按位数跳过
+                        for (int k = 1; k < 64;) {
+                            if (r.count < 27) r.fill();
+                            entry = ac.lookup[r.bits >> LOOKUP_SHIFT];
+                            int rs;
+                            if (entry & LOOKUP_WHOLE) {
+                                r.skip((entry >> 8) & 0x1f);
+                                k += ((entry >> 4) & 0x0f) + 1;
+                                continue;
+                            }
+                            if (entry) {
+                                r.skip((entry >> 8) & 0x1f);
+                                rs = entry & 0xff;
+                            } else {
+                                rs = decodeSlow(r, ac.maxCode, ac.valOffset, ac.symbols);
+                                if (rs < 0) return false;
+                            }
+                            int run = rs >> 4;
+                            int size = rs & 0x0f;
+                            if (size == 0) {
+                                if (run != 15) break;  // EOB
+                                k += 16;
+                            } else {
+                                k += run + 1;
+                                r.skip(size);
+                            }
+                        }
+
+                        if (sc.index != 0) continue;
+                        uint32_t bx = interleaved ? mx * c.h + h : mx;
+                        uint32_t by = interleaved ? my * c.v + v : my;
+                        if (bx >= frame.blocksWide || by >= frame.blocksHigh) continue;  // MCU 右/下边缘的填充块
+                        // DC = 8 x 块均值（电平平移 -128 后），四舍五入
+                        int32_t dq = pred[i] * q0;
+                        int luma = 128 + (dq >= 0 ? dq + 4 : dq - 4) / 8;
+                        onBlock(arg, bx, by, (uint8_t)constrain(luma, 0, 255));
+                    }
+                }
+            }
+        }
+    }
+    return !r.overrun();
+}
+
+bool JpegDcDecoder::decode(const uint8_t* jpeg, size_t len, JpegDcBlockFn onBlock, void* arg) {
+    if (!onBlock) return false;
+    const uint8_t* data = parseHeaders(jpeg, len);
+    if (!data) return false;
+    return decodeScan(data, jpeg + len, onBlock, arg);
+}
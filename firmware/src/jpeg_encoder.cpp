@@ -0,0 +1,43 @@
+#include "jpeg_encoder.h"
+#include <img_converters.h>
+
+struct JpegSink {
+    uint8_t* out;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+};
+
+static size_t jpegSinkWrite(void* arg, size_t index, const void* data, size_t len) {
+    JpegSink* sink = (JpegSink*)arg;
+    if (index + len > sink->capacity) {
+        sink->overflow = true;
+        return 0;  // 让编码器中止
+    }
+    memcpy(sink->out + index, data, len);
+    if (index + len > sink->length) {
+        sink->length = index + len;
+    }
+    return len;
+}
+
+size_t JpegEncoder::encode(const uint8_t* pixels, int width, int height, pixformat_t format,
+                           int quality, uint8_t* out, size_t capacity) {
+    if (!pixels || !out) return 0;
+
+    size_t srcLen = (size_t)width * height * (format == PIXFORMAT_GRAYSCALE ? 1 : 2);
+    JpegSink sink = {out, capacity, 0, false};
+    bool ok = fmt2jpg_cb((uint8_t*)pixels, srcLen, width, height, format, quality,
+                         jpegSinkWrite, &sink);
+    return (ok && !sink.overflow) ? sink.length : 0;
+}
+
+size_t JpegEncoder::encodeFrame(const camera_fb_t* fb, int quality, uint8_t* out, size_t capacity) {
+    if (!fb) return 0;
+    if (fb->format == PIXFORMAT_JPEG) {
+        if (!out || fb->len > capacity) return 0;
+        memcpy(out, fb->buf, fb->len);
+        return fb->len;
+    }
+    return encode(fb->buf, fb->width, fb->height, fb->format, quality, out, capacity);
+}
@@ -0,0 +1,71 @@
+#include "latency_tracer.h"
+
+LatencyTracer latencyTracer;
+
+static const char* const STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+    "capture", "analysis", "wait", "encode", "first_byte", "send", "total",
+};
+
+void LatencyTracer::record(LatencyStage stage, int64_t fromUs, int64_t toUs) {
+    if (stage >= LATENCY_STAGE_COUNT || fromUs == 0 || toUs == 0) return;
+    int64_t delta = toUs - fromUs;
+    uint32_t us = delta <= 0 ? 0 : delta > UINT32_MAX ? UINT32_MAX : (uint32_t)delta;
+    uint8_t index = bucketIndex(us);
+
+    portENTER_CRITICAL(&lock);
+    LatencyHistogram& h = histograms[stage];
+    h.count++;
+    h.totalUs += us;
+    if (us > h.maxUs) h.maxUs = us;
+    h.buckets[index]++;
+    portEXIT_CRITICAL(&lock);
+}
+
+LatencyHistogram LatencyTracer::getHistogram(LatencyStage stage) {
+    LatencyHistogram copy = {};
+    if (stage >= LATENCY_STAGE_COUNT) return copy;
+    portENTER_CRITICAL(&lock);
+    copy = histograms[stage];
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
+
+void LatencyTracer::reset() {
+    portENTER_CRITICAL(&lock);
+    memset(histograms, 0, sizeof(histograms));
+    portEXIT_CRITICAL(&lock);
+}
+
+uint32_t LatencyTracer::percentile(const LatencyHistogram& h, float p) {
+    if (h.count == 0) return 0;
+    uint32_t rank = (uint32_t)ceilf(h.count * constrain(p, 0.0f, 100.0f) / 100.0f);
+    if (rank == 0) rank = 1;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += h.buckets[i];
+        if (seen >= rank) return min(bucketUpperBound(i), h.maxUs);
+    }
+    return h.maxUs;
+}
+
+const char* LatencyTracer::stageName(LatencyStage stage) {
+    return stage < LATENCY_STAGE_COUNT ? STAGE_NAMES[stage] : "unknown";
+}
+
+uint8_t LatencyTracer::bucketIndex(uint32_t us) {
+    if (us < 64) return 0;
+    int msb = 31 - __builtin_clz(us);
+    int octave = msb - 6;
+    if (octave >= 20) return LATENCY_BUCKETS - 1;
+    // 最高位之后的两位决定 2 倍区间内的 4 个子桶
+    int sub = (us >> (msb - 2)) & 3;
+    return 1 + octave * 4 + sub;
+}
+
+uint32_t LatencyTracer::bucketUpperBound(uint8_t index) {
+    if (index == 0) return 64;
+    if (index >= LATENCY_BUCKETS - 1) return UINT32_MAX;
+    int octave = (index - 1) / 4;
+    int sub = (index - 1) % 4;
+    return (uint32_t)(5 + sub) << (octave + 4);
+}
@@ -5,13 +5,18 @@
 LogLevel Logger::minLevel = LOG_INFO;
 
 void Logger::log(LogLevel level, const char* tag, const char* format, ...) {
-    if (level < minLevel) return;
-
-    char buffer[256];
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    vlog(level, tag, format, args);
     va_end(args);
+}
+
+void Logger::vlog(LogLevel level, const char* tag, const char* format, va_list args) {
+    // 级别数值越大越详细
+    if (level > minLevel) return;
+
+    char buffer[256];
+    vsnprintf(buffer, sizeof(buffer), format, args);
 
     Serial.printf("[%s][%s] %s\n", levelToString(level), tag, buffer);
 }
@@ -19,28 +24,28 @@ void Logger::log(LogLevel level, const char* tag, const char* format, ...) {
 void Logger::error(const char* tag, const char* format, ...) {
     va_list args;
     va_start(args, format);
-    log(LOG_ERROR, tag, format, args);
+    vlog(LOG_ERROR, tag, format, args);
     va_end(args);
 }
 
 void Logger::warn(const char* tag, const char* format, ...) {
     va_list args;
     va_start(args, format);
-    log(LOG_WARN, tag, format, args);
+    vlog(LOG_WARN, tag, format, args);
     va_end(args);
 }
 
 void Logger::info(const char* tag, const char* format, ...) {
     va_list args;
     va_start(args, format);
-    log(LOG_INFO, tag, format, args);
+    vlog(LOG_INFO, tag, format, args);
     va_end(args);
 }
 
 void Logger::debug(const char* tag, const char* format, ...) {
     va_list args;
     va_start(args, format);
-    log(LOG_DEBUG, tag, format, args);
+    vlog(LOG_DEBUG, tag, format, args);
     va_end(args);
 }
 
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <Arduino.h>
+#include <stdarg.h>
 
 enum LogLevel {
     LOG_ERROR,
@@ -22,5 +23,6 @@ public:
 
 private:
     static LogLevel minLevel;
+    static void vlog(LogLevel level, const char* tag, const char* format, va_list args);
     static const char* levelToString(LogLevel level);
 };
@@ -12,6 +12,24 @@
 #include "wifi_scanner.h"
 #include "provisioning_manager.h"
 #include "captive_portal.h"
+#include "frame_recorder.h"
+#include "buffer_pool.h"
+#include "power_manager.h"
+#include "event_store.h"
+#include "jpeg_encoder.h"
+#include "scheduler.h"
+#include "https_pool.h"
+#include "cloud_client.h"
+#include "timelapse_recorder.h"
+#include "motion_uploader.h"
+#include "frame_dedup.h"
+#include "motion_estimator.h"
+#include "motion_event.h"
+#include "rtsp_server.h"
+#include "burst_selector.h"
+#include "parallel.h"
+#include "clip_recorder.h"
+#include "bandwidth_arbiter.h"
 
 Camera camera;
 WiFiManager wifiManager;
@@ -20,38 +38,296 @@ WiFiScanner wifiScanner;
 ProvisioningManager* provManager = nullptr;
 HTTPServer httpServer;
 MotionDetector motionDetector;
+FrameRecorder frameRecorder;
+PowerManager powerManager(camera, wifiManager);
+EventStore eventStore;
+bool g_eventStoreReady = false;
+HttpsPool httpsPool(createTlsTransport);
+CloudClient cloudClient(httpsPool);
+TimelapseRecorder timelapseRecorder(cloudClient);
+bool g_timelapseReady = false;
+MotionUploader motionUploader(cloudClient);
+bool g_motionUploadReady = false;
+FrameDeduplicator frameDedup;
+MotionEstimator motionEstimator;
+MotionEventEngine motionEvents;
+BurstSelector burstSelector;
+ClipRecorder clipRecorder;
+bool g_clipReady = false;
+RtspServer rtspServer([](uint8_t* jpeg) { bufferPool.release(jpeg); });
+bool g_rtspReady = false;
 
 camera_fb_t* g_currentFb = nullptr;
 bool g_motionDetected = false;
 
-// 看门狗任务
-void wdtTask(void* parameter) {
+// 将触发运动的帧编码为 JPEG 存入本地事件日志
+// @return JPEG 字节数，未保存时为 0
+size_t saveMotionEvent(camera_fb_t* fb, uint8_t score) {
+    if (!g_eventStoreReady) return 0;
+
+    uint8_t* jpg = bufferPool.acquire(JpegEncoder::frameOutputSize(fb));
+    if (!jpg) return 0;
+
+    size_t jpgSize = JpegEncoder::encodeFrame(fb, EVENT_JPEG_QUALITY, jpg, bufferPool.capacity(jpg));
+    if (jpgSize > 0) {
+        eventStore.append(eventStore.now(), score, jpg, jpgSize);
+    }
+    bufferPool.release(jpg);
+    return jpgSize;
+}
+
+// 上传变化区域裁剪图和低分辨率全景图
+void uploadMotionEvent(camera_fb_t* fb, uint8_t score, size_t fullFrameBytes) {
+    if (!g_motionUploadReady) return;
+
+    CropRect box;
+    if (motionDetector.getMotionBox(fb->width, fb->height, MOTION_CROP_PADDING, box)) {
+        motionUploader.submit(fb, box, score, fullFrameBytes);
+    }
+}
+
+// 候选事件帧：与近期放行帧相似的丢弃，其余保存到本地
+// @param force 绊线触发的事件不经过去重，并立即上传
+// @return 已保存到本地
+bool handleMotionEvent(camera_fb_t* fb, bool force) {
+    if (!force && DEDUP_ENABLED && !frameDedup.check(motionDetector.getFrameHash(), millis())) return false;
+
+    uint8_t score = motionDetector.getLastScore();
+    size_t jpgSize = saveMotionEvent(fb, score);
+    if (force) {
+        uploadMotionEvent(fb, score, jpgSize);
+    }
+    return jpgSize > 0;
+}
+
+// 事件图像：保存到本地，并替换事件结束时上传的图像（冷却或限速期间的事件只保存到本地）
+// @return 已交给事件上传
+bool holdEventFrame(camera_fb_t* fb, const CropRect* box, uint8_t score, const BurstSelection* burst) {
+    size_t jpgSize = saveMotionEvent(fb, score);
+    if (g_motionUploadReady && box && !motionEvents.isSuppressed()) {
+        return motionUploader.hold(fb, *box, score, jpgSize, burst);
+    }
+    return false;
+}
+
+// 连拍结束：只保存和上传最清晰的一帧
+void finishBurst() {
+    CropRect box;
+    uint8_t score = 0;
+    camera_fb_t* best = burstSelector.getBest(box, score);
+    BurstSelection selection = burstSelector.getSelection();
+    if (best) {
+        holdEventFrame(best, &box, score, &selection);
+        Logger::info("MOTION", "Burst: frame %u of %u selected, sharpness %lu (trigger %lu), scoring %lu us/frame",
+                     selection.selected, selection.frames, (unsigned long)selection.sharpness,
+                     (unsigned long)selection.triggerSharpness, (unsigned long)selection.scoringUs);
+    }
+    burstSelector.finish();
+}
+
+// 事件的新峰值帧：开始连拍选优，不连拍或缓冲池没有整帧槽时直接使用该帧
+// @return 已交给事件上传（连拍选出的帧将交给事件上传）
+bool holdMotionPeak(camera_fb_t* fb) {
+    uint8_t score = motionDetector.getLastScore();
+    CropRect box;
+    bool hasBox = motionDetector.getMotionBox(fb->width, fb->height, MOTION_CROP_PADDING, box);
+    if (BURST_ENABLED && hasBox && burstSelector.start(fb, box, score)) {
+        return g_motionUploadReady && !motionEvents.isSuppressed();
+    }
+    return holdEventFrame(fb, hasBox ? &box : nullptr, score, nullptr);
+}
+
+// 连拍中的帧（包括新的峰值帧）只参与评分
+void offerBurstFrame(camera_fb_t* fb) {
+    CropRect box;
+    bool hasBox = motionDetector.getMotionBox(fb->width, fb->height, MOTION_CROP_PADDING, box);
+    if (burstSelector.offer(fb, hasBox ? &box : nullptr, motionDetector.getLastScore())) {
+        finishBurst();
+    }
+}
+
+// 本帧在事件状态机中的去向，绊线据此避免重复保存和上传
+struct EventFrameUse {
+    bool saved;   // 已保存到本地，或进入连拍（选出的帧会保存）
+    bool held;    // 已作为事件图像等待上传
+};
+
+// 状态机逐帧判断事件开始/结束，每个事件只上传一次峰值帧
+EventFrameUse updateMotionEvent(camera_fb_t* fb, bool motion, uint32_t& lastEventMs) {
+    EventFrameUse use = {false, false};
+    uint32_t now = millis();
+    uint8_t flags = motionEvents.update(motion, motionDetector.getLastScore(), now);
+
+    if (flags & MOTION_EVENT_STARTED) {
+        g_motionDetected = true;
+        Logger::info("MOTION", "Motion detected!");
+        if (g_clipReady) clipRecorder.start(now);
+    }
+    // 短片按自己的帧间隔取帧，与峰值帧、连拍互不影响
+    if (clipRecorder.isDue(now)) {
+        clipRecorder.addFrame(fb, now);
+    }
+    if (burstSelector.isActive()) {
+        if (flags & MOTION_EVENT_PEAK) lastEventMs = now;
+        offerBurstFrame(fb);
+        use.saved = true;
+        use.held = g_motionUploadReady && !motionEvents.isSuppressed();
+    } else if (flags & MOTION_EVENT_PEAK) {
+        lastEventMs = now;
+        use.held = holdMotionPeak(fb);
+        use.saved = true;
+    } else if (motion && motionEvents.isActive() && now - lastEventMs >= MOTION_EVENT_INTERVAL_MS) {
+        // 持续运动期间按间隔保存候选帧到本地，由去重过滤
+        lastEventMs = now;
+        use.saved = handleMotionEvent(fb, false);
+    }
+
+    if (flags & MOTION_EVENT_ENDED) {
+        g_motionDetected = false;
+        if (burstSelector.isActive()) finishBurst();
+        const MotionEvent& event = motionEvents.lastEvent();
+        Logger::info("MOTION", "Motion event ended: %lu ms, peak %u%s%s",
+                     (unsigned long)(event.endMs - event.startMs), event.peakScore,
+                     event.truncated ? " (max duration)" : "", event.suppressed ? " (local only)" : "");
+        ClipInfo clip;
+        bool hasClip = clipRecorder.finish(clip);
+        if (g_motionUploadReady && !event.suppressed) {
+            motionUploader.submitHeld(event, hasClip ? &clip : nullptr);
+        }
+    } else if (flags & MOTION_EVENT_DISCARDED) {
+        g_motionDetected = false;
+        burstSelector.finish();
+        clipRecorder.abort();
+        if (g_motionUploadReady) motionUploader.discardHeld();
+    }
+    return use;
+}
+
+// 绊线触发的帧立即保存和上传，事件状态机已保存或待上传的部分不再重复
+void handleTripwires(camera_fb_t* fb, uint32_t crossed, const EventFrameUse& use) {
+    Tripwire list[MV_MAX_TRIPWIRES];
+    TripwireStatus status[MV_MAX_TRIPWIRES];
+    uint8_t n = motionEstimator.getTripwires(list, status, MV_MAX_TRIPWIRES);
+    for (uint8_t i = 0; i < n; i++) {
+        if (crossed & (1u << i)) {
+            Logger::info("MOTION", "Tripwire '%s' crossed (%s)", list[i].name,
+                         tripwireDirectionName(status[i].lastDirection));
+        }
+    }
+    if (!use.saved) {
+        handleMotionEvent(fb, true);
+    } else if (!use.held) {
+        uploadMotionEvent(fb, motionDetector.getLastScore(), 0);
+    }
+}
+
+// 编码一帧交给 RTSP 任务发送，缓冲区由 RTSP 任务发送后归还
+void streamRtspFrame(camera_fb_t* fb, uint32_t now) {
+    uint8_t* jpg = bufferPool.acquire(JpegEncoder::frameOutputSize(fb));
+    if (!jpg) return;
+
+    size_t jpgSize = JpegEncoder::encodeFrame(fb, RTSP_JPEG_QUALITY, jpg, bufferPool.capacity(jpg));
+    if (jpgSize == 0) {
+        bufferPool.release(jpg);
+        return;
+    }
+    rtspServer.submitFrame(jpg, jpgSize, now);
+}
+
+void rtspTask(void* parameter) {
     while (true) {
-        esp_task_wdt_reset();
-        vTaskDelay(pdMS_TO_TICKS(5000));
+        rtspServer.poll(RTSP_POLL_MS);
     }
 }
 
+// 帧尺寸为活动分辨率（不是空闲监视或唤醒过程中的小分辨率帧）
+bool isActiveFrame(const camera_fb_t* fb) {
+    const resolution_info_t& active = resolution[powerManager.getActiveFrameSize()];
+    return fb->width == active.width && fb->height == active.height;
+}
+
 void captureTask(void* parameter) {
+    uint32_t lastEventMs = 0;
+
     while (true) {
-        if (camera.capture()) {
-            if (g_currentFb != nullptr) {
-                esp_camera_fb_return(g_currentFb);
-            }
-            g_currentFb = camera.getBuffer();
-            httpServer.setBuffer(g_currentFb);
+        // 采集参数、分辨率变更和基准测试会归还或重新分配驱动帧缓冲：
+        // 先等正在读取当前帧的请求结束并撤下当前帧，切换后重建依赖帧尺寸的检测状态
+        if (camera.hasPendingRequest()) {
+            // 连拍已选出的帧是独立拷贝，提前结束连拍
+            if (burstSelector.isActive()) finishBurst();
+            httpServer.lockFrame();
+            httpServer.setBuffer(nullptr);
+            httpServer.unlockFrame();
+            g_currentFb = nullptr;
+            camera.servicePending();
+            motionDetector.reset();
+            motionEstimator.reset();
+        }
+
+        // 取帧可能阻塞到传感器出下一帧，期间不持帧锁，请求读取的仍是上一帧。
+        // 驱动只有一个帧缓冲时须先撤下上一帧
+        if (!camera.keepsPreviousFrame()) {
+            httpServer.lockFrame();
+            httpServer.setBuffer(nullptr);
+            httpServer.unlockFrame();
+        }
+        bool captured = camera.capture();
+        g_currentFb = captured ? camera.getBuffer() : nullptr;
 
+        bool motion = false;
+        uint32_t crossed = 0;
+        bool downstream = false;
+        if (captured) {
             // 运动检测
-            if (motionDetector.detect(g_currentFb)) {
-                if (!g_motionDetected) {
-                    g_motionDetected = true;
-                    Logger::info("MOTION", "Motion detected!");
+            motion = motionDetector.detect(g_currentFb);
+
+            // 配置了绊线时做块匹配（缓慢移动时网格可能没有超过阈值，不依赖网格判断）
+            if (MV_ENABLED && motionEstimator.hasTripwires()) {
+                crossed = motionEstimator.process(g_currentFb, millis());
+            }
+            camera.markAnalyzed();
+
+            // 空闲/唤醒切换，唤醒过程中残留的小分辨率帧不交给下游
+            downstream = powerManager.onFrame(g_currentFb, motion);
+        }
+
+        // 观看者只拿到活动分辨率的帧（空闲监视帧和唤醒残留帧不发布，请求返回 503 并唤醒）。
+        // 只持锁换帧，换下的上一帧此后才还给驱动
+        httpServer.lockFrame();
+        httpServer.setBuffer(downstream && isActiveFrame(g_currentFb) ? g_currentFb : nullptr);
+        httpServer.unlockFrame();
+        camera.releasePrevious();
+
+        if (downstream) {
+            EventFrameUse use = updateMotionEvent(g_currentFb, motion, lastEventMs);
+            if (crossed) {
+                handleTripwires(g_currentFb, crossed, use);
+            }
+
+            // 录制标记逐帧的检测结果，便于离线回放对照
+            frameRecorder.addFrame(g_currentFb, motion);
+
+            // RTSP 观看者和 /stream 一样保持全分辨率
+            if (g_rtspReady && rtspServer.isPlaying()) {
+                powerManager.notifyActivity();
+                uint32_t now = millis();
+                bandwidthArbiter.noteViewer(now);
+                if (rtspServer.wantsFrame(now)) {
+                    streamRtspFrame(g_currentFb, now);
+                }
+            }
+
+            // 延时摄影只用活动分辨率的帧，空闲时先唤醒
+            if (g_timelapseReady && timelapseRecorder.isDue()) {
+                if (isActiveFrame(g_currentFb)) {
+                    timelapseRecorder.addFrame(g_currentFb);
+                } else {
+                    powerManager.notifyActivity();
                 }
-            } else {
-                g_motionDetected = false;
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(1000 / STREAM_FPS));
+        // 连拍期间不等待，capture() 按传感器帧率取连续的帧
+        vTaskDelay(pdMS_TO_TICKS(burstSelector.isActive() ? 0 : powerManager.getFrameIntervalMs()));
     }
 }
 
@@ -67,9 +343,13 @@ void setup() {
     }
     Logger::info("MAIN", "LittleFS mounted");
 
-    // 初始化看门狗
+    // 调度器绑定到主循环任务，之后的定时器和事件都在 loop() 中分发
+    scheduler.begin();
+
+    // 初始化看门狗（订阅主循环任务，由调度器定时喂狗）
     esp_task_wdt_init(10, true);
     esp_task_wdt_add(NULL);
+    scheduler.schedule(WDT_FEED_INTERVAL_MS, []() { esp_task_wdt_reset(); }, WDT_FEED_INTERVAL_MS);
 
     if (!camera.init()) {
         Logger::error("MAIN", "Camera init failed!");
@@ -78,8 +358,46 @@ void setup() {
     }
     Logger::info("MAIN", "Camera initialized");
 
+    // 按可切换的最大帧尺寸预分配缓冲池（RGB565：2 字节/像素）
+    size_t frameBytes = (size_t)resolution[CAMERA_MAX_FRAME_SIZE].width *
+                        resolution[CAMERA_MAX_FRAME_SIZE].height * 2;
+    if (!bufferPool.begin(frameBytes)) {
+        Logger::error("MAIN", "Buffer pool init failed!");
+        delay(1000);
+        ESP.restart();
+    }
+
     motionDetector.init();
     Logger::info("MAIN", "Motion detector initialized");
+    if (MV_ENABLED) {
+        motionEstimator.loadTripwires();
+    }
+
+    powerManager.begin();
+
+    g_eventStoreReady = eventStore.begin();
+    if (!g_eventStoreReady) {
+        Logger::warn("MAIN", "Event store unavailable, events will not be kept locally");
+    }
+
+    wifiManager.init();
+    cloudClient.begin();
+    // 及时关闭空闲连接，批次之间链路保持空闲（会话票据保留）
+    scheduler.schedule(HTTPS_KEEPALIVE_IDLE_MS, []() { httpsPool.closeIdle(); }, HTTPS_KEEPALIVE_IDLE_MS / 2);
+
+    g_motionUploadReady = MOTION_UPLOAD_ENABLED && motionUploader.begin();
+
+    g_clipReady = CLIP_ENABLED && clipRecorder.begin();
+    if (g_clipReady) {
+        motionUploader.setClipRecorder(&clipRecorder);
+    } else if (CLIP_ENABLED) {
+        Logger::warn("MAIN", "Clip recorder unavailable, events upload stills only");
+    }
+
+    g_timelapseReady = timelapseRecorder.begin();
+    if (!g_timelapseReady) {
+        Logger::warn("MAIN", "Time-lapse unavailable");
+    }
 
     // Provisioning 管理
     provManager = new ProvisioningManager(&storage, wifiManager);
@@ -89,9 +407,51 @@ void setup() {
         ESP.restart();
     }
 
+    // RTSP 服务（在 WiFi 初始化之后）
+    if (RTSP_ENABLED) {
+        g_rtspReady = rtspServer.begin();
+        if (g_rtspReady) {
+            xTaskCreateUniversal(rtspTask, "rtsp", 6144, NULL, TASK_RTSP_PRIORITY, NULL, ARDUINO_RUNNING_CORE);
+        } else {
+            Logger::warn("MAIN", "RTSP server unavailable");
+        }
+    }
+
     // 设置 HTTP 服务依赖
+    httpServer.setCamera(&camera);
     httpServer.setProvisioningManager(provManager);
     httpServer.setWiFiScanner(&wifiScanner);
+    if (frameRecorder.begin()) {
+        httpServer.setFrameRecorder(&frameRecorder);
+    }
+    httpServer.setPowerManager(&powerManager);
+    httpServer.setHttpsPool(&httpsPool);
+    httpServer.setMotionEventEngine(&motionEvents);
+    httpServer.setMotionDetector(&motionDetector);
+    if (BURST_ENABLED) {
+        httpServer.setBurstSelector(&burstSelector);
+    }
+    if (DEDUP_ENABLED) {
+        httpServer.setFrameDeduplicator(&frameDedup);
+    }
+    if (MV_ENABLED) {
+        httpServer.setMotionEstimator(&motionEstimator);
+    }
+    if (g_motionUploadReady) {
+        httpServer.setMotionUploader(&motionUploader);
+    }
+    if (g_eventStoreReady) {
+        httpServer.setEventStore(&eventStore);
+    }
+    if (g_clipReady) {
+        httpServer.setClipRecorder(&clipRecorder);
+    }
+    if (g_timelapseReady) {
+        httpServer.setTimelapseRecorder(&timelapseRecorder);
+    }
+    if (g_rtspReady) {
+        httpServer.setRtspServer(&rtspServer);
+    }
 
     httpServer.begin();
     Logger::info("MAIN", "HTTP server started");
@@ -105,6 +465,16 @@ void setup() {
         Logger::info("MAIN", "AP mode: connect to WiFi and open browser");
     }
 
+    // 对时后事件使用真实时间戳
+    if (provManager->getState() == STA_CONNECTED) {
+        configTime(NTP_GMT_OFFSET_SEC, 0, NTP_SERVER);
+    }
+
+    // 帧分析的第二个 worker，须在采集任务开始分析前就绪
+    if (PARALLEL_ANALYSIS_ENABLED && !parallelRunner.begin(PARALLEL_HELPER_CORE)) {
+        Logger::warn("MAIN", "Analysis helper not started, frame analysis runs on one core");
+    }
+
     // 创建采集任务
     xTaskCreateUniversal(
         captureTask,
@@ -116,24 +486,10 @@ void setup() {
         ARDUINO_RUNNING_CORE
     );
 
-    // 创建看门狗任务
-    xTaskCreateUniversal(
-        wdtTask,
-        "wdt",
-        2048,
-        NULL,
-        0,
-        NULL,
-        ARDUINO_RUNNING_CORE
-    );
-
     Logger::info("MAIN", "Setup complete");
 }
 
 void loop() {
-    wifiManager.update();
-    if (provManager) {
-        provManager->update();
-    }
-    vTaskDelay(100);
+    // 阻塞到下一个事件或定时器到期
+    scheduler.run();
 }
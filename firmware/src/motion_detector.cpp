@@ -1,17 +1,29 @@
 // firmware/src/motion_detector.cpp
 #include "motion_detector.h"
 #include "config.h"
+#include "parallel.h"
 #include <string.h>
 
 bool MotionDetector::init() {
-    memset(prevGrid, 0, sizeof(prevGrid));
+    reset();
     initialized = true;
     Serial.println("Motion detector initialized");
     return true;
 }
 
-void MotionDetector::processGrid(camera_fb_t* fb, uint8_t* grid) {
-    if (!fb || !fb->buf) return;
+namespace {
+
+struct GridBands {
+    const camera_fb_t* fb;
+    uint8_t* grid;
+};
+
+}  // namespace
+
+// 计算 [rowBegin, rowEnd) 网格行的平均亮度，各网格只由一个 worker 写入
+static void gridRows(void* arg, uint8_t worker, int rowBegin, int rowEnd) {
+    const GridBands* job = static_cast<const GridBands*>(arg);
+    const camera_fb_t* fb = job->fb;
 
     // 计算 VMA (每个网格的平均亮度)
     int imgWidth = fb->width;
@@ -19,7 +31,7 @@ void MotionDetector::processGrid(camera_fb_t* fb, uint8_t* grid) {
     int cellWidth = imgWidth / MOTION_GRID_COLS;
     int cellHeight = imgHeight / MOTION_GRID_ROWS;
 
-    for (int row = 0; row < MOTION_GRID_ROWS; row++) {
+    for (int row = rowBegin; row < rowEnd; row++) {
         for (int col = 0; col < MOTION_GRID_COLS; col++) {
             // 计算当前网格的像素平均值
             unsigned long sum = 0;
@@ -34,10 +46,10 @@ void MotionDetector::processGrid(camera_fb_t* fb, uint8_t* grid) {
             for (int y = startY; y < endY; y += 2) {
                 for (int x = startX; x < endX; x += 2) {
                     if (y < imgHeight && x < imgWidth) {
-                        // RGB565 格式：2 字节/像素
+                        // RGB565 格式：2 字节/像素，字节序与缩放器相同
                         int idx = y * imgWidth + x;
-                        if (idx < fb->len / 2) {  // 检查 uint16_t 数组边界
-                            uint16_t pixel = ((uint16_t*)fb->buf)[idx];
+                        if ((size_t)idx < fb->len / 2) {  // 检查 uint16_t 数组边界
+                            uint16_t pixel = ImageScaler::loadRGB565(fb->buf + idx * 2);
 
                             // 提取 RGB565 分量
                             uint8_t r5 = (pixel >> 11) & 0x1F;  // 5 位红色
@@ -57,31 +69,108 @@ void MotionDetector::processGrid(camera_fb_t* fb, uint8_t* grid) {
                 }
             }
 
-            grid[row * MOTION_GRID_COLS + col] = count > 0 ? sum / count : 0;
+            job->grid[row * MOTION_GRID_COLS + col] = count > 0 ? sum / count : 0;
         }
     }
 }
 
+bool MotionDetector::processGrid(camera_fb_t* fb, uint8_t* grid) {
+    if (!fb || !fb->buf) return false;
+    if (fb->format == PIXFORMAT_JPEG) return processJpegGrid(fb, grid);
+
+    // 按网格行分给两个核
+    GridBands job = {fb, grid};
+    parallelRunner.run(gridRows, &job, MOTION_GRID_ROWS);
+    return true;
+}
+
+namespace {
+
+// DC 亮度块按块中心落在哪个网格累加，网格划分与 RGB565 路径相同
+struct DcGridSums {
+    int cellWidth;
+    int cellHeight;
+    uint32_t sums[MOTION_GRID_ROWS * MOTION_GRID_COLS];
+    uint16_t counts[MOTION_GRID_ROWS * MOTION_GRID_COLS];
+};
+
+}  // namespace
+
+static void addDcBlock(void* arg, uint16_t bx, uint16_t by, uint8_t luma) {
+    DcGridSums* g = (DcGridSums*)arg;
+    int col = (bx * 8 + 4) / g->cellWidth;
+    int row = (by * 8 + 4) / g->cellHeight;
+    if (col >= MOTION_GRID_COLS || row >= MOTION_GRID_ROWS) return;
+    g->sums[row * MOTION_GRID_COLS + col] += luma;
+    g->counts[row * MOTION_GRID_COLS + col]++;
+}
+
+bool MotionDetector::processJpegGrid(camera_fb_t* fb, uint8_t* grid) {
+    DcGridSums g = {};
+    g.cellWidth = fb->width / MOTION_GRID_COLS;
+    g.cellHeight = fb->height / MOTION_GRID_ROWS;
+    if (g.cellWidth == 0 || g.cellHeight == 0 || !dcDecoder.decode(fb->buf, fb->len, addDcBlock, &g)) {
+        decodeErrors++;
+        return false;
+    }
+
+    for (int i = 0; i < MOTION_GRID_ROWS * MOTION_GRID_COLS; i++) {
+        grid[i] = g.counts[i] ? g.sums[i] / g.counts[i] : 0;
+    }
+    return true;
+}
+
 bool MotionDetector::compareGrids(const uint8_t* grid1, const uint8_t* grid2) {
     int changedCells = 0;
+    changedRowMin = MOTION_GRID_ROWS;
+    changedColMin = MOTION_GRID_COLS;
+    changedRowMax = 0;
+    changedColMax = 0;
 
     for (int i = 0; i < MOTION_GRID_ROWS * MOTION_GRID_COLS; i++) {
         int diff = abs((int)grid1[i] - (int)grid2[i]);
         if (diff > threshold) {
             changedCells++;
+
+            // 记录变化区域，供裁剪上传使用
+            uint8_t row = i / MOTION_GRID_COLS;
+            uint8_t col = i % MOTION_GRID_COLS;
+            changedRowMin = min(changedRowMin, row);
+            changedRowMax = max(changedRowMax, row);
+            changedColMin = min(changedColMin, col);
+            changedColMax = max(changedColMax, col);
         }
     }
 
+    lastScore = changedCells;
     return changedCells >= triggerCount;
 }
 
+uint64_t MotionDetector::hashGrid(const uint8_t* grid) {
+    static_assert(MOTION_GRID_ROWS * (MOTION_GRID_COLS - 1) <= 64, "grid too large for 64-bit hash");
+
+    // 只比较亮度的相对大小，对整体曝光变化不敏感
+    uint64_t hash = 0;
+    for (int row = 0; row < MOTION_GRID_ROWS; row++) {
+        const uint8_t* cells = grid + row * MOTION_GRID_COLS;
+        for (int col = 0; col < MOTION_GRID_COLS - 1; col++) {
+            hash = (hash << 1) | (cells[col] > cells[col + 1] ? 1 : 0);
+        }
+    }
+    return hash;
+}
+
 bool MotionDetector::detect(camera_fb_t* fb) {
     if (!initialized || !fb) return false;
 
     uint8_t currentGrid[MOTION_GRID_ROWS * MOTION_GRID_COLS];
-    processGrid(fb, currentGrid);
+    lastScore = 0;
+    // 无法解析的帧不更新基准
+    if (!processGrid(fb, currentGrid)) return false;
+    lastHash = hashGrid(currentGrid);
 
-    bool motion = compareGrids(prevGrid, currentGrid);
+    bool motion = hasBaseline && compareGrids(prevGrid, currentGrid);
+    hasBaseline = true;
 
     // 更新前一帧
     memcpy(prevGrid, currentGrid, sizeof(prevGrid));
@@ -89,6 +178,32 @@ bool MotionDetector::detect(camera_fb_t* fb) {
     return motion;
 }
 
+bool MotionDetector::getMotionBox(int frameWidth, int frameHeight, int padding, CropRect& box) const {
+    if (lastScore == 0) return false;
+
+    // 与 processGrid 相同的网格划分，最后一行/列延伸到图像边缘
+    int cellWidth = frameWidth / MOTION_GRID_COLS;
+    int cellHeight = frameHeight / MOTION_GRID_ROWS;
+    int x0 = changedColMin * cellWidth - padding;
+    int y0 = changedRowMin * cellHeight - padding;
+    int x1 = changedColMax == MOTION_GRID_COLS - 1 ? frameWidth : (changedColMax + 1) * cellWidth + padding;
+    int y1 = changedRowMax == MOTION_GRID_ROWS - 1 ? frameHeight : (changedRowMax + 1) * cellHeight + padding;
+
+    // 按 8 像素对齐，与 JPEG 块边界一致
+    x0 &= ~7;
+    y0 &= ~7;
+    x1 = (x1 + 7) & ~7;
+    y1 = (y1 + 7) & ~7;
+
+    box = CropRect(x0, y0, x1 - x0, y1 - y0);
+    return ImageScaler::clampCrop(box, frameWidth, frameHeight);
+}
+
+void MotionDetector::reset() {
+    memset(prevGrid, 0, sizeof(prevGrid));
+    hasBaseline = false;
+}
+
 void MotionDetector::setThreshold(uint8_t th) {
     threshold = th;
 }
@@ -0,0 +1,347 @@
+#include "motion_estimator.h"
+#include "image_scaler.h"
+#include <math.h>
+
+#if MV_SAD_SIMD && defined(CONFIG_IDF_TARGET_ESP32S3)
+static_assert(MV_BLOCK_SIZE == 8, "PIE blockSad handles 8-pixel rows");
+
+// ESP32-S3 PIE（128 位向量）：每行 8 像素，用 EE.LD.128.USAR + EE.SRC.Q 从任意地址取 16 字节，只统计低 8 个通道。
+// 没有无符号字节的 max/min，异或 0x80 后按有符号比较；|a-b| = max - min，
+// sum(max) 与 sum(255 - min) 用 EE.VMULAS.U8.ACCX 乘通道掩码累加到 ACCX，再减去每像素多出的 255。
+// Q 寄存器和 ACCX 不随任务切换保存：要求每个核上只有执行本函数的任务（采集任务、分析辅助任务）使用 PIE，
+// 且本函数不会在一次调用中途被同核的另一次调用抢占
+alignas(16) static const uint8_t SAD_CONSTANTS[3][16] = {
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F},
+    {1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0},
+};
+
+uint32_t MotionEstimator::blockSad(const uint8_t* a, const uint8_t* b, int stride, uint32_t limit) {
+    const uint8_t* constants = SAD_CONSTANTS[0];
+    __asm__ volatile(
+        "ee.vld.128.ip q5, %0, 16\n"
+        "ee.vld.128.ip q6, %0, 16\n"
+        "ee.vld.128.ip q7, %0, 16\n"
+        : "+r"(constants) : : "memory");
+
+    uint32_t sum = 0;
+    for (int y = 0; y < MV_BLOCK_SIZE; y += 2) {
+        __asm__ volatile("ee.zero.accx\n");
+        for (int row = 0; row < 2; row++) {
+            const uint8_t* pa = a;
+            const uint8_t* pb = b;
+            __asm__ volatile(
+                "ee.ld.128.usar.ip q0, %0, 16\n"
+                "ee.vld.128.ip q1, %0, 16\n"
+                "ee.src.q q0, q0, q1\n"
+                "ee.ld.128.usar.ip q2, %1, 16\n"
+                "ee.vld.128.ip q3, %1, 16\n"
+                "ee.src.q q2, q2, q3\n"
+                "ee.xorq q0, q0, q5\n"
+                "ee.xorq q2, q2, q5\n"
+                "ee.vmax.s8 q1, q0, q2\n"
+                "ee.vmin.s8 q3, q0, q2\n"
+                "ee.xorq q1, q1, q5\n"
+                "ee.xorq q3, q3, q6\n"
+                "ee.vmulas.u8.accx q1, q7\n"
+                "ee.vmulas.u8.accx q3, q7\n"
+                : "+r"(pa), "+r"(pb) : : "memory");
+            a += stride;
+            b += stride;
+        }
+        uint32_t acc;
+        __asm__ volatile("rur.accx_0 %0\n" : "=r"(acc));
+        sum += acc - 2 * MV_BLOCK_SIZE * 255;
+        // 已不可能优于当前最佳匹配
+        if (sum >= limit) return sum;
+    }
+    return sum;
+}
+#else
+uint32_t MotionEstimator::blockSad(const uint8_t* a, const uint8_t* b, int stride, uint32_t limit) {
+    uint32_t sum = 0;
+    for (int y = 0; y < MV_BLOCK_SIZE; y++) {
+        // 定长内层循环，编译器可展开/向量化
+        for (int x = 0; x < MV_BLOCK_SIZE; x++) {
+            sum += abs((int)a[x] - (int)b[x]);
+        }
+        // 已不可能优于当前最佳匹配
+        if (sum >= limit) return sum;
+        a += stride;
+        b += stride;
+    }
+    return sum;
+}
+#endif
+
+namespace {
+
+struct PlaneBands {
+    const camera_fb_t* fb;
+    uint8_t* plane;
+    uint32_t (*scratch)[MV_PLANE_WIDTH];
+};
+
+struct BlockBands {
+    MotionEstimator* estimator;
+    const uint8_t* cur;
+    const uint8_t* ref;
+    // 各 worker 的部分计数，返回后按 worker 顺序相加
+    uint16_t moving[ParallelRunner::WORKERS];
+    uint32_t searched[ParallelRunner::WORKERS];
+};
+
+}  // namespace
+
+void MotionEstimator::planeRows(void* arg, uint8_t worker, int begin, int end) {
+    PlaneBands* job = static_cast<PlaneBands*>(arg);
+    CropRect full(0, 0, job->fb->width, job->fb->height);
+    ImageScaler::scaleRGB565ToGrayRows(job->fb->buf, job->fb->width, full, job->plane, MV_PLANE_WIDTH,
+                                       MV_PLANE_HEIGHT, begin, end, job->scratch[worker]);
+}
+
+void MotionEstimator::buildPlane(camera_fb_t* fb, uint8_t* plane) {
+    // 每组 MV_BLOCK_SIZE 行，两个核交替领取
+    PlaneBands job = {fb, plane, scratch};
+    parallelRunner.run(planeRows, &job, MV_PLANE_HEIGHT, MV_BLOCK_SIZE);
+}
+
+void MotionEstimator::blockRows(void* arg, uint8_t worker, int begin, int end) {
+    BlockBands* job = static_cast<BlockBands*>(arg);
+    for (int br = begin; br < end; br++) {
+        job->moving[worker] += job->estimator->estimateRow(job->cur, job->ref, br, job->searched[worker]);
+    }
+}
+
+uint16_t MotionEstimator::estimate(const uint8_t* cur, const uint8_t* ref) {
+    // 每行块只写自己的矢量，计数按 worker 分开
+    BlockBands job = {this, cur, ref, {}, {}};
+    parallelRunner.run(blockRows, &job, BLOCK_ROWS);
+
+    uint16_t moving = 0;
+    uint32_t searched = 0;
+    for (uint8_t w = 0; w < ParallelRunner::WORKERS; w++) {
+        moving += job.moving[w];
+        searched += job.searched[w];
+    }
+    stats.searchedBlocks += searched;
+    return moving;
+}
+
+uint16_t MotionEstimator::estimateRow(const uint8_t* cur, const uint8_t* ref, int br, uint32_t& searched) {
+    uint16_t moving = 0;
+    for (int bc = 0; bc < BLOCK_COLS; bc++) {
+        int x = bc * MV_BLOCK_SIZE;
+        int y = br * MV_BLOCK_SIZE;
+        const uint8_t* block = cur + y * MV_PLANE_WIDTH + x;
+        MotionVector& mv = vectors[br * BLOCK_COLS + bc];
+
+        uint32_t zero = blockSad(block, ref + y * MV_PLANE_WIDTH + x, MV_PLANE_WIDTH, UINT32_MAX);
+        mv = {0, 0, (uint16_t)min(zero, (uint32_t)UINT16_MAX)};
+        if (zero < MV_MIN_BLOCK_SAD) continue;
+
+        // 窗口内全搜索，零位移作为初始最佳值，相同 SAD 保留先找到的
+        searched++;
+        uint32_t best = zero;
+        int bestDx = 0, bestDy = 0;
+        for (int dy = -MV_SEARCH_RANGE; dy <= MV_SEARCH_RANGE; dy++) {
+            if (y + dy < 0 || y + dy + MV_BLOCK_SIZE > MV_PLANE_HEIGHT) continue;
+            for (int dx = -MV_SEARCH_RANGE; dx <= MV_SEARCH_RANGE; dx++) {
+                if (x + dx < 0 || x + dx + MV_BLOCK_SIZE > MV_PLANE_WIDTH) continue;
+                uint32_t sad = blockSad(block, ref + (y + dy) * MV_PLANE_WIDTH + x + dx, MV_PLANE_WIDTH, best);
+                if (sad < best) {
+                    best = sad;
+                    bestDx = dx;
+                    bestDy = dy;
+                }
+            }
+        }
+
+        // 匹配没有明显优于零位移（纹理不足、光照变化）时不给出矢量
+        if (best * 4 > zero * 3) continue;
+
+        // 当前块来自上一帧的 (x+dx, y+dy)，内容位移方向相反
+        mv = {(int8_t)-bestDx, (int8_t)-bestDy, (uint16_t)best};
+        moving++;
+    }
+    return moving;
+}
+
+uint32_t MotionEstimator::checkTripwires(uint32_t nowMs) {
+    uint32_t fired = 0;
+    const float half = MV_BLOCK_SIZE / 2.0f;
+
+    // 绊线可能同时被 HTTP 任务修改，在副本上计算
+    Tripwire active[MV_MAX_TRIPWIRES];
+    uint8_t count = getTripwires(active, nullptr, MV_MAX_TRIPWIRES);
+
+    for (uint8_t i = 0; i < count; i++) {
+        const Tripwire& tw = active[i];
+        float ax = tw.x0 * MV_PLANE_WIDTH / 1000.0f;
+        float ay = tw.y0 * MV_PLANE_HEIGHT / 1000.0f;
+        float abx = tw.x1 * MV_PLANE_WIDTH / 1000.0f - ax;
+        float aby = tw.y1 * MV_PLANE_HEIGHT / 1000.0f - ay;
+        float len = sqrtf(abx * abx + aby * aby);
+        if (len < 1.0f) continue;
+
+        int forward = 0, backward = 0;
+        for (int b = 0; b < BLOCK_COLS * BLOCK_ROWS; b++) {
+            const MotionVector& mv = vectors[b];
+            if (mv.dx == 0 && mv.dy == 0) continue;
+
+            // 块中心到线的有符号距离（正值在 A→B 右手侧）及沿线位置
+            float cx = (b % BLOCK_COLS) * MV_BLOCK_SIZE + half - ax;
+            float cy = (b / BLOCK_COLS) * MV_BLOCK_SIZE + half - ay;
+            float along = (cx * abx + cy * aby) / len;
+            if (along < -half || along > len + half) continue;
+
+            float d1 = (abx * cy - aby * cx) / len;
+            float dn = (abx * mv.dy - aby * mv.dx) / len;   // 矢量的法向分量
+            float d0 = d1 - dn;
+            if (fabsf(dn) < 1.0f) continue;
+
+            // 矢量穿过线，或起止点落在线两侧半个块宽的带内
+            if ((d0 < 0) != (d1 < 0) || min(fabsf(d0), fabsf(d1)) <= half) {
+                if (dn > 0) forward++;
+                else backward++;
+            }
+        }
+
+        TripwireDirection dir = TRIPWIRE_BOTH;
+        if (forward >= MV_TRIPWIRE_MIN_BLOCKS && forward > backward) dir = TRIPWIRE_FORWARD;
+        else if (backward >= MV_TRIPWIRE_MIN_BLOCKS && backward > forward) dir = TRIPWIRE_BACKWARD;
+        bool wanted = dir != TRIPWIRE_BOTH && (tw.direction == TRIPWIRE_BOTH || tw.direction == dir);
+
+        // 同一次穿越会持续数帧：线附近清空之前、以及冷却期内不重复触发
+        portENTER_CRITICAL(&lock);
+        TripwireStatus& st = status[i];
+        bool changed = i >= tripwireCount || strncmp(tripwires[i].name, tw.name, sizeof(tw.name)) != 0;
+        bool cooling = st.crossings > 0 && nowMs - st.lastCrossMs < MV_TRIPWIRE_COOLDOWN_MS;
+        if (!changed && forward == 0 && backward == 0) {
+            busy[i] = false;
+        }
+        if (!changed && wanted && !busy[i] && !cooling) {
+            busy[i] = true;
+            st.crossings++;
+            st.lastCrossMs = nowMs;
+            st.lastDirection = dir;
+            fired |= 1u << i;
+        }
+        portEXIT_CRITICAL(&lock);
+    }
+    return fired;
+}
+
+uint32_t MotionEstimator::process(camera_fb_t* fb, uint32_t nowMs) {
+    if (!fb || !fb->buf || fb->format != PIXFORMAT_RGB565 ||
+        (int)fb->width < MV_PLANE_WIDTH || (int)fb->height < MV_PLANE_HEIGHT) {
+        reset();
+        return 0;
+    }
+
+    uint32_t start = micros();
+    uint8_t next = current ^ 1;
+    buildPlane(fb, planes[next]);
+
+    uint32_t fired = 0;
+    uint16_t moving = 0;
+    bool searched = hasReference;
+    if (searched) {
+        moving = estimate(planes[next], planes[current]);
+
+        // 大部分块都在动通常是镜头晃动或自动曝光，不判断越线
+        if (moving * 100 > BLOCK_COLS * BLOCK_ROWS * MV_MAX_MOVING_PCT) {
+            stats.globalMotionFrames++;
+        } else {
+            fired = checkTripwires(nowMs);
+        }
+    } else {
+        memset(vectors, 0, sizeof(vectors));
+    }
+    current = next;
+    hasReference = true;
+
+    uint32_t elapsed = micros() - start;
+    portENTER_CRITICAL(&lock);
+    if (searched) {
+        stats.frames++;
+        stats.lastUs = elapsed;
+        stats.maxUs = max(stats.maxUs, elapsed);
+        stats.totalUs += elapsed;
+    }
+    stats.movingBlocks = moving;
+    memcpy(published, vectors, sizeof(published));
+    portEXIT_CRITICAL(&lock);
+
+    return fired;
+}
+
+void MotionEstimator::reset() {
+    hasReference = false;
+}
+
+bool MotionEstimator::setTripwire(const Tripwire& tripwire) {
+    if (tripwire.x0 > 1000 || tripwire.y0 > 1000 || tripwire.x1 > 1000 || tripwire.y1 > 1000 ||
+        tripwire.direction > TRIPWIRE_BACKWARD || tripwire.name[0] == '\0') {
+        return false;
+    }
+
+    bool ok = true;
+    portENTER_CRITICAL(&lock);
+    uint8_t i = 0;
+    while (i < tripwireCount && strncmp(tripwires[i].name, tripwire.name, sizeof(tripwire.name)) != 0) i++;
+    if (i == tripwireCount) {
+        if (tripwireCount < MV_MAX_TRIPWIRES) tripwireCount++;
+        else ok = false;
+    }
+    if (ok) {
+        tripwires[i] = tripwire;
+        tripwires[i].name[sizeof(tripwire.name) - 1] = '\0';
+        status[i] = {};
+        busy[i] = false;
+    }
+    portEXIT_CRITICAL(&lock);
+    return ok;
+}
+
+bool MotionEstimator::removeTripwire(const char* name) {
+    bool found = false;
+    portENTER_CRITICAL(&lock);
+    for (uint8_t i = 0; i < tripwireCount; i++) {
+        if (strncmp(tripwires[i].name, name, sizeof(tripwires[i].name)) != 0) continue;
+        for (uint8_t j = i + 1; j < tripwireCount; j++) {
+            tripwires[j - 1] = tripwires[j];
+            status[j - 1] = status[j];
+            busy[j - 1] = busy[j];
+        }
+        tripwireCount--;
+        found = true;
+        break;
+    }
+    portEXIT_CRITICAL(&lock);
+    return found;
+}
+
+uint8_t MotionEstimator::getTripwires(Tripwire* out, TripwireStatus* outStatus, uint8_t max) {
+    portENTER_CRITICAL(&lock);
+    uint8_t n = min(tripwireCount, max);
+    for (uint8_t i = 0; i < n; i++) {
+        out[i] = tripwires[i];
+        if (outStatus) outStatus[i] = status[i];
+    }
+    portEXIT_CRITICAL(&lock);
+    return n;
+}
+
+void MotionEstimator::getVectors(MotionVector* out) {
+    portENTER_CRITICAL(&lock);
+    memcpy(out, published, sizeof(published));
+    portEXIT_CRITICAL(&lock);
+}
+
+MotionEstimatorStats MotionEstimator::getStats() {
+    portENTER_CRITICAL(&lock);
+    MotionEstimatorStats copy = stats;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
@@ -0,0 +1,123 @@
+#include "motion_event.h"
+
+static_assert(EVENT_WINDOW_FRAMES >= 1 && EVENT_WINDOW_FRAMES <= 32, "EVENT_WINDOW_FRAMES must be 1..32");
+static_assert(EVENT_START_FRAMES >= 1 && EVENT_START_FRAMES <= EVENT_WINDOW_FRAMES,
+              "EVENT_START_FRAMES must be 1..EVENT_WINDOW_FRAMES");
+
+static const uint32_t WINDOW_MASK = EVENT_WINDOW_FRAMES == 32 ? 0xFFFFFFFFu : (1u << EVENT_WINDOW_FRAMES) - 1;
+
+uint8_t MotionEventEngine::update(bool motion, uint8_t score, uint32_t nowMs) {
+    if (motion && !lastMotion) {
+        portENTER_CRITICAL(&lock);
+        stats.onsets++;
+        portEXIT_CRITICAL(&lock);
+    }
+    lastMotion = motion;
+
+    if (active) {
+        uint8_t flags = 0;
+        if (motion || score >= EVENT_HOLD_SCORE) {
+            event.endMs = nowMs;
+            event.motionFrames++;
+            if (score > event.peakScore) event.peakScore = score;
+            // 冷却或限速期间开始的事件在期满后转为上报，以当前帧作为待上传图像
+            if (event.suppressed && motion && !coolingDown(nowMs) && !rateLimited(nowMs)) {
+                event.suppressed = false;
+                imageScore = 0;
+                imageMs = nowMs - EVENT_PEAK_REFRESH_MS;
+            }
+            // 分数持续上升时每帧都是新峰值，限制重新编码的频率
+            if (score > imageScore && nowMs - imageMs >= EVENT_PEAK_REFRESH_MS) {
+                imageScore = score;
+                imageMs = nowMs;
+                flags |= MOTION_EVENT_PEAK;
+            }
+        }
+        if (nowMs - event.startMs >= EVENT_MAX_DURATION_MS) return flags | finish(nowMs, true);
+        if (nowMs - event.endMs >= EVENT_QUIET_MS) return flags | finish(nowMs, false);
+        return flags;
+    }
+
+    framePos = (framePos + 1) % EVENT_WINDOW_FRAMES;
+    frameTimes[framePos] = nowMs;
+    window = ((window << 1) | (motion ? 1 : 0)) & WINDOW_MASK;
+    if (!window) {
+        windowPeak = 0;
+        return 0;
+    }
+    if (motion && score > windowPeak) windowPeak = score;
+
+    // 以当前帧有运动为开始条件，事件图像取自这一帧
+    if (!motion || __builtin_popcount(window) < EVENT_START_FRAMES) return 0;
+
+    // 冷却或限速期间照常开始事件，只是结束时不上报
+    bool cooling = coolingDown(nowMs);
+    bool limited = !cooling && rateLimited(nowMs);
+
+    // 事件从窗口内最早的运动帧算起
+    int oldest = 31 - __builtin_clz(window);
+    event = {};
+    event.startMs = frameTimes[(framePos + EVENT_WINDOW_FRAMES - oldest) % EVENT_WINDOW_FRAMES];
+    event.endMs = nowMs;
+    event.motionFrames = __builtin_popcount(window);
+    event.peakScore = windowPeak;
+    event.suppressed = cooling || limited;
+    imageScore = score;
+    imageMs = nowMs;
+    active = true;
+
+    portENTER_CRITICAL(&lock);
+    stats.started++;
+    if (cooling) stats.cooldownSuppressed++;
+    if (limited) stats.rateSuppressed++;
+    stats.active = true;
+    portEXIT_CRITICAL(&lock);
+    return MOTION_EVENT_STARTED | MOTION_EVENT_PEAK;
+}
+
+uint8_t MotionEventEngine::finish(uint32_t nowMs, bool truncated) {
+    active = false;
+    window = 0;
+    windowPeak = 0;
+    event.truncated = truncated;
+    bool tooShort = !truncated && event.endMs - event.startMs < EVENT_MIN_DURATION_MS;
+
+    portENTER_CRITICAL(&lock);
+    stats.active = false;
+    if (tooShort) {
+        stats.discarded++;
+    } else {
+        if (truncated) stats.truncated++;
+        if (!event.suppressed) {
+            stats.reported++;
+            stats.last = event;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (tooShort) return MOTION_EVENT_DISCARDED;
+    if (event.suppressed) return MOTION_EVENT_ENDED;
+
+    hasReported = true;
+    lastReportMs = nowMs;
+    reportTimes[reportNext] = nowMs;
+    reportNext = (reportNext + 1) % EVENT_RATE_LIMIT;
+    if (reportCount < EVENT_RATE_LIMIT) reportCount++;
+    return MOTION_EVENT_ENDED;
+}
+
+bool MotionEventEngine::coolingDown(uint32_t nowMs) const {
+    return hasReported && nowMs - lastReportMs < EVENT_COOLDOWN_MS;
+}
+
+bool MotionEventEngine::rateLimited(uint32_t nowMs) const {
+    // 记录已满时 reportNext 指向最早的一次上报
+    return reportCount >= EVENT_RATE_LIMIT && nowMs - reportTimes[reportNext] < EVENT_RATE_WINDOW_MS;
+}
+
+MotionEventStats MotionEventEngine::getStats() {
+    portENTER_CRITICAL(&lock);
+    MotionEventStats copy = stats;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
@@ -0,0 +1,344 @@
+#include "motion_uploader.h"
+#include "buffer_pool.h"
+#include "jpeg_encoder.h"
+#include "logger.h"
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include <time.h>
+
+static const char* UPLOAD_PATH = "/api/v1/images/upload";
+
+// 先按原始大小的 1/4 申请输出缓冲区（整帧时为中槽），放不下再用原始大小重试
+static size_t encodeToPool(const uint8_t* pixels, int width, int height, int quality, uint8_t*& out) {
+    size_t rawBytes = (size_t)width * height * 2;
+    size_t sizes[2] = {rawBytes / 4, rawBytes + BUFFER_POOL_HEADROOM};
+    for (size_t capacity : sizes) {
+        out = bufferPool.acquire(capacity);
+        if (!out) continue;
+        size_t n = JpegEncoder::encode(pixels, width, height, PIXFORMAT_RGB565, quality,
+                                       out, bufferPool.capacity(out));
+        if (n > 0) return n;
+        bufferPool.release(out);
+    }
+    out = nullptr;
+    return 0;
+}
+
+// 编码输出按原始大小申请，通常占着大槽；移到能容纳实际字节数的最小槽
+static void shrinkToFit(uint8_t*& buf, size_t bytes) {
+    uint8_t* smaller = bufferPool.acquire(bytes);
+    if (!smaller) return;
+    if (bufferPool.capacity(smaller) >= bufferPool.capacity(buf)) {
+        bufferPool.release(smaller);
+        return;
+    }
+    memcpy(smaller, buf, bytes);
+    bufferPool.release(buf);
+    buf = smaller;
+}
+
+static bool isUploadable(const camera_fb_t* fb) {
+    return fb->format == PIXFORMAT_RGB565 || fb->format == PIXFORMAT_JPEG;
+}
+
+bool MotionUploader::begin() {
+    queue = xQueueCreate(MOTION_UPLOAD_QUEUE_DEPTH, sizeof(Job));
+    if (!queue) return false;
+
+    TaskHandle_t task = nullptr;
+    xTaskCreateUniversal(uploadTaskEntry, "motion_up", 8192, this,
+                         TASK_UPLOAD_PRIORITY, &task, ARDUINO_RUNNING_CORE);
+    return task != nullptr;
+}
+
+size_t MotionUploader::encodeCrop(camera_fb_t* fb, const CropRect& box, uint8_t*& out) {
+    // 传感器 JPEG 无法裁剪，原样上传整帧
+    if (fb->format == PIXFORMAT_JPEG) {
+        out = bufferPool.acquire(fb->len);
+        if (!out) return 0;
+        memcpy(out, fb->buf, fb->len);
+        return fb->len;
+    }
+    if (box.width == (int)fb->width && box.height == (int)fb->height) {
+        return encodeToPool(fb->buf, fb->width, fb->height, MOTION_CROP_JPEG_QUALITY, out);
+    }
+
+    // 把裁剪区域复制成连续的 RGB565 图像再编码
+    size_t rowBytes = (size_t)box.width * 2;
+    uint8_t* pixels = bufferPool.acquire(rowBytes * box.height);
+    if (!pixels) return 0;
+    for (int y = 0; y < box.height; y++) {
+        memcpy(pixels + y * rowBytes, fb->buf + ((size_t)(box.y + y) * fb->width + box.x) * 2, rowBytes);
+    }
+    size_t n = encodeToPool(pixels, box.width, box.height, MOTION_CROP_JPEG_QUALITY, out);
+    bufferPool.release(pixels);
+    return n;
+}
+
+size_t MotionUploader::encodeContext(camera_fb_t* fb, int width, int height, uint8_t*& out) {
+    CropRect full(0, 0, fb->width, fb->height);
+    uint8_t* pixels = bufferPool.acquire((size_t)width * height * 2);
+    uint32_t* scratch = (uint32_t*)bufferPool.acquire(ImageScaler::scratchSize(width));
+    size_t n = 0;
+    if (pixels && scratch) {
+        ImageScaler::scaleRGB565(fb->buf, fb->width, full, pixels, width, height, scratch);
+        n = encodeToPool(pixels, width, height, MOTION_CONTEXT_JPEG_QUALITY, out);
+    }
+    if (pixels) bufferPool.release(pixels);
+    if (scratch) bufferPool.release((uint8_t*)scratch);
+    return n;
+}
+
+bool MotionUploader::encodeJob(camera_fb_t* fb, const CropRect& box, uint8_t score, size_t fullFrameBytes, Job& job) {
+    job = {};
+    job.box = box;
+    job.frameWidth = fb->width;
+    job.frameHeight = fb->height;
+    job.score = score;
+    job.fullFrameBytes = fullFrameBytes;
+    time_t t = time(nullptr);
+    job.timestamp = t > 1600000000 ? (uint32_t)t : 0;
+
+    // 变化区域已占大半画面时，全景图没有意义，直接上传整帧
+    long frameArea = (long)fb->width * fb->height;
+    if ((long)box.width * box.height * 100 > frameArea * MOTION_CROP_FULL_FRAME_PCT ||
+        fb->format == PIXFORMAT_JPEG) {
+        job.box = CropRect(0, 0, fb->width, fb->height);
+    }
+
+    job.cropBytes = encodeCrop(fb, job.box, job.crop);
+    if (job.cropBytes == 0) return false;
+    if (job.box.width < (int)fb->width || job.box.height < (int)fb->height) {
+        int contextWidth = MOTION_CONTEXT_WIDTH;
+        int contextHeight = 0;
+        ImageScaler::fitOutputSize(CropRect(0, 0, fb->width, fb->height), contextWidth, contextHeight);
+        job.contextWidth = contextWidth;
+        job.contextHeight = contextHeight;
+        job.contextBytes = encodeContext(fb, contextWidth, contextHeight, job.context);
+        if (job.contextBytes == 0) return false;
+    }
+    return true;
+}
+
+void MotionUploader::drop() {
+    portENTER_CRITICAL(&statsLock);
+    stats.dropped++;
+    portEXIT_CRITICAL(&statsLock);
+    Logger::warn("UPLOAD", "Motion event dropped");
+}
+
+bool MotionUploader::submit(camera_fb_t* fb, const CropRect& box, uint8_t score, size_t fullFrameBytes) {
+    if (!queue || !isUploadable(fb)) return false;
+
+    portENTER_CRITICAL(&statsLock);
+    stats.events++;
+    portEXIT_CRITICAL(&statsLock);
+
+    Job job = {};
+    bool ok = uxQueueSpacesAvailable(queue) > 0 && encodeJob(fb, box, score, fullFrameBytes, job) &&
+              xQueueSend(queue, &job, 0) == pdTRUE;
+    if (!ok) {
+        releaseJob(job);
+        drop();
+    }
+    return ok;
+}
+
+bool MotionUploader::hold(camera_fb_t* fb, const CropRect& box, uint8_t score, size_t fullFrameBytes,
+                          const BurstSelection* burst) {
+    if (!queue || !isUploadable(fb)) return false;
+
+    // 先释放旧的峰值帧，池中槽位有限
+    releaseJob(held);
+    if (!encodeJob(fb, box, score, fullFrameBytes, held)) {
+        releaseJob(held);
+        return false;
+    }
+    if (burst) {
+        held.hasBurst = true;
+        held.burst = *burst;
+    }
+    // 事件可能持续到 EVENT_MAX_DURATION_MS，期间不占整帧槽
+    shrinkToFit(held.crop, held.cropBytes);
+    if (held.context) shrinkToFit(held.context, held.contextBytes);
+    return true;
+}
+
+bool MotionUploader::submitHeld(const MotionEvent& event, const ClipInfo* clip) {
+    if (!queue || !held.crop) return false;
+
+    portENTER_CRITICAL(&statsLock);
+    stats.events++;
+    portEXIT_CRITICAL(&statsLock);
+
+    held.hasEvent = true;
+    held.truncated = event.truncated;
+    held.peakScore = event.peakScore;
+    held.motionFrames = event.motionFrames;
+    held.durationMs = event.endMs - event.startMs;
+    time_t t = time(nullptr);
+    held.eventStart = t > 1600000000 ? (uint32_t)t - (millis() - event.startMs) / 1000 : 0;
+    if (clip) {
+        held.hasClip = true;
+        held.clip = *clip;
+    }
+
+    bool ok = xQueueSend(queue, &held, 0) == pdTRUE;
+    if (!ok) {
+        releaseJob(held);
+        drop();
+    }
+    // 缓冲区已交给上传任务或已释放
+    held = {};
+    return ok;
+}
+
+void MotionUploader::discardHeld() {
+    releaseJob(held);
+}
+
+void MotionUploader::releaseJob(Job& job) {
+    if (job.crop) bufferPool.release(job.crop);
+    if (job.context) bufferPool.release(job.context);
+    job.crop = nullptr;
+    job.context = nullptr;
+}
+
+MotionUploadStats MotionUploader::getStats() {
+    portENTER_CRITICAL(&statsLock);
+    MotionUploadStats copy = stats;
+    portEXIT_CRITICAL(&statsLock);
+    return copy;
+}
+
+void MotionUploader::uploadTaskEntry(void* parameter) {
+    static_cast<MotionUploader*>(parameter)->uploadLoop();
+}
+
+void MotionUploader::uploadLoop() {
+    Job job;
+    while (true) {
+        if (xQueueReceive(queue, &job, portMAX_DELAY) != pdTRUE) continue;
+
+        int status = WiFi.isConnected() ? upload(job) : HTTPS_ERR_CONNECT;
+        bool ok = status >= 200 && status < 300;
+
+        portENTER_CRITICAL(&statsLock);
+        stats.lastStatus = status;
+        if (ok) {
+            stats.uploaded++;
+            stats.bytesUploaded += job.cropBytes + job.contextBytes;
+            stats.fullFrameBytes += job.fullFrameBytes;
+            if (job.context) stats.croppedEvents++;
+            if (job.hasClip) {
+                stats.clipsUploaded++;
+                stats.clipBytes += job.clip.bytes;
+            }
+        } else {
+            stats.failures++;
+        }
+        portEXIT_CRITICAL(&statsLock);
+
+        if (ok) {
+            Logger::info("UPLOAD", "Motion event uploaded: crop %dx%d %u bytes, context %u bytes",
+                         job.box.width, job.box.height, (unsigned)job.cropBytes, (unsigned)job.contextBytes);
+        } else {
+            Logger::warn("UPLOAD", "Motion event upload failed (%d)", status);
+        }
+        // 上传失败的短片留在本地（/api/clips），由之后的事件按数量轮换
+        if (ok && job.hasClip && clips) clips->remove(job.clip.id);
+        releaseJob(job);
+    }
+}
+
+int MotionUploader::upload(const Job& job) {
+    StaticJsonDocument<768> doc;
+    doc["device_id"] = cloud.getDeviceId();
+    doc["has_motion"] = true;
+    doc["score"] = job.score;
+    doc["timestamp"] = job.timestamp;
+    doc["image_size"] = job.cropBytes;
+    doc["frame_width"] = job.frameWidth;
+    doc["frame_height"] = job.frameHeight;
+    JsonObject crop = doc.createNestedObject("crop");
+    crop["x"] = job.box.x;
+    crop["y"] = job.box.y;
+    crop["width"] = job.box.width;
+    crop["height"] = job.box.height;
+    if (job.context) {
+        JsonObject context = doc.createNestedObject("context");
+        context["width"] = job.contextWidth;
+        context["height"] = job.contextHeight;
+    }
+    if (job.hasEvent) {
+        JsonObject event = doc.createNestedObject("event");
+        event["start"] = job.eventStart;
+        event["duration_ms"] = job.durationMs;
+        event["peak_score"] = job.peakScore;
+        event["motion_frames"] = job.motionFrames;
+        event["truncated"] = job.truncated;
+    }
+    if (job.hasBurst) {
+        JsonObject burst = doc.createNestedObject("burst");
+        burst["frames"] = job.burst.frames;
+        burst["selected"] = job.burst.selected;
+        burst["sharpness"] = job.burst.sharpness;
+        burst["trigger_sharpness"] = job.burst.triggerSharpness;
+        burst["scoring_us"] = job.burst.scoringUs;
+    }
+
+    // 短片打不开时只上传图像
+    File clipFile;
+    if (job.hasClip) clipFile = LittleFS.open(ClipRecorder::clipPath(job.clip.id), "r");
+    if (clipFile) {
+        JsonObject clip = doc.createNestedObject("clip");
+        clip["width"] = job.clip.width;
+        clip["height"] = job.clip.height;
+        clip["frames"] = job.clip.frames;
+        clip["duration_ms"] = job.clip.durationMs;
+        clip["size"] = job.clip.bytes;
+        clip["truncated"] = job.clip.truncated;
+    }
+
+    String metadata;
+    serializeJson(doc, metadata);
+
+    MultipartForm form;
+    size_t contentLength = form.partLength("metadata", nullptr, "application/json", metadata.length()) +
+                           form.partLength("original", "crop.jpg", "image/jpeg", job.cropBytes) +
+                           form.closingLength();
+    if (job.context) {
+        contentLength += form.partLength("thumbnail", "context.jpg", "image/jpeg", job.contextBytes);
+    }
+    size_t clipBytes = clipFile ? clipFile.size() : 0;
+    if (clipFile) {
+        contentLength += form.partLength("clip", "clip.avi", "video/x-msvideo", clipBytes);
+    }
+
+    int status = cloud.post(UPLOAD_PATH, form.getContentType(), contentLength, [&](const HttpsWriteFn& write) {
+        if (!form.writePart(write, "metadata", nullptr, "application/json",
+                            (const uint8_t*)metadata.c_str(), metadata.length()) ||
+            !form.writePart(write, "original", "crop.jpg", "image/jpeg", job.crop, job.cropBytes) ||
+            (job.context &&
+             !form.writePart(write, "thumbnail", "context.jpg", "image/jpeg", job.context, job.contextBytes))) {
+            return false;
+        }
+
+        if (clipFile) {
+            if (!form.writePartHeader(write, "clip", "clip.avi", "video/x-msvideo")) return false;
+            uint8_t chunk[1024];
+            size_t remaining = clipBytes;
+            clipFile.seek(0);
+            while (remaining > 0) {
+                size_t n = clipFile.read(chunk, min(remaining, sizeof(chunk)));
+                if (n == 0 || !write(chunk, n)) return false;
+                remaining -= n;
+            }
+            if (!form.writePartEnd(write)) return false;
+        }
+        return form.writeClosing(write);
+    });
+
+    if (clipFile) clipFile.close();
+    return status;
+}
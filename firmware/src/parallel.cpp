@@ -0,0 +1,112 @@
+#include "parallel.h"
+#include "logger.h"
+
+ParallelRunner parallelRunner;
+
+bool ParallelRunner::begin(BaseType_t helperCore) {
+    if (helper) return true;
+
+    done = xSemaphoreCreateBinary();
+    if (!done) return false;
+    xTaskCreatePinnedToCore(helperEntry, "analysis", 4096, this, TASK_ANALYSIS_PRIORITY, &helper, helperCore);
+    if (!helper) {
+        Logger::warn("PARALLEL", "Helper task creation failed, analysis stays on one core");
+        return false;
+    }
+    return true;
+}
+
+void ParallelRunner::run(ParallelFn fn, void* arg, int count, int grain) {
+    if (count <= 0) return;
+    if (grain < 1) grain = 1;
+
+    // 不够分成两组时唤醒辅助任务得不偿失
+    if (!helper || !enabled || count <= grain) {
+        fn(arg, 0, 0, count);
+        portENTER_CRITICAL(&statsLock);
+        stats.inlineRuns++;
+        portEXIT_CRITICAL(&statsLock);
+        return;
+    }
+
+    this->fn = fn;
+    this->arg = arg;
+    this->count = count;
+    this->grain = grain;
+    portENTER_CRITICAL(&claimLock);
+    next = 0;
+    open = true;
+    joined = false;
+    portEXIT_CRITICAL(&claimLock);
+    xTaskNotifyGive(helper);
+
+    work(0);
+
+    // 关闭本次任务；辅助任务还没加入（core 0 被 WiFi 等更高优先级任务占用）时
+    // 条目已全部由调用者做完，不等它，它醒来后看到已关闭会直接跳过
+    portENTER_CRITICAL(&claimLock);
+    open = false;
+    bool helperJoined = joined;
+    portEXIT_CRITICAL(&claimLock);
+    if (helperJoined) xSemaphoreTake(done, portMAX_DELAY);
+
+    portENTER_CRITICAL(&statsLock);
+    if (helperJoined) {
+        stats.runs++;
+        stats.helperItems += helperItems;
+    } else {
+        stats.soloRuns++;
+    }
+    stats.items += count;
+    portEXIT_CRITICAL(&statsLock);
+}
+
+// 领取并执行，直到没有剩余条目
+// @return 本 worker 处理的条目数
+int ParallelRunner::work(uint8_t worker) {
+    int items = 0;
+    while (true) {
+        portENTER_CRITICAL(&claimLock);
+        int begin = next;
+        next += grain;
+        portEXIT_CRITICAL(&claimLock);
+        if (begin >= count) break;
+
+        int end = min(begin + grain, count);
+        fn(arg, worker, begin, end);
+        items += end - begin;
+    }
+    return items;
+}
+
+void ParallelRunner::helperEntry(void* parameter) {
+    static_cast<ParallelRunner*>(parameter)->helperLoop();
+}
+
+void ParallelRunner::helperLoop() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // 只加入仍在进行的任务，加入后调用者才会等待 done
+        portENTER_CRITICAL(&claimLock);
+        bool join = open;
+        if (join) joined = true;
+        portEXIT_CRITICAL(&claimLock);
+        if (!join) continue;
+
+        helperItems = work(1);
+        xSemaphoreGive(done);
+    }
+}
+
+void ParallelRunner::setEnabled(bool value) {
+    enabled = value;
+}
+
+ParallelStats ParallelRunner::getStats() {
+    portENTER_CRITICAL(&statsLock);
+    ParallelStats copy = stats;
+    copy.enabled = enabled;
+    portEXIT_CRITICAL(&statsLock);
+    return copy;
+}
@@ -0,0 +1,116 @@
+#include "power_manager.h"
+#include "config.h"
+#include "logger.h"
+
+void PowerManager::begin() {
+    lastActivity = millis();
+    stateSince = lastActivity;
+    state = POWER_ACTIVE;
+}
+
+unsigned long PowerManager::getFrameIntervalMs() const {
+    // 唤醒过程中全速采集，尽快排空低分辨率帧
+    if (state == POWER_IDLE && !waking) {
+        return POWER_IDLE_DETECT_INTERVAL_MS;
+    }
+    return 1000 / STREAM_FPS;
+}
+
+bool PowerManager::onFrame(camera_fb_t* fb, bool motion) {
+    unsigned long now = millis();
+    bool activity = motion || activityPending;
+    activityPending = false;
+
+    // 空闲时只记录新分辨率，唤醒时切换
+    if (frameSizeChanged) {
+        frameSizeChanged = false;
+        if (state == POWER_ACTIVE || waking) {
+            camera.requestFrameSize(activeFrameSize);
+        }
+    }
+
+    if (waking) {
+        // 切换请求由采集任务在下一帧前执行，之前的帧仍是小分辨率
+        if (fb->width != resolution[activeFrameSize].width ||
+            fb->height != resolution[activeFrameSize].height) {
+            return false;
+        }
+
+        waking = false;
+        lastWakeMs = now - wakeStart;
+        lastWakeFrames = camera.getSwitchStats().lastFrames;
+        if (lastWakeMs > maxWakeMs) maxWakeMs = lastWakeMs;
+        if (lastWakeFrames > maxWakeFrames) maxWakeFrames = lastWakeFrames;
+        setState(POWER_ACTIVE);
+        lastActivity = now;
+        Logger::info("POWER", "Active in %lu ms (%u frames)", lastWakeMs, lastWakeFrames);
+        return true;
+    }
+
+    if (activity) {
+        lastActivity = now;
+        if (state == POWER_IDLE) {
+            wake();
+            return true;
+        }
+    }
+
+    if (state == POWER_ACTIVE && idleEnabled &&
+        now - lastActivity > POWER_IDLE_ENTER_AFTER_MS) {
+        enterIdle();
+    }
+    return true;
+}
+
+void PowerManager::setIdleEnabled(bool enabled) {
+    idleEnabled = enabled;
+    if (!enabled) {
+        notifyActivity();
+    }
+}
+
+bool PowerManager::setActiveFrameSize(framesize_t size) {
+    if (!Camera::isSupportedFrameSize(size)) return false;
+    activeFrameSize = size;
+    frameSizeChanged = true;
+    return true;
+}
+
+PowerStats PowerManager::getStats() const {
+    PowerStats stats;
+    stats.state = state;
+    for (int i = 0; i < POWER_STATE_COUNT; i++) {
+        stats.residencyMs[i] = residencyMs[i];
+    }
+    stats.residencyMs[state] += millis() - stateSince;
+    stats.wakeCount = wakeCount;
+    stats.lastWakeMs = lastWakeMs;
+    stats.maxWakeMs = maxWakeMs;
+    stats.lastWakeFrames = lastWakeFrames;
+    stats.maxWakeFrames = maxWakeFrames;
+    return stats;
+}
+
+void PowerManager::enterIdle() {
+    Logger::info("POWER", "No activity for %d s, entering idle", POWER_IDLE_ENTER_AFTER_MS / 1000);
+    // 采集任务切换后会重建运动检测基准，避免切换本身被判定为运动
+    camera.requestFrameSize(POWER_IDLE_FRAME_SIZE);
+    wifiManager.setPowerSave(true);
+    setState(POWER_IDLE);
+}
+
+void PowerManager::wake() {
+    Logger::info("POWER", "Activity detected, waking");
+    wifiManager.setPowerSave(false);
+    camera.requestFrameSize(activeFrameSize);
+    waking = true;
+    wakeStart = millis();
+    wakeCount++;
+}
+
+void PowerManager::setState(PowerState next) {
+    unsigned long now = millis();
+    residencyMs[state] += now - stateSince;
+    stateSince = now;
+    state = next;
+}
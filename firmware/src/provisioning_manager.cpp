@@ -5,6 +5,8 @@
 bool ProvisioningManager::begin() {
     Logger::info("PROV", "Provisioning manager starting...");
 
+    scheduler.on(EVENT_WIFI_CONNECTED, [this]() { onWiFiConnected(); });
+
     if (!storage->init()) {
         Logger::error("PROV", "Storage init failed, going to AP mode");
         enterAPMode();
@@ -25,30 +27,40 @@ bool ProvisioningManager::begin() {
     }
 }
 
-void ProvisioningManager::update() {
-    captivePortal.update();
+// 连接成功事件：立即完成状态切换，不等待下一次轮询
+void ProvisioningManager::onWiFiConnected() {
+    switch (state) {
+        case STA_CONNECTING:
+            scheduler.cancel(timeoutTimer);
+            state = STA_CONNECTED;
+            Logger::info("PROV", "STA connected successfully");
+            break;
+
+        case AP_SWITCHING:
+            scheduler.cancel(timeoutTimer);
+            state = STA_CONNECTED;
+            captivePortal.stop();
+            WiFi.mode(WIFI_STA);
+            Logger::info("PROV", "Switched to STA mode successfully");
+            break;
+
+        default:
+            break;
+    }
+}
+
+void ProvisioningManager::onTimeout() {
+    timeoutTimer = INVALID_TIMER;
 
     switch (state) {
         case STA_CONNECTING:
-            if (wifiManager.isConnected()) {
-                state = STA_CONNECTED;
-                Logger::info("PROV", "STA connected successfully");
-            } else if (millis() - stateStartTime > STA_TIMEOUT_MS) {
-                Logger::warn("PROV", "STA connection timeout, entering AP mode");
-                enterAPMode();
-            }
+            Logger::warn("PROV", "STA connection timeout, entering AP mode");
+            enterAPMode();
             break;
 
         case AP_SWITCHING:
-            if (wifiManager.isConnected()) {
-                state = STA_CONNECTED;
-                captivePortal.stop();
-                WiFi.mode(WIFI_STA);
-                Logger::info("PROV", "Switched to STA mode successfully");
-            } else if (millis() - stateStartTime > SWITCHING_TIMEOUT_MS) {
-                Logger::error("PROV", "Switching timeout, staying in AP mode");
-                state = AP_PROVISIONING;
-            }
+            Logger::error("PROV", "Switching timeout, staying in AP mode");
+            state = AP_PROVISIONING;
             break;
 
         default:
@@ -56,6 +68,15 @@ void ProvisioningManager::update() {
     }
 }
 
+void ProvisioningManager::enterState(ProvisioningState next, unsigned long timeoutMs) {
+    scheduler.cancel(timeoutTimer);
+    state = next;
+    stateStartTime = millis();
+    if (timeoutMs > 0) {
+        timeoutTimer = scheduler.schedule(timeoutMs, [this]() { onTimeout(); });
+    }
+}
+
 bool ProvisioningManager::saveAndConnect(const char* ssid, const char* password) {
     Logger::info("PROV", "Saving config for SSID: %s", ssid);
 
@@ -71,8 +92,7 @@ bool ProvisioningManager::saveAndConnect(const char* ssid, const char* password)
     }
 
     Logger::info("PROV", "Config saved, switching to STA mode...");
-    state = AP_SWITCHING;
-    stateStartTime = millis();
+    enterState(AP_SWITCHING, SWITCHING_TIMEOUT_MS);
 
     WiFi.begin(ssid, password);
     return true;
@@ -90,7 +110,7 @@ bool ProvisioningManager::resetConfig() {
 }
 
 void ProvisioningManager::enterAPMode() {
-    state = AP_PROVISIONING;
+    enterState(AP_PROVISIONING, 0);
 
     // 使用 MAC 后 6 位作为 SSID 后缀
     String mac = WiFi.macAddress();
@@ -117,10 +137,11 @@ bool ProvisioningManager::tryConnectSaved() {
         return true;
     }
 
-    state = STA_CONNECTING;
-    stateStartTime = millis();
+    enterState(STA_CONNECTING, STA_TIMEOUT_MS);
 
-    if (!wifiManager.begin(config.ssid, config.password)) {
+    if (wifiManager.begin(config.ssid, config.password)) {
+        onWiFiConnected();
+    } else {
         Logger::warn("PROV", "STA connection failed");
         enterAPMode();
     }
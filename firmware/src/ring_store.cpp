@@ -0,0 +1,208 @@
+#include "ring_store.h"
+#include "logger.h"
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+    // 按半字节查表，表只占 64 字节
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+size_t RingStore::recordBytes(size_t length) {
+    return (ALIGN + length + ALIGN - 1) / ALIGN * ALIGN;
+}
+
+uint32_t RingStore::headerCrc(const RingRecordHeader& header) {
+    return crc32Update(0, (const uint8_t*)&header, offsetof(RingRecordHeader, headerCrc));
+}
+
+size_t RingStore::maxRecordBytes() const {
+    return size / 4 - ALIGN;
+}
+
+bool RingStore::begin(const char* label, esp_partition_subtype_t subtype, const RecordFn& onRecord) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, subtype, label);
+    if (!partition) {
+        Logger::error("RING", "Partition %s not found", label);
+        return false;
+    }
+    if (partition->size % SPI_FLASH_SEC_SIZE || partition->size < 4 * SPI_FLASH_SEC_SIZE) {
+        Logger::error("RING", "Partition %s has unusable size %u", label, (unsigned)partition->size);
+        return false;
+    }
+
+    const void* mapped = nullptr;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &mapHandle);
+    if (err != ESP_OK) {
+        Logger::error("RING", "Failed to map %s (%d)", label, err);
+        return false;
+    }
+    lock = xSemaphoreCreateMutex();
+    writeLock = xSemaphoreCreateMutex();
+    if (!lock || !writeLock) return false;
+    base = (const uint8_t*)mapped;
+    size = partition->size;
+
+    // 扫描整个分区：完好的记录整条跳过，否则按对齐单位前进
+    // （头部完好而后半段所在扇区已被擦除重写时，较新的记录位于它的范围内）
+    struct Found {
+        uint64_t offset;
+        uint32_t position;
+    };
+    std::vector<Found> found;
+    for (uint32_t pos = 0; pos + ALIGN <= size;) {
+        const RingRecordHeader* h = (const RingRecordHeader*)(base + pos);
+        if (h->magic != MAGIC || h->length == 0 || h->length > maxRecordBytes() ||
+            pos + recordBytes(h->length) > size || h->offset % size != pos || headerCrc(*h) != h->headerCrc) {
+            pos += ALIGN;
+            continue;
+        }
+        if (crc32Update(0, base + pos + ALIGN, h->length) != h->dataCrc) {
+            stats.corruptRecords++;
+            pos += ALIGN;
+            continue;
+        }
+        found.push_back({h->offset, pos});
+        pos += recordBytes(h->length);
+    }
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.offset < b.offset; });
+
+    // 最新记录所在扇区的剩余部分可能有掉电时写了一半的数据，从下一个扇区开始写
+    if (!found.empty()) {
+        const Found& last = found.back();
+        head = last.offset + recordBytes(((const RingRecordHeader*)(base + last.position))->length);
+        head = (head + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE * SPI_FLASH_SEC_SIZE;
+    }
+    erasedUpTo = head;
+
+    // 更早几圈的记录可能因跨圈跳过的扇区残留下来，只保留最近一个分区大小以内的
+    uint64_t oldest = tail();
+    size_t kept = 0;
+    for (const Found& f : found) {
+        if (f.offset < oldest) continue;
+        onRecord((uint32_t)f.offset, *(const RingRecordHeader*)(base + f.position));
+        kept++;
+    }
+
+    Logger::info("RING", "%s: %u records, lap %u at 0x%x, %u corrupt", label, (unsigned)kept,
+                 (unsigned)(head / size), (unsigned)(head % size), (unsigned)stats.corruptRecords);
+    return true;
+}
+
+bool RingStore::eraseNextSector() {
+    uint64_t sector = erasedUpTo;
+    // 先让扇区中的旧记录失效再擦除：已通过检查的读取持锁拷贝完才会走到这里
+    xSemaphoreTake(lock, portMAX_DELAY);
+    erasedUpTo += SPI_FLASH_SEC_SIZE;
+    stats.sectorErases++;
+    xSemaphoreGive(lock);
+
+    esp_err_t err = esp_partition_erase_range(partition, sector % size, SPI_FLASH_SEC_SIZE);
+    if (err != ESP_OK) {
+        Logger::error("RING", "Erase at 0x%x failed (%d)", (unsigned)(sector % size), err);
+        return false;
+    }
+    return true;
+}
+
+bool RingStore::append(uint32_t timestamp, uint16_t tag, const uint8_t* data, size_t length, uint32_t& id) {
+    if (!base || length == 0 || length > maxRecordBytes()) return false;
+    size_t bytes = recordBytes(length);
+
+    xSemaphoreTake(writeLock, portMAX_DELAY);
+
+    // 放不下时从下一圈开头写，分区末尾的剩余部分随顺序擦除照常回收
+    uint64_t offset = head;
+    uint32_t position = offset % size;
+    if (position + bytes > size) {
+        offset += size - position;
+        position = 0;
+    }
+
+    bool ok = true;
+    while (ok && erasedUpTo < offset + bytes) {
+        ok = eraseNextSector();
+    }
+
+    RingRecordHeader header;
+    header.magic = MAGIC;
+    header.length = length;
+    header.offset = offset;
+    header.timestamp = timestamp;
+    header.tag = tag;
+    header.flags = 0;
+    header.dataCrc = crc32Update(0, data, length);
+    header.headerCrc = headerCrc(header);
+
+    // 先写数据后写头：头完好即说明数据已完整写入
+    ok = ok && esp_partition_write(partition, position + ALIGN, data, length) == ESP_OK &&
+         esp_partition_write(partition, position, &header, sizeof(header)) == ESP_OK;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    // 失败时越过已擦除的整段，下一条记录不会写到可能写了一半的位置上
+    head = ok ? offset + bytes : erasedUpTo;
+    if (!ok) stats.failedWrites++;
+    xSemaphoreGive(lock);
+    xSemaphoreGive(writeLock);
+
+    if (!ok) {
+        Logger::error("RING", "Failed to append %u bytes", (unsigned)length);
+        return false;
+    }
+    id = (uint32_t)offset;
+    return true;
+}
+
+// 调用者持有 lock；逻辑偏移从回收边界起算，ID 回绕后仍能还原
+bool RingStore::locate(uint32_t id, uint64_t& offset) const {
+    uint64_t oldest = tail();
+    offset = oldest + (uint32_t)(id - (uint32_t)oldest);
+    return offset < head;
+}
+
+bool RingStore::isLive(uint32_t id) {
+    if (!base) return false;
+    uint64_t offset;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool live = locate(id, offset);
+    xSemaphoreGive(lock);
+    return live;
+}
+
+size_t RingStore::read(uint32_t id, size_t pos, uint8_t* buffer, size_t len) {
+    if (!base) return 0;
+    size_t n = 0;
+    uint64_t offset;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (locate(id, offset)) {
+        const uint8_t* record = base + offset % size;
+        const RingRecordHeader* header = (const RingRecordHeader*)record;
+        if (header->magic == MAGIC && header->offset == offset && pos < header->length) {
+            n = min(len, (size_t)header->length - pos);
+            memcpy(buffer, record + ALIGN + pos, n);
+        }
+    }
+    xSemaphoreGive(lock);
+    return n;
+}
+
+RingStoreStats RingStore::getStats() {
+    if (!lock) return RingStoreStats();
+    xSemaphoreTake(lock, portMAX_DELAY);
+    RingStoreStats copy = stats;
+    copy.capacity = size;
+    copy.bytesUsed = (uint32_t)(head - tail());
+    copy.wearLaps = (uint32_t)(erasedUpTo / size);
+    xSemaphoreGive(lock);
+    return copy;
+}
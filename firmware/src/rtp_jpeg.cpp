@@ -0,0 +1,168 @@
+#include "rtp_jpeg.h"
+#include "jpeg_tables.h"
+
+static uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+// 检查一个 DHT 段内的所有表都是标准表
+static bool isStandardHuffman(const uint8_t* p, size_t len) {
+    while (len >= 17) {
+        uint8_t cls = p[0] >> 4;
+        uint8_t id = p[0] & 0x0f;
+        if (cls > 1 || id > 1) return false;
+
+        const uint8_t* bits = cls == 0 ? (id == 0 ? JPEG_DC_LUMA_BITS : JPEG_DC_CHROMA_BITS)
+                                       : (id == 0 ? JPEG_AC_LUMA_BITS : JPEG_AC_CHROMA_BITS);
+        const uint8_t* values = cls == 0 ? JPEG_DC_VALUES
+                                         : (id == 0 ? JPEG_AC_LUMA_VALUES : JPEG_AC_CHROMA_VALUES);
+        size_t count = 0;
+        for (int i = 0; i < 16; i++) count += p[1 + i];
+        if (len < 17 + count) return false;
+        if (memcmp(p + 1, bits, 16) != 0 || memcmp(p + 17, values, count) != 0) return false;
+
+        p += 17 + count;
+        len -= 17 + count;
+    }
+    return len == 0;
+}
+
+bool RtpJpeg::parse(const uint8_t* jpeg, size_t len, RtpJpegFrame& frame) {
+    frame = {};
+    if (len < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) return false;
+
+    bool haveFrame = false;
+    size_t pos = 2;
+    while (pos + 4 <= len) {
+        if (jpeg[pos] != 0xFF) return false;
+        uint8_t marker = jpeg[pos + 1];
+        if (marker == 0xFF) {  // 填充字节
+            pos++;
+            continue;
+        }
+        size_t segLen = readU16(jpeg + pos + 2);
+        const uint8_t* seg = jpeg + pos + 4;
+        if (segLen < 2 || pos + 2 + segLen > len) return false;
+        size_t bodyLen = segLen - 2;
+
+        switch (marker) {
+        case 0xDB:  // DQT，可能一段包含多张表
+            for (size_t i = 0; i < bodyLen; i += 65) {
+                uint8_t precision = seg[i] >> 4;
+                uint8_t id = seg[i] & 0x0f;
+                if (precision != 0 || id > 1 || i + 65 > bodyLen) return false;
+                frame.tables[id] = seg + i + 1;
+            }
+            break;
+        case 0xC4:  // DHT
+            if (!isStandardHuffman(seg, bodyLen)) return false;
+            break;
+        case 0xC0: {  // 基线 SOF：YCbCr 三分量，色度 1x1，亮度 2x1（4:2:2）或 2x2（4:2:0）
+            if (bodyLen < 15 || seg[0] != 8 || seg[5] != 3) return false;
+            frame.height = readU16(seg + 1);
+            frame.width = readU16(seg + 3);
+            uint8_t luma = seg[7];
+            if (seg[8] != 0 || seg[10] != 0x11 || seg[11] != 1 || seg[13] != 0x11 || seg[14] != 1) {
+                return false;
+            }
+            if (luma == 0x21) frame.type = 0;
+            else if (luma == 0x22) frame.type = 1;
+            else return false;
+            haveFrame = true;
+            break;
+        }
+        case 0xDD:  // DRI
+            if (bodyLen < 2) return false;
+            frame.restartInterval = readU16(seg);
+            break;
+        case 0xDA: {  // SOS：之后到 EOI 为熵编码数据
+            size_t start = pos + 2 + segLen;
+            size_t end = len;
+            while (end >= start + 2 && !(jpeg[end - 2] == 0xFF && jpeg[end - 1] == 0xD9)) end--;
+            if (end < start + 2 || !haveFrame || !frame.tables[0] || !frame.tables[1]) return false;
+            // 负载头中宽高以 8 像素为单位，最大 2040
+            if (frame.width % 8 || frame.height % 8 || frame.width > 2040 || frame.height > 2040) {
+                return false;
+            }
+            if (frame.restartInterval) frame.type += 64;
+            frame.scan = jpeg + start;
+            frame.scanBytes = end - 2 - start;
+            return true;
+        }
+        default:
+            // 渐进式等其他编码方式无法用 RFC 2435 传输
+            if (marker >= 0xC1 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                return false;
+            }
+            break;
+        }
+        pos += 2 + segLen;
+    }
+    return false;
+}
+
+int RtpJpeg::packetize(const RtpJpegFrame& frame, uint32_t timestamp, RtpStream& stream,
+                       size_t maxPacket, uint8_t* buffer, RtpPacketSink sink, void* arg) {
+    uint8_t* packet = buffer + RTP_INTERLEAVED_PREFIX;
+    size_t offset = 0;
+    int packets = 0;
+
+    do {
+        // RTP 头
+        uint8_t* p = packet;
+        p[0] = 0x80;
+        p[1] = PAYLOAD_TYPE;
+        p[2] = stream.seq >> 8;
+        p[3] = stream.seq & 0xff;
+        p[4] = timestamp >> 24;
+        p[5] = timestamp >> 16;
+        p[6] = timestamp >> 8;
+        p[7] = timestamp;
+        p[8] = stream.ssrc >> 24;
+        p[9] = stream.ssrc >> 16;
+        p[10] = stream.ssrc >> 8;
+        p[11] = stream.ssrc;
+        p += RTP_HEADER_SIZE;
+
+        // JPEG 负载头：片偏移、类型、Q=255（量化表随帧发送）、宽高
+        *p++ = 0;
+        *p++ = offset >> 16;
+        *p++ = offset >> 8;
+        *p++ = offset;
+        *p++ = frame.type;
+        *p++ = 255;
+        *p++ = frame.width / 8;
+        *p++ = frame.height / 8;
+
+        if (frame.restartInterval) {
+            // 不按重启间隔对齐分片：F=L=1，计数 0x3FFF
+            *p++ = frame.restartInterval >> 8;
+            *p++ = frame.restartInterval & 0xff;
+            *p++ = 0xff;
+            *p++ = 0xff;
+        }
+
+        // 量化表只放在首包
+        if (offset == 0) {
+            *p++ = 0;
+            *p++ = 0;
+            *p++ = 0;
+            *p++ = 128;
+            memcpy(p, frame.tables[0], 64);
+            memcpy(p + 64, frame.tables[1], 64);
+            p += 128;
+        }
+
+        size_t room = maxPacket - (p - packet);
+        size_t chunk = min(room, frame.scanBytes - offset);
+        memcpy(p, frame.scan + offset, chunk);
+        offset += chunk;
+        if (offset == frame.scanBytes) packet[1] |= 0x80;  // marker：帧的最后一包
+
+        if (!sink(packet, p - packet + chunk, arg)) return -1;
+        stream.seq++;
+        packets++;
+    } while (offset < frame.scanBytes);
+
+    return packets;
+}
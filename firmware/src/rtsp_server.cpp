@@ -0,0 +1,512 @@
+#include "rtsp_server.h"
+#include "logger.h"
+#include "bandwidth_arbiter.h"
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// 发送一帧时传给分包回调的上下文
+struct RtpSendContext {
+    RtspServer* server;
+    int sock;
+    bool interleaved;
+    uint8_t channel;
+    const sockaddr_in* addr;
+    int udpSock;
+    uint32_t bytes;
+};
+
+static const char* statusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 454: return "Session Not Found";
+    case 455: return "Method Not Valid in This State";
+    case 461: return "Unsupported Transport";
+    case 501: return "Not Implemented";
+    default: return "Error";
+    }
+}
+
+// 取请求头的值（不区分大小写，去掉前导空格）
+// @return 没有该头时返回 false
+static bool headerValue(const char* request, const char* name, char* out, size_t outSize) {
+    size_t nameLen = strlen(name);
+    const char* line = strstr(request, "\r\n");
+    while (line) {
+        line += 2;
+        if (strncasecmp(line, name, nameLen) == 0 && line[nameLen] == ':') {
+            const char* v = line + nameLen + 1;
+            while (*v == ' ') v++;
+            const char* end = strstr(v, "\r\n");
+            size_t n = end ? (size_t)(end - v) : strlen(v);
+            n = min(n, outSize - 1);
+            memcpy(out, v, n);
+            out[n] = '\0';
+            return true;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return false;
+}
+
+uint32_t RtspServer::randomId() {
+    return ((uint32_t)rand() << 16) ^ (uint32_t)rand() ^ micros();
+}
+
+bool RtspServer::begin(uint16_t port, uint16_t udpPort) {
+    listenSock = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSock < 0) return false;
+
+    int yes = 1;
+    setsockopt(listenSock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(listenSock, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenSock, 2) < 0) {
+        Logger::error("RTSP", "Cannot listen on port %u (errno %d)", port, errno);
+        ::close(listenSock);
+        listenSock = -1;
+        return false;
+    }
+
+    // UDP 传输的 RTP 都从同一个端口发出
+    rtpSock = socket(AF_INET, SOCK_DGRAM, 0);
+    addr.sin_port = htons(udpPort);
+    if (rtpSock < 0 || bind(rtpSock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        Logger::warn("RTSP", "Cannot bind RTP port %u, UDP transport disabled", udpPort);
+        if (rtpSock >= 0) ::close(rtpSock);
+        rtpSock = -1;
+    }
+    rtpPort = udpPort;
+
+    // SETUP 应答中的 server_port 包含 RTCP 端口，须实际绑定，否则客户端的接收报告会收到 ICMP 端口不可达
+    if (rtpSock >= 0) {
+        rtcpSock = socket(AF_INET, SOCK_DGRAM, 0);
+        addr.sin_port = htons(udpPort + 1);
+        if (rtcpSock < 0 || bind(rtcpSock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            Logger::warn("RTSP", "Cannot bind RTCP port %u, advertising RTP port only", udpPort + 1);
+            if (rtcpSock >= 0) ::close(rtcpSock);
+            rtcpSock = -1;
+        }
+    }
+
+    Logger::info("RTSP", "Listening on port %u", port);
+    return true;
+}
+
+void RtspServer::poll(uint32_t timeoutMs) {
+    if (listenSock < 0) return;
+
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(listenSock, &readSet);
+    int maxFd = listenSock;
+    // 客户端发到 RTP/RTCP 端口的数据（接收报告、NAT 打洞包）读出丢弃，不占 lwIP 接收缓冲
+    for (int sock : {rtpSock, rtcpSock}) {
+        if (sock < 0) continue;
+        FD_SET(sock, &readSet);
+        maxFd = max(maxFd, sock);
+    }
+    for (Session& s : sessions) {
+        if (s.sock < 0) continue;
+        FD_SET(s.sock, &readSet);
+        maxFd = max(maxFd, s.sock);
+    }
+
+    timeval tv = {(time_t)(timeoutMs / 1000), (suseconds_t)(timeoutMs % 1000) * 1000};
+    if (select(maxFd + 1, &readSet, nullptr, nullptr, &tv) > 0) {
+        if (FD_ISSET(listenSock, &readSet)) acceptClient();
+        for (int sock : {rtpSock, rtcpSock}) {
+            if (sock >= 0 && FD_ISSET(sock, &readSet)) drainUdp(sock);
+        }
+        for (Session& s : sessions) {
+            if (s.sock >= 0 && FD_ISSET(s.sock, &readSet)) receive(s);
+        }
+    }
+
+    portENTER_CRITICAL(&lock);
+    uint8_t* frame = pendingFrame;
+    size_t bytes = pendingBytes;
+    uint32_t timestamp = pendingTimestamp;
+    pendingFrame = nullptr;
+    portEXIT_CRITICAL(&lock);
+
+    if (frame) {
+        sendFrame(frame, bytes, timestamp);
+        releaseFrame(frame);
+    }
+}
+
+void RtspServer::drainUdp(int sock) {
+    uint8_t discard[64];
+    while (recv(sock, discard, sizeof(discard), MSG_DONTWAIT) >= 0) {
+    }
+}
+
+bool RtspServer::wantsFrame(uint32_t nowMs) const {
+    return playingCount > 0 && nowMs - lastSubmitMs >= RTSP_FRAME_INTERVAL_MS;
+}
+
+void RtspServer::submitFrame(uint8_t* jpeg, size_t len, uint32_t nowMs) {
+    portENTER_CRITICAL(&lock);
+    uint8_t* dropped = pendingFrame;
+    pendingFrame = jpeg;
+    pendingBytes = len;
+    pendingTimestamp = nowMs * (RtpJpeg::CLOCK_RATE / 1000);
+    lastSubmitMs = nowMs;
+    stats.framesSubmitted++;
+    if (dropped) stats.framesDropped++;
+    portEXIT_CRITICAL(&lock);
+
+    if (dropped) releaseFrame(dropped);
+}
+
+RtspStats RtspServer::getStats() {
+    portENTER_CRITICAL(&lock);
+    RtspStats copy = stats;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
+
+void RtspServer::acceptClient() {
+    sockaddr_in addr = {};
+    socklen_t addrLen = sizeof(addr);
+    int sock = ::accept(listenSock, (sockaddr*)&addr, &addrLen);
+    if (sock < 0) return;
+
+    Session* slot = nullptr;
+    for (Session& s : sessions) {
+        if (s.sock < 0) {
+            slot = &s;
+            break;
+        }
+    }
+    if (!slot) {
+        Logger::warn("RTSP", "Rejecting %s: %d sessions active", inet_ntoa(addr.sin_addr), RTSP_MAX_SESSIONS);
+        ::close(sock);
+        portENTER_CRITICAL(&lock);
+        stats.rejected++;
+        portEXIT_CRITICAL(&lock);
+        return;
+    }
+
+    // 交织传输时 RTP 包逐个写入，关闭 Nagle；客户端不读时发送超时后断开
+    int yes = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    timeval timeout = {RTSP_SEND_TIMEOUT_MS / 1000, (RTSP_SEND_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    slot->sock = sock;
+    slot->playing = false;
+    slot->ready = false;
+    slot->interleaved = false;
+    slot->buffered = 0;
+    slot->skip = 0;
+    slot->id = randomId();
+
+    portENTER_CRITICAL(&lock);
+    stats.connections++;
+    portEXIT_CRITICAL(&lock);
+    updatePlaying();
+    Logger::info("RTSP", "Client %s connected", inet_ntoa(addr.sin_addr));
+}
+
+void RtspServer::receive(Session& s) {
+    int n = recv(s.sock, s.request + s.buffered, sizeof(s.request) - 1 - s.buffered, 0);
+    if (n <= 0) {
+        closeSession(s);
+        return;
+    }
+    s.buffered += n;
+
+    auto consume = [&s](size_t bytes) {
+        memmove(s.request, s.request + bytes, s.buffered - bytes);
+        s.buffered -= bytes;
+    };
+
+    while (s.buffered > 0) {
+        // 客户端在 RTSP 连接内发来的交织数据（RTCP 接收报告）直接丢弃
+        if (s.skip > 0) {
+            size_t bytes = min(s.skip, s.buffered);
+            consume(bytes);
+            s.skip -= bytes;
+            continue;
+        }
+        if (s.request[0] == '$') {
+            if (s.buffered < 4) break;
+            s.skip = 4 + ((uint8_t)s.request[2] << 8 | (uint8_t)s.request[3]);
+            continue;
+        }
+
+        s.request[s.buffered] = '\0';
+        char* end = strstr(s.request, "\r\n\r\n");
+        if (!end) {
+            if (s.buffered == sizeof(s.request) - 1) {
+                Logger::warn("RTSP", "Request too large, closing");
+                closeSession(s);
+            }
+            return;
+        }
+
+        size_t headerBytes = end + 4 - s.request;
+        end[2] = '\0';  // 只保留本条请求头（最后一行的 CRLF 仍在）
+        char value[16];
+        size_t bodyBytes = headerValue(s.request, "Content-Length", value, sizeof(value)) ? atoi(value) : 0;
+        if (headerBytes + bodyBytes > sizeof(s.request) - 1) {
+            closeSession(s);
+            return;
+        }
+        if (s.buffered < headerBytes + bodyBytes) {
+            end[2] = '\r';
+            return;
+        }
+
+        if (!handleRequest(s, s.request)) {
+            closeSession(s);
+            return;
+        }
+        if (s.sock < 0) return;  // 回复失败已断开
+        consume(headerBytes + bodyBytes);
+    }
+}
+
+bool RtspServer::handleRequest(Session& s, const char* request) {
+    char method[16], url[128];
+    if (sscanf(request, "%15s %127s", method, url) != 2) return false;
+
+    char cseq[16] = "0";
+    headerValue(request, "CSeq", cseq, sizeof(cseq));
+
+    char headers[256];
+    char session[16];
+    bool hasSession = headerValue(request, "Session", session, sizeof(session));
+    snprintf(headers, sizeof(headers), "Session: %08X\r\n", (unsigned)s.id);
+
+    if (strcmp(method, "OPTIONS") == 0) {
+        respond(s, 200, cseq, "Public: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER\r\n");
+        return true;
+    }
+
+    if (strcmp(method, "DESCRIBE") == 0) {
+        sockaddr_in local = {};
+        socklen_t len = sizeof(local);
+        getsockname(s.sock, (sockaddr*)&local, &len);
+
+        char sdp[256];
+        snprintf(sdp, sizeof(sdp),
+                 "v=0\r\n"
+                 "o=- %u 1 IN IP4 %s\r\n"
+                 "s=%s\r\n"
+                 "c=IN IP4 0.0.0.0\r\n"
+                 "t=0 0\r\n"
+                 "m=video 0 RTP/AVP %u\r\n"
+                 "a=rtpmap:%u JPEG/%u\r\n"
+                 "a=control:track1\r\n",
+                 (unsigned)s.id, inet_ntoa(local.sin_addr), MDNS_NAME, RtpJpeg::PAYLOAD_TYPE,
+                 RtpJpeg::PAYLOAD_TYPE, (unsigned)RtpJpeg::CLOCK_RATE);
+
+        size_t urlLen = strlen(url);
+        snprintf(headers, sizeof(headers), "Content-Base: %s%s\r\nContent-Type: application/sdp\r\n",
+                 url, urlLen && url[urlLen - 1] == '/' ? "" : "/");
+        respond(s, 200, cseq, headers, sdp);
+        return true;
+    }
+
+    if (strcmp(method, "SETUP") == 0) {
+        char transport[128];
+        char reply[128];
+        if (!headerValue(request, "Transport", transport, sizeof(transport)) ||
+            !setupTransport(s, transport, reply, sizeof(reply))) {
+            respond(s, 461, cseq, nullptr);
+            return true;
+        }
+        s.ready = true;
+        snprintf(headers, sizeof(headers), "Transport: %s\r\nSession: %08X\r\n", reply, (unsigned)s.id);
+        respond(s, 200, cseq, headers);
+        return true;
+    }
+
+    bool known = strcmp(method, "PLAY") == 0 || strcmp(method, "TEARDOWN") == 0 ||
+                 strcmp(method, "GET_PARAMETER") == 0;
+    if (!known) {
+        respond(s, 501, cseq, nullptr);
+        return true;
+    }
+    if (hasSession && strtoul(session, nullptr, 16) != s.id) {
+        respond(s, 454, cseq, nullptr);
+        return true;
+    }
+
+    if (strcmp(method, "PLAY") == 0) {
+        if (!s.ready) {
+            respond(s, 455, cseq, nullptr);
+            return true;
+        }
+        s.playing = true;
+        updatePlaying();
+        Logger::info("RTSP", "Session %08X playing over %s", (unsigned)s.id, s.interleaved ? "TCP" : "UDP");
+        snprintf(headers, sizeof(headers), "Session: %08X\r\nRange: npt=0.000-\r\n", (unsigned)s.id);
+        respond(s, 200, cseq, headers);
+    } else if (strcmp(method, "TEARDOWN") == 0) {
+        s.playing = false;
+        s.ready = false;
+        updatePlaying();
+        respond(s, 200, cseq, headers);
+    } else {
+        // 客户端保活
+        respond(s, 200, cseq, headers);
+    }
+    return true;
+}
+
+bool RtspServer::setupTransport(Session& s, const char* transport, char* reply, size_t replySize) {
+    if (strstr(transport, "multicast")) return false;
+
+    s.rtp.ssrc = randomId();
+    s.rtp.seq = (uint16_t)rand();
+
+    if (strstr(transport, "RTP/AVP/TCP")) {
+        unsigned rtp = 0, rtcp = 1;
+        const char* p = strstr(transport, "interleaved=");
+        if (p) sscanf(p + 12, "%u-%u", &rtp, &rtcp);
+        s.interleaved = true;
+        s.channel = rtp;
+        snprintf(reply, replySize, "RTP/AVP/TCP;unicast;interleaved=%u-%u;ssrc=%08X",
+                 rtp, rtcp, (unsigned)s.rtp.ssrc);
+        return true;
+    }
+
+    const char* p = strstr(transport, "client_port=");
+    if (rtpSock < 0 || !strstr(transport, "RTP/AVP") || !p) return false;
+    unsigned rtp = 0, rtcp = 0;
+    if (sscanf(p + 12, "%u-%u", &rtp, &rtcp) < 1 || rtp == 0 || rtp > 65535) return false;
+    if (rtcp == 0) rtcp = rtp + 1;
+
+    socklen_t len = sizeof(s.rtpAddr);
+    if (getpeername(s.sock, (sockaddr*)&s.rtpAddr, &len) < 0) return false;
+    s.rtpAddr.sin_port = htons(rtp);
+    s.interleaved = false;
+    char serverPort[16];
+    if (rtcpSock >= 0) snprintf(serverPort, sizeof(serverPort), "%u-%u", rtpPort, rtpPort + 1);
+    else snprintf(serverPort, sizeof(serverPort), "%u", rtpPort);
+    snprintf(reply, replySize, "RTP/AVP;unicast;client_port=%u-%u;server_port=%s;ssrc=%08X",
+             rtp, rtcp, serverPort, (unsigned)s.rtp.ssrc);
+    return true;
+}
+
+void RtspServer::respond(Session& s, int status, const char* cseq, const char* extraHeaders, const char* body) {
+    char head[512];
+    int n = snprintf(head, sizeof(head), "RTSP/1.0 %d %s\r\nCSeq: %s\r\nServer: MyCam\r\n%s",
+                     status, statusText(status), cseq, extraHeaders ? extraHeaders : "");
+    if (body) {
+        n += snprintf(head + n, sizeof(head) - n, "Content-Length: %u\r\n", (unsigned)strlen(body));
+    }
+    n += snprintf(head + n, sizeof(head) - n, "\r\n");
+
+    bool ok = sendAll(s.sock, (const uint8_t*)head, min((size_t)n, sizeof(head) - 1));
+    if (ok && body) ok = sendAll(s.sock, (const uint8_t*)body, strlen(body));
+    if (!ok) closeSession(s);
+}
+
+bool RtspServer::sendAll(int sock, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        int n = send(sock, data, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool RtspServer::sendPacket(uint8_t* packet, size_t len, void* arg) {
+    RtpSendContext* ctx = (RtpSendContext*)arg;
+    ctx->bytes += len;
+
+    if (ctx->interleaved) {
+        uint8_t* framed = packet - RTP_INTERLEAVED_PREFIX;
+        framed[0] = '$';
+        framed[1] = ctx->channel;
+        framed[2] = len >> 8;
+        framed[3] = len & 0xff;
+        return ctx->server->sendAll(ctx->sock, framed, len + RTP_INTERLEAVED_PREFIX);
+    }
+
+    // 一帧的包连续发出，lwIP 缓冲暂时用尽时稍等重试
+    for (int attempt = 0; attempt < 3; attempt++) {
+        int n = sendto(ctx->udpSock, packet, len, 0, (const sockaddr*)ctx->addr, sizeof(sockaddr_in));
+        if (n == (int)len) return true;
+        if (errno != ENOMEM && errno != ENOBUFS && errno != EAGAIN) break;
+        delay(1);
+    }
+    return false;
+}
+
+void RtspServer::sendFrame(const uint8_t* jpeg, size_t len, uint32_t timestamp) {
+    RtpJpegFrame frame;
+    if (!RtpJpeg::parse(jpeg, len, frame)) {
+        Logger::warn("RTSP", "Frame is not a baseline JPEG with standard tables, skipped");
+        portENTER_CRITICAL(&lock);
+        stats.framesInvalid++;
+        portEXIT_CRITICAL(&lock);
+        return;
+    }
+
+    for (Session& s : sessions) {
+        if (s.sock < 0 || !s.playing) continue;
+
+        RtpSendContext ctx = {this, s.sock, s.interleaved, s.channel, &s.rtpAddr, rtpSock, 0};
+        int packets = RtpJpeg::packetize(frame, timestamp, s.rtp, RTSP_RTP_PACKET_SIZE, packet, sendPacket, &ctx);
+
+        portENTER_CRITICAL(&lock);
+        if (packets < 0) {
+            stats.sendErrors++;
+        } else {
+            stats.framesSent++;
+            stats.packetsSent += packets;
+        }
+        stats.bytesSent += ctx.bytes;
+        portEXIT_CRITICAL(&lock);
+        bandwidthArbiter.recordLive(ctx.bytes, millis());
+
+        // TCP 上已写出半个包，流无法恢复；UDP 只丢掉这一帧
+        if (packets < 0 && s.interleaved) {
+            Logger::warn("RTSP", "Session %08X send failed, closing", (unsigned)s.id);
+            closeSession(s);
+        }
+    }
+}
+
+void RtspServer::closeSession(Session& s) {
+    if (s.sock < 0) return;
+    ::close(s.sock);
+    s.sock = -1;
+    s.playing = false;
+    s.ready = false;
+    s.buffered = 0;
+    s.skip = 0;
+    updatePlaying();
+    Logger::info("RTSP", "Session %08X closed", (unsigned)s.id);
+}
+
+void RtspServer::updatePlaying() {
+    uint8_t open = 0, playing = 0;
+    for (const Session& s : sessions) {
+        if (s.sock < 0) continue;
+        open++;
+        if (s.playing) playing++;
+    }
+    playingCount = playing;
+    portENTER_CRITICAL(&lock);
+    stats.sessions = open;
+    stats.playing = playing;
+    portEXIT_CRITICAL(&lock);
+}
@@ -0,0 +1,213 @@
+#include "scheduler.h"
+#include "logger.h"
+
+Scheduler scheduler;
+
+// 无符号回绕安全的时间比较
+static inline bool reached(uint32_t now, uint32_t deadline) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+void Scheduler::begin() {
+    task = xTaskGetCurrentTaskHandle();
+    mutex = xSemaphoreCreateRecursiveMutex();
+    for (uint32_t i = 0; i < WHEEL_SLOTS; i++) {
+        wheel[i] = -1;
+    }
+    lastTick = tickOf(millis());
+}
+
+void Scheduler::post(SchedulerEvent event) {
+    if (task) {
+        xTaskNotify(task, 1u << event, eSetBits);
+    }
+}
+
+void Scheduler::postFromISR(SchedulerEvent event) {
+    if (!task) return;
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(task, 1u << event, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+bool Scheduler::on(SchedulerEvent event, SchedulerHandler handler) {
+    if (handlerCount >= SCHEDULER_MAX_HANDLERS) {
+        Logger::error("SCHED", "Too many event handlers");
+        return false;
+    }
+    handlers[handlerCount].event = event;
+    handlers[handlerCount].handler = handler;
+    handlerCount++;
+    return true;
+}
+
+TimerId Scheduler::schedule(uint32_t delayMs, SchedulerHandler handler, uint32_t periodMs) {
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+
+    int16_t index = -1;
+    for (int16_t i = 0; i < SCHEDULER_MAX_TIMERS; i++) {
+        if (!timers[i].active) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        xSemaphoreGiveRecursive(mutex);
+        Logger::error("SCHED", "No free timer slot");
+        return INVALID_TIMER;
+    }
+
+    Timer& t = timers[index];
+    t.handler = handler;
+    t.deadline = millis() + delayMs;
+    t.period = periodMs;
+    t.generation++;
+    t.active = true;
+    link(index);
+    TimerId id = ((TimerId)t.generation << 8) | index;
+
+    xSemaphoreGiveRecursive(mutex);
+
+    // 从其他任务添加的定时器可能比当前等待的更早到期，唤醒调度任务重新计算
+    if (task && xTaskGetCurrentTaskHandle() != task) {
+        xTaskNotify(task, RESCHEDULE_BIT, eSetBits);
+    }
+    return id;
+}
+
+void Scheduler::cancel(TimerId& id) {
+    if (id == INVALID_TIMER) return;
+
+    int16_t index = id & 0xFF;
+    uint16_t generation = (uint16_t)(id >> 8);
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    if (index < SCHEDULER_MAX_TIMERS && timers[index].active &&
+        timers[index].generation == generation) {
+        unlink(index);
+        timers[index].active = false;
+        timers[index].handler = nullptr;
+    }
+    xSemaphoreGiveRecursive(mutex);
+    id = INVALID_TIMER;
+}
+
+void Scheduler::link(int16_t index) {
+    uint32_t slot = tickOf(timers[index].deadline) % WHEEL_SLOTS;
+    timers[index].next = wheel[slot];
+    wheel[slot] = index;
+}
+
+void Scheduler::unlink(int16_t index) {
+    uint32_t slot = tickOf(timers[index].deadline) % WHEEL_SLOTS;
+    int16_t* p = &wheel[slot];
+    while (*p >= 0) {
+        if (*p == index) {
+            *p = timers[index].next;
+            timers[index].next = -1;
+            return;
+        }
+        p = &timers[*p].next;
+    }
+}
+
+TickType_t Scheduler::ticksUntilNextTimer() {
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+
+    uint32_t now = millis();
+    uint32_t nowTick = tickOf(now);
+    bool anyTimer = false;
+    TickType_t wait = portMAX_DELAY;
+
+    // 从当前槽向前扫描一圈，找到本轮内最早到期的定时器
+    for (uint32_t i = 0; i < WHEEL_SLOTS && wait == portMAX_DELAY; i++) {
+        uint32_t tick = nowTick + i;
+        for (int16_t idx = wheel[tick % WHEEL_SLOTS]; idx >= 0; idx = timers[idx].next) {
+            anyTimer = true;
+            if (tickOf(timers[idx].deadline) == tick || reached(now, timers[idx].deadline)) {
+                uint32_t ms = reached(now, timers[idx].deadline) ? 0 : timers[idx].deadline - now;
+                wait = pdMS_TO_TICKS(ms);
+                break;
+            }
+        }
+    }
+
+    // 本轮没有到期的定时器：最多睡一圈后再检查
+    if (wait == portMAX_DELAY && anyTimer) {
+        wait = pdMS_TO_TICKS(WHEEL_SLOTS * TICK_MS);
+    }
+
+    xSemaphoreGiveRecursive(mutex);
+    return wait;
+}
+
+void Scheduler::runExpiredTimers() {
+    uint32_t now = millis();
+    uint32_t nowTick = tickOf(now);
+
+    // 间隔超过一圈时每个槽都要检查
+    uint32_t span = nowTick - lastTick;
+    if (span >= WHEEL_SLOTS) span = WHEEL_SLOTS - 1;
+
+    for (uint32_t tick = nowTick - span; tick != nowTick + 1; tick++) {
+        uint32_t slot = tick % WHEEL_SLOTS;
+        while (true) {
+            // 处理函数可能增删定时器，每次从槽头重新查找
+            xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+            int16_t idx = wheel[slot];
+            while (idx >= 0 && !reached(now, timers[idx].deadline)) {
+                idx = timers[idx].next;
+            }
+            if (idx < 0) {
+                xSemaphoreGiveRecursive(mutex);
+                break;
+            }
+
+            Timer& t = timers[idx];
+            unlink(idx);
+            SchedulerHandler handler = t.handler;
+            if (t.period > 0) {
+                t.deadline += t.period;
+                if (reached(now, t.deadline)) t.deadline = now + t.period;
+                link(idx);
+            } else {
+                t.active = false;
+                t.handler = nullptr;
+            }
+            xSemaphoreGiveRecursive(mutex);
+
+            timersFired++;
+            handler();
+        }
+    }
+    lastTick = nowTick;
+}
+
+void Scheduler::run() {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, 0xFFFFFFFF, &bits, ticksUntilNextTimer());
+    wakeups++;
+
+    for (int e = 0; e < EVENT_COUNT; e++) {
+        if (!(bits & (1u << e))) continue;
+        eventsDispatched++;
+        for (uint8_t i = 0; i < handlerCount; i++) {
+            if (handlers[i].event == e) {
+                handlers[i].handler();
+            }
+        }
+    }
+
+    runExpiredTimers();
+}
+
+SchedulerStats Scheduler::getStats() const {
+    SchedulerStats stats;
+    stats.wakeups = wakeups;
+    stats.events = eventsDispatched;
+    stats.timersFired = timersFired;
+    stats.activeTimers = 0;
+    for (int i = 0; i < SCHEDULER_MAX_TIMERS; i++) {
+        if (timers[i].active) stats.activeTimers++;
+    }
+    return stats;
+}
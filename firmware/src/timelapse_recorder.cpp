@@ -0,0 +1,414 @@
+#include "timelapse_recorder.h"
+#include "buffer_pool.h"
+#include "jpeg_encoder.h"
+#include "logger.h"
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include <time.h>
+
+static const char* TIMELAPSE_DIR = "/timelapse";
+static const char* OPEN_PATH = "/timelapse/open.bin";
+static const char* OPEN_TMP_PATH = "/timelapse/open.tmp";
+static const char* READY_PATH = "/timelapse/ready.bin";
+static const char* CONFIG_PATH = "/timelapse/config.json";
+static const char* UPLOAD_PATH = "/api/v1/images/batch";
+
+bool TimelapseRecorder::begin() {
+    mutex = xSemaphoreCreateMutex();
+    if (!mutex) return false;
+
+    if (!LittleFS.exists(TIMELAPSE_DIR) && !LittleFS.mkdir(TIMELAPSE_DIR)) {
+        Logger::error("TIMELAPSE", "Failed to create %s", TIMELAPSE_DIR);
+        return false;
+    }
+
+    loadConfig();
+    recoverBatches();
+
+    // 重新联网后立即补传
+    scheduler.on(EVENT_WIFI_CONNECTED, [this]() {
+        if (uploadTask) xTaskNotifyGive(uploadTask);
+    });
+
+    xTaskCreateUniversal(uploadTaskEntry, "timelapse", 8192, this,
+                         TASK_UPLOAD_PRIORITY, &uploadTask, ARDUINO_RUNNING_CORE);
+    if (uploadTask && stats.batchPending) {
+        xTaskNotifyGive(uploadTask);
+    }
+
+    Logger::info("TIMELAPSE", "Time-lapse %s: every %u s, %u frames or %u s per batch",
+                 config.enabled ? "enabled" : "disabled", (unsigned)config.intervalSec,
+                 config.batchFrames, (unsigned)config.batchAgeSec);
+    return uploadTask != nullptr;
+}
+
+void TimelapseRecorder::loadConfig() {
+    config.enabled = false;
+    config.intervalSec = TIMELAPSE_DEFAULT_INTERVAL_SEC;
+    config.batchFrames = TIMELAPSE_DEFAULT_BATCH_FRAMES;
+    config.batchAgeSec = TIMELAPSE_DEFAULT_BATCH_AGE_SEC;
+
+    File file = LittleFS.open(CONFIG_PATH, "r");
+    if (!file) return;
+
+    StaticJsonDocument<256> doc;
+    DeserializationError err = deserializeJson(doc, file);
+    file.close();
+    if (err) {
+        Logger::warn("TIMELAPSE", "Invalid config, using defaults");
+        return;
+    }
+
+    TimelapseConfig loaded;
+    loaded.enabled = doc["enabled"] | false;
+    loaded.intervalSec = doc["interval"] | (uint32_t)TIMELAPSE_DEFAULT_INTERVAL_SEC;
+    loaded.batchFrames = doc["batch_frames"] | (uint16_t)TIMELAPSE_DEFAULT_BATCH_FRAMES;
+    loaded.batchAgeSec = doc["batch_age"] | (uint32_t)TIMELAPSE_DEFAULT_BATCH_AGE_SEC;
+    if (loaded.intervalSec > 0 && loaded.batchFrames > 0 &&
+        loaded.batchFrames <= TIMELAPSE_MAX_BATCH_FRAMES && loaded.batchAgeSec > 0) {
+        config = loaded;
+    }
+}
+
+bool TimelapseRecorder::saveConfig() {
+    StaticJsonDocument<256> doc;
+    doc["enabled"] = config.enabled;
+    doc["interval"] = config.intervalSec;
+    doc["batch_frames"] = config.batchFrames;
+    doc["batch_age"] = config.batchAgeSec;
+
+    File file = LittleFS.open(CONFIG_PATH, "w");
+    if (!file) return false;
+    bool ok = serializeJson(doc, file) > 0;
+    file.close();
+    return ok;
+}
+
+void TimelapseRecorder::recoverBatches() {
+    stats.batchPending = LittleFS.exists(READY_PATH);
+
+    // 统计掉电前写入的完整帧，截断末尾写了一半的帧
+    File file = LittleFS.open(OPEN_PATH, "r");
+    if (!file) return;
+
+    size_t size = file.size();
+    size_t offset = 0;
+    TimelapseFrameHeader header;
+    while (offset + sizeof(header) <= size) {
+        file.seek(offset);
+        if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header)) break;
+        if (offset + sizeof(header) + header.length > size) break;
+        offset += sizeof(header) + header.length;
+        stats.openFrames++;
+    }
+    file.close();
+    stats.openBytes = offset;
+
+    if (offset < size) {
+        Logger::warn("TIMELAPSE", "Dropping %u bytes of partial frame", (unsigned)(size - offset));
+        if (offset == 0) {
+            LittleFS.remove(OPEN_PATH);
+        } else {
+            // LittleFS 不支持截断，重写有效部分
+            File src = LittleFS.open(OPEN_PATH, "r");
+            File dst = LittleFS.open(OPEN_TMP_PATH, "w");
+            uint8_t chunk[512];
+            size_t remaining = offset;
+            while (src && dst && remaining > 0) {
+                size_t n = src.read(chunk, min(remaining, sizeof(chunk)));
+                if (n == 0 || dst.write(chunk, n) != n) break;
+                remaining -= n;
+            }
+            src.close();
+            dst.close();
+            LittleFS.remove(OPEN_PATH);
+            if (remaining == 0) {
+                LittleFS.rename(OPEN_TMP_PATH, OPEN_PATH);
+            } else {
+                LittleFS.remove(OPEN_TMP_PATH);
+                stats.openFrames = 0;
+                stats.openBytes = 0;
+            }
+        }
+    }
+
+    if (stats.openFrames > 0) {
+        Logger::info("TIMELAPSE", "Recovered batch with %u frames", stats.openFrames);
+        ageTimer = scheduler.schedule(config.batchAgeSec * 1000, [this]() { onBatchAged(); });
+    }
+}
+
+bool TimelapseRecorder::isDue() const {
+    if (!config.enabled) return false;
+    return !captured || millis() - lastCaptureMs >= config.intervalSec * 1000;
+}
+
+void TimelapseRecorder::addFrame(camera_fb_t* fb) {
+    lastCaptureMs = millis();
+    captured = true;
+
+    uint8_t* jpg = bufferPool.acquire(JpegEncoder::frameOutputSize(fb));
+    if (!jpg) return;
+
+    size_t jpgSize = JpegEncoder::encodeFrame(fb, TIMELAPSE_JPEG_QUALITY, jpg, bufferPool.capacity(jpg));
+    if (jpgSize > 0) {
+        time_t t = time(nullptr);
+        appendFrame(t > 1600000000 ? (uint32_t)t : 0, jpg, jpgSize);
+    }
+    bufferPool.release(jpg);
+}
+
+bool TimelapseRecorder::isOpenFull(size_t nextBytes) const {
+    return stats.openFrames >= config.batchFrames ||
+           stats.openBytes + nextBytes > TIMELAPSE_BATCH_MAX_BYTES;
+}
+
+void TimelapseRecorder::appendFrame(uint32_t timestamp, const uint8_t* jpg, size_t length) {
+    TimelapseFrameHeader header;
+    header.timestamp = timestamp;
+    header.length = length;
+    size_t needed = sizeof(header) + length;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    if (needed > TIMELAPSE_BATCH_MAX_BYTES ||
+        (stats.openFrames > 0 && isOpenFull(needed) && !sealOpenBatch())) {
+        // 上一批还没传走，没有空间
+        stats.framesDropped++;
+        xSemaphoreGive(mutex);
+        Logger::warn("TIMELAPSE", "Batch store full, frame dropped");
+        return;
+    }
+
+    File file = LittleFS.open(OPEN_PATH, "a");
+    bool ok = file && file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              file.write(jpg, length) == length;
+    file.close();
+    if (!ok) {
+        xSemaphoreGive(mutex);
+        Logger::error("TIMELAPSE", "Failed to write frame");
+        return;
+    }
+
+    stats.openFrames++;
+    stats.openBytes += needed;
+    if (stats.openFrames == 1) {
+        ageTimer = scheduler.schedule(config.batchAgeSec * 1000, [this]() { onBatchAged(); });
+    }
+    if (stats.openFrames >= config.batchFrames) {
+        sealOpenBatch();
+    }
+
+    xSemaphoreGive(mutex);
+}
+
+// 调用方持有 mutex
+bool TimelapseRecorder::sealOpenBatch() {
+    if (stats.openFrames == 0) return true;
+    if (stats.batchPending) {
+        // 上传完成后再封装
+        openExpired = true;
+        return false;
+    }
+    if (!LittleFS.rename(OPEN_PATH, READY_PATH)) {
+        Logger::error("TIMELAPSE", "Failed to seal batch");
+        return false;
+    }
+
+    Logger::info("TIMELAPSE", "Batch sealed: %u frames, %u bytes",
+                 stats.openFrames, (unsigned)stats.openBytes);
+    scheduler.cancel(ageTimer);
+    stats.openFrames = 0;
+    stats.openBytes = 0;
+    stats.batchPending = true;
+    openExpired = false;
+    xTaskNotifyGive(uploadTask);
+    return true;
+}
+
+void TimelapseRecorder::onBatchAged() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    ageTimer = INVALID_TIMER;
+    sealOpenBatch();
+    xSemaphoreGive(mutex);
+}
+
+bool TimelapseRecorder::flush() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    // 有待传批次时在其上传完成后封装
+    bool ok = stats.openFrames > 0;
+    if (ok) sealOpenBatch();
+    xSemaphoreGive(mutex);
+    return ok;
+}
+
+bool TimelapseRecorder::setConfig(const TimelapseConfig& next) {
+    if (next.intervalSec == 0 || next.batchFrames == 0 ||
+        next.batchFrames > TIMELAPSE_MAX_BATCH_FRAMES || next.batchAgeSec == 0) {
+        return false;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool enabling = next.enabled && !config.enabled;
+    config = next;
+    if (enabling) {
+        // 开启后立即拍第一帧
+        captured = false;
+    }
+    if (stats.openFrames >= config.batchFrames) {
+        sealOpenBatch();
+    }
+    bool ok = saveConfig();
+    xSemaphoreGive(mutex);
+    return ok;
+}
+
+TimelapseStats TimelapseRecorder::getStats() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    TimelapseStats copy = stats;
+    xSemaphoreGive(mutex);
+    return copy;
+}
+
+void TimelapseRecorder::uploadTaskEntry(void* parameter) {
+    static_cast<TimelapseRecorder*>(parameter)->uploadLoop();
+}
+
+void TimelapseRecorder::uploadLoop() {
+    uint32_t retryMs = 0;
+
+    while (true) {
+        // 没有待传批次时一直阻塞，链路保持空闲
+        ulTaskNotifyTake(pdTRUE, retryMs ? pdMS_TO_TICKS(retryMs) : portMAX_DELAY);
+
+        if (!stats.batchPending) {
+            retryMs = 0;
+            continue;
+        }
+        if (!WiFi.isConnected()) {
+            // 等待 EVENT_WIFI_CONNECTED
+            retryMs = 0;
+            continue;
+        }
+
+        uint32_t frames = 0;
+        uint32_t bytes = 0;
+        unsigned long start = millis();
+        int status = uploadReadyBatch(frames, bytes);
+        unsigned long elapsed = millis() - start;
+
+        // 4xx（超时和限流除外）重试也不会成功，丢弃该批次
+        bool rejected = status >= 400 && status < 500 && status != 408 && status != 429;
+        bool done = (status >= 200 && status < 300) || rejected;
+
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        stats.lastStatus = status;
+        if (status >= 200 && status < 300) {
+            stats.batchesUploaded++;
+            stats.framesUploaded += frames;
+            stats.bytesUploaded += bytes;
+            stats.lastUploadMs = elapsed;
+        } else {
+            stats.uploadFailures++;
+        }
+        if (done) {
+            LittleFS.remove(READY_PATH);
+            stats.batchPending = false;
+            if (stats.openFrames > 0 && (openExpired || isOpenFull(0))) {
+                sealOpenBatch();
+            }
+        }
+        xSemaphoreGive(mutex);
+
+        if (rejected) {
+            Logger::error("TIMELAPSE", "Batch rejected by server (HTTP %d), discarded", status);
+            retryMs = 0;
+        } else if (done) {
+            Logger::info("TIMELAPSE", "Uploaded %u frames, %u bytes in %lu ms",
+                         (unsigned)frames, (unsigned)bytes, elapsed);
+            retryMs = 0;
+        } else {
+            retryMs = retryMs ? min<uint32_t>(retryMs * 2, TIMELAPSE_RETRY_MAX_MS) : TIMELAPSE_RETRY_MIN_MS;
+            Logger::warn("TIMELAPSE", "Upload failed (%d), retry in %u s", status, (unsigned)(retryMs / 1000));
+        }
+    }
+}
+
+int TimelapseRecorder::uploadReadyBatch(uint32_t& frames, uint32_t& bytes) {
+    // 上传期间 ready.bin 只由本任务访问
+    File file = LittleFS.open(READY_PATH, "r");
+    if (!file) return -4;
+
+    // 第一遍：读帧头，生成元数据并计算请求体长度
+    MultipartForm form;
+    char filename[32];
+
+    DynamicJsonDocument doc(256 + TIMELAPSE_MAX_BATCH_FRAMES * 48);
+    doc["device_id"] = cloud.getDeviceId();
+    doc["interval"] = config.intervalSec;
+    JsonArray list = doc.createNestedArray("frames");
+
+    size_t contentLength = 0;
+    size_t size = file.size();
+    size_t offset = 0;
+    TimelapseFrameHeader header;
+    frames = 0;
+    bytes = 0;
+    while (offset + sizeof(header) <= size && frames < TIMELAPSE_MAX_BATCH_FRAMES) {
+        file.seek(offset);
+        if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header)) break;
+        if (offset + sizeof(header) + header.length > size) break;
+
+        JsonObject item = list.createNestedObject();
+        item["timestamp"] = header.timestamp;
+        item["size"] = header.length;
+
+        snprintf(filename, sizeof(filename), "%u_%u.jpg", (unsigned)header.timestamp, (unsigned)frames);
+        contentLength += form.partLength("frame", filename, "image/jpeg", header.length);
+        offset += sizeof(header) + header.length;
+        frames++;
+        bytes += header.length;
+    }
+    if (frames == 0) {
+        file.close();
+        // 空批次视为已完成
+        return 204;
+    }
+
+    String metadata;
+    serializeJson(doc, metadata);
+    contentLength += form.partLength("metadata", nullptr, "application/json", metadata.length());
+    contentLength += form.closingLength();
+
+    // 第二遍：流式写出，帧数据直接从文件读取
+    int status = cloud.post(UPLOAD_PATH, form.getContentType(), contentLength, [&](const HttpsWriteFn& write) {
+        if (!form.writePart(write, "metadata", nullptr, "application/json",
+                            (const uint8_t*)metadata.c_str(), metadata.length())) {
+            return false;
+        }
+
+        uint8_t chunk[1024];
+        size_t pos = 0;
+        for (uint32_t i = 0; i < frames; i++) {
+            file.seek(pos);
+            if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header)) return false;
+            snprintf(filename, sizeof(filename), "%u_%u.jpg", (unsigned)header.timestamp, (unsigned)i);
+            if (!form.writePartHeader(write, "frame", filename, "image/jpeg")) return false;
+
+            size_t remaining = header.length;
+            while (remaining > 0) {
+                size_t n = file.read(chunk, min(remaining, sizeof(chunk)));
+                if (n == 0 || !write(chunk, n)) return false;
+                remaining -= n;
+            }
+            if (!form.writePartEnd(write)) return false;
+            pos += sizeof(header) + header.length;
+        }
+
+        return form.writeClosing(write);
+    });
+
+    file.close();
+    return status;
+}
@@ -0,0 +1,174 @@
+// 设备端 TlsTransport：mbedTLS + lwIP 套接字
+#include "tls_transport.h"
+#include "config.h"
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/ssl_internal.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+#include <esp_crt_bundle.h>
+#include <lwip/sockets.h>
+#include <errno.h>
+
+class MbedTlsTransport : public TlsTransport {
+public:
+    MbedTlsTransport();
+    ~MbedTlsTransport() override;
+
+    bool connect(const char* host, uint16_t port,
+                 const uint8_t* session, size_t sessionLen, uint32_t timeoutMs) override;
+    bool sessionResumed() const override { return resumed; }
+    bool saveSession(std::vector<uint8_t>& out) override;
+    int write(const uint8_t* data, size_t len) override;
+    int read(uint8_t* data, size_t len, uint32_t timeoutMs) override;
+    bool isAlive() override;
+    void close() override;
+
+private:
+    mbedtls_net_context net;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_entropy_context entropy;
+    mbedtls_x509_crt ca;
+    bool connected = false;
+    bool resumed = false;
+};
+
+MbedTlsTransport::MbedTlsTransport() {
+    mbedtls_net_init(&net);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_x509_crt_init(&ca);
+}
+
+MbedTlsTransport::~MbedTlsTransport() {
+    close();
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    mbedtls_x509_crt_free(&ca);
+}
+
+bool MbedTlsTransport::connect(const char* host, uint16_t port,
+                               const uint8_t* session, size_t sessionLen, uint32_t timeoutMs) {
+    if (mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, nullptr, 0) != 0 ||
+        mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        return false;
+    }
+
+    // 始终校验服务器证书：配置了 HTTPS_ROOT_CA 时只信任该根证书，否则用 IDF 内置的根证书包；
+    // 两者都没有时不连接，不退回到不校验
+    const char* rootCa = HTTPS_ROOT_CA;
+    if (rootCa) {
+        if (mbedtls_x509_crt_parse(&ca, (const unsigned char*)rootCa, strlen(rootCa) + 1) != 0) {
+            return false;
+        }
+        mbedtls_ssl_conf_ca_chain(&conf, &ca, nullptr);
+    } else {
+#ifdef CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+        if (esp_crt_bundle_attach(&conf) != ESP_OK) return false;
+#else
+        return false;
+#endif
+    }
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_read_timeout(&conf, timeoutMs);
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+
+    if (mbedtls_ssl_setup(&ssl, &conf) != 0 || mbedtls_ssl_set_hostname(&ssl, host) != 0) {
+        return false;
+    }
+
+    char portStr[8];
+    snprintf(portStr, sizeof(portStr), "%u", port);
+    if (mbedtls_net_connect(&net, host, portStr, MBEDTLS_NET_PROTO_TCP) != 0) {
+        return false;
+    }
+    connected = true;
+
+    // 请求已在连接池中合并写出，关闭 Nagle 避免与延迟 ACK 叠加
+    int yes = 1;
+    setsockopt(net.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    mbedtls_ssl_set_bio(&ssl, &net, mbedtls_net_send, nullptr, mbedtls_net_recv_timeout);
+
+    if (session) {
+        mbedtls_ssl_session saved;
+        mbedtls_ssl_session_init(&saved);
+        if (mbedtls_ssl_session_load(&saved, session, sessionLen) == 0) {
+            mbedtls_ssl_set_session(&ssl, &saved);
+        }
+        mbedtls_ssl_session_free(&saved);
+    }
+
+    // 逐步握手：mbedTLS 2.x 握手结束后不保留是否恢复的信息，只能在握手过程中读取
+    resumed = false;
+    while (ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        int ret = mbedtls_ssl_handshake_step(&ssl);
+        if (ssl.handshake && ssl.handshake->resume) resumed = true;
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) continue;
+        if (ret != 0) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MbedTlsTransport::saveSession(std::vector<uint8_t>& out) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    bool ok = false;
+    if (mbedtls_ssl_get_session(&ssl, &session) == 0) {
+        size_t len = 0;
+        mbedtls_ssl_session_save(&session, nullptr, 0, &len);
+        out.resize(len);
+        ok = len > 0 && mbedtls_ssl_session_save(&session, out.data(), out.size(), &len) == 0;
+    }
+    mbedtls_ssl_session_free(&session);
+    return ok;
+}
+
+int MbedTlsTransport::write(const uint8_t* data, size_t len) {
+    while (true) {
+        int ret = mbedtls_ssl_write(&ssl, data, len);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) continue;
+        return ret;
+    }
+}
+
+int MbedTlsTransport::read(uint8_t* data, size_t len, uint32_t timeoutMs) {
+    mbedtls_ssl_conf_read_timeout(&conf, timeoutMs);
+    while (true) {
+        int ret = mbedtls_ssl_read(&ssl, data, len);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) continue;
+        if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) return 0;
+        return ret;
+    }
+}
+
+bool MbedTlsTransport::isAlive() {
+    if (!connected || mbedtls_ssl_get_bytes_avail(&ssl) > 0) return false;
+
+    // 空闲连接上不应有数据：可读即为对端关闭或 close_notify
+    uint8_t c;
+    int n = recv(net.fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN);
+}
+
+void MbedTlsTransport::close() {
+    if (!connected) return;
+    mbedtls_ssl_close_notify(&ssl);
+    mbedtls_net_free(&net);
+    connected = false;
+}
+
+TlsTransport* createTlsTransport() {
+    return new MbedTlsTransport();
+}
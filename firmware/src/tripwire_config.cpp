@@ -0,0 +1,56 @@
+#include "motion_estimator.h"
+#include "logger.h"
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+
+// 绊线配置单独成文件，主机端工具只链接 motion_estimator.cpp
+static const char* TRIPWIRE_PATH = "/tripwires.json";
+
+void MotionEstimator::loadTripwires() {
+    File file = LittleFS.open(TRIPWIRE_PATH, "r");
+    if (!file) return;
+
+    StaticJsonDocument<1024> doc;
+    DeserializationError err = deserializeJson(doc, file);
+    file.close();
+    if (err) {
+        Logger::warn("MV", "Invalid tripwire config, ignored");
+        return;
+    }
+
+    for (JsonObject item : doc.as<JsonArray>()) {
+        Tripwire tw = {};
+        strlcpy(tw.name, item["name"] | "", sizeof(tw.name));
+        tw.x0 = item["x0"] | 0;
+        tw.y0 = item["y0"] | 0;
+        tw.x1 = item["x1"] | 0;
+        tw.y1 = item["y1"] | 0;
+        if (!parseTripwireDirection(item["direction"] | "both", tw.direction) || !setTripwire(tw)) {
+            Logger::warn("MV", "Tripwire '%s' ignored", tw.name);
+        }
+    }
+    Logger::info("MV", "%u tripwires loaded", tripwireCount);
+}
+
+bool MotionEstimator::saveTripwires() {
+    Tripwire list[MV_MAX_TRIPWIRES];
+    uint8_t n = getTripwires(list, nullptr, MV_MAX_TRIPWIRES);
+
+    StaticJsonDocument<1024> doc;
+    JsonArray arr = doc.to<JsonArray>();
+    for (uint8_t i = 0; i < n; i++) {
+        JsonObject item = arr.createNestedObject();
+        item["name"] = list[i].name;
+        item["x0"] = list[i].x0;
+        item["y0"] = list[i].y0;
+        item["x1"] = list[i].x1;
+        item["y1"] = list[i].y1;
+        item["direction"] = tripwireDirectionName(list[i].direction);
+    }
+
+    File file = LittleFS.open(TRIPWIRE_PATH, "w");
+    if (!file) return false;
+    bool ok = serializeJson(doc, file) > 0;
+    file.close();
+    return ok;
+}
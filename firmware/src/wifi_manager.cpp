@@ -1,6 +1,25 @@
 // firmware/src/wifi_manager.cpp
 #include "wifi_manager.h"
 #include "config.h"
+#include "scheduler.h"
+
+void WiFiManager::init() {
+    // WiFi 事件在系统事件任务中触发，转投到调度器在主循环中处理
+    WiFi.onEvent([](arduino_event_id_t event, arduino_event_info_t info) {
+        if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+            scheduler.post(EVENT_WIFI_CONNECTED);
+        } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+            scheduler.post(EVENT_WIFI_DISCONNECTED);
+        }
+    });
+
+    scheduler.on(EVENT_WIFI_DISCONNECTED, [this]() {
+        scheduleReconnect();
+    });
+    scheduler.on(EVENT_WIFI_CONNECTED, [this]() {
+        scheduler.cancel(reconnectTimer);
+    });
+}
 
 bool WiFiManager::begin(const char* ssid, const char* password) {
     Serial.printf("Connecting to WiFi: %s\n", ssid);
@@ -13,6 +32,7 @@ bool WiFiManager::begin(const char* ssid, const char* password) {
     while (WiFi.status() != WL_CONNECTED &&
            millis() - start < WIFI_TIMEOUT_MS) {
         delay(500);
+        esp_task_wdt_reset();  // 启动阶段在主循环任务中阻塞等待
         Serial.print(".");
     }
 
@@ -30,16 +50,21 @@ bool WiFiManager::isConnected() {
     return WiFi.status() == WL_CONNECTED;
 }
 
-void WiFiManager::update() {
-    if (!isConnected() &&
-        millis() - lastReconnectAttempt > WIFI_RECONNECT_INTERVAL_MS) {
-        reconnect();
-    }
+// 断线后每隔 WIFI_RECONNECT_INTERVAL_MS 重连一次，直到收到连接事件
+void WiFiManager::scheduleReconnect() {
+    if (reconnectTimer != INVALID_TIMER) return;
+
+    reconnectTimer = scheduler.schedule(WIFI_RECONNECT_INTERVAL_MS, [this]() {
+        reconnectTimer = INVALID_TIMER;
+        if (!isConnected()) {
+            reconnect();
+            scheduleReconnect();
+        }
+    });
 }
 
 void WiFiManager::reconnect() {
     Serial.println("Attempting WiFi reconnection...");
-    lastReconnectAttempt = millis();
     WiFi.reconnect();
 }
 
@@ -50,3 +75,8 @@ String WiFiManager::getIP() {
 String WiFiManager::getMAC() {
     return WiFi.macAddress();
 }
+
+void WiFiManager::setPowerSave(bool enabled) {
+    if (WiFi.getMode() != WIFI_STA) return;
+    WiFi.setSleep(enabled);
+}
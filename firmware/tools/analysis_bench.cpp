@@ -0,0 +1,195 @@
+// 帧分析单核/双核对照：对 .mcfr 录制文件的每一帧依次运行
+// - MotionDetector::detect（RGB565 亮度网格）
+// - MotionEstimator::process（建亮度平面 + 块匹配）
+// - BurstSelector::sharpness（整帧，抽样间隔 BURST_SHARPNESS_STEP）
+// 先关闭 ParallelRunner 顺序执行，再打开用两个线程执行，比较逐帧输出（分数、dHash、运动矢量、清晰度）
+// 是否完全相同，并给出各阶段每帧耗时和加速比
+//
+// 用法:
+//   analysis_bench <recording.mcfr> [--iterations N] [--step N]
+//
+// 构建: tools/build_host.sh
+
+#include "motion_detector.h"
+#include "motion_estimator.h"
+#include "burst_selector.h"
+#include "buffer_pool.h"
+#include "parallel.h"
+#include "frame_recording.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int STAGES = 3;
+static const char* STAGE_NAMES[STAGES] = {"detect (luma grid)", "motion vectors", "sharpness"};
+
+struct Options {
+    const char* recordingPath = nullptr;
+    int iterations = 5;
+    int step = BURST_SHARPNESS_STEP;
+};
+
+// 每帧的分析输出，两种执行方式须逐位相同
+struct FrameOutput {
+    uint8_t score;
+    uint64_t hash;
+    uint32_t sharpness;
+    MotionVector vectors[MotionEstimator::BLOCK_COLS * MotionEstimator::BLOCK_ROWS];
+};
+
+struct PassResult {
+    std::vector<FrameOutput> outputs;
+    double stageUs[STAGES] = {};     // 每帧平均
+};
+
+static double elapsedUs(Clock::time_point from) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - from).count();
+}
+
+static bool loadFrames(const char* path, RecordingHeader& header, std::vector<std::vector<uint8_t>>& frames) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 && isValidRecordingHeader(header) &&
+              header.pixformat == PIXFORMAT_RGB565;
+    if (!ok) {
+        fprintf(stderr, "Not an RGB565 .mcfr recording\n");
+        fclose(f);
+        return false;
+    }
+
+    fseek(f, header.headerSize, SEEK_SET);
+    for (uint32_t i = 0; i < header.frameCount; i++) {
+        RecordingFrameHeader fh;
+        if (fread(&fh, sizeof(fh), 1, f) != 1) break;
+        std::vector<uint8_t> pixels(fh.length);
+        if (fread(pixels.data(), 1, fh.length, f) != fh.length) break;
+        if (fh.length >= (size_t)header.width * header.height * 2) frames.push_back(std::move(pixels));
+    }
+    fclose(f);
+    return !frames.empty();
+}
+
+static PassResult runPass(const RecordingHeader& header, std::vector<std::vector<uint8_t>>& frames,
+                          const Options& opt) {
+    PassResult result;
+    CropRect full(0, 0, header.width, header.height);
+    std::vector<uint8_t> rows(BurstSelector::scratchSize(header.width, opt.step));
+    MotionDetector detector;
+    detector.init();
+    std::unique_ptr<MotionEstimator> estimator(new MotionEstimator());
+
+    for (int it = 0; it < opt.iterations; it++) {
+        detector.reset();
+        estimator->reset();
+        bool record = it == 0;
+        for (size_t i = 0; i < frames.size(); i++) {
+            camera_fb_t fb = {};
+            fb.buf = frames[i].data();
+            fb.len = frames[i].size();
+            fb.width = header.width;
+            fb.height = header.height;
+            fb.format = PIXFORMAT_RGB565;
+
+            FrameOutput out = {};
+            Clock::time_point t0 = Clock::now();
+            detector.detect(&fb);
+            result.stageUs[0] += elapsedUs(t0);
+
+            t0 = Clock::now();
+            estimator->process(&fb, (uint32_t)(i * 100));
+            result.stageUs[1] += elapsedUs(t0);
+
+            t0 = Clock::now();
+            out.sharpness = BurstSelector::sharpness(&fb, full, opt.step, rows.data());
+            result.stageUs[2] += elapsedUs(t0);
+
+            if (record) {
+                out.score = detector.getLastScore();
+                out.hash = detector.getFrameHash();
+                estimator->getVectors(out.vectors);
+                result.outputs.push_back(out);
+            }
+        }
+    }
+
+    double runs = (double)opt.iterations * frames.size();
+    for (int s = 0; s < STAGES; s++) result.stageUs[s] /= runs;
+    return result;
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--iterations" && hasValue) {
+            opt.iterations = max(1, atoi(argv[++i]));
+        } else if (arg == "--step" && hasValue) {
+            opt.step = max(1, atoi(argv[++i]));
+        } else if (arg[0] != '-' && !opt.recordingPath) {
+            opt.recordingPath = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return opt.recordingPath != nullptr;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s <recording.mcfr> [--iterations N] [--step N]\n", argv[0]);
+        return 1;
+    }
+
+    RecordingHeader header;
+    std::vector<std::vector<uint8_t>> frames;
+    if (!loadFrames(opt.recordingPath, header, frames)) return 1;
+    if (header.width < MV_PLANE_WIDTH || header.height < MV_PLANE_HEIGHT) {
+        fprintf(stderr, "Frames smaller than the %dx%d motion plane\n", MV_PLANE_WIDTH, MV_PLANE_HEIGHT);
+        return 1;
+    }
+
+    parallelRunner.begin(PARALLEL_HELPER_CORE);
+    parallelRunner.setEnabled(false);
+    PassResult single = runPass(header, frames, opt);
+    parallelRunner.setEnabled(true);
+    PassResult dual = runPass(header, frames, opt);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < single.outputs.size(); i++) {
+        const FrameOutput& a = single.outputs[i];
+        const FrameOutput& b = dual.outputs[i];
+        if (a.score != b.score || a.hash != b.hash || a.sharpness != b.sharpness ||
+            memcmp(a.vectors, b.vectors, sizeof(a.vectors)) != 0) {
+            if (mismatches++ < 5) {
+                printf("frame %zu differs: score %u/%u hash %016llx/%016llx sharpness %u/%u\n", i, a.score,
+                       b.score, (unsigned long long)a.hash, (unsigned long long)b.hash, a.sharpness,
+                       b.sharpness);
+            }
+        }
+    }
+
+    printf("%zu frames %ux%u, %d iterations, sharpness step %d\n", frames.size(), header.width, header.height,
+           opt.iterations, opt.step);
+    printf("%-22s %10s %10s %8s\n", "stage", "1 core", "2 cores", "speedup");
+    double totalSingle = 0, totalDual = 0;
+    for (int s = 0; s < STAGES; s++) {
+        printf("%-22s %8.1f us %8.1f us %7.2fx\n", STAGE_NAMES[s], single.stageUs[s], dual.stageUs[s],
+               single.stageUs[s] / dual.stageUs[s]);
+        totalSingle += single.stageUs[s];
+        totalDual += dual.stageUs[s];
+    }
+    printf("%-22s %8.1f us %8.1f us %7.2fx\n", "total", totalSingle, totalDual, totalSingle / totalDual);
+
+    ParallelStats stats = parallelRunner.getStats();
+    printf("Helper share %.1f%% of %u items; helper joined %u of %u runs; outputs %s (%zu of %zu frames differ)\n",
+           stats.items ? 100.0 * stats.helperItems / stats.items : 0.0, stats.items, stats.runs,
+           stats.runs + stats.soloRuns, mismatches ? "DIFFER" : "identical", mismatches, single.outputs.size());
+    return mismatches ? 1 : 0;
+}
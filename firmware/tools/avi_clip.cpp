@@ -0,0 +1,347 @@
+// AviWriter 主机验证：把 .mcfr 录制文件按事件短片的方式（缩小到 CLIP_WIDTH、JPEG 编码、流式写入）
+// 生成 MJPEG AVI，再独立解析输出文件检查 RIFF 结构、idx1 索引与帧数据一致，并逐帧用 libjpeg 解码
+// PATH 中有 ffprobe 时再用它读出编码格式、尺寸和实际帧数，确认标准播放器能打开
+//
+// 用法:
+//   avi_clip <recording.mcfr> <out.avi> [--width N] [--quality N] [--interval-ms N]
+//            [--max-frames N] [--max-bytes N] [--event-ms N]
+//
+// --quality 为 libjpeg 质量（1-100，默认 60，约相当于 CLIP_JPEG_QUALITY 20）
+// --interval-ms 为最短帧间隔，录制文件按每帧 1 个间隔计时（默认 CLIP_FRAME_INTERVAL_MS）
+// --event-ms 为事件时长（默认 EVENT_MAX_DURATION_MS），帧间隔与设备一样按字节上限摊到该时长内
+//
+// 构建: tools/build_host.sh（需要 libjpeg 开发包）
+
+#include "config.h"
+#include "avi_writer.h"
+#include "image_scaler.h"
+#include "frame_recording.h"
+#include <esp_camera.h>
+#include <jpeglib.h>
+#include <setjmp.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct Options {
+    const char* recordingPath = nullptr;
+    const char* outPath = nullptr;
+    int width = CLIP_WIDTH;
+    int quality = 60;
+    uint32_t intervalMs = CLIP_FRAME_INTERVAL_MS;
+    int maxFrames = CLIP_MAX_FRAMES;
+    uint32_t maxBytes = CLIP_MAX_BYTES;
+    uint32_t eventMs = EVENT_MAX_DURATION_MS;
+};
+
+// 普通文件输出，writeAt 之后回到末尾
+class FileSink : public AviSink {
+public:
+    FILE* f = nullptr;
+    size_t writes = 0;
+    size_t largestWrite = 0;
+
+    bool write(const uint8_t* data, size_t length) override {
+        writes++;
+        if (length > largestWrite) largestWrite = length;
+        return fwrite(data, 1, length, f) == length;
+    }
+    bool writeAt(uint32_t offset, const uint8_t* data, size_t length) override {
+        long end = ftell(f);
+        bool ok = fseek(f, offset, SEEK_SET) == 0 && fwrite(data, 1, length, f) == length;
+        return fseek(f, end, SEEK_SET) == 0 && ok;
+    }
+};
+
+// RGB565（大端，与传感器输出一致）编码为 JPEG
+static std::vector<uint8_t> encodeJpeg(const uint8_t* rgb565, int width, int height, int quality) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char* out = nullptr;
+    unsigned long outSize = 0;
+    jpeg_mem_dest(&cinfo, &out, &outSize);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    std::vector<uint8_t> row(width * 3);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        const uint8_t* src = rgb565 + (size_t)cinfo.next_scanline * width * 2;
+        for (int x = 0; x < width; x++) {
+            uint16_t p = (src[x * 2] << 8) | src[x * 2 + 1];
+            row[x * 3] = ((p >> 11) & 0x1F) << 3;
+            row[x * 3 + 1] = ((p >> 5) & 0x3F) << 2;
+            row[x * 3 + 2] = (p & 0x1F) << 3;
+        }
+        JSAMPROW rows[1] = {row.data()};
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    std::vector<uint8_t> jpeg(out, out + outSize);
+    free(out);
+    return jpeg;
+}
+
+// libjpeg 出错时默认直接退出进程，这里跳回调用处只报告失败
+struct DecodeError {
+    jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+
+static void onDecodeError(j_common_ptr cinfo) {
+    longjmp(((DecodeError*)cinfo->err)->jump, 1);
+}
+
+static bool decodeJpeg(const uint8_t* data, size_t length, int& width, int& height) {
+    jpeg_decompress_struct cinfo;
+    DecodeError err;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = onDecodeError;
+    err.mgr.emit_message = [](j_common_ptr, int) {};
+    jpeg_create_decompress(&cinfo);
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_mem_src(&cinfo, data, length);
+    jpeg_read_header(&cinfo, TRUE);
+    jpeg_start_decompress(&cinfo);
+    std::vector<uint8_t> row(cinfo.output_width * cinfo.output_components);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW rows[1] = {row.data()};
+        jpeg_read_scanlines(&cinfo, rows, 1);
+    }
+    width = cinfo.output_width;
+    height = cinfo.output_height;
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool fail(const char* message) {
+    printf("FAIL: %s\n", message);
+    return false;
+}
+
+// 独立于 AviWriter 遍历 RIFF 块，检查各级长度、索引和帧数据
+static bool verifyAvi(const std::vector<uint8_t>& file, uint32_t expectFrames, int expectWidth, int expectHeight) {
+    size_t size = file.size();
+    const uint8_t* d = file.data();
+    if (size < AviWriter::HEADER_BYTES + 8) return fail("file too short");
+    if (memcmp(d, "RIFF", 4) != 0 || memcmp(d + 8, "AVI ", 4) != 0) return fail("not a RIFF AVI");
+    if (le32(d + 4) != size - 8) return fail("RIFF size does not match file size");
+
+    AviFileInfo info;
+    if (!AviWriter::parseHeader(d, size, info)) return fail("header not recognised");
+    if (info.frames != expectFrames) return fail("avih frame count");
+    if (info.width != expectWidth || info.height != expectHeight) return fail("avih dimensions");
+
+    // 顶层块：LIST hdrl, LIST movi, idx1
+    size_t moviStart = 0, moviEnd = 0, idxStart = 0, idxSize = 0;
+    for (size_t pos = 12; pos + 8 <= size;) {
+        uint32_t chunkSize = le32(d + pos + 4);
+        if (pos + 8 + chunkSize > size) return fail("chunk runs past end of file");
+        if (memcmp(d + pos, "LIST", 4) == 0 && memcmp(d + pos + 8, "movi", 4) == 0) {
+            moviStart = pos + 8;
+            moviEnd = pos + 8 + chunkSize;
+        } else if (memcmp(d + pos, "idx1", 4) == 0) {
+            idxStart = pos + 8;
+            idxSize = chunkSize;
+        }
+        pos += 8 + ((chunkSize + 1) & ~1u);
+    }
+    if (!moviStart) return fail("no movi list");
+    if (!idxStart) return fail("no idx1 index");
+    if (idxSize != expectFrames * 16) return fail("idx1 entry count");
+
+    // movi 中的帧块与索引逐项对照，偏移相对 'movi' 标识
+    size_t chunkPos = moviStart + 4;
+    size_t padded = 0;
+    for (uint32_t i = 0; i < expectFrames; i++) {
+        const uint8_t* e = d + idxStart + i * 16;
+        uint32_t offset = le32(e + 8);
+        uint32_t length = le32(e + 12);
+        if (memcmp(e, "00dc", 4) != 0 || !(le32(e + 4) & 0x10)) return fail("idx1 entry id/flags");
+        if (moviStart + offset != chunkPos) return fail("idx1 offset does not point at the next chunk");
+        if (memcmp(d + chunkPos, "00dc", 4) != 0 || le32(d + chunkPos + 4) != length) {
+            return fail("frame chunk header does not match index");
+        }
+        const uint8_t* jpeg = d + chunkPos + 8;
+        if (length < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8 || jpeg[length - 2] != 0xFF || jpeg[length - 1] != 0xD9) {
+            return fail("frame is not a complete JPEG");
+        }
+        int w = 0, h = 0;
+        if (!decodeJpeg(jpeg, length, w, h) || w != expectWidth || h != expectHeight) {
+            printf("frame %u: ", i);
+            return fail("frame does not decode to the clip size");
+        }
+        if (length & 1) padded++;
+        chunkPos += 8 + ((length + 1) & ~1u);
+    }
+    if (chunkPos != moviEnd) return fail("movi list size does not match frame chunks");
+
+    printf("RIFF structure OK: %u frames indexed and decoded, %zu odd-length frames padded\n",
+           expectFrames, padded);
+    return true;
+}
+
+static bool runFfprobe(const char* path, uint32_t expectFrames, int expectWidth, int expectHeight) {
+    if (system("command -v ffprobe >/dev/null 2>&1") != 0) {
+        printf("ffprobe not found, skipping player check\n");
+        return true;
+    }
+    std::string cmd = std::string("ffprobe -v error -count_frames -select_streams v:0 "
+                                  "-show_entries stream=codec_name,width,height,nb_read_frames -of csv=p=0 '") +
+                      path + "'";
+    FILE* p = popen(cmd.c_str(), "r");
+    if (!p) return fail("cannot run ffprobe");
+    char line[128] = {};
+    bool got = fgets(line, sizeof(line), p) != nullptr;
+    pclose(p);
+    line[strcspn(line, "\r\n")] = 0;
+    printf("ffprobe: %s\n", line);
+
+    char expect[128];
+    snprintf(expect, sizeof(expect), "mjpeg,%d,%d,%u", expectWidth, expectHeight, expectFrames);
+    if (!got || strcmp(line, expect) != 0) return fail("ffprobe output differs from expected");
+    return true;
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--width" && hasValue) opt.width = atoi(argv[++i]);
+        else if (arg == "--quality" && hasValue) opt.quality = atoi(argv[++i]);
+        else if (arg == "--interval-ms" && hasValue) opt.intervalMs = atoi(argv[++i]);
+        else if (arg == "--max-frames" && hasValue) opt.maxFrames = atoi(argv[++i]);
+        else if (arg == "--max-bytes" && hasValue) opt.maxBytes = atoi(argv[++i]);
+        else if (arg == "--event-ms" && hasValue) opt.eventMs = atoi(argv[++i]);
+        else if (arg[0] != '-' && !opt.recordingPath) opt.recordingPath = argv[i];
+        else if (arg[0] != '-' && !opt.outPath) opt.outPath = argv[i];
+        else return false;
+    }
+    return opt.recordingPath && opt.outPath && opt.width > 0 && opt.maxFrames > 0 && opt.intervalMs > 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s <recording.mcfr> <out.avi> [--width N] [--quality N] [--interval-ms N]"
+                        " [--max-frames N] [--max-bytes N] [--event-ms N]\n", argv[0]);
+        return 2;
+    }
+
+    FILE* in = fopen(opt.recordingPath, "rb");
+    RecordingHeader header;
+    if (!in || fread(&header, sizeof(header), 1, in) != 1 || !isValidRecordingHeader(header) ||
+        header.pixformat != PIXFORMAT_RGB565) {
+        fprintf(stderr, "Not an RGB565 .mcfr recording: %s\n", opt.recordingPath);
+        return 1;
+    }
+
+    CropRect full(0, 0, header.width, header.height);
+    int outWidth = opt.width;
+    int outHeight = 0;
+    ImageScaler::fitOutputSize(full, outWidth, outHeight);
+    std::vector<uint8_t> scaled((size_t)outWidth * outHeight * 2);
+    std::vector<uint32_t> scratch(ImageScaler::scratchSize(outWidth) / sizeof(uint32_t));
+
+    FileSink sink;
+    sink.f = fopen(opt.outPath, "w+b");
+    if (!sink.f) {
+        fprintf(stderr, "Cannot create %s\n", opt.outPath);
+        return 1;
+    }
+    std::vector<AviIndexEntry> index(opt.maxFrames);
+    AviWriter writer;
+    if (!writer.begin(&sink, outWidth, outHeight, index.data(), opt.maxFrames)) {
+        fprintf(stderr, "Cannot write AVI header\n");
+        return 1;
+    }
+
+    // 帧逐个读入、编码、写出，不保留之前的帧
+    printf("%s: %ux%u, %u frames -> %dx%d, quality %d, %u ms per recorded frame, %u ms event\n",
+           opt.recordingPath, header.width, header.height, header.frameCount, outWidth, outHeight,
+           opt.quality, (unsigned)opt.intervalMs, (unsigned)opt.eventMs);
+    fseek(in, header.headerSize, SEEK_SET);
+    std::vector<uint8_t> pixels;
+    size_t jpegBytes = 0;
+    bool truncated = false;
+    uint32_t nextDueMs = 0;
+    uint32_t firstMs = 0;
+    uint32_t lastMs = 0;
+    for (uint32_t i = 0; i < header.frameCount; i++) {
+        uint32_t now = i * opt.intervalMs;
+        if (now >= opt.eventMs) break;
+        RecordingFrameHeader fh;
+        if (fread(&fh, sizeof(fh), 1, in) != 1) break;
+        pixels.resize(fh.length);
+        if (fread(pixels.data(), 1, fh.length, in) != fh.length) break;
+        if (now < nextDueMs || fh.length < (size_t)header.width * header.height * 2) continue;
+
+        ImageScaler::scaleRGB565(pixels.data(), header.width, full, scaled.data(), outWidth, outHeight,
+                                 scratch.data());
+        std::vector<uint8_t> jpeg = encodeJpeg(scaled.data(), outWidth, outHeight, opt.quality);
+        if (writer.isFull() || writer.sizeWith(jpeg.size()) > opt.maxBytes) {
+            truncated = true;
+            break;
+        }
+        if (!writer.addFrame(jpeg.data(), jpeg.size())) {
+            fprintf(stderr, "Write failed at frame %u\n", i);
+            return 1;
+        }
+        jpegBytes += jpeg.size();
+        if (writer.getFrames() == 1) firstMs = now;
+        lastMs = now;
+        nextDueMs = now + writer.spreadInterval(opt.maxBytes, opt.eventMs - now, opt.intervalMs);
+    }
+    fclose(in);
+
+    uint32_t frames = writer.getFrames();
+    if (frames == 0) {
+        fprintf(stderr, "No frames written\n");
+        return 1;
+    }
+    uint32_t predicted = writer.sizeWith(0) - 8 - 16;   // sizeWith 含下一帧的块头和索引项
+    // 与设备相同，帧间隔取实际平均值
+    uint32_t usPerFrame = frames > 1 ? (lastMs - firstMs) * 1000 / (frames - 1) : opt.intervalMs * 1000;
+    if (!writer.finish(usPerFrame)) {
+        fprintf(stderr, "Cannot finish AVI\n");
+        return 1;
+    }
+    long fileSize = ftell(sink.f);
+    fclose(sink.f);
+
+    printf("Clip: %u frames%s, %ld bytes (JPEG %zu, container %ld), %.1f s at %.2f fps\n", frames,
+           truncated ? " (limit reached)" : "", fileSize, jpegBytes, fileSize - (long)jpegBytes,
+           frames * usPerFrame / 1e6, 1e6 / usPerFrame);
+    printf("Writer memory: %zu bytes index, largest single write %zu bytes over %zu writes\n",
+           frames * sizeof(AviIndexEntry), sink.largestWrite, sink.writes);
+
+    bool ok = true;
+    if ((long)predicted != fileSize) ok = fail("sizeWith() did not predict the final size");
+
+    std::vector<uint8_t> file(fileSize);
+    FILE* f = fopen(opt.outPath, "rb");
+    ok = f && fread(file.data(), 1, file.size(), f) == file.size() && ok;
+    if (f) fclose(f);
+    ok = verifyAvi(file, frames, outWidth, outHeight) && ok;
+    ok = runFfprobe(opt.outPath, frames, outWidth, outHeight) && ok;
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+// 实时预览与后台上传的带宽仲裁对照：毫秒步进的链路仿真，分别关闭和打开 BandwidthArbiter 运行同一场景
+// - 链路按毫秒向两个 TCP 发送缓冲区平分容量（一方空闲时另一方用满），中途容量下降
+// - 实时流：观看期间按帧率产生固定大小的帧，写入发送缓冲区时 recordLive，帧最后一个字节发出即送达
+// - 后台上传：持续按 BW_BUCKET_BYTES 切片，写入前 reserve（与 BandwidthArbiter::pace 相同的轮询等待），
+//   写完后 recordBackground 带上阻塞在发送缓冲区上的时间
+// 输出实时帧延迟 p50/p95/max、观看开始后第一秒内的最大帧延迟、观看期间和空闲期间的后台吞吐
+//
+// 用法:
+//   bandwidth_bench [--link KBps] [--drop KBps] [--frame KB] [--fps N] [--sndbuf B]
+//
+// 构建: tools/build_host.sh
+
+#include "bandwidth_arbiter.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+struct Options {
+    uint32_t linkBps = 160 * 1024;
+    uint32_t dropBps = 100 * 1024;
+    uint32_t frameBytes = 20 * 1024;
+    uint32_t fps = 3;
+    uint32_t sndbuf = 5744;        // lwIP TCP_SND_BUF（4 * MSS）
+};
+
+// 场景时间线（毫秒）
+static const uint32_t VIEWER_START_MS = 10000;
+static const uint32_t LINK_DROP_MS = 25000;
+static const uint32_t VIEWER_END_MS = 40000;
+static const uint32_t END_MS = 50000;
+
+struct Frame {
+    uint32_t createdMs;
+    uint64_t endOffset;            // 帧最后一个字节在实时流中的累计偏移
+};
+
+struct Result {
+    std::vector<uint32_t> latencies;
+    uint64_t backgroundViewing = 0;
+    uint64_t backgroundIdle = 0;
+    uint32_t firstSecondMaxMs = 0; // 观看开始后第一秒内产生的帧的最大延迟，反映后台降速快慢
+    BandwidthStats stats;
+};
+
+static uint32_t percentile(std::vector<uint32_t> values, int pct) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, values.size() * pct / 100);
+    return values[index];
+}
+
+static Result run(const Options& opts, bool enabled) {
+    BandwidthArbiter arbiter;
+    arbiter.setEnabled(enabled);
+    Result result = {};
+
+    uint32_t liveQueued = 0, liveBuf = 0;
+    uint64_t liveDelivered = 0, liveWritten = 0;
+    std::deque<Frame> frames;
+
+    uint32_t bgBuf = 0, bgSlice = 0, bgWakeMs = 0, bgSliceStart = 0;
+    uint32_t frameInterval = 1000 / opts.fps;
+
+    for (uint32_t now = 0; now < END_MS; now++) {
+        bool viewing = now >= VIEWER_START_MS && now < VIEWER_END_MS;
+        uint32_t capacity = now < LINK_DROP_MS ? opts.linkBps : opts.dropBps;
+
+        // 实时流：每帧一次观看者活动，帧数据尽量写入发送缓冲区
+        if (viewing && (now - VIEWER_START_MS) % frameInterval == 0) {
+            arbiter.noteViewer(now);
+            liveQueued += opts.frameBytes;
+            frames.push_back({now, liveWritten + liveQueued});
+        }
+        if (liveQueued && liveBuf < opts.sndbuf) {
+            uint32_t n = std::min(liveQueued, opts.sndbuf - liveBuf);
+            liveQueued -= n;
+            liveBuf += n;
+            liveWritten += n;
+            arbiter.recordLive(n, now);
+        }
+
+        // 后台：取到令牌后开始一个切片，写满发送缓冲区即阻塞
+        if (!bgSlice && now >= bgWakeMs) {
+            uint32_t wait = arbiter.reserve(BW_BUCKET_BYTES, now);
+            if (wait) {
+                bgWakeMs = now + std::min<uint32_t>(wait, BW_PACE_POLL_MS);
+            } else {
+                bgSlice = BW_BUCKET_BYTES;
+                bgSliceStart = now;
+            }
+        }
+        if (bgSlice && bgBuf < opts.sndbuf) {
+            uint32_t n = std::min(bgSlice, opts.sndbuf - bgBuf);
+            bgSlice -= n;
+            bgBuf += n;
+            if (!bgSlice) {
+                arbiter.recordBackground(BW_BUCKET_BYTES, (now - bgSliceStart) * 1000, now);
+            }
+        }
+
+        // 链路本毫秒的容量在两个发送缓冲区之间平分，一方用不完的给另一方
+        uint32_t budget = capacity / 1000;
+        uint32_t liveShare = std::min(liveBuf, bgBuf ? budget / 2 : budget);
+        uint32_t bgShare = std::min(bgBuf, budget - liveShare);
+        liveShare = std::min(liveBuf, budget - bgShare);
+        liveBuf -= liveShare;
+        bgBuf -= bgShare;
+        liveDelivered += liveShare;
+        (viewing ? result.backgroundViewing : result.backgroundIdle) += bgShare;
+
+        while (!frames.empty() && liveDelivered >= frames.front().endOffset) {
+            uint32_t latency = now + 1 - frames.front().createdMs;
+            result.latencies.push_back(latency);
+            if (frames.front().createdMs < VIEWER_START_MS + 1000) {
+                result.firstSecondMaxMs = std::max(result.firstSecondMaxMs, latency);
+            }
+            frames.pop_front();
+        }
+    }
+    result.stats = arbiter.getStats(END_MS);
+    return result;
+}
+
+static void report(const char* name, const Result& r) {
+    uint32_t viewingS = (VIEWER_END_MS - VIEWER_START_MS) / 1000;
+    uint32_t idleS = (END_MS - (VIEWER_END_MS - VIEWER_START_MS)) / 1000;
+    printf("%-9s live p50 %5u ms  p95 %5u ms  max %5u ms | background viewing %4.1f KB/s  idle %5.1f KB/s"
+           " | first second max %5u ms | congestions %u\n",
+           name, percentile(r.latencies, 50), percentile(r.latencies, 95), percentile(r.latencies, 100),
+           r.backgroundViewing / 1024.0 / viewingS, r.backgroundIdle / 1024.0 / idleS, r.firstSecondMaxMs,
+           r.stats.congestions);
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return 1;
+        }
+        if (strcmp(arg, "--link") == 0) opts.linkBps = atoi(value) * 1024;
+        else if (strcmp(arg, "--drop") == 0) opts.dropBps = atoi(value) * 1024;
+        else if (strcmp(arg, "--frame") == 0) opts.frameBytes = atoi(value) * 1024;
+        else if (strcmp(arg, "--fps") == 0) opts.fps = atoi(value);
+        else if (strcmp(arg, "--sndbuf") == 0) opts.sndbuf = atoi(value);
+        else {
+            fprintf(stderr, "Unknown option %s\n", arg);
+            return 1;
+        }
+        i++;
+    }
+    if (!opts.fps || opts.fps > 30 || opts.frameBytes * opts.fps >= opts.linkBps || opts.sndbuf == 0) {
+        fprintf(stderr, "Live stream must fit in --link (frame * fps < link)\n");
+        return 1;
+    }
+
+    printf("link %u KB/s -> %u KB/s at %us, live %u KB x %u fps while viewing %us-%us\n",
+           opts.linkBps / 1024, opts.dropBps / 1024, LINK_DROP_MS / 1000, opts.frameBytes / 1024, opts.fps,
+           VIEWER_START_MS / 1000, VIEWER_END_MS / 1000);
+    report("disabled", run(opts, false));
+    report("enabled", run(opts, true));
+    return 0;
+}
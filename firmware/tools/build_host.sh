@@ -0,0 +1,99 @@
+#!/bin/bash
+# 构建主机端离线工具（Linux/macOS，需要 g++ 或 clang++）
+# 用法: tools/build_host.sh [输出目录，默认 tools/bin]
+
+set -e
+
+cd "$(dirname "$0")/.."
+
+CXX=${CXX:-g++}
+OUT=${1:-tools/bin}
+CXXFLAGS="-std=gnu++17 -O2 -Wall -Itools/host -Iinclude -Isrc"
+HOST_RUNTIME="tools/host/host_runtime.cpp"
+# 分析内核经 ParallelRunner 分段执行，主机端用 std::thread 实现
+HOST_PARALLEL="tools/host/host_parallel.cpp"
+
+mkdir -p "$OUT"
+
+echo "Building motion_replay..."
+$CXX $CXXFLAGS -pthread -o "$OUT/motion_replay" \
+    tools/motion_replay.cpp src/motion_detector.cpp src/jpeg_dc.cpp src/jpeg_tables.cpp src/image_scaler.cpp \
+    src/frame_dedup.cpp src/motion_estimator.cpp src/motion_event.cpp $HOST_PARALLEL $HOST_RUNTIME
+
+echo "Building analysis_bench..."
+$CXX $CXXFLAGS -pthread -o "$OUT/analysis_bench" \
+    tools/analysis_bench.cpp src/motion_detector.cpp src/jpeg_dc.cpp src/jpeg_tables.cpp src/image_scaler.cpp \
+    src/motion_estimator.cpp src/burst_selector.cpp src/buffer_pool.cpp src/logger.cpp \
+    $HOST_PARALLEL $HOST_RUNTIME
+
+# 需要 OpenSSL 开发包（libssl-dev）
+if echo '#include <openssl/ssl.h>' | $CXX -E -x c++ - >/dev/null 2>&1; then
+    HAVE_SSL=1
+    echo "Building https_pool_bench..."
+    $CXX $CXXFLAGS -pthread -o "$OUT/https_pool_bench" \
+        tools/https_pool_bench.cpp src/https_pool.cpp src/logger.cpp \
+        tools/host/tls_transport_openssl.cpp $HOST_RUNTIME -lssl -lcrypto
+else
+    echo "Skipping https_pool_bench: OpenSSL headers not found"
+fi
+
+# 需要 libjpeg 开发包（libjpeg-dev）
+if echo '#include <stdio.h>
+#include <jpeglib.h>' | $CXX -E -x c++ - >/dev/null 2>&1; then
+    HAVE_JPEG=1
+    echo "Building rtsp_replay..."
+    $CXX $CXXFLAGS -o "$OUT/rtsp_replay" \
+        tools/rtsp_replay.cpp src/rtsp_server.cpp src/bandwidth_arbiter.cpp src/rtp_jpeg.cpp src/jpeg_tables.cpp src/logger.cpp \
+        $HOST_RUNTIME -ljpeg
+    echo "Building jpeg_dc_bench..."
+    $CXX $CXXFLAGS -pthread -o "$OUT/jpeg_dc_bench" \
+        tools/jpeg_dc_bench.cpp src/jpeg_dc.cpp src/jpeg_tables.cpp src/motion_detector.cpp src/image_scaler.cpp \
+        $HOST_PARALLEL $HOST_RUNTIME -ljpeg
+    echo "Building avi_clip..."
+    $CXX $CXXFLAGS -o "$OUT/avi_clip" \
+        tools/avi_clip.cpp src/avi_writer.cpp src/image_scaler.cpp $HOST_RUNTIME -ljpeg
+else
+    echo "Skipping rtsp_replay, jpeg_dc_bench, avi_clip: libjpeg headers not found"
+fi
+
+echo "Building bandwidth_bench..."
+$CXX $CXXFLAGS -o "$OUT/bandwidth_bench" tools/bandwidth_bench.cpp src/bandwidth_arbiter.cpp $HOST_RUNTIME
+
+# LittleFS 对照：littlefs 源码随仓库放在 tools/third_party/littlefs（固定 v2.5.1，不联网），
+# 版本不符时构建失败；目录中没有源码时 ring_store_bench 不带对照，并在运行时注明
+LFS_DIR=tools/third_party/littlefs
+LFS_VERSION_CODE=0x00020005
+LFS_FLAGS=""
+if [ -f "$LFS_DIR/lfs.c" ]; then
+    if ! grep -q "define LFS_VERSION $LFS_VERSION_CODE" "$LFS_DIR/lfs.h"; then
+        echo "error: $LFS_DIR is not littlefs $LFS_VERSION_CODE (see $LFS_DIR/README.md)" >&2
+        exit 1
+    fi
+    ${CC:-gcc} -O2 -I"$LFS_DIR" -DLFS_NO_DEBUG -c -o "$OUT/lfs.o" "$LFS_DIR/lfs.c"
+    ${CC:-gcc} -O2 -I"$LFS_DIR" -c -o "$OUT/lfs_util.o" "$LFS_DIR/lfs_util.c"
+    LFS_FLAGS="-DHAVE_LITTLEFS -I$LFS_DIR $OUT/lfs.o $OUT/lfs_util.o"
+else
+    echo "warning: $LFS_DIR/lfs.c missing: ring_store_bench builds WITHOUT the LittleFS comparison (see $LFS_DIR/README.md)"
+fi
+echo "Building ring_store_bench..."
+$CXX $CXXFLAGS -o "$OUT/ring_store_bench" tools/ring_store_bench.cpp src/ring_store.cpp src/logger.cpp \
+    tools/host/host_partition.cpp $HOST_RUNTIME $LFS_FLAGS
+
+echo "Building load_gen..."
+$CXX $CXXFLAGS -pthread -o "$OUT/load_gen" tools/load_gen.cpp
+
+echo "Building frame_latency..."
+$CXX $CXXFLAGS -o "$OUT/frame_latency" tools/frame_latency.cpp
+
+# 整机仿真：固件源码链接到 tools/sim 的替身上，--wrap 接管 malloc 统计堆占用（GNU ld，仅 Linux）
+if [ "$(uname -s)" = "Linux" ] && [ -n "$HAVE_SSL" ] && [ -n "$HAVE_JPEG" ]; then
+    echo "Building firmware_sim..."
+    SIM_SOURCES=$(ls src/*.cpp tools/sim/*.cpp | grep -v tls_transport_mbedtls)
+    $CXX -std=gnu++17 -O2 -Wall -Itools/sim -Iinclude -Isrc -pthread -o "$OUT/firmware_sim" \
+        $SIM_SOURCES tools/host/tls_transport_openssl.cpp tools/host/host_partition.cpp \
+        -Wl,--wrap=malloc,--wrap=free,--wrap=calloc,--wrap=realloc,--wrap=bind -lssl -lcrypto -ljpeg
+else
+    echo "Skipping firmware_sim: needs Linux, OpenSSL and libjpeg headers"
+fi
+
+echo "Done: $OUT"
@@ -0,0 +1,318 @@
+// 帧延迟探针：按间隔拉取 /stream（或 /snapshot），读取设备写入的帧时间戳响应头，
+// 报告各阶段延迟的 p50/p90/p99，并附上设备端 /api/latency 的直方图
+//
+// 用法:
+//   frame_latency [--host H] [--port N] [--path P] [--count N] [--interval-ms N]
+//                 [--timeout-ms N] [--reset]
+//
+// 设备端阶段来自 Server-Timing 响应头：capture（驱动队列）、analysis（运动检测）、
+// wait（帧等待请求）、encode（BMP 拷贝/缩放/JPEG 编码）
+// 主机端阶段：ttfb（请求发出到收到第一个字节）、download（第一个字节到最后一个字节）
+// 发送阶段（first_byte、send、total）只能在设备上测量，取自 /api/latency
+// X-Frame-Seq 用于统计重复帧（同一帧被连续拉到）和跳过的帧
+// --reset 先清空设备端直方图，只统计本次运行
+//
+// 构建: tools/build_host.sh
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options {
+    const char* host = "127.0.0.1";
+    uint16_t port = 80;
+    const char* path = "/stream";
+    uint32_t count = 100;
+    uint32_t intervalMs = 333;
+    uint32_t timeoutMs = 10000;
+    bool reset = false;
+};
+
+static Options options;
+
+typedef std::chrono::steady_clock Clock;
+
+static double msBetween(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// ---- HTTP ----
+
+struct Response {
+    int status = 0;              // 0 表示连接或传输失败
+    std::string head;
+    std::string body;
+    double ttfbMs = 0;
+    double downloadMs = 0;
+};
+
+static int connectTo() {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    char portStr[8];
+    snprintf(portStr, sizeof(portStr), "%u", options.port);
+    if (getaddrinfo(options.host, portStr, &hints, &res) != 0 || !res) return -1;
+
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd >= 0) {
+        timeval tv = {(time_t)(options.timeoutMs / 1000), (suseconds_t)(options.timeoutMs % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+static Response httpRequest(const char* method, const char* path, bool keepBody) {
+    Response result;
+    int fd = connectTo();
+    if (fd < 0) return result;
+
+    std::string request = std::string(method) + " " + path + " HTTP/1.1\r\nHost: " + options.host +
+                          "\r\nConnection: close\r\n\r\n";
+    Clock::time_point sent = Clock::now();
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) {
+        close(fd);
+        return result;
+    }
+
+    // 帧响应体只计数，不保留
+    std::string data;
+    size_t headEnd = std::string::npos;
+    size_t received = 0;
+    Clock::time_point firstByte;
+    char buffer[16384];
+    bool ok = true;
+    while (true) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n == 0) break;
+        if (n < 0) {
+            ok = false;
+            break;
+        }
+        if (received == 0) firstByte = Clock::now();
+        received += n;
+        if (keepBody || headEnd == std::string::npos) {
+            data.append(buffer, n);
+            if (headEnd == std::string::npos) headEnd = data.find("\r\n\r\n");
+        }
+    }
+    Clock::time_point last = Clock::now();
+    close(fd);
+
+    if (!ok || headEnd == std::string::npos) return result;
+    if (sscanf(data.c_str(), "HTTP/1.%*d %d", &result.status) != 1) {
+        result.status = 0;
+        return result;
+    }
+    result.head = data.substr(0, headEnd + 2);
+    if (keepBody) result.body = data.substr(headEnd + 4);
+    result.ttfbMs = msBetween(sent, firstByte);
+    result.downloadMs = msBetween(firstByte, last);
+    return result;
+}
+
+// 取响应头的值（不区分大小写），不存在时返回空串
+static std::string header(const std::string& head, const char* name) {
+    std::string key = std::string("\r\n") + name + ":";
+    const char* pos = strcasestr(head.c_str(), key.c_str());
+    if (!pos) return "";
+    pos += key.size();
+    while (*pos == ' ') pos++;
+    const char* end = strstr(pos, "\r\n");
+    return std::string(pos, end ? end - pos : strlen(pos));
+}
+
+// ---- 统计 ----
+
+static const char* const DEVICE_STAGES[] = {"capture", "analysis", "wait", "encode"};
+static const int DEVICE_STAGE_COUNT = sizeof(DEVICE_STAGES) / sizeof(DEVICE_STAGES[0]);
+
+struct Samples {
+    std::vector<double> device[DEVICE_STAGE_COUNT];
+    std::vector<double> ttfb;
+    std::vector<double> download;
+    uint32_t responses = 0;
+    uint32_t failures = 0;
+    uint32_t untraced = 0;        // 没有帧时间戳响应头
+    uint32_t repeated = 0;        // 与上一次响应是同一帧
+    uint32_t skipped = 0;         // 两次响应之间未被拉到的帧
+};
+
+// Server-Timing: "capture;dur=1.234, analysis;dur=0.456, ..."
+static void parseServerTiming(const std::string& value, Samples& samples) {
+    size_t pos = 0;
+    while (pos < value.size()) {
+        size_t end = value.find(',', pos);
+        if (end == std::string::npos) end = value.size();
+        std::string entry = value.substr(pos, end - pos);
+        pos = end + 1;
+
+        size_t start = entry.find_first_not_of(' ');
+        if (start == std::string::npos) continue;
+        size_t semi = entry.find(';', start);
+        size_t dur = entry.find("dur=", start);
+        if (semi == std::string::npos || dur == std::string::npos) continue;
+        std::string name = entry.substr(start, semi - start);
+        double ms = atof(entry.c_str() + dur + 4);
+        for (int i = 0; i < DEVICE_STAGE_COUNT; i++) {
+            if (name == DEVICE_STAGES[i]) samples.device[i].push_back(ms);
+        }
+    }
+}
+
+static double percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void printRow(const char* name, std::vector<double>& values) {
+    if (values.empty()) {
+        printf("%-12s %8d\n", name, 0);
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    printf("%-12s %8zu %9.2f %9.2f %9.2f %9.2f\n", name, values.size(), percentile(values, 50),
+           percentile(values, 90), percentile(values, 99), values.back());
+}
+
+// ---- 设备端直方图 ----
+
+static bool jsonNumber(const std::string& text, const char* key, uint32_t& value) {
+    std::string pattern = std::string("\"") + key + "\":";
+    size_t pos = text.find(pattern);
+    if (pos == std::string::npos) return false;
+    value = strtoul(text.c_str() + pos + pattern.size(), nullptr, 10);
+    return true;
+}
+
+static void printDeviceHistograms() {
+    Response r = httpRequest("GET", "/api/latency", true);
+    if (r.status != 200) {
+        printf("\nDevice histograms: /api/latency not available\n");
+        return;
+    }
+    printf("\nDevice histograms (/api/latency, bucket upper bounds)\n");
+    printf("%-12s %8s %9s %9s %9s %9s\n", "stage", "count", "p50 ms", "p90 ms", "p99 ms", "max ms");
+    size_t pos = 0;
+    while ((pos = r.body.find("{\"stage\":\"", pos)) != std::string::npos) {
+        size_t nameStart = pos + 10;
+        size_t nameEnd = r.body.find('"', nameStart);
+        size_t objectEnd = r.body.find('}', nameStart);
+        if (nameEnd == std::string::npos || objectEnd == std::string::npos) break;
+        std::string name = r.body.substr(nameStart, nameEnd - nameStart);
+        std::string object = r.body.substr(pos, objectEnd - pos);
+        uint32_t count = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;
+        jsonNumber(object, "count", count);
+        jsonNumber(object, "p50_us", p50);
+        jsonNumber(object, "p90_us", p90);
+        jsonNumber(object, "p99_us", p99);
+        jsonNumber(object, "max_us", max);
+        printf("%-12s %8u %9.2f %9.2f %9.2f %9.2f\n", name.c_str(), count, p50 / 1000.0, p90 / 1000.0,
+               p99 / 1000.0, max / 1000.0);
+        pos = objectEnd;
+    }
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [--host H] [--port N] [--path P] [--count N] [--interval-ms N]\n"
+            "          [--timeout-ms N] [--reset]\n",
+            prog);
+}
+
+static bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--reset") == 0) {
+            options.reset = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const char* value = argv[++i];
+        unsigned long n = strtoul(value, nullptr, 10);
+        if (strcmp(arg, "--host") == 0) options.host = value;
+        else if (strcmp(arg, "--port") == 0) options.port = n;
+        else if (strcmp(arg, "--path") == 0) options.path = value;
+        else if (strcmp(arg, "--count") == 0 && n > 0) options.count = n;
+        else if (strcmp(arg, "--interval-ms") == 0) options.intervalMs = n;
+        else if (strcmp(arg, "--timeout-ms") == 0 && n > 0) options.timeoutMs = n;
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseArgs(argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+    printf("Probing http://%s:%u%s: %u requests every %u ms\n", options.host, options.port, options.path,
+           options.count, options.intervalMs);
+
+    if (options.reset && httpRequest("DELETE", "/api/latency", false).status != 200) {
+        fprintf(stderr, "Warning: could not reset device histograms\n");
+    }
+
+    Samples samples;
+    bool haveSeq = false;
+    uint32_t lastSeq = 0;
+    Clock::time_point next = Clock::now();
+    for (uint32_t i = 0; i < options.count; i++) {
+        Response r = httpRequest("GET", options.path, false);
+        if (r.status != 200) {
+            samples.failures++;
+        } else {
+            samples.responses++;
+            samples.ttfb.push_back(r.ttfbMs);
+            samples.download.push_back(r.downloadMs);
+
+            std::string seq = header(r.head, "X-Frame-Seq");
+            if (seq.empty()) {
+                samples.untraced++;
+            } else {
+                uint32_t value = strtoul(seq.c_str(), nullptr, 10);
+                if (haveSeq && value == lastSeq) samples.repeated++;
+                else if (haveSeq && value > lastSeq + 1) samples.skipped += value - lastSeq - 1;
+                lastSeq = value;
+                haveSeq = true;
+                parseServerTiming(header(r.head, "Server-Timing"), samples);
+            }
+        }
+        next += std::chrono::milliseconds(options.intervalMs);
+        std::this_thread::sleep_until(next);
+    }
+
+    printf("\nresponses: %u  failures: %u  untraced: %u  repeated frames: %u  skipped frames: %u\n",
+           samples.responses, samples.failures, samples.untraced, samples.repeated, samples.skipped);
+    printf("\n%-12s %8s %9s %9s %9s %9s\n", "stage", "samples", "p50 ms", "p90 ms", "p99 ms", "max ms");
+    for (int i = 0; i < DEVICE_STAGE_COUNT; i++) {
+        printRow(DEVICE_STAGES[i], samples.device[i]);
+    }
+    printRow("ttfb", samples.ttfb);
+    printRow("download", samples.download);
+
+    printDeviceHistograms();
+    return samples.responses > 0 ? 0 : 1;
+}
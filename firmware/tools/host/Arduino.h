@@ -0,0 +1,52 @@
+#pragma once
+
+// 主机端 Arduino 最小替身，仅供 tools/ 下的离线工具编译固件模块
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    int printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void print(const char* s) { fputs(s, stdout); }
+    void println(const char* s = "") { puts(s); }
+};
+
+extern HostSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// PSRAM 分配在主机上就是 malloc（BufferPool）
+#define MALLOC_CAP_SPIRAM 0
+inline void* heap_caps_malloc(size_t size, uint32_t caps) { (void)caps; return malloc(size); }
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// 单线程工具不需要临界区
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+// 任务句柄只占位：ParallelRunner 在主机上由 host_parallel.cpp 用 std::thread 实现
+typedef int BaseType_t;
+typedef void* TaskHandle_t;
+typedef void* SemaphoreHandle_t;
+
+// 互斥量同样只占位（RingStore）
+#define portMAX_DELAY 0xffffffffUL
+#define pdTRUE 1
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { static int mutex; return &mutex; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, unsigned long) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
@@ -0,0 +1,78 @@
+#pragma once
+
+// esp_partition 替身：分区由文件模拟（NOR 闪存语义），供 tools/ 下的离线工具和整机仿真使用
+// - 擦除按 SPI_FLASH_SEC_SIZE 对齐，擦除后为 0xFF；写入只能把 1 改成 0（与已有内容按位与）
+// - esp_partition_mmap 返回文件的内存映射，与设备上经 cache 映射的读法相同
+// - 统计读写擦除字节数并按典型 SPI NOR 时序估算设备耗时，可注入掉电（写到一半失败）
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ESP_OK
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_NOT_FOUND 0x105
+#endif
+#ifndef ESP_ERR_INVALID_SIZE
+#define ESP_ERR_INVALID_SIZE 0x104
+#endif
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+// 与 ESP-IDF 一样是枚举，自定义子类型（0x40-0xFE）需要显式转换
+typedef enum {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef enum {
+    SPI_FLASH_MMAP_DATA,
+    SPI_FLASH_MMAP_INST,
+} spi_flash_mmap_memory_t;
+
+typedef uint32_t spi_flash_mmap_handle_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    bool encrypted;
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label);
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size);
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t memory, const void** outPtr,
+                             spi_flash_mmap_handle_t* outHandle);
+void spi_flash_munmap(spi_flash_mmap_handle_t handle);
+
+// ---- 主机端扩展 ----
+
+struct HostPartitionStats {
+    uint64_t bytesRead;        // esp_partition_read
+    uint64_t bytesWritten;
+    uint64_t sectorErases;
+    uint32_t dirtyWrites;      // 写入的位置有未擦除的 0 位（设备上会静默写坏数据）
+    uint64_t modeledUs;        // 按典型 SPI NOR 时序估算的设备耗时（不含 mmap 读）
+};
+
+// 注册一个数据分区，镜像文件不存在或大小不符时新建并填充 0xFF；重复注册同名分区时替换
+bool hostPartitionAdd(const char* label, esp_partition_subtype_t subtype, uint32_t size, const char* imagePath);
+HostPartitionStats hostPartitionStats(const char* label);
+void hostPartitionResetStats(const char* label);
+// 每个扇区的累计擦除次数
+const uint32_t* hostPartitionEraseCounts(const char* label);
+// 再写入 bytes 字节后模拟掉电：超出部分丢弃并返回 ESP_FAIL，之后的写入和擦除都失败，直到再次调用
+// @param bytes UINT64_MAX 表示取消
+void hostPartitionFailAfter(const char* label, uint64_t bytes);
@@ -0,0 +1,115 @@
+// ParallelRunner 的主机实现：辅助 worker 为常驻 std::thread，领取与归约方式与固件相同，
+// 离线工具可以对照测量单核/双核的分析耗时并核对结果
+// 交接用原子变量加 yield 轮询：分析内核每次只有几百微秒，条件变量的唤醒延迟在部分主机
+// （虚拟机、容器）上远大于此，测不出真实的分段开销
+#include "parallel.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+ParallelRunner parallelRunner;
+
+static std::atomic<uint32_t> generation(0);   // run 每次加一，辅助线程据此开始
+static std::atomic<uint32_t> finished(0);     // 辅助线程完成的 generation
+static std::atomic<int> claimNext(0);
+static std::mutex joinLock;                   // 保护 open/joined，与固件的 claimLock 相同
+static bool started = false;
+
+bool ParallelRunner::begin(BaseType_t helperCore) {
+    (void)helperCore;
+    if (started) return true;
+    started = true;
+    std::thread([this]() { helperLoop(); }).detach();
+    return true;
+}
+
+void ParallelRunner::run(ParallelFn fn, void* arg, int count, int grain) {
+    if (count <= 0) return;
+    if (grain < 1) grain = 1;
+
+    if (!started || !enabled || count <= grain) {
+        fn(arg, 0, 0, count);
+        stats.inlineRuns++;
+        return;
+    }
+
+    this->fn = fn;
+    this->arg = arg;
+    this->count = count;
+    this->grain = grain;
+    claimNext.store(0);
+    uint32_t current;
+    {
+        std::lock_guard<std::mutex> lock(joinLock);
+        open = true;
+        joined = false;
+        current = generation.load() + 1;
+        generation.store(current);    // 之前的写入对辅助线程可见
+    }
+
+    work(0);
+
+    bool helperJoined;
+    {
+        std::lock_guard<std::mutex> lock(joinLock);
+        open = false;
+        helperJoined = joined;
+    }
+    if (helperJoined) {
+        while (finished.load() != current) std::this_thread::yield();
+        stats.runs++;
+        stats.helperItems += helperItems;
+    } else {
+        stats.soloRuns++;
+    }
+    stats.items += count;
+}
+
+int ParallelRunner::work(uint8_t worker) {
+    int items = 0;
+    while (true) {
+        int begin = claimNext.fetch_add(grain);
+        if (begin >= count) break;
+
+        int end = min(begin + grain, count);
+        fn(arg, worker, begin, end);
+        items += end - begin;
+    }
+    return items;
+}
+
+void ParallelRunner::helperEntry(void* parameter) {
+    static_cast<ParallelRunner*>(parameter)->helperLoop();
+}
+
+void ParallelRunner::helperLoop() {
+    uint32_t seen = 0;
+    while (true) {
+        while (generation.load() == seen) std::this_thread::yield();
+
+        // generation 与 open 一起读，加入的一定是当前这一次
+        uint32_t current;
+        bool join;
+        {
+            std::lock_guard<std::mutex> lock(joinLock);
+            current = generation.load();
+            seen = current;
+            join = open;
+            if (join) joined = true;
+        }
+        if (!join) continue;
+
+        helperItems = work(1);
+        finished.store(current);
+    }
+}
+
+void ParallelRunner::setEnabled(bool value) {
+    enabled = value;
+}
+
+ParallelStats ParallelRunner::getStats() {
+    ParallelStats copy = stats;
+    copy.enabled = enabled;
+    return copy;
+}
@@ -0,0 +1,194 @@
+// esp_partition 替身的实现：分区镜像文件 mmap 到内存，按 NOR 闪存语义读写擦除
+// 固定大小的分区表，不在堆上分配（整机仿真统计堆占用）
+#include "esp_partition.h"
+#include <fcntl.h>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 典型 SPI NOR 时序（W25Q32JV 数据手册典型值，80MHz QIO 读）
+static const uint32_t PAGE_SIZE = 256;
+static const double PAGE_PROGRAM_US = 400;
+static const double SECTOR_ERASE_US = 45000;
+static const double READ_US_PER_BYTE = 1.0 / 40;
+
+static const int MAX_PARTITIONS = 4;
+static const uint32_t MAX_SECTORS = 4096;   // 16MB
+
+struct HostPartition {
+    esp_partition_t info;
+    uint8_t* data = nullptr;
+    HostPartitionStats stats;
+    uint32_t eraseCounts[MAX_SECTORS];
+    uint64_t failAfter = UINT64_MAX;
+    bool failed = false;
+};
+
+static HostPartition partitions[MAX_PARTITIONS];
+static int partitionCount = 0;
+static std::mutex lock;
+
+static HostPartition* findByLabel(const char* label) {
+    for (int i = 0; i < partitionCount; i++) {
+        if (strcmp(partitions[i].info.label, label) == 0) return &partitions[i];
+    }
+    return nullptr;
+}
+
+static HostPartition* fromInfo(const esp_partition_t* info) {
+    for (int i = 0; i < partitionCount; i++) {
+        if (&partitions[i].info == info) return &partitions[i];
+    }
+    return nullptr;
+}
+
+bool hostPartitionAdd(const char* label, esp_partition_subtype_t subtype, uint32_t size, const char* imagePath) {
+    if (size == 0 || size % SPI_FLASH_SEC_SIZE || size / SPI_FLASH_SEC_SIZE > MAX_SECTORS ||
+        strlen(label) >= sizeof(partitions[0].info.label)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    HostPartition* p = findByLabel(label);
+    if (!p) {
+        if (partitionCount == MAX_PARTITIONS) return false;
+        p = &partitions[partitionCount++];
+    } else if (p->data) {
+        munmap(p->data, p->info.size);
+        p->data = nullptr;
+    }
+
+    int fd = open(imagePath, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+    struct stat st;
+    bool fresh = fstat(fd, &st) != 0 || (uint64_t)st.st_size != size;
+    if (fresh && ftruncate(fd, size) != 0) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    *p = HostPartition();
+    p->info.type = ESP_PARTITION_TYPE_DATA;
+    p->info.subtype = subtype;
+    p->info.address = 0;
+    p->info.size = size;
+    strcpy(p->info.label, label);
+    p->data = (uint8_t*)mapped;
+    if (fresh) memset(p->data, 0xFF, size);
+    return true;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (int i = 0; i < partitionCount; i++) {
+        const esp_partition_t& info = partitions[i].info;
+        if (info.type != type) continue;
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && info.subtype != subtype) continue;
+        if (label && strcmp(info.label, label) != 0) continue;
+        return &info;
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size) {
+    HostPartition* p = fromInfo(partition);
+    if (!p || !dst || srcOffset > p->info.size || size > p->info.size - srcOffset) return ESP_ERR_INVALID_ARG;
+    memcpy(dst, p->data + srcOffset, size);
+    std::lock_guard<std::mutex> guard(lock);
+    p->stats.bytesRead += size;
+    p->stats.modeledUs += (uint64_t)(size * READ_US_PER_BYTE);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size) {
+    HostPartition* p = fromInfo(partition);
+    if (!p || !src || dstOffset > p->info.size || size > p->info.size - dstOffset) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard(lock);
+    if (p->failed) return ESP_FAIL;
+
+    // 掉电：只写入前一部分
+    size_t n = size;
+    if (p->stats.bytesWritten + size > p->failAfter) {
+        n = (size_t)(p->failAfter - p->stats.bytesWritten);
+        p->failed = true;
+    }
+
+    const uint8_t* in = (const uint8_t*)src;
+    uint8_t* out = p->data + dstOffset;
+    bool dirty = false;
+    for (size_t i = 0; i < n; i++) {
+        if (in[i] & ~out[i]) dirty = true;
+        out[i] &= in[i];
+    }
+    if (dirty) p->stats.dirtyWrites++;
+    p->stats.bytesWritten += n;
+    if (n > 0) {
+        uint32_t pages = (uint32_t)((dstOffset + n - 1) / PAGE_SIZE - dstOffset / PAGE_SIZE + 1);
+        p->stats.modeledUs += (uint64_t)(pages * PAGE_PROGRAM_US);
+    }
+    return p->failed ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    HostPartition* p = fromInfo(partition);
+    if (!p || offset > p->info.size || size > p->info.size - offset) return ESP_ERR_INVALID_ARG;
+    if (offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE) return ESP_ERR_INVALID_SIZE;
+    std::lock_guard<std::mutex> guard(lock);
+    if (p->failed) return ESP_FAIL;
+    memset(p->data + offset, 0xFF, size);
+    for (size_t s = offset / SPI_FLASH_SEC_SIZE; s < (offset + size) / SPI_FLASH_SEC_SIZE; s++) {
+        p->eraseCounts[s]++;
+        p->stats.sectorErases++;
+        p->stats.modeledUs += (uint64_t)SECTOR_ERASE_US;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t memory, const void** outPtr,
+                             spi_flash_mmap_handle_t* outHandle) {
+    (void)memory;
+    HostPartition* p = fromInfo(partition);
+    if (!p || !outPtr || offset > p->info.size || size > p->info.size - offset) return ESP_ERR_INVALID_ARG;
+    *outPtr = p->data + offset;
+    if (outHandle) *outHandle = 0;
+    return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle) {
+    (void)handle;
+}
+
+HostPartitionStats hostPartitionStats(const char* label) {
+    std::lock_guard<std::mutex> guard(lock);
+    HostPartition* p = findByLabel(label);
+    return p ? p->stats : HostPartitionStats();
+}
+
+void hostPartitionResetStats(const char* label) {
+    std::lock_guard<std::mutex> guard(lock);
+    HostPartition* p = findByLabel(label);
+    if (!p) return;
+    p->stats = HostPartitionStats();
+    memset(p->eraseCounts, 0, sizeof(p->eraseCounts));
+}
+
+const uint32_t* hostPartitionEraseCounts(const char* label) {
+    std::lock_guard<std::mutex> guard(lock);
+    HostPartition* p = findByLabel(label);
+    return p ? p->eraseCounts : nullptr;
+}
+
+void hostPartitionFailAfter(const char* label, uint64_t bytes) {
+    std::lock_guard<std::mutex> guard(lock);
+    HostPartition* p = findByLabel(label);
+    if (!p) return;
+    p->failAfter = bytes == UINT64_MAX ? UINT64_MAX : p->stats.bytesWritten + bytes;
+    p->failed = false;
+}
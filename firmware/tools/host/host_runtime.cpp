@@ -0,0 +1,31 @@
+// 主机端 Arduino 替身的实现
+#include "Arduino.h"
+#include <stdarg.h>
+#include <chrono>
+#include <thread>
+
+HostSerial Serial;
+
+static const auto startTime = std::chrono::steady_clock::now();
+
+int HostSerial::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n;
+}
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
@@ -0,0 +1,146 @@
+// 主机端 TlsTransport：OpenSSL + BSD 套接字，供 tools/ 下的工具使用
+// 与设备端 mbedTLS 2.x 一致，限定 TLS 1.2（会话票据在握手中下发）
+#include "tls_transport.h"
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+class OpenSslTransport : public TlsTransport {
+public:
+    ~OpenSslTransport() override {
+        close();
+    }
+
+    bool connect(const char* host, uint16_t port,
+                 const uint8_t* session, size_t sessionLen, uint32_t timeoutMs) override {
+        fd = openSocket(host, port);
+        if (fd < 0) return false;
+
+        ctx = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+        SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+        ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, fd);
+        SSL_set_tlsext_host_name(ssl, host);
+
+        if (session) {
+            const unsigned char* p = session;
+            SSL_SESSION* saved = d2i_SSL_SESSION(nullptr, &p, (long)sessionLen);
+            if (saved) {
+                SSL_set_session(ssl, saved);
+                SSL_SESSION_free(saved);
+            }
+        }
+
+        setTimeout(timeoutMs);
+        if (SSL_connect(ssl) != 1) {
+            close();
+            return false;
+        }
+        resumed = SSL_session_reused(ssl) == 1;
+        return true;
+    }
+
+    bool sessionResumed() const override { return resumed; }
+
+    bool saveSession(std::vector<uint8_t>& out) override {
+        SSL_SESSION* session = SSL_get1_session(ssl);
+        if (!session) return false;
+        int len = i2d_SSL_SESSION(session, nullptr);
+        bool ok = len > 0;
+        if (ok) {
+            out.resize(len);
+            unsigned char* p = out.data();
+            i2d_SSL_SESSION(session, &p);
+        }
+        SSL_SESSION_free(session);
+        return ok;
+    }
+
+    int write(const uint8_t* data, size_t len) override {
+        int n = SSL_write(ssl, data, (int)len);
+        return n > 0 ? n : -1;
+    }
+
+    int read(uint8_t* data, size_t len, uint32_t timeoutMs) override {
+        setTimeout(timeoutMs);
+        int n = SSL_read(ssl, data, (int)len);
+        if (n > 0) return n;
+        return SSL_get_error(ssl, n) == SSL_ERROR_ZERO_RETURN ? 0 : -1;
+    }
+
+    bool isAlive() override {
+        if (fd < 0 || SSL_pending(ssl) > 0) return false;
+        uint8_t c;
+        int n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        return n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN);
+    }
+
+    void close() override {
+        if (ssl) {
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+            ssl = nullptr;
+        }
+        if (ctx) {
+            SSL_CTX_free(ctx);
+            ctx = nullptr;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+private:
+    int fd = -1;
+    SSL_CTX* ctx = nullptr;
+    SSL* ssl = nullptr;
+    bool resumed = false;
+
+    static int openSocket(const char* host, uint16_t port) {
+        char portStr[8];
+        snprintf(portStr, sizeof(portStr), "%u", port);
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host, portStr, &hints, &result) != 0) return -1;
+
+        int sock = -1;
+        for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+            sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (sock < 0) continue;
+            if (::connect(sock, ai->ai_addr, ai->ai_addrlen) == 0) {
+                // 请求已在连接池中合并写出，关闭 Nagle 避免与延迟 ACK 叠加
+                int yes = 1;
+                setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+                break;
+            }
+            ::close(sock);
+            sock = -1;
+        }
+        freeaddrinfo(result);
+        return sock;
+    }
+
+    void setTimeout(uint32_t timeoutMs) {
+        timeval tv;
+        tv.tv_sec = timeoutMs / 1000;
+        tv.tv_usec = (timeoutMs % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+};
+
+TlsTransport* createTlsTransport() {
+    return new OpenSslTransport();
+}
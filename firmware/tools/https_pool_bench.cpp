@@ -0,0 +1,288 @@
+// HttpsPool 主机端验证：本地起一个 TLS 1.2 替身服务器，对比三种连接策略
+//
+// 用法:
+//   https_pool_bench [--requests N] [--body-bytes N] [--gap-ms N] [--server-idle-ms N]
+//
+//   no-pool     每个请求新建连接，完整握手
+//   tickets     每个请求新建连接，用缓存的会话票据恢复
+//   keep-alive  连接池默认配置：保持连接，断开后用票据恢复
+//
+// --server-idle-ms 让服务器关闭空闲超过该时间的连接（模拟网关 keep-alive 超时），
+// 与 --gap-ms 配合可验证失效连接的检测和重试
+//
+// 构建: tools/build_host.sh
+
+#include "https_pool.h"
+#include "logger.h"
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+struct Options {
+    int requests = 20;
+    size_t bodyBytes = 16 * 1024;
+    int gapMs = 0;
+    int serverIdleMs = 0;
+};
+
+// ---- TLS 替身服务器 ----
+
+class StandInServer {
+public:
+    bool start(int idleMs) {
+        this->idleMs = idleMs;
+        ctx = SSL_CTX_new(TLS_server_method());
+        SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+        if (!loadSelfSignedCert()) return false;
+
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 8) != 0) {
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(listenFd, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+
+        std::thread([this]() { acceptLoop(); }).detach();
+        return true;
+    }
+
+    uint16_t getPort() const { return port; }
+    int getHandshakes() const { return handshakes; }
+    int getResumed() const { return resumed; }
+
+private:
+    SSL_CTX* ctx = nullptr;
+    int listenFd = -1;
+    uint16_t port = 0;
+    int idleMs = 0;
+    std::atomic<int> handshakes{0};
+    std::atomic<int> resumed{0};
+
+    bool loadSelfSignedCert() {
+        EVP_PKEY* key = EVP_RSA_gen(2048);
+        X509* cert = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509_sign(cert, key, EVP_sha256());
+
+        bool ok = SSL_CTX_use_certificate(ctx, cert) == 1 && SSL_CTX_use_PrivateKey(ctx, key) == 1;
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        return ok;
+    }
+
+    void acceptLoop() {
+        while (true) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) continue;
+            int yes = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+            std::thread([this, fd]() { serve(fd); }).detach();
+        }
+    }
+
+    static bool readLine(SSL* ssl, std::string& line) {
+        line.clear();
+        char c;
+        while (SSL_read(ssl, &c, 1) == 1) {
+            if (c == '\n') {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                return true;
+            }
+            line += c;
+        }
+        return false;
+    }
+
+    void serve(int fd) {
+        if (idleMs > 0) {
+            timeval tv = { idleMs / 1000, (idleMs % 1000) * 1000 };
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        }
+
+        SSL* ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, fd);
+        if (SSL_accept(ssl) == 1) {
+            handshakes++;
+            if (SSL_session_reused(ssl)) resumed++;
+
+            std::string line;
+            // keep-alive：逐个处理请求，空闲超时或客户端关闭后退出
+            while (readLine(ssl, line)) {
+                size_t length = 0;
+                bool close = false;
+                while (readLine(ssl, line) && !line.empty()) {
+                    if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) {
+                        length = strtoul(line.c_str() + 15, nullptr, 10);
+                    } else if (strncasecmp(line.c_str(), "Connection: close", 17) == 0) {
+                        close = true;
+                    }
+                }
+                char discard[4096];
+                while (length > 0) {
+                    int n = SSL_read(ssl, discard, (int)std::min(length, sizeof(discard)));
+                    if (n <= 0) break;
+                    length -= n;
+                }
+
+                const char* body = "{\"message\":\"success\"}";
+                char response[160];
+                int len = snprintf(response, sizeof(response),
+                                   "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                   "Content-Length: %zu\r\n\r\n%s", strlen(body), body);
+                SSL_write(ssl, response, len);
+                if (close) break;
+            }
+        }
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+        ::close(fd);
+    }
+};
+
+// ---- 客户端场景 ----
+
+struct ScenarioResult {
+    int ok = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+    HttpsPoolStats stats;
+};
+
+static ScenarioResult runScenario(uint16_t port, const HttpsPoolConfig& config, const Options& opt) {
+    HttpsPool pool(createTlsTransport, config);
+    std::string payload(opt.bodyBytes, 'x');
+    ScenarioResult result;
+
+    for (int i = 0; i < opt.requests; i++) {
+        if (i > 0 && opt.gapMs > 0) {
+            delay(opt.gapMs);
+            pool.closeIdle();
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        std::string response;
+        int status = pool.request("127.0.0.1", port, "POST", "/api/v1/images/upload", nullptr,
+                                  "application/octet-stream", payload.size(),
+                                  [&](const HttpsWriteFn& write) {
+                                      return write((const uint8_t*)payload.data(), payload.size());
+                                  }, &response);
+        auto t1 = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        result.totalMs += ms;
+        result.maxMs = std::max(result.maxMs, ms);
+        if (status == 200 && response.find("success") != std::string::npos) result.ok++;
+    }
+    result.stats = pool.getStats();
+    return result;
+}
+
+static void printResult(const char* name, const ScenarioResult& r, int requests) {
+    const HttpsPoolStats& s = r.stats;
+    printf("%-11s %4d/%-4d %5u %7u %6u %5u %7.1f%% %8.2f %8.2f %9.2f %9.2f\n",
+           name, r.ok, requests, s.fullHandshakes, s.resumedHandshakes, s.reusedRequests,
+           s.staleRetries, s.requests ? s.reusedRequests * 100.0 / s.requests : 0.0,
+           requests ? r.totalMs / requests : 0.0, r.maxMs,
+           s.fullHandshakes ? (double)s.fullHandshakeMs / s.fullHandshakes : 0.0,
+           s.resumedHandshakes ? (double)s.resumedHandshakeMs / s.resumedHandshakes : 0.0);
+}
+
+static bool check(bool condition, const char* what) {
+    if (!condition) printf("FAIL: %s\n", what);
+    return condition;
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--requests" && hasValue) {
+            opt.requests = atoi(argv[++i]);
+        } else if (arg == "--body-bytes" && hasValue) {
+            opt.bodyBytes = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--gap-ms" && hasValue) {
+            opt.gapMs = atoi(argv[++i]);
+        } else if (arg == "--server-idle-ms" && hasValue) {
+            opt.serverIdleMs = atoi(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return opt.requests > 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s [--requests N] [--body-bytes N] [--gap-ms N] [--server-idle-ms N]\n",
+                argv[0]);
+        return 2;
+    }
+    Logger::setLogLevel(LOG_WARN);
+
+    StandInServer server;
+    if (!server.start(opt.serverIdleMs)) {
+        fprintf(stderr, "Failed to start TLS stand-in server\n");
+        return 1;
+    }
+
+    HttpsPoolConfig noPool;
+    noPool.keepAliveIdleMs = 0;
+    noPool.sessionCache = false;
+
+    HttpsPoolConfig ticketsOnly;
+    ticketsOnly.keepAliveIdleMs = 0;
+
+    HttpsPoolConfig keepAlive;
+
+    printf("requests: %d  body: %zu bytes  gap: %d ms  server idle timeout: %d ms\n\n",
+           opt.requests, opt.bodyBytes, opt.gapMs, opt.serverIdleMs);
+    printf("%-11s %9s %5s %7s %6s %5s %8s %8s %8s %9s %9s\n", "scenario", "ok", "full",
+           "resumed", "reused", "stale", "reuse", "avg_ms", "max_ms", "full_hs", "resume_hs");
+
+    ScenarioResult a = runScenario(server.getPort(), noPool, opt);
+    printResult("no-pool", a, opt.requests);
+    ScenarioResult b = runScenario(server.getPort(), ticketsOnly, opt);
+    printResult("tickets", b, opt.requests);
+    ScenarioResult c = runScenario(server.getPort(), keepAlive, opt);
+    printResult("keep-alive", c, opt.requests);
+
+    printf("\nserver: %d handshakes, %d resumed\n\n", server.getHandshakes(), server.getResumed());
+
+    int n = opt.requests;
+    bool pass = true;
+    pass &= check(a.ok == n && b.ok == n && c.ok == n, "all requests succeed");
+    pass &= check(a.stats.fullHandshakes == (uint32_t)n, "no-pool: full handshake per request");
+    pass &= check(b.stats.fullHandshakes == 1 && b.stats.resumedHandshakes == (uint32_t)n - 1,
+                  "tickets: one full handshake, the rest resumed");
+    if (opt.serverIdleMs == 0 || opt.gapMs < opt.serverIdleMs) {
+        pass &= check(c.stats.fullHandshakes == 1 && c.stats.reusedRequests == (uint32_t)n - 1,
+                      "keep-alive: one connection for all requests");
+    } else {
+        pass &= check(c.stats.fullHandshakes == 1 &&
+                      c.stats.resumedHandshakes + c.stats.reusedRequests == (uint32_t)n - 1,
+                      "keep-alive: closed connections resumed");
+    }
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,333 @@
+// JpegDcDecoder 基准与精度对照：把 .mcfr 录制文件编码为传感器式 JPEG，比较
+// - 每帧解码耗时：libjpeg 完整解码（RGB）、libjpeg 1/8 缩放解码、DC 熵解码、RGB565 网格（现有路径）
+// - DC 亮度图与完整解码后 8x8 块均值的误差
+// - 同一段录制分别以 RGB565 帧和 JPEG 帧送入 MotionDetector 的检测结果一致性、分数差和 dHash 距离
+//
+// 用法:
+//   jpeg_dc_bench <recording.mcfr> [--quality N] [--sampling 422|420|444] [--restart N]
+//                 [--iterations N] [--threshold N] [--trigger N] [--verbose]
+//
+// --quality 为 libjpeg 质量（1-100，默认 80，约相当于传感器 jpeg_quality 12）
+// --sampling 默认 422（OV2640 硬件编码器的输出）；--restart 为每多少个 MCU 一个重启标记
+//
+// 构建: tools/build_host.sh（需要 libjpeg 开发包）
+
+#include "jpeg_dc.h"
+#include "motion_detector.h"
+#include "frame_recording.h"
+#include <esp_camera.h>
+#include <jpeglib.h>
+#include <chrono>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    const char* recordingPath = nullptr;
+    int quality = 80;
+    int sampling = 422;
+    int restart = 0;
+    int iterations = 5;
+    int threshold = MOTION_THRESHOLD;
+    int trigger = MOTION_TRIGGER_COUNT;
+    bool verbose = false;
+};
+
+static double elapsedUs(Clock::time_point from) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - from).count();
+}
+
+static bool loadFrames(const char* path, RecordingHeader& header, std::vector<std::vector<uint8_t>>& frames) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 && isValidRecordingHeader(header) &&
+              header.pixformat == PIXFORMAT_RGB565;
+    if (!ok) {
+        fprintf(stderr, "Not an RGB565 .mcfr recording\n");
+        fclose(f);
+        return false;
+    }
+
+    fseek(f, header.headerSize, SEEK_SET);
+    for (uint32_t i = 0; i < header.frameCount; i++) {
+        RecordingFrameHeader fh;
+        if (fread(&fh, sizeof(fh), 1, f) != 1) break;
+        std::vector<uint8_t> pixels(fh.length);
+        if (fread(pixels.data(), 1, fh.length, f) != fh.length) break;
+        if (fh.length >= (size_t)header.width * header.height * 2) frames.push_back(std::move(pixels));
+    }
+    fclose(f);
+    return !frames.empty();
+}
+
+// RGB565（大端，与传感器输出一致）编码为 JPEG
+static std::vector<uint8_t> encodeJpeg(const uint8_t* rgb565, int width, int height, const Options& opt) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char* out = nullptr;
+    unsigned long outSize = 0;
+    jpeg_mem_dest(&cinfo, &out, &outSize);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, opt.quality, TRUE);
+    cinfo.comp_info[0].h_samp_factor = opt.sampling == 444 ? 1 : 2;
+    cinfo.comp_info[0].v_samp_factor = opt.sampling == 420 ? 2 : 1;
+    cinfo.restart_interval = opt.restart;
+    jpeg_start_compress(&cinfo, TRUE);
+
+    std::vector<uint8_t> row(width * 3);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        const uint8_t* src = rgb565 + (size_t)cinfo.next_scanline * width * 2;
+        for (int x = 0; x < width; x++) {
+            uint16_t p = src[x * 2] << 8 | src[x * 2 + 1];
+            row[x * 3] = (p >> 11) << 3;
+            row[x * 3 + 1] = ((p >> 5) & 0x3f) << 2;
+            row[x * 3 + 2] = (p & 0x1f) << 3;
+        }
+        JSAMPROW rows[1] = {row.data()};
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    std::vector<uint8_t> jpeg(out, out + outSize);
+    free(out);
+    return jpeg;
+}
+
+// libjpeg 解码；scaleDenom 为 8 时只做 DC 反变换（libjpeg 自带的 1/8 缩放）
+static bool decodeLibjpeg(const std::vector<uint8_t>& jpeg, J_COLOR_SPACE space, int scaleDenom,
+                          std::vector<uint8_t>& out, int& width, int& height) {
+    jpeg_decompress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpeg.data(), jpeg.size());
+    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    cinfo.out_color_space = space;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = scaleDenom;
+    jpeg_start_decompress(&cinfo);
+    width = cinfo.output_width;
+    height = cinfo.output_height;
+    size_t stride = (size_t)width * cinfo.output_components;
+    out.resize(stride * height);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW rows[1] = {out.data() + stride * cinfo.output_scanline};
+        jpeg_read_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+namespace {
+
+struct DcMap {
+    const JpegDcDecoder* decoder;
+    std::vector<uint8_t> luma;
+    uint32_t blocks;
+};
+
+}  // namespace
+
+static void storeDcBlock(void* arg, uint16_t bx, uint16_t by, uint8_t luma) {
+    DcMap* map = (DcMap*)arg;
+    // 回调期间帧信息已有效
+    const JpegDcInfo& info = map->decoder->info();
+    if (map->luma.empty()) map->luma.assign((size_t)info.blocksWide * info.blocksHigh, 0);
+    map->luma[(size_t)by * info.blocksWide + bx] = luma;
+    map->blocks++;
+}
+
+static void countDcBlock(void* arg, uint16_t, uint16_t, uint8_t) {
+    (*(uint32_t*)arg)++;
+}
+
+static bool decodeDcMap(JpegDcDecoder& decoder, const std::vector<uint8_t>& jpeg, DcMap& map) {
+    map.decoder = &decoder;
+    map.luma.clear();
+    map.blocks = 0;
+    return decoder.decode(jpeg.data(), jpeg.size(), storeDcBlock, &map) &&
+           map.blocks == (uint32_t)decoder.info().blocksWide * decoder.info().blocksHigh;
+}
+
+static camera_fb_t makeFrame(const uint8_t* data, size_t len, int width, int height, pixformat_t format) {
+    camera_fb_t fb = {};
+    fb.buf = (uint8_t*)data;
+    fb.len = len;
+    fb.width = width;
+    fb.height = height;
+    fb.format = format;
+    return fb;
+}
+
+static void printUsage() {
+    fprintf(stderr,
+            "Usage: jpeg_dc_bench <recording.mcfr> [--quality N] [--sampling 422|420|444] [--restart N]\n"
+            "                     [--iterations N] [--threshold N] [--trigger N] [--verbose]\n");
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--quality") == 0 && hasValue) opt.quality = atoi(argv[++i]);
+        else if (strcmp(arg, "--sampling") == 0 && hasValue) opt.sampling = atoi(argv[++i]);
+        else if (strcmp(arg, "--restart") == 0 && hasValue) opt.restart = atoi(argv[++i]);
+        else if (strcmp(arg, "--iterations") == 0 && hasValue) opt.iterations = atoi(argv[++i]);
+        else if (strcmp(arg, "--threshold") == 0 && hasValue) opt.threshold = atoi(argv[++i]);
+        else if (strcmp(arg, "--trigger") == 0 && hasValue) opt.trigger = atoi(argv[++i]);
+        else if (strcmp(arg, "--verbose") == 0) opt.verbose = true;
+        else if (arg[0] != '-' && !opt.recordingPath) opt.recordingPath = arg;
+        else return false;
+    }
+    return opt.recordingPath && opt.quality >= 1 && opt.quality <= 100 && opt.iterations > 0 &&
+           (opt.sampling == 422 || opt.sampling == 420 || opt.sampling == 444) && opt.restart >= 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printUsage();
+        return 1;
+    }
+
+    RecordingHeader header;
+    std::vector<std::vector<uint8_t>> frames;
+    if (!loadFrames(opt.recordingPath, header, frames)) return 1;
+    int width = header.width;
+    int height = header.height;
+    size_t rawBytes = (size_t)width * height * 2;
+
+    std::vector<std::vector<uint8_t>> jpegs;
+    size_t jpegBytes = 0;
+    for (const auto& pixels : frames) {
+        jpegs.push_back(encodeJpeg(pixels.data(), width, height, opt));
+        jpegBytes += jpegs.back().size();
+    }
+    printf("%zu frames %dx%d, JPEG quality %d, %d, restart %d: avg %zu bytes (RGB565 %zu, %.1fx)\n",
+           frames.size(), width, height, opt.quality, opt.sampling, opt.restart, jpegBytes / jpegs.size(),
+           rawBytes, (double)rawBytes * jpegs.size() / jpegBytes);
+
+    // DC 亮度图对照完整解码（灰度，即 Y 分量）的 8x8 块均值
+    JpegDcDecoder decoder;
+    uint64_t blockCount = 0;
+    double errorSum = 0;
+    int errorMax = 0;
+    for (size_t i = 0; i < jpegs.size(); i++) {
+        DcMap map;
+        std::vector<uint8_t> gray;
+        int w = 0, h = 0;
+        if (!decodeDcMap(decoder, jpegs[i], map) || !decodeLibjpeg(jpegs[i], JCS_GRAYSCALE, 1, gray, w, h)) {
+            fprintf(stderr, "Frame %zu: decode failed\n", i);
+            return 1;
+        }
+        const JpegDcInfo& info = decoder.info();
+        for (int by = 0; by < info.blocksHigh; by++) {
+            for (int bx = 0; bx < info.blocksWide; bx++) {
+                int sum = 0, n = 0;
+                for (int y = by * 8; y < min(by * 8 + 8, h); y++) {
+                    for (int x = bx * 8; x < min(bx * 8 + 8, w); x++) {
+                        sum += gray[(size_t)y * w + x];
+                        n++;
+                    }
+                }
+                int err = abs((int)map.luma[(size_t)by * info.blocksWide + bx] - (sum + n / 2) / n);
+                errorSum += err;
+                errorMax = max(errorMax, err);
+                blockCount++;
+            }
+        }
+    }
+    printf("DC map: %ux%u blocks, |DC - decoded block mean| avg %.2f, max %d\n", decoder.info().blocksWide,
+           decoder.info().blocksHigh, errorSum / blockCount, errorMax);
+
+    // 解码耗时：每种方式把全部帧解码 iterations 遍
+    double fullUs = 0, scaledUs = 0, dcUs = 0, rgbGridUs = 0;
+    MotionDetector gridDetector;
+    gridDetector.init();
+    std::vector<uint8_t> out;
+    int w = 0, h = 0;
+    for (int it = 0; it < opt.iterations; it++) {
+        for (size_t i = 0; i < jpegs.size(); i++) {
+            auto t0 = Clock::now();
+            decodeLibjpeg(jpegs[i], JCS_RGB, 1, out, w, h);
+            fullUs += elapsedUs(t0);
+
+            t0 = Clock::now();
+            decodeLibjpeg(jpegs[i], JCS_GRAYSCALE, 8, out, w, h);
+            scaledUs += elapsedUs(t0);
+
+            uint32_t count = 0;
+            t0 = Clock::now();
+            decoder.decode(jpegs[i].data(), jpegs[i].size(), countDcBlock, &count);
+            dcUs += elapsedUs(t0);
+
+            // 现有路径：RGB565 网格（含比较）
+            camera_fb_t fb = makeFrame(frames[i].data(), rawBytes, width, height, PIXFORMAT_RGB565);
+            t0 = Clock::now();
+            gridDetector.detect(&fb);
+            rgbGridUs += elapsedUs(t0);
+        }
+    }
+    double runs = (double)opt.iterations * jpegs.size();
+    printf("Per-frame time (avg of %d x %zu):\n", opt.iterations, jpegs.size());
+    printf("  libjpeg full decode (RGB)  %8.1f us\n", fullUs / runs);
+    printf("  libjpeg 1/8 scale (gray)   %8.1f us\n", scaledUs / runs);
+    printf("  DC entropy decode          %8.1f us  (%.1fx faster than full decode)\n", dcUs / runs,
+           dcUs > 0 ? fullUs / dcUs : 0.0);
+    printf("  RGB565 grid (sampled)      %8.1f us\n", rgbGridUs / runs);
+
+    // 同一段录制分别走 RGB565 和 JPEG 路径
+    MotionDetector rgbDetector, jpegDetector;
+    rgbDetector.init();
+    jpegDetector.init();
+    rgbDetector.setThreshold(opt.threshold);
+    jpegDetector.setThreshold(opt.threshold);
+    rgbDetector.setTriggerCount(opt.trigger);
+    jpegDetector.setTriggerCount(opt.trigger);
+
+    int agree = 0, both = 0, rgbOnly = 0, jpegOnly = 0;
+    double scoreDiffSum = 0, hashSum = 0;
+    int scoreDiffMax = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        camera_fb_t rgbFb = makeFrame(frames[i].data(), rawBytes, width, height, PIXFORMAT_RGB565);
+        camera_fb_t jpegFb = makeFrame(jpegs[i].data(), jpegs[i].size(), width, height, PIXFORMAT_JPEG);
+        bool rgbMotion = rgbDetector.detect(&rgbFb);
+        bool jpegMotion = jpegDetector.detect(&jpegFb);
+        int scoreDiff = abs((int)rgbDetector.getLastScore() - (int)jpegDetector.getLastScore());
+        int hashDistance = __builtin_popcountll(rgbDetector.getFrameHash() ^ jpegDetector.getFrameHash());
+
+        agree += rgbMotion == jpegMotion;
+        both += rgbMotion && jpegMotion;
+        rgbOnly += rgbMotion && !jpegMotion;
+        jpegOnly += !rgbMotion && jpegMotion;
+        scoreDiffSum += scoreDiff;
+        scoreDiffMax = max(scoreDiffMax, scoreDiff);
+        hashSum += hashDistance;
+
+        if (opt.verbose) {
+            printf("%5zu  rgb565 %c %2u  jpeg %c %2u  hash distance %d\n", i, rgbMotion ? 'M' : '.',
+                   rgbDetector.getLastScore(), jpegMotion ? 'M' : '.', jpegDetector.getLastScore(), hashDistance);
+        }
+    }
+    printf("Motion (threshold %d, trigger %d): agree %d/%zu (%.1f%%), both %d, rgb565 only %d, jpeg only %d\n",
+           opt.threshold, opt.trigger, agree, frames.size(), 100.0 * agree / frames.size(), both, rgbOnly,
+           jpegOnly);
+    printf("Score |diff| avg %.2f, max %d; dHash distance avg %.2f bits; jpeg decode errors %u\n",
+           scoreDiffSum / frames.size(), scoreDiffMax, hashSum / frames.size(), jpegDetector.getDecodeErrors());
+    return 0;
+}
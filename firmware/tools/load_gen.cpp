@@ -0,0 +1,381 @@
+// HTTP 负载发生器：并发驱动 /stream、/motion 和配网接口，报告吞吐、延迟分位数和堆峰值
+// 可以对准整机仿真（tools/sim）或真实设备
+//
+// 用法:
+//   load_gen [--host H] [--port N] [--duration S] [--stream N] [--motion N] [--prov N]
+//            [--motion-interval-ms N] [--prov-interval-ms N] [--prov-post] [--timeout-ms N]
+//
+// 每个 /stream 客户端连续拉取整帧 BMP；/motion 客户端按间隔轮询；
+// 配网客户端依次请求 /provision、/api/wifi/status、/api/wifi/config、/api/wifi/scan，
+// 加 --prov-post 时每轮再提交一次 POST /api/wifi/config
+// 堆峰值：每 250 ms 轮询 /api/memory，取 free_heap 最小值，并与设备记录的 min_free_heap 对照
+//
+// 构建: tools/build_host.sh
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options {
+    const char* host = "127.0.0.1";
+    uint16_t port = 8080;
+    uint32_t durationSec = 30;
+    uint32_t streamClients = 2;
+    uint32_t motionClients = 2;
+    uint32_t provClients = 1;
+    uint32_t motionIntervalMs = 200;
+    uint32_t provIntervalMs = 1000;
+    bool provPost = false;
+    uint32_t timeoutMs = 10000;
+};
+
+static Options options;
+static std::atomic<bool> stopping(false);
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// ---- HTTP ----
+
+struct HttpResult {
+    int status = 0;         // 0 表示连接或传输失败
+    size_t bodyBytes = 0;
+    double latencyMs = 0;   // 从建立连接到读完响应
+    std::string body;       // 只在需要时保留
+    const char* error = nullptr;
+};
+
+static int connectTo(const char* host, uint16_t port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    char portStr[8];
+    snprintf(portStr, sizeof(portStr), "%u", port);
+    if (getaddrinfo(host, portStr, &hints, &res) != 0 || !res) return -1;
+
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd >= 0) {
+        timeval tv = {(time_t)(options.timeoutMs / 1000), (suseconds_t)(options.timeoutMs % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+static HttpResult httpRequest(const char* method, const char* path, const char* form, bool keepBody) {
+    HttpResult result;
+    Clock::time_point start = Clock::now();
+
+    int fd = connectTo(options.host, options.port);
+    if (fd < 0) {
+        result.error = "connect";
+        result.latencyMs = msSince(start);
+        return result;
+    }
+
+    std::string request = std::string(method) + " " + path + " HTTP/1.1\r\nHost: " + options.host +
+                          "\r\nConnection: close\r\n";
+    if (form) {
+        request += "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: " +
+                   std::to_string(strlen(form)) + "\r\n\r\n" + form;
+    } else {
+        request += "\r\n";
+    }
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) {
+        close(fd);
+        result.error = "send";
+        result.latencyMs = msSince(start);
+        return result;
+    }
+
+    // 只保留响应头，响应体只计数
+    std::string head;
+    size_t headEnd = std::string::npos;
+    size_t total = 0;
+    char buffer[16384];
+    while (true) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n == 0) break;
+        if (n < 0) {
+            result.error = (errno == EAGAIN || errno == EWOULDBLOCK) ? "timeout" : "recv";
+            break;
+        }
+        total += n;
+        if (headEnd == std::string::npos) {
+            head.append(buffer, n);
+            headEnd = head.find("\r\n\r\n");
+            if (headEnd != std::string::npos && keepBody) result.body = head.substr(headEnd + 4);
+        } else if (keepBody) {
+            result.body.append(buffer, n);
+        }
+    }
+    close(fd);
+    result.latencyMs = msSince(start);
+
+    if (headEnd == std::string::npos) {
+        if (!result.error) result.error = "no-response";
+        return result;
+    }
+    result.bodyBytes = total - (headEnd + 4);
+    if (sscanf(head.c_str(), "HTTP/1.%*d %d", &result.status) != 1) {
+        result.error = "bad-status";
+        result.status = 0;
+        return result;
+    }
+
+    // 响应体短于 Content-Length：服务器中途断开
+    const char* cl = strcasestr(head.c_str(), "\r\nContent-Length:");
+    if (cl && (size_t)(cl - head.c_str()) < headEnd && !result.error) {
+        size_t expected = strtoul(cl + 17, nullptr, 10);
+        if (result.bodyBytes < expected) result.error = "truncated";
+    }
+    return result;
+}
+
+// ---- 统计 ----
+
+struct ClassStats {
+    const char* name;
+    std::mutex mutex;
+    std::vector<double> latencies;
+    uint64_t requests = 0;
+    uint64_t bytes = 0;
+    uint64_t ok = 0;
+    uint64_t httpErrors = 0;        // 非 2xx
+    uint64_t transportErrors = 0;   // 连接失败、超时、截断
+    std::vector<std::pair<std::string, uint64_t>> errorKinds;
+
+    explicit ClassStats(const char* name) : name(name) {}
+
+    void record(const HttpResult& r) {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests++;
+        bytes += r.bodyBytes;
+        latencies.push_back(r.latencyMs);
+        std::string kind;
+        if (r.error) {
+            transportErrors++;
+            kind = r.error;
+        } else if (r.status < 200 || r.status >= 300) {
+            httpErrors++;
+            kind = "http-" + std::to_string(r.status);
+        } else {
+            ok++;
+            return;
+        }
+        for (auto& e : errorKinds) {
+            if (e.first == kind) {
+                e.second++;
+                return;
+            }
+        }
+        errorKinds.emplace_back(kind, 1);
+    }
+};
+
+static ClassStats streamStats("stream");
+static ClassStats motionStats("motion");
+static ClassStats provStats("prov");
+
+static double percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// ---- 客户端 ----
+
+static void sleepUntil(Clock::time_point next) {
+    while (!stopping && Clock::now() < next) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+static void streamClient() {
+    while (!stopping) {
+        streamStats.record(httpRequest("GET", "/stream", nullptr, false));
+    }
+}
+
+static void motionClient() {
+    Clock::time_point next = Clock::now();
+    while (!stopping) {
+        motionStats.record(httpRequest("GET", "/motion", nullptr, false));
+        next += std::chrono::milliseconds(options.motionIntervalMs);
+        sleepUntil(next);
+    }
+}
+
+static void provClient(int id) {
+    static const char* const PATHS[] = {"/provision", "/api/wifi/status", "/api/wifi/config", "/api/wifi/scan"};
+    char form[96];
+    snprintf(form, sizeof(form), "ssid=LoadGen-%d&password=loadgen%%20pass", id);
+
+    Clock::time_point next = Clock::now();
+    while (!stopping) {
+        for (const char* path : PATHS) {
+            if (stopping) break;
+            provStats.record(httpRequest("GET", path, nullptr, false));
+        }
+        if (options.provPost && !stopping) provStats.record(httpRequest("POST", "/api/wifi/config", form, false));
+        next += std::chrono::milliseconds(options.provIntervalMs);
+        sleepUntil(next);
+    }
+}
+
+// ---- 堆采样 ----
+
+struct HeapSamples {
+    bool available = false;
+    uint64_t samples = 0;
+    uint32_t heapSize = 0;
+    uint32_t firstFree = 0;
+    uint32_t minFree = UINT32_MAX;
+    uint32_t deviceMinFree = UINT32_MAX;   // 设备记录的最低水位
+    uint32_t psramSize = 0;
+    uint32_t minFreePsram = UINT32_MAX;
+};
+
+static HeapSamples heap;
+
+static bool jsonNumber(const std::string& body, const char* key, uint32_t& value) {
+    std::string pattern = std::string("\"") + key + "\":";
+    size_t pos = body.find(pattern);
+    if (pos == std::string::npos) return false;
+    value = strtoul(body.c_str() + pos + pattern.size(), nullptr, 10);
+    return true;
+}
+
+static void heapSampler() {
+    while (!stopping) {
+        HttpResult r = httpRequest("GET", "/api/memory", nullptr, true);
+        uint32_t value;
+        if (r.status == 200 && jsonNumber(r.body, "free_heap", value)) {
+            if (!heap.available) heap.firstFree = value;
+            heap.available = true;
+            heap.samples++;
+            heap.minFree = std::min(heap.minFree, value);
+            if (jsonNumber(r.body, "min_free_heap", value)) heap.deviceMinFree = std::min(heap.deviceMinFree, value);
+            if (jsonNumber(r.body, "heap_size", value)) heap.heapSize = value;
+            if (jsonNumber(r.body, "psram_size", value)) heap.psramSize = value;
+            if (jsonNumber(r.body, "free_psram", value)) heap.minFreePsram = std::min(heap.minFreePsram, value);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+}
+
+// ---- 报告 ----
+
+static void report(ClassStats& s, double seconds) {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.requests) return;
+    std::sort(s.latencies.begin(), s.latencies.end());
+    printf("%-7s %8llu %8.1f %9.2f %8.1f %8.1f %8.1f %8.1f %7llu %7llu\n", s.name,
+           (unsigned long long)s.requests, s.requests / seconds, s.bytes / seconds / 1024.0,
+           percentile(s.latencies, 50), percentile(s.latencies, 90), percentile(s.latencies, 99),
+           s.latencies.back(), (unsigned long long)s.httpErrors, (unsigned long long)s.transportErrors);
+    for (auto& e : s.errorKinds) {
+        printf("        %s: %llu\n", e.first.c_str(), (unsigned long long)e.second);
+    }
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [--host H] [--port N] [--duration S] [--stream N] [--motion N] [--prov N]\n"
+            "          [--motion-interval-ms N] [--prov-interval-ms N] [--prov-post] [--timeout-ms N]\n",
+            prog);
+}
+
+static bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--prov-post") == 0) {
+            options.provPost = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const char* value = argv[++i];
+        unsigned long n = strtoul(value, nullptr, 10);
+        if (strcmp(arg, "--host") == 0) options.host = value;
+        else if (strcmp(arg, "--port") == 0) options.port = n;
+        else if (strcmp(arg, "--duration") == 0 && n > 0) options.durationSec = n;
+        else if (strcmp(arg, "--stream") == 0) options.streamClients = n;
+        else if (strcmp(arg, "--motion") == 0) options.motionClients = n;
+        else if (strcmp(arg, "--prov") == 0) options.provClients = n;
+        else if (strcmp(arg, "--motion-interval-ms") == 0) options.motionIntervalMs = n;
+        else if (strcmp(arg, "--prov-interval-ms") == 0) options.provIntervalMs = n;
+        else if (strcmp(arg, "--timeout-ms") == 0 && n > 0) options.timeoutMs = n;
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseArgs(argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    printf("Target http://%s:%u, %u s: %u stream, %u motion, %u provisioning clients\n", options.host,
+           options.port, options.durationSec, options.streamClients, options.motionClients, options.provClients);
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(heapSampler);
+    for (uint32_t i = 0; i < options.streamClients; i++) threads.emplace_back(streamClient);
+    for (uint32_t i = 0; i < options.motionClients; i++) threads.emplace_back(motionClient);
+    for (uint32_t i = 0; i < options.provClients; i++) threads.emplace_back(provClient, (int)i);
+
+    Clock::time_point start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(options.durationSec));
+    stopping = true;
+    for (auto& t : threads) t.join();
+    double seconds = msSince(start) / 1000.0;
+
+    printf("\n%-7s %8s %8s %9s %8s %8s %8s %8s %7s %7s\n", "class", "requests", "req/s", "KB/s", "p50 ms",
+           "p90 ms", "p99 ms", "max ms", "http", "errors");
+    report(streamStats, seconds);
+    report(motionStats, seconds);
+    report(provStats, seconds);
+
+    if (!heap.available) {
+        printf("\nHeap: /api/memory not available\n");
+        return 0;
+    }
+    printf("\nHeap (%llu samples): free at start %u, min sampled free %u, device min_free_heap (since boot) %u\n",
+           (unsigned long long)heap.samples, heap.firstFree, heap.minFree, heap.deviceMinFree);
+    if (heap.heapSize) {
+        uint32_t minFree = std::min(heap.minFree, heap.deviceMinFree);
+        printf("Peak heap used: %u of %u bytes (%.1f%%)\n", heap.heapSize - minFree, heap.heapSize,
+               100.0 * (heap.heapSize - minFree) / heap.heapSize);
+    }
+    if (heap.psramSize && heap.minFreePsram != UINT32_MAX) {
+        printf("Peak PSRAM used (sampled): %u of %u bytes\n", heap.psramSize - heap.minFreePsram, heap.psramSize);
+    }
+    return 0;
+}
@@ -0,0 +1,347 @@
+// 离线回放 .mcfr 录制文件并评估 MotionDetector
+//
+// 用法:
+//   motion_replay <recording.mcfr> [--labels labels.txt] [--threshold N] [--trigger N]
+//                 [--sweep-threshold FROM:TO:STEP] [--dedup-distance N]
+//                 [--tripwire X0,Y0,X1,Y1[,forward|backward|both]]... [--quiet]
+//
+// 同时运行 MotionEventEngine，state 列为事件开始（start）、峰值帧（peak）、结束上报（end）、
+// 过短丢弃（drop），汇总中给出逐帧运动上升沿与上报事件数之比（即云端调用的减少倍数）
+//
+// 本地保存的事件帧按设备逻辑产生（事件峰值帧 + 事件进行中每 MOTION_EVENT_INTERVAL_MS 一帧），
+// 间隔帧经 FrameDeduplicator 过滤，汇总中给出丢弃比例，用于调整 --dedup-distance
+//
+// 给出 --tripwire（坐标为画面千分比）时同时运行 MotionEstimator，输出越线事件和块匹配耗时
+//
+// labels.txt 每行一个运动区间 "起始帧 结束帧"（闭区间，从 0 开始），# 开头为注释
+//
+// 构建: tools/build_host.sh
+
+#include "motion_detector.h"
+#include "frame_dedup.h"
+#include "motion_estimator.h"
+#include "motion_event.h"
+#include "frame_recording.h"
+#include <chrono>
+#include <vector>
+#include <string>
+
+struct Recording {
+    RecordingHeader header;
+    std::vector<RecordingFrameHeader> frames;
+    std::vector<const uint8_t*> pixels;
+    std::vector<uint8_t> data;
+};
+
+struct Options {
+    const char* recordingPath = nullptr;
+    const char* labelsPath = nullptr;
+    int threshold = MOTION_THRESHOLD;
+    int trigger = MOTION_TRIGGER_COUNT;
+    int sweepFrom = -1;
+    int sweepTo = -1;
+    int sweepStep = 1;
+    int dedupDistance = DEDUP_MAX_DISTANCE;
+    std::vector<Tripwire> tripwires;
+    bool quiet = false;
+};
+
+struct Evaluation {
+    int truePositive = 0;
+    int falsePositive = 0;
+    int falseNegative = 0;
+    int trueNegative = 0;
+    int liveAgreement = 0;
+    int eventCandidates = 0;
+    int eventsSuppressed = 0;
+    MotionEventStats events = {};
+    int estimatedFrames = 0;
+    double estimatorTotalUs = 0;
+    double estimatorMaxUs = 0;
+    std::vector<int> crossings;
+    double totalUs = 0;
+    double maxUs = 0;
+};
+
+static bool loadRecording(const char* path, Recording& rec) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    rec.data.resize(size);
+    size_t got = fread(rec.data.data(), 1, size, f);
+    fclose(f);
+
+    if (got < sizeof(RecordingHeader)) {
+        fprintf(stderr, "File too short\n");
+        return false;
+    }
+    memcpy(&rec.header, rec.data.data(), sizeof(RecordingHeader));
+    if (!isValidRecordingHeader(rec.header)) {
+        fprintf(stderr, "Not a .mcfr recording\n");
+        return false;
+    }
+    if (rec.header.pixformat != PIXFORMAT_RGB565) {
+        fprintf(stderr, "Unsupported pixel format %u\n", rec.header.pixformat);
+        return false;
+    }
+
+    // 逐帧解析，截断的文件只回放完整的帧
+    size_t offset = rec.header.headerSize;
+    for (uint32_t i = 0; i < rec.header.frameCount; i++) {
+        if (offset + sizeof(RecordingFrameHeader) > got) break;
+        RecordingFrameHeader fh;
+        memcpy(&fh, rec.data.data() + offset, sizeof(fh));
+        offset += sizeof(fh);
+        if (offset + fh.length > got) break;
+        rec.frames.push_back(fh);
+        rec.pixels.push_back(rec.data.data() + offset);
+        offset += fh.length;
+    }
+    if (rec.frames.size() < rec.header.frameCount) {
+        fprintf(stderr, "Warning: recording truncated, %zu of %u frames\n",
+                rec.frames.size(), rec.header.frameCount);
+    }
+    return true;
+}
+
+static bool loadLabels(const char* path, size_t frameCount, std::vector<bool>& labels) {
+    labels.assign(frameCount, false);
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        long start, end;
+        if (sscanf(line, "%ld %ld", &start, &end) != 2) continue;
+        for (long i = std::max(start, 0L); i <= end && i < (long)frameCount; i++) {
+            labels[i] = true;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static Evaluation evaluate(const Recording& rec, const std::vector<bool>* labels,
+                           int threshold, int trigger, int dedupDistance,
+                           const std::vector<Tripwire>& tripwires, bool printFrames) {
+    MotionDetector detector;
+    detector.init();
+    detector.setThreshold(threshold);
+    detector.setTriggerCount(trigger);
+
+    FrameDeduplicator dedup;
+    dedup.setMaxDistance(dedupDistance);
+    MotionEventEngine engine;
+    uint32_t lastEventMs = 0;
+
+    // 约 40KB 的亮度平面，不放在栈上
+    static MotionEstimator estimator;
+    estimator.reset();
+    for (const Tripwire& tw : tripwires) estimator.setTripwire(tw);
+
+    Evaluation ev;
+    camera_fb_t fb;
+    memset(&fb, 0, sizeof(fb));
+    fb.width = rec.header.width;
+    fb.height = rec.header.height;
+    fb.format = PIXFORMAT_RGB565;
+
+    if (printFrames) {
+        printf("%6s %10s %5s %6s %5s %6s %6s %8s  %s\n", "frame", "ts_ms", "live", "detect", "label", "state",
+               "event", "us", tripwires.empty() ? "" : "tripwire");
+    }
+
+    for (size_t i = 0; i < rec.frames.size(); i++) {
+        fb.buf = const_cast<uint8_t*>(rec.pixels[i]);
+        fb.len = rec.frames[i].length;
+
+        auto t0 = std::chrono::steady_clock::now();
+        bool detected = detector.detect(&fb);
+        auto t1 = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        ev.totalUs += us;
+        ev.maxUs = std::max(ev.maxUs, us);
+
+        uint32_t crossed = 0;
+        if (!tripwires.empty()) {
+            auto t2 = std::chrono::steady_clock::now();
+            crossed = estimator.process(&fb, rec.frames[i].timestampMs);
+            double mvUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t2).count();
+            ev.estimatedFrames++;
+            ev.estimatorTotalUs += mvUs;
+            ev.estimatorMaxUs = std::max(ev.estimatorMaxUs, mvUs);
+        }
+        std::string trip;
+        for (size_t t = 0; t < tripwires.size(); t++) {
+            if (!(crossed & (1u << t))) continue;
+            Tripwire list[MV_MAX_TRIPWIRES];
+            TripwireStatus status[MV_MAX_TRIPWIRES];
+            estimator.getTripwires(list, status, MV_MAX_TRIPWIRES);
+            ev.crossings.push_back((int)i);
+            if (!trip.empty()) trip += ",";
+            trip += std::string(list[t].name) + ":" + tripwireDirectionName(status[t].lastDirection);
+        }
+
+        // 与 captureTask 相同的事件状态机和本地事件帧逻辑
+        const char* state = "-";
+        const char* event = "-";
+        uint32_t ts = rec.frames[i].timestampMs;
+        uint8_t flags = engine.update(detected, detector.getLastScore(), ts);
+        if (flags & MOTION_EVENT_STARTED) state = "start";
+        else if (flags & MOTION_EVENT_PEAK) state = "peak";
+        if (flags & MOTION_EVENT_ENDED) state = "end";
+        else if (flags & MOTION_EVENT_DISCARDED) state = "drop";
+        if (flags & MOTION_EVENT_PEAK) {
+            lastEventMs = ts;
+            ev.eventCandidates++;
+            event = "peak";
+        } else if (detected && engine.isActive() && ts - lastEventMs >= MOTION_EVENT_INTERVAL_MS) {
+            lastEventMs = ts;
+            ev.eventCandidates++;
+            if (dedup.check(detector.getFrameHash(), ts)) {
+                event = "new";
+            } else {
+                event = "dup";
+                ev.eventsSuppressed++;
+            }
+        }
+
+        bool live = rec.frames[i].flags & RECORDING_FLAG_LIVE_MOTION;
+        if (live == detected) ev.liveAgreement++;
+
+        const char* label = "-";
+        if (labels) {
+            bool truth = (*labels)[i];
+            label = truth ? "1" : "0";
+            if (detected && truth) ev.truePositive++;
+            else if (detected && !truth) ev.falsePositive++;
+            else if (!detected && truth) ev.falseNegative++;
+            else ev.trueNegative++;
+        }
+
+        if (printFrames) {
+            printf("%6zu %10u %5d %6d %5s %6s %6s %8.1f  %s\n", i, rec.frames[i].timestampMs,
+                   live ? 1 : 0, detected ? 1 : 0, label, state, event, us, trip.c_str());
+        }
+    }
+    ev.events = engine.getStats();
+    return ev;
+}
+
+static double ratio(int num, int den) {
+    return den > 0 ? (double)num / den : 0.0;
+}
+
+static void printSummary(const Recording& rec, const Evaluation& ev, bool hasLabels) {
+    size_t n = rec.frames.size();
+    printf("\nframes: %zu  size: %ux%u  decimation: %u\n", n,
+           rec.header.width, rec.header.height, rec.header.decimation);
+    if (n > 1) {
+        double spanMs = rec.frames[n - 1].timestampMs - rec.frames[0].timestampMs;
+        printf("recorded rate: %.2f fps\n", spanMs > 0 ? (n - 1) * 1000.0 / spanMs : 0.0);
+    }
+    printf("processing: avg %.1f us  max %.1f us  throughput %.0f fps\n",
+           n ? ev.totalUs / n : 0.0, ev.maxUs, ev.totalUs > 0 ? n * 1e6 / ev.totalUs : 0.0);
+    printf("agreement with live device: %d/%zu\n", ev.liveAgreement, n);
+    const MotionEventStats& es = ev.events;
+    printf("motion onsets: %u  events: %u reported, %u discarded, %u truncated%s  "
+           "suppressed: %u cooldown, %u rate  onsets per event: %.1f\n",
+           es.onsets, es.reported, es.discarded, es.truncated, es.active ? " (1 still active)" : "",
+           es.cooldownSuppressed, es.rateSuppressed, ratio(es.onsets, es.reported));
+    printf("event frames: %d  suppressed by dedup: %d (%.1f%%)\n", ev.eventCandidates,
+           ev.eventsSuppressed, 100.0 * ratio(ev.eventsSuppressed, ev.eventCandidates));
+    if (ev.estimatedFrames > 0) {
+        printf("block matching: %d frames  avg %.1f us  max %.1f us  tripwire crossings: %zu\n",
+               ev.estimatedFrames, ev.estimatorTotalUs / ev.estimatedFrames, ev.estimatorMaxUs,
+               ev.crossings.size());
+    }
+    if (hasLabels) {
+        printf("TP %d  FP %d  FN %d  TN %d  precision %.3f  recall %.3f\n",
+               ev.truePositive, ev.falsePositive, ev.falseNegative, ev.trueNegative,
+               ratio(ev.truePositive, ev.truePositive + ev.falsePositive),
+               ratio(ev.truePositive, ev.truePositive + ev.falseNegative));
+    }
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--labels" && hasValue) {
+            opt.labelsPath = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            opt.threshold = atoi(argv[++i]);
+        } else if (arg == "--trigger" && hasValue) {
+            opt.trigger = atoi(argv[++i]);
+        } else if (arg == "--sweep-threshold" && hasValue) {
+            if (sscanf(argv[++i], "%d:%d:%d", &opt.sweepFrom, &opt.sweepTo, &opt.sweepStep) < 2) {
+                return false;
+            }
+            if (opt.sweepStep <= 0) opt.sweepStep = 1;
+        } else if (arg == "--dedup-distance" && hasValue) {
+            opt.dedupDistance = atoi(argv[++i]);
+        } else if (arg == "--tripwire" && hasValue) {
+            Tripwire tw = {};
+            char dir[16] = "both";
+            int x0, y0, x1, y1;
+            if (sscanf(argv[++i], "%d,%d,%d,%d,%15s", &x0, &y0, &x1, &y1, dir) < 4 ||
+                !parseTripwireDirection(dir, tw.direction)) {
+                return false;
+            }
+            snprintf(tw.name, sizeof(tw.name), "tw%zu", opt.tripwires.size());
+            tw.x0 = x0; tw.y0 = y0; tw.x1 = x1; tw.y1 = y1;
+            opt.tripwires.push_back(tw);
+        } else if (arg == "--quiet") {
+            opt.quiet = true;
+        } else if (arg[0] != '-' && !opt.recordingPath) {
+            opt.recordingPath = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return opt.recordingPath != nullptr;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s <recording.mcfr> [--labels FILE] [--threshold N] [--trigger N] "
+                        "[--sweep-threshold FROM:TO:STEP] [--dedup-distance N] "
+                        "[--tripwire X0,Y0,X1,Y1[,DIR]]... [--quiet]\n", argv[0]);
+        return 2;
+    }
+
+    Recording rec;
+    if (!loadRecording(opt.recordingPath, rec)) return 1;
+
+    std::vector<bool> labels;
+    if (opt.labelsPath && !loadLabels(opt.labelsPath, rec.frames.size(), labels)) return 1;
+    const std::vector<bool>* labelPtr = opt.labelsPath ? &labels : nullptr;
+
+    if (opt.sweepFrom >= 0) {
+        // 阈值扫描：每个阈值一行汇总
+        printf("%9s %7s %5s %5s %5s %9s %7s %8s\n",
+               "threshold", "trigger", "TP", "FP", "FN", "precision", "recall", "avg_us");
+        for (int th = opt.sweepFrom; th <= opt.sweepTo; th += opt.sweepStep) {
+            Evaluation ev = evaluate(rec, labelPtr, th, opt.trigger, opt.dedupDistance, opt.tripwires, false);
+            printf("%9d %7d %5d %5d %5d %9.3f %7.3f %8.1f\n", th, opt.trigger,
+                   ev.truePositive, ev.falsePositive, ev.falseNegative,
+                   ratio(ev.truePositive, ev.truePositive + ev.falsePositive),
+                   ratio(ev.truePositive, ev.truePositive + ev.falseNegative),
+                   rec.frames.empty() ? 0.0 : ev.totalUs / rec.frames.size());
+        }
+        return 0;
+    }
+
+    Evaluation ev = evaluate(rec, labelPtr, opt.threshold, opt.trigger, opt.dedupDistance, opt.tripwires, !opt.quiet);
+    printSummary(rec, ev, labelPtr != nullptr);
+    return 0;
+}
@@ -0,0 +1,421 @@
+// RingStore 验证与吞吐对照：在文件模拟的分区（tools/host/host_partition.cpp，NOR 闪存语义）上
+// 1. 追加若干圈随机大小的记录，每条追加后抽查一条较早的记录，结束后重新扫描分区，
+//    核对重建的记录集合与内容；给出主机吞吐、写入放大、按典型 SPI NOR 时序估算的设备吞吐和各扇区擦除次数
+// 2. 掉电注入：随机在某次写入中途断电，重新 begin 后核对已确认且未回收的记录一条不少、内容无误
+// 3. tools/third_party/littlefs 中有源码时，用 littlefs 在同样大小的分区上按原 LittleFS 事件日志的方式
+//    （64KB 分段文件 + 索引文件，超出配额删除最旧分段）运行同一组记录，对照同样的指标
+//
+// 用法:
+//   ring_store_bench [--records N] [--min-kb N] [--max-kb N] [--power-cuts N] [--seed N]
+//
+// 构建: tools/build_host.sh（LittleFS 对照从 tools/third_party/littlefs 编译，固定 v2.5.1）
+
+#include "ring_store.h"
+#include "logger.h"
+#include <chrono>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#ifdef HAVE_LITTLEFS
+#include <lfs.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static const uint32_t PARTITION_BYTES = 0x60000;   // partitions.csv 的 events 分区
+static const esp_partition_subtype_t SUBTYPE = (esp_partition_subtype_t)0x40;
+// 映射读取按 80MHz QIO（40MB/s）估算，与模拟器对 esp_partition_read 的估算相同
+static const double MAPPED_READ_US_PER_BYTE = 1.0 / 40;
+
+struct Options {
+    uint32_t records = 2000;
+    uint32_t minBytes = 4 * 1024;
+    uint32_t maxBytes = 30 * 1024;
+    uint32_t powerCuts = 200;
+    uint32_t seed = 1;
+};
+
+static uint32_t rng = 1;
+
+static uint32_t nextRandom() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// 第 n 条记录的内容由 n 决定，读回时可逐字节核对
+static void fillRecord(uint32_t n, uint8_t* out, size_t length) {
+    uint32_t x = n * 2654435761u + 1;
+    for (size_t i = 0; i < length; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        out[i] = (uint8_t)x;
+    }
+}
+
+struct Written {
+    uint32_t n;          // 记录序号，决定内容
+    uint32_t length;
+};
+
+static double elapsedUs(Clock::time_point from) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - from).count();
+}
+
+static std::string makeImage(const char* name) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/%s_XXXXXX", name);
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    unlink(path);   // hostPartitionAdd 按大小不符新建并填充 0xFF
+    return path;
+}
+
+static bool verify(RingStore& store, uint32_t id, const Written& w, std::vector<uint8_t>& expect,
+                   std::vector<uint8_t>& got) {
+    fillRecord(w.n, expect.data(), w.length);
+    return store.read(id, 0, got.data(), w.length + 1) == w.length && memcmp(expect.data(), got.data(), w.length) == 0;
+}
+
+struct Metrics {
+    uint64_t payload = 0;
+    double appendUs = 0;
+    uint64_t readBytes = 0;
+    double readUs = 0;
+    double modeledWriteUs = 0;
+    double modeledReadUs = 0;
+    HostPartitionStats flash = {};
+    uint32_t minErases = 0;
+    uint32_t maxErases = 0;
+    uint32_t retained = 0;       // 结束时仍可读的数据字节
+};
+
+static void eraseSpread(const char* label, Metrics& m) {
+    const uint32_t* counts = hostPartitionEraseCounts(label);
+    m.minErases = UINT32_MAX;
+    m.maxErases = 0;
+    for (uint32_t s = 0; s < PARTITION_BYTES / SPI_FLASH_SEC_SIZE; s++) {
+        m.minErases = min(m.minErases, counts[s]);
+        m.maxErases = max(m.maxErases, counts[s]);
+    }
+}
+
+static void report(const char* name, const Metrics& m) {
+    double mb = m.payload / 1048576.0;
+    printf("%-9s append %7.1f MB/s host, %6.1f KB/s device | read %7.1f MB/s host, %6.1f MB/s device |"
+           " programmed %.2fx, %.1f erases/MB, sector erases %u-%u | retained %u KB\n",
+           name, mb / (m.appendUs / 1e6), m.payload / 1024.0 / (m.modeledWriteUs / 1e6),
+           m.readBytes / 1048576.0 / (m.readUs / 1e6), m.readBytes / 1048576.0 / (m.modeledReadUs / 1e6),
+           (double)m.flash.bytesWritten / m.payload, m.flash.sectorErases / mb, m.minErases, m.maxErases,
+           m.retained / 1024);
+}
+
+// 1. 连续追加与重建
+static bool runRing(const Options& opts, Metrics& m) {
+    std::string image = makeImage("ring_bench");
+    if (!hostPartitionAdd("ring", SUBTYPE, PARTITION_BYTES, image.c_str())) {
+        fprintf(stderr, "Cannot create %s\n", image.c_str());
+        return false;
+    }
+    RingStore store;
+    store.begin("ring", SUBTYPE, [](uint32_t, const RingRecordHeader&) {});
+    hostPartitionResetStats("ring");
+
+    std::vector<uint8_t> data(opts.maxBytes + 1), expect(opts.maxBytes + 1), got(opts.maxBytes + 1);
+    std::map<uint32_t, Written> written;   // id -> 记录
+    uint32_t spotFailures = 0;
+    rng = opts.seed;
+    for (uint32_t n = 0; n < opts.records; n++) {
+        uint32_t length = opts.minBytes + nextRandom() % (opts.maxBytes - opts.minBytes + 1);
+        fillRecord(n, data.data(), length);
+        uint32_t id;
+        auto start = Clock::now();
+        if (!store.append(n, n & 0xFFFF, data.data(), length, id)) {
+            fprintf(stderr, "append %u failed\n", n);
+            return false;
+        }
+        m.appendUs += elapsedUs(start);
+        m.payload += length;
+        written[id] = {n, length};
+
+        // 抽查一条仍在环中的较早记录
+        for (auto it = written.begin(); it != written.end() && !store.isLive(it->first);) {
+            it = written.erase(it);
+        }
+        auto pick = written.begin();
+        std::advance(pick, nextRandom() % written.size());
+        if (!verify(store, pick->first, pick->second, expect, got)) spotFailures++;
+    }
+    m.flash = hostPartitionStats("ring");
+    m.modeledWriteUs = m.flash.modeledUs;
+    eraseSpread("ring", m);
+
+    // 读取吞吐：逐条拷贝全部仍在环中的记录
+    for (int pass = 0; pass < 20; pass++) {
+        for (const auto& entry : written) {
+            auto start = Clock::now();
+            size_t n = store.read(entry.first, 0, got.data(), entry.second.length);
+            m.readUs += elapsedUs(start);
+            m.readBytes += n;
+        }
+    }
+    m.modeledReadUs = m.readBytes * MAPPED_READ_US_PER_BYTE;
+
+    // 重新扫描分区，重建的记录须与仍在环中的完全相同
+    RingStore reopened;
+    std::map<uint32_t, uint32_t> rebuilt;
+    reopened.begin("ring", SUBTYPE, [&rebuilt](uint32_t id, const RingRecordHeader& h) { rebuilt[id] = h.length; });
+    uint32_t rebuildFailures = 0;
+    for (const auto& entry : written) {
+        m.retained += entry.second.length;
+        auto it = rebuilt.find(entry.first);
+        if (it == rebuilt.end() || it->second != entry.second.length ||
+            !verify(reopened, entry.first, entry.second, expect, got)) {
+            rebuildFailures++;
+        }
+    }
+    rebuildFailures += rebuilt.size() > written.size() ? rebuilt.size() - written.size() : 0;
+
+    printf("ring: %u records, %u live, %.1f laps; spot-check failures %u, rebuild mismatches %u, dirty writes %u\n",
+           opts.records, (unsigned)written.size(), (double)m.flash.bytesWritten / PARTITION_BYTES, spotFailures,
+           rebuildFailures, m.flash.dirtyWrites);
+    unlink(image.c_str());
+    return spotFailures == 0 && rebuildFailures == 0 && m.flash.dirtyWrites == 0;
+}
+
+// 2. 掉电注入
+static bool runPowerCuts(const Options& opts) {
+    std::string image = makeImage("ring_cut");
+    if (!hostPartitionAdd("cut", SUBTYPE, PARTITION_BYTES, image.c_str())) return false;
+    // 断电期间追加必然失败，不打印错误
+    Logger::setLogLevel((LogLevel)(LOG_ERROR - 1));
+
+    std::vector<uint8_t> data(opts.maxBytes + 1), expect(opts.maxBytes + 1), got(opts.maxBytes + 1);
+    std::map<uint32_t, Written> acked;
+    uint32_t n = 0, lost = 0, corrupt = 0, recovered = 0;
+    rng = opts.seed + 1;
+
+    RingStore* store = new RingStore();
+    store->begin("cut", SUBTYPE, [](uint32_t, const RingRecordHeader&) {});
+    for (uint32_t cut = 0; cut < opts.powerCuts; cut++) {
+        // 在接下来约 0-3 条记录的写入量内断电
+        hostPartitionFailAfter("cut", nextRandom() % (3 * opts.maxBytes));
+        while (true) {
+            uint32_t length = opts.minBytes + nextRandom() % (opts.maxBytes - opts.minBytes + 1);
+            fillRecord(n, data.data(), length);
+            uint32_t id;
+            bool ok = store->append(n, 0, data.data(), length, id);
+            n++;
+            if (!ok) break;
+            acked[id] = {n - 1, length};
+        }
+        for (auto it = acked.begin(); it != acked.end();) {
+            it = store->isLive(it->first) ? std::next(it) : acked.erase(it);
+        }
+
+        // 重启
+        hostPartitionFailAfter("cut", UINT64_MAX);
+        delete store;
+        store = new RingStore();
+        std::map<uint32_t, Written> found;
+        store->begin("cut", SUBTYPE, [&found](uint32_t id, const RingRecordHeader& h) {
+            found[id] = {h.timestamp, h.length};
+        });
+        for (const auto& entry : acked) {
+            if (!found.count(entry.first)) lost++;
+        }
+        for (const auto& entry : found) {
+            // 时间戳存的是记录序号
+            if (!verify(*store, entry.first, entry.second, expect, got)) corrupt++;
+        }
+        recovered += found.size();
+        acked = found;
+    }
+    delete store;
+    Logger::setLogLevel(LOG_INFO);
+
+    printf("power cuts: %u, records recovered %u, acknowledged records lost %u, corrupt reads %u\n",
+           opts.powerCuts, recovered, lost, corrupt);
+    unlink(image.c_str());
+    return lost == 0 && corrupt == 0;
+}
+
+#ifdef HAVE_LITTLEFS
+// 3. littlefs 对照：参数同 esp_littlefs 的默认配置
+static const uint32_t LFS_SEGMENT_SIZE = 64 * 1024;
+static const uint32_t LFS_QUOTA = 256 * 1024;   // 写时复制需要空闲块，配额取分区的 2/3
+
+static const esp_partition_t* lfsPartition = nullptr;
+
+static int lfsRead(const struct lfs_config*, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size) {
+    return esp_partition_read(lfsPartition, block * SPI_FLASH_SEC_SIZE + off, buffer, size) == ESP_OK ? 0 : LFS_ERR_IO;
+}
+
+static int lfsProg(const struct lfs_config*, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size) {
+    return esp_partition_write(lfsPartition, block * SPI_FLASH_SEC_SIZE + off, buffer, size) == ESP_OK ? 0 : LFS_ERR_IO;
+}
+
+static int lfsErase(const struct lfs_config*, lfs_block_t block) {
+    return esp_partition_erase_range(lfsPartition, block * SPI_FLASH_SEC_SIZE, SPI_FLASH_SEC_SIZE) == ESP_OK ? 0 : LFS_ERR_IO;
+}
+
+static int lfsSync(const struct lfs_config*) {
+    return 0;
+}
+
+static std::string segmentPath(uint32_t segment) {
+    return "/seg_" + std::to_string(segment) + ".bin";
+}
+
+static bool runLittleFs(const Options& opts, Metrics& m) {
+    std::string image = makeImage("lfs_bench");
+    if (!hostPartitionAdd("lfs", SUBTYPE, PARTITION_BYTES, image.c_str())) return false;
+    lfsPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, SUBTYPE, "lfs");
+
+    struct lfs_config cfg = {};
+    cfg.read = lfsRead;
+    cfg.prog = lfsProg;
+    cfg.erase = lfsErase;
+    cfg.sync = lfsSync;
+    cfg.read_size = 128;
+    cfg.prog_size = 128;
+    cfg.block_size = SPI_FLASH_SEC_SIZE;
+    cfg.block_count = PARTITION_BYTES / SPI_FLASH_SEC_SIZE;
+    cfg.block_cycles = 512;
+    cfg.cache_size = 512;
+    cfg.lookahead_size = 128;
+
+    lfs_t lfs;
+    if (lfs_format(&lfs, &cfg) != 0 || lfs_mount(&lfs, &cfg) != 0) {
+        fprintf(stderr, "littlefs format/mount failed\n");
+        return false;
+    }
+    hostPartitionResetStats("lfs");
+
+    struct Entry {
+        uint32_t offset;
+        Written w;
+    };
+    std::vector<Entry> entries;
+    std::vector<uint8_t> data(opts.maxBytes), expect(opts.maxBytes), got(opts.maxBytes);
+    uint32_t nextOffset = 0, firstSegment = 0, failures = 0;
+    rng = opts.seed;
+
+    for (uint32_t n = 0; n < opts.records; n++) {
+        uint32_t length = opts.minBytes + nextRandom() % (opts.maxBytes - opts.minBytes + 1);
+        fillRecord(n, data.data(), length);
+        auto start = Clock::now();
+
+        uint32_t segment = nextOffset / LFS_SEGMENT_SIZE;
+        uint32_t position = nextOffset % LFS_SEGMENT_SIZE;
+        if (position + length > LFS_SEGMENT_SIZE) {
+            segment++;
+            position = 0;
+            nextOffset = segment * LFS_SEGMENT_SIZE;
+        }
+        while ((segment - firstSegment + 1) * LFS_SEGMENT_SIZE > LFS_QUOTA) {
+            lfs_remove(&lfs, segmentPath(firstSegment).c_str());
+            while (!entries.empty() && entries.front().offset < (firstSegment + 1) * LFS_SEGMENT_SIZE) {
+                entries.erase(entries.begin());
+            }
+            firstSegment++;
+        }
+
+        lfs_file_t file;
+        bool ok = lfs_file_open(&lfs, &file, segmentPath(segment).c_str(), LFS_O_RDWR | LFS_O_CREAT) == 0;
+        ok = ok && lfs_file_seek(&lfs, &file, position, LFS_SEEK_SET) == (lfs_soff_t)position &&
+             lfs_file_write(&lfs, &file, data.data(), length) == (lfs_ssize_t)length;
+        ok = lfs_file_close(&lfs, &file) == 0 && ok;
+        // 原实现每条事件追加 16 字节索引
+        uint8_t record[16] = {};
+        ok = ok && lfs_file_open(&lfs, &file, "/index.bin", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND) == 0;
+        ok = ok && lfs_file_write(&lfs, &file, record, sizeof(record)) == (lfs_ssize_t)sizeof(record);
+        ok = lfs_file_close(&lfs, &file) == 0 && ok;
+        m.appendUs += elapsedUs(start);
+        if (!ok) {
+            fprintf(stderr, "littlefs append %u failed\n", n);
+            return false;
+        }
+        m.payload += length;
+        entries.push_back({nextOffset, {n, length}});
+        nextOffset += length;
+    }
+    m.flash = hostPartitionStats("lfs");
+    m.modeledWriteUs = m.flash.modeledUs;
+    eraseSpread("lfs", m);
+
+    hostPartitionResetStats("lfs");
+    for (int pass = 0; pass < 20; pass++) {
+        for (const Entry& e : entries) {
+            auto start = Clock::now();
+            lfs_file_t file;
+            lfs_ssize_t n = -1;
+            if (lfs_file_open(&lfs, &file, segmentPath(e.offset / LFS_SEGMENT_SIZE).c_str(), LFS_O_RDONLY) == 0) {
+                if (lfs_file_seek(&lfs, &file, e.offset % LFS_SEGMENT_SIZE, LFS_SEEK_SET) >= 0) {
+                    n = lfs_file_read(&lfs, &file, got.data(), e.w.length);
+                }
+                lfs_file_close(&lfs, &file);
+            }
+            m.readUs += elapsedUs(start);
+            fillRecord(e.w.n, expect.data(), e.w.length);
+            if (n != (lfs_ssize_t)e.w.length || memcmp(expect.data(), got.data(), e.w.length) != 0) failures++;
+            m.readBytes += e.w.length;
+        }
+    }
+    m.modeledReadUs = hostPartitionStats("lfs").modeledUs;
+    for (const Entry& e : entries) m.retained += e.w.length;
+
+    lfs_unmount(&lfs);
+    printf("littlefs: %u records, %u live, read failures %u\n", opts.records, (unsigned)entries.size(), failures);
+    unlink(image.c_str());
+    return failures == 0;
+}
+#endif
+
+int main(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return 1;
+        }
+        uint32_t value = strtoul(argv[++i], nullptr, 10);
+        if (strcmp(arg, "--records") == 0) opts.records = value;
+        else if (strcmp(arg, "--min-kb") == 0) opts.minBytes = value * 1024;
+        else if (strcmp(arg, "--max-kb") == 0) opts.maxBytes = value * 1024;
+        else if (strcmp(arg, "--power-cuts") == 0) opts.powerCuts = value;
+        else if (strcmp(arg, "--seed") == 0 && value) opts.seed = value;
+        else {
+            fprintf(stderr, "Unknown option %s\n", arg);
+            return 1;
+        }
+    }
+    // 上限同 RingStore::maxRecordBytes
+    if (!opts.records || !opts.minBytes || opts.minBytes > opts.maxBytes ||
+        opts.maxBytes > PARTITION_BYTES / 4 - RingStore::ALIGN) {
+        fprintf(stderr, "Record sizes must satisfy 0 < min-kb <= max-kb < %u KB\n", PARTITION_BYTES / 4 / 1024);
+        return 1;
+    }
+
+    printf("partition %u KB, %u records of %u-%u KB\n", PARTITION_BYTES / 1024, opts.records,
+           opts.minBytes / 1024, opts.maxBytes / 1024);
+    Logger::setLogLevel(LOG_WARN);
+    Metrics ring;
+    bool ok = runRing(opts, ring);
+    ok = runPowerCuts(opts) && ok;
+#ifdef HAVE_LITTLEFS
+    Metrics lfs;
+    ok = runLittleFs(opts, lfs) && ok;
+    report("ring", ring);
+    report("littlefs", lfs);
+#else
+    report("ring", ring);
+    printf("littlefs comparison skipped: tools/third_party/littlefs/lfs.c was missing at build time (see its README.md)\n");
+#endif
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+// RtspServer 主机端验证：把 .mcfr 录制文件循环编码为 JPEG，经 RTSP 推流
+//
+// 用法:
+//   rtsp_replay <recording.mcfr> [--port N] [--rtp-port N] [--fps N] [--quality N] [--seconds N]
+//
+// 用普通 RTSP 客户端拉流，例如:
+//   ffplay rtsp://127.0.0.1:8554/stream
+//   ffplay -rtsp_transport tcp rtsp://127.0.0.1:8554/stream
+//
+// 帧按 --fps 提交（默认 STREAM_FPS），退出时打印会话与发送统计
+//
+// 构建: tools/build_host.sh（需要 libjpeg 开发包）
+
+#include "rtsp_server.h"
+#include "frame_recording.h"
+#include <esp_camera.h>
+#include <jpeglib.h>
+#include <signal.h>
+#include <vector>
+
+struct Options {
+    const char* recordingPath = nullptr;
+    int port = 8554;
+    int rtpPort = RTSP_RTP_PORT;
+    int fps = STREAM_FPS;
+    int quality = 80;
+    int seconds = 0;
+};
+
+static volatile bool running = true;
+
+static bool loadFrames(const char* path, RecordingHeader& header, std::vector<std::vector<uint8_t>>& frames) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 && isValidRecordingHeader(header) &&
+              header.pixformat == PIXFORMAT_RGB565;
+    if (!ok) {
+        fprintf(stderr, "Not an RGB565 .mcfr recording\n");
+        fclose(f);
+        return false;
+    }
+
+    fseek(f, header.headerSize, SEEK_SET);
+    for (uint32_t i = 0; i < header.frameCount; i++) {
+        RecordingFrameHeader fh;
+        if (fread(&fh, sizeof(fh), 1, f) != 1) break;
+        std::vector<uint8_t> pixels(fh.length);
+        if (fread(pixels.data(), 1, fh.length, f) != fh.length) break;
+        if (fh.length >= (size_t)header.width * header.height * 2) frames.push_back(std::move(pixels));
+    }
+    fclose(f);
+    return !frames.empty();
+}
+
+// RGB565（大端，与传感器输出一致）编码为 JPEG，结果用 malloc 分配
+static uint8_t* encodeJpeg(const uint8_t* rgb565, int width, int height, int quality, size_t& size) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char* out = nullptr;
+    unsigned long outSize = 0;
+    jpeg_mem_dest(&cinfo, &out, &outSize);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    std::vector<uint8_t> row(width * 3);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        const uint8_t* src = rgb565 + (size_t)cinfo.next_scanline * width * 2;
+        for (int x = 0; x < width; x++) {
+            uint16_t p = src[x * 2] << 8 | src[x * 2 + 1];
+            row[x * 3] = (p >> 11) << 3;
+            row[x * 3 + 1] = ((p >> 5) & 0x3f) << 2;
+            row[x * 3 + 2] = (p & 0x1f) << 3;
+        }
+        JSAMPROW rows[1] = {row.data()};
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    size = outSize;
+    return out;
+}
+
+static void printUsage() {
+    fprintf(stderr,
+            "Usage: rtsp_replay <recording.mcfr> [--port N] [--rtp-port N] [--fps N] "
+            "[--quality N] [--seconds N]\n");
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--port") == 0 && hasValue) opt.port = atoi(argv[++i]);
+        else if (strcmp(arg, "--rtp-port") == 0 && hasValue) opt.rtpPort = atoi(argv[++i]);
+        else if (strcmp(arg, "--fps") == 0 && hasValue) opt.fps = atoi(argv[++i]);
+        else if (strcmp(arg, "--quality") == 0 && hasValue) opt.quality = atoi(argv[++i]);
+        else if (strcmp(arg, "--seconds") == 0 && hasValue) opt.seconds = atoi(argv[++i]);
+        else if (arg[0] != '-' && !opt.recordingPath) opt.recordingPath = arg;
+        else return false;
+    }
+    return opt.recordingPath && opt.fps > 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printUsage();
+        return 1;
+    }
+
+    RecordingHeader header;
+    std::vector<std::vector<uint8_t>> frames;
+    if (!loadFrames(opt.recordingPath, header, frames)) return 1;
+
+    // 预先编码，推流循环只做提交和发送
+    std::vector<std::pair<uint8_t*, size_t>> jpegs;
+    size_t totalBytes = 0;
+    for (const auto& pixels : frames) {
+        size_t size = 0;
+        uint8_t* jpeg = encodeJpeg(pixels.data(), header.width, header.height, opt.quality, size);
+        jpegs.push_back({jpeg, size});
+        totalBytes += size;
+    }
+    printf("%zu frames %ux%u, avg JPEG %zu bytes\n", jpegs.size(), header.width, header.height,
+           totalBytes / jpegs.size());
+
+    signal(SIGINT, [](int) { running = false; });
+    signal(SIGPIPE, SIG_IGN);
+
+    // 提交的是副本，发送后由服务器释放
+    RtspServer server([](uint8_t* jpeg) { free(jpeg); });
+    if (!server.begin(opt.port, opt.rtpPort)) return 1;
+    printf("Streaming at rtsp://127.0.0.1:%d/stream (Ctrl-C to stop)\n", opt.port);
+
+    uint32_t interval = 1000 / opt.fps;
+    uint32_t start = millis();
+    uint32_t nextFrame = start;
+    size_t index = 0;
+    while (running && (opt.seconds == 0 || millis() - start < (uint32_t)opt.seconds * 1000)) {
+        uint32_t now = millis();
+        if ((int32_t)(now - nextFrame) >= 0) {
+            nextFrame += interval;
+            if (server.isPlaying()) {
+                const auto& jpeg = jpegs[index++ % jpegs.size()];
+                uint8_t* copy = (uint8_t*)malloc(jpeg.second);
+                memcpy(copy, jpeg.first, jpeg.second);
+                server.submitFrame(copy, jpeg.second, now);
+            }
+        }
+        int32_t wait = (int32_t)(nextFrame - millis());
+        server.poll(wait > 0 ? min<int32_t>(wait, RTSP_POLL_MS) : 0);
+    }
+
+    RtspStats stats = server.getStats();
+    printf("connections %u, rejected %u, frames submitted %u, sent %u, dropped %u, invalid %u\n",
+           stats.connections, stats.rejected, stats.framesSubmitted, stats.framesSent,
+           stats.framesDropped, stats.framesInvalid);
+    printf("packets %u, bytes %u, send errors %u\n", stats.packetsSent, stats.bytesSent, stats.sendErrors);
+
+    for (auto& jpeg : jpegs) free(jpeg.first);
+    return 0;
+}
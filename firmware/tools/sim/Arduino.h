@@ -0,0 +1,155 @@
+#pragma once
+
+// 整机仿真的 Arduino-ESP32 替身：String、Serial、ESP、时间函数
+// 与 tools/host/Arduino.h 不同，这里的临界区和任务是真实的多线程实现
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_task_wdt.h"
+#include "esp_err.h"
+
+using std::min;
+using std::max;
+
+#define ARDUINO_RUNNING_CORE 1
+#define IRAM_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+class String {
+public:
+    String(const char* s = "") : s(s ? s : "") {}
+    String(const std::string& s) : s(s) {}
+    explicit String(char c) : s(1, c) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned int v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    String(long long v) : s(std::to_string(v)) {}
+    String(unsigned long long v) : s(std::to_string(v)) {}
+    String(double v, unsigned int decimals = 2);
+
+    const char* c_str() const { return s.c_str(); }
+    size_t length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(size_t size) { s.reserve(size); return true; }
+    char charAt(size_t i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](size_t i) const { return charAt(i); }
+
+    String substring(size_t from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+    String substring(size_t from, size_t to) const;
+    int indexOf(char c, size_t from = 0) const;
+    int indexOf(const char* str, size_t from = 0) const;
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const;
+    void replace(const String& from, const String& to);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+    long toInt() const { return strtol(s.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(s.c_str(), nullptr); }
+    bool equalsIgnoreCase(const String& other) const { return strcasecmp(s.c_str(), other.c_str()) == 0; }
+
+    bool concat(const String& other) { s += other.s; return true; }
+    bool concat(const char* str, size_t len) { s.append(str, len); return true; }
+    String& operator+=(const String& other) { s += other.s; return *this; }
+    String& operator+=(const char* str) { s += str; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator==(const char* str) const { return s == str; }
+    bool operator!=(const String& other) const { return s != other.s; }
+    bool operator!=(const char* str) const { return s != str; }
+    bool operator<(const String& other) const { return s < other.s; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+
+private:
+    std::string s;
+};
+
+// Print / Stream 接口（ArduinoJson 通过它们读写 File 和 Serial）
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t len);
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write((const uint8_t*)str.c_str(), str.length()); }
+    size_t println(const char* str = "");
+    size_t println(const String& str) { return println(str.c_str()); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t readBytes(uint8_t* buffer, size_t len);
+};
+
+// 写到标准输出，多任务输出按行不交错
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    // 以原参数重新执行进程，LittleFS 目录保留，等同设备重启
+    void restart();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getHeapSize();
+    uint32_t getFreePsram();
+    uint32_t getMinFreePsram();
+    uint32_t getPsramSize();
+    uint32_t getCpuFreqMHz() { return 240; }
+};
+
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void* ps_malloc(size_t size);
+
+// glibc 2.38 之前没有 strlcpy
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+// 主机时钟已经是真实时间，对时只记录时区
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+uint32_t esp_random();
@@ -0,0 +1,288 @@
+#pragma once
+
+// ArduinoJson 6 替身：只实现固件用到的接口
+// 文档容量按 32 位 ArduinoJson 6 的内存模型计算（每个成员或元素 16 字节，复制的字符串另计 len+1），
+// 超出容量时与原库一样静默丢弃新值并置 overflowed()，同时打印一次警告，便于在仿真中发现容量不足
+// 节点本身不计入仿真堆统计；DynamicJsonDocument 另外按容量 malloc 一块，模拟它在堆上的内存池
+
+#include <Arduino.h>
+#include "sim.h"
+#include <deque>
+#include <vector>
+
+class JsonDocument;
+
+struct JsonNode {
+    enum Type : uint8_t { Null, Bool, Int, UInt, Double, Str, Array, Object };
+
+    Type type = Null;
+    bool b = false;
+    int64_t i = 0;
+    uint64_t u = 0;
+    double f = 0;
+    std::basic_string<char, std::char_traits<char>, SimUntrackedAllocator<char>> str;
+    std::vector<const char*, SimUntrackedAllocator<const char*>> keys;
+    std::vector<JsonNode*, SimUntrackedAllocator<JsonNode*>> children;
+    JsonDocument* doc = nullptr;
+};
+
+class JsonVariant;
+class JsonObject;
+class JsonArray;
+
+class JsonDocument {
+public:
+    explicit JsonDocument(size_t capacity);
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+    virtual ~JsonDocument() {}
+
+    size_t capacity() const { return _capacity; }
+    size_t memoryUsage() const { return used; }
+    bool overflowed() const { return _overflowed; }
+    void clear();
+
+    JsonVariant operator[](const char* key);
+    JsonVariant operator[](const String& key);
+    JsonObject createNestedObject(const char* key);
+    JsonArray createNestedArray(const char* key);
+
+    template <typename T>
+    T to();
+    template <typename T>
+    T as();
+
+    // 以下由替身内部使用
+    JsonNode* root() { return &_root; }
+    JsonNode* newNode(JsonNode::Type type);
+    const char* saveKey(const char* key, bool copy);
+    bool charge(size_t bytes);
+
+private:
+    JsonNode _root;
+    std::deque<JsonNode, SimUntrackedAllocator<JsonNode>> nodes;
+    std::deque<std::basic_string<char, std::char_traits<char>, SimUntrackedAllocator<char>>,
+               SimUntrackedAllocator<std::basic_string<char, std::char_traits<char>, SimUntrackedAllocator<char>>>>
+        copiedKeys;
+    size_t _capacity;
+    size_t used = 0;
+    bool _overflowed = false;
+};
+
+template <size_t N>
+class StaticJsonDocument : public JsonDocument {
+public:
+    StaticJsonDocument() : JsonDocument(N) {}
+};
+
+class DynamicJsonDocument : public JsonDocument {
+public:
+    explicit DynamicJsonDocument(size_t capacity) : JsonDocument(capacity), pool(malloc(capacity)) {}
+    ~DynamicJsonDocument() override { free(pool); }
+
+private:
+    void* pool;
+};
+
+class JsonVariant {
+public:
+    JsonVariant(JsonNode* node = nullptr) : node(node) {}
+
+    bool isNull() const { return !node || node->type == JsonNode::Null; }
+
+    void set(bool value);
+    void set(int value) { setSigned(value); }
+    void set(long value) { setSigned(value); }
+    void set(long long value) { setSigned(value); }
+    void set(unsigned int value) { setUnsigned(value); }
+    void set(unsigned long value) { setUnsigned(value); }
+    void set(unsigned long long value) { setUnsigned(value); }
+    void set(short value) { setSigned(value); }
+    void set(unsigned short value) { setUnsigned(value); }
+    void set(signed char value) { setSigned(value); }
+    void set(unsigned char value) { setUnsigned(value); }
+    void set(float value);
+    void set(double value);
+    // const char* 按指针保存，不占文档容量；char* 和 String 复制
+    void set(const char* value) { setString(value, false); }
+    void set(char* value) { setString(value, true); }
+    void set(const String& value) { setString(value.c_str(), true); }
+
+    template <typename T>
+    JsonVariant& operator=(const T& value) {
+        set(value);
+        return *this;
+    }
+    JsonVariant& operator=(const JsonVariant&) = delete;
+
+    JsonVariant operator[](const char* key) const;
+    JsonVariant operator[](size_t index) const;
+
+    template <typename T>
+    T as() const;
+
+    operator JsonObject() const;
+    operator JsonArray() const;
+
+    const char* operator|(const char* fallback) const;
+    bool operator|(bool fallback) const;
+    int operator|(int fallback) const { return (int)numberOr(fallback); }
+    long operator|(long fallback) const { return (long)numberOr(fallback); }
+    unsigned int operator|(unsigned int fallback) const { return (unsigned int)numberOr(fallback); }
+    unsigned long operator|(unsigned long fallback) const { return (unsigned long)numberOr(fallback); }
+    uint16_t operator|(uint16_t fallback) const { return (uint16_t)numberOr(fallback); }
+    uint8_t operator|(uint8_t fallback) const { return (uint8_t)numberOr(fallback); }
+    int16_t operator|(int16_t fallback) const { return (int16_t)numberOr(fallback); }
+    float operator|(float fallback) const { return (float)numberOr(fallback); }
+    double operator|(double fallback) const { return numberOr(fallback); }
+
+    JsonNode* raw() const { return node; }
+
+private:
+    JsonNode* node;
+
+    void setSigned(long long value);
+    void setUnsigned(unsigned long long value);
+    void setString(const char* value, bool copy);
+    double numberOr(double fallback) const;
+    bool isNumber() const;
+};
+
+class JsonObject {
+public:
+    JsonObject(JsonNode* node = nullptr) : node(node) {}
+    bool isNull() const { return !node || node->type != JsonNode::Object; }
+    explicit operator bool() const { return !isNull(); }
+    size_t size() const { return isNull() ? 0 : node->children.size(); }
+    bool containsKey(const char* key) const;
+
+    JsonVariant operator[](const char* key) const;
+    JsonVariant operator[](const String& key) const { return (*this)[key.c_str()]; }
+    JsonObject createNestedObject(const char* key) const;
+    JsonArray createNestedArray(const char* key) const;
+
+    JsonNode* raw() const { return node; }
+
+private:
+    JsonNode* node;
+};
+
+class JsonArray {
+public:
+    class iterator {
+    public:
+        iterator(JsonNode* const* pos) : pos(pos) {}
+        JsonVariant operator*() const { return JsonVariant(*pos); }
+        iterator& operator++() {
+            ++pos;
+            return *this;
+        }
+        bool operator!=(const iterator& other) const { return pos != other.pos; }
+
+    private:
+        JsonNode* const* pos;
+    };
+
+    JsonArray(JsonNode* node = nullptr) : node(node) {}
+    bool isNull() const { return !node || node->type != JsonNode::Array; }
+    explicit operator bool() const { return !isNull(); }
+    size_t size() const { return isNull() ? 0 : node->children.size(); }
+
+    template <typename T>
+    bool add(const T& value) {
+        JsonNode* item = append();
+        if (!item) return false;
+        JsonVariant(item).set(value);
+        return true;
+    }
+    JsonObject createNestedObject() const;
+    JsonArray createNestedArray() const;
+    JsonVariant operator[](size_t index) const;
+
+    iterator begin() const { return iterator(isNull() ? nullptr : node->children.data()); }
+    iterator end() const { return iterator(isNull() ? nullptr : node->children.data() + node->children.size()); }
+
+    JsonNode* raw() const { return node; }
+
+private:
+    JsonNode* node;
+
+    JsonNode* append() const;
+};
+
+template <>
+inline JsonObject JsonDocument::to<JsonObject>() {
+    clear();
+    _root.type = JsonNode::Object;
+    return JsonObject(&_root);
+}
+
+template <>
+inline JsonArray JsonDocument::to<JsonArray>() {
+    clear();
+    _root.type = JsonNode::Array;
+    return JsonArray(&_root);
+}
+
+template <>
+inline JsonObject JsonDocument::as<JsonObject>() {
+    return JsonObject(&_root);
+}
+
+template <>
+inline JsonArray JsonDocument::as<JsonArray>() {
+    return JsonArray(&_root);
+}
+
+template <>
+inline JsonVariant JsonDocument::as<JsonVariant>() {
+    return JsonVariant(&_root);
+}
+
+template <>
+const char* JsonVariant::as<const char*>() const;
+template <>
+String JsonVariant::as<String>() const;
+template <>
+bool JsonVariant::as<bool>() const;
+template <>
+int JsonVariant::as<int>() const;
+template <>
+long JsonVariant::as<long>() const;
+template <>
+unsigned int JsonVariant::as<unsigned int>() const;
+template <>
+unsigned long JsonVariant::as<unsigned long>() const;
+template <>
+float JsonVariant::as<float>() const;
+template <>
+double JsonVariant::as<double>() const;
+template <>
+JsonObject JsonVariant::as<JsonObject>() const;
+template <>
+JsonArray JsonVariant::as<JsonArray>() const;
+
+class DeserializationError {
+public:
+    enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+
+    DeserializationError(Code code = Ok) : _code(code) {}
+    explicit operator bool() const { return _code != Ok; }
+    bool operator==(Code code) const { return _code == code; }
+    bool operator!=(Code code) const { return _code != code; }
+    Code code() const { return _code; }
+    const char* c_str() const;
+
+private:
+    Code _code;
+};
+
+size_t serializeJson(JsonDocument& doc, String& output);
+size_t serializeJson(JsonDocument& doc, Print& output);
+size_t serializeJson(JsonDocument& doc, char* output, size_t size);
+size_t measureJson(JsonDocument& doc);
+
+DeserializationError deserializeJson(JsonDocument& doc, Stream& input);
+DeserializationError deserializeJson(JsonDocument& doc, const char* input);
+DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length);
+DeserializationError deserializeJson(JsonDocument& doc, const String& input);
@@ -0,0 +1,43 @@
+#pragma once
+
+// AsyncUDP 替身：每个监听套接字一个接收线程，回调在该线程中执行（设备上在 LwIP 任务中执行）
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include <thread>
+#include <netinet/in.h>
+
+class AsyncUDPPacket {
+public:
+    AsyncUDPPacket(int fd, const sockaddr_in& from, const uint8_t* data, size_t len)
+        : fd(fd), from(from), _data(data), len(len) {}
+    const uint8_t* data() const { return _data; }
+    size_t length() const { return len; }
+    IPAddress remoteIP() const { return IPAddress(from.sin_addr.s_addr); }
+    uint16_t remotePort() const { return ntohs(from.sin_port); }
+    // 回复给发送方
+    size_t write(const uint8_t* data, size_t len);
+
+private:
+    int fd;
+    sockaddr_in from;
+    const uint8_t* _data;
+    size_t len;
+};
+
+typedef std::function<void(AsyncUDPPacket& packet)> AuPacketHandlerFunction;
+
+class AsyncUDP {
+public:
+    ~AsyncUDP() { close(); }
+    bool listen(uint16_t port);
+    void close();
+    void onPacket(AuPacketHandlerFunction cb) { handler = cb; }
+
+private:
+    int fd = -1;
+    std::atomic<bool> running{false};
+    std::thread receiver;
+    AuPacketHandlerFunction handler;
+};
@@ -0,0 +1,247 @@
+#pragma once
+
+// ESPAsyncWebServer 替身：基于回环套接字，行为按原库实现
+// - 所有请求处理函数和响应填充回调都在同一个 async_tcp 任务中执行，处理函数阻塞时其他连接一起停顿
+// - 路由按注册顺序匹配，"/a" 同时匹配 "/a/b"（与 AsyncCallbackWebHandler::canHandle 一致）
+// - 每个响应后关闭连接；填充回调每次最多拿到一个 TCP 发送窗口（SIM_TCP_SND_BUF）
+// - 所有连接共享 --link-kbps 限速，近似 WiFi 空口带宽
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <FS.h>
+#include <memory>
+#include <vector>
+
+#define SIM_TCP_SND_BUF 5744            // lwIP TCP_SND_BUF（4 * MSS）
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+typedef std::function<size_t(uint8_t*, size_t, size_t)> AwsResponseFiller;
+typedef std::function<void(void)> ArDisconnectHandler;
+
+class AsyncWebServerRequest;
+struct SimConnection;
+
+class AsyncWebParameter {
+public:
+    AsyncWebParameter(const String& name, const String& value, bool form = false, bool file = false)
+        : _name(name), _value(value), _isForm(form), _isFile(file) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+    size_t size() const { return _value.length(); }
+    bool isPost() const { return _isForm; }
+    bool isFile() const { return _isFile; }
+
+private:
+    String _name;
+    String _value;
+    bool _isForm;
+    bool _isFile;
+};
+
+class AsyncWebHeader {
+public:
+    AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+
+private:
+    String _name;
+    String _value;
+};
+
+class AsyncClient {
+public:
+    explicit AsyncClient(SimConnection* conn) : conn(conn) {}
+    IPAddress remoteIP() const;
+    uint16_t remotePort() const;
+    // 发送窗口剩余字节
+    size_t space() const;
+    bool connected() const;
+    void close(bool now = false);
+    // 与 AsyncTCP 相同：连续 seconds 秒没有收到数据或确认时，由连接自己的轮询关闭连接（0 为不限）
+    void setRxTimeout(uint32_t seconds);
+
+private:
+    SimConnection* conn;
+};
+
+class AsyncWebServerResponse {
+public:
+    virtual ~AsyncWebServerResponse() {}
+    void setCode(int code) { _code = code; }
+    int code() const { return _code; }
+    void setContentType(const String& type) { _contentType = type; }
+    void setContentLength(size_t len) { _contentLength = len; }
+    void addHeader(const String& name, const String& value) { _headers.emplace_back(name, value); }
+
+    // 以下由服务器调用
+    String assembleHead() const;
+    // 填充响应体，返回 0 表示结束（已知长度时未达 Content-Length 的 0 只是这一轮没有数据，与 ESPAsyncWebServer
+    // 一样之后再次轮询），RESPONSE_TRY_AGAIN 表示稍后再试
+    virtual size_t fillBody(uint8_t* buffer, size_t maxLen) = 0;
+    bool bodyKnownLength() const { return !_chunked; }
+    size_t contentLength() const { return _contentLength; }
+
+protected:
+    int _code = 200;
+    String _contentType;
+    size_t _contentLength = 0;
+    bool _chunked = false;
+    std::vector<AsyncWebHeader> _headers;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+public:
+    AsyncBasicResponse(int code, const String& contentType = String(), const String& content = String());
+    AsyncBasicResponse(int code, const String& contentType, const uint8_t* data, size_t len);
+    size_t fillBody(uint8_t* buffer, size_t maxLen) override;
+
+private:
+    std::string content;
+    size_t sent = 0;
+};
+
+class AsyncCallbackResponse : public AsyncWebServerResponse {
+public:
+    AsyncCallbackResponse(const String& contentType, size_t len, AwsResponseFiller filler, bool chunked = false);
+    size_t fillBody(uint8_t* buffer, size_t maxLen) override;
+
+private:
+    AwsResponseFiller filler;
+    size_t index = 0;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+public:
+    AsyncResponseStream(const String& contentType, size_t bufferSize);
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+    size_t fillBody(uint8_t* buffer, size_t maxLen) override;
+
+private:
+    std::string content;
+    size_t sent = 0;
+};
+
+class AsyncWebServerRequest {
+public:
+    explicit AsyncWebServerRequest(SimConnection* conn);
+    ~AsyncWebServerRequest();
+
+    AsyncClient* client() { return &_client; }
+    WebRequestMethodComposite method() const { return _method; }
+    const char* methodToString() const;
+    const String& url() const { return _url; }
+    const String& host() const;
+    const String& contentType() const { return _contentType; }
+    size_t contentLength() const { return _contentLength; }
+
+    size_t headers() const { return _headers.size(); }
+    bool hasHeader(const String& name) const;
+    AsyncWebHeader* getHeader(const String& name) const;
+    AsyncWebHeader* getHeader(size_t index) const;
+
+    size_t params() const { return _params.size(); }
+    bool hasParam(const String& name, bool post = false, bool file = false) const;
+    AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const;
+    AsyncWebParameter* getParam(size_t index) const;
+    bool hasArg(const char* name) const;
+    const String& arg(const char* name) const;
+
+    void send(AsyncWebServerResponse* response);
+    void send(int code, const String& contentType = String(), const String& content = String());
+    void redirect(const String& url);
+
+    AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(),
+                                          const String& content = String());
+    AsyncWebServerResponse* beginResponse(const String& contentType, size_t len, AwsResponseFiller filler);
+    AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller filler);
+    AsyncWebServerResponse* beginResponse_P(int code, const String& contentType, const uint8_t* content,
+                                            size_t len);
+    AsyncResponseStream* beginResponseStream(const String& contentType, size_t bufferSize = 1460);
+
+    void onDisconnect(ArDisconnectHandler fn) { _onDisconnect = fn; }
+
+    // 处理函数的私有数据，请求销毁时 free()
+    void* _tempObject = nullptr;
+
+    // 以下由服务器调用
+    bool parseHead(const std::string& head);
+    void parseFormBody(const std::string& body);
+    AsyncWebServerResponse* takeResponse();
+    void notifyDisconnect();
+
+private:
+    SimConnection* _conn;
+    AsyncClient _client;
+    WebRequestMethodComposite _method = 0;
+    String _url;
+    String _contentType;
+    size_t _contentLength = 0;
+    std::vector<std::unique_ptr<AsyncWebHeader>> _headers;
+    std::vector<std::unique_ptr<AsyncWebParameter>> _params;
+    AsyncWebServerResponse* _response = nullptr;
+    ArDisconnectHandler _onDisconnect;
+
+    void addParams(const std::string& encoded, bool form);
+};
+
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, const String&, size_t, uint8_t*, size_t, bool)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, uint8_t*, size_t, size_t, size_t)> ArBodyHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest*)> ArRequestFilterFunction;
+
+class AsyncCallbackWebHandler {
+public:
+    AsyncCallbackWebHandler(const String& uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                            ArBodyHandlerFunction onBody)
+        : uri(uri), method(method), onRequest(onRequest), onBody(onBody) {}
+
+    bool canHandle(AsyncWebServerRequest* request) const;
+    AsyncCallbackWebHandler& setFilter(ArRequestFilterFunction fn) { filter = fn; return *this; }
+
+    String uri;
+    WebRequestMethodComposite method;
+    ArRequestHandlerFunction onRequest;
+    ArBodyHandlerFunction onBody;
+    ArRequestFilterFunction filter;
+};
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) : port(port) {}
+    ~AsyncWebServer();
+
+    void begin();
+    void end();
+
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+    // 上传（multipart）回调不调用，仿真中只有请求体回调生效
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody = nullptr);
+    void onNotFound(ArRequestHandlerFunction fn) { notFound = fn; }
+
+    // 以下由 async_tcp 任务调用
+    AsyncCallbackWebHandler* findHandler(AsyncWebServerRequest* request);
+    void handleNotFound(AsyncWebServerRequest* request);
+    int listenFd() const { return fd; }
+
+private:
+    uint16_t port;
+    int fd = -1;
+    std::vector<std::unique_ptr<AsyncCallbackWebHandler>> handlers;
+    ArRequestHandlerFunction notFound;
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+// mDNS 替身：不发送组播，只记录服务名
+
+#include <Arduino.h>
+
+class MDNSResponder {
+public:
+    bool begin(const char* hostName);
+    void end() {}
+    bool addService(const char* service, const char* proto, uint16_t port);
+};
+
+extern MDNSResponder MDNS;
@@ -0,0 +1,17 @@
+#pragma once
+
+// LittleFS 替身：映射到主机目录 --fs-dir，进程重启（ESP.restart）后内容保留
+
+#include <FS.h>
+
+class LittleFSFS : public fs::FS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = "spiffs");
+    void end() {}
+    bool format();
+    size_t totalBytes();
+    size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
@@ -0,0 +1,108 @@
+#pragma once
+
+// WiFi 替身：STA 总是“连接”到回环地址，扫描返回固定列表
+// 连接结果和事件在单独的 sys_evt 线程中按 --connect-ms 延时投递，与设备上的事件任务一致
+
+#include <Arduino.h>
+#include <vector>
+
+class IPAddress {
+public:
+    IPAddress() : addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+    // 网络字节序
+    IPAddress(uint32_t addr) : addr(addr) {}
+    operator uint32_t() const { return addr; }
+    uint8_t operator[](int i) const { return (addr >> (8 * i)) & 0xFF; }
+    String toString() const;
+
+private:
+    uint32_t addr;
+};
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3,
+} wifi_mode_t;
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+} wifi_auth_mode_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_START = 2,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+} arduino_event_id_t;
+
+typedef struct {
+    uint32_t reason;
+} arduino_event_info_t;
+
+typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> WiFiEventFuncCb;
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t mode);
+    wifi_mode_t getMode() const { return _mode; }
+    bool setSleep(bool) { return true; }
+
+    wl_status_t begin(const char* ssid, const char* password = nullptr);
+    wl_status_t status() const { return _status; }
+    bool isConnected() const { return _status == WL_CONNECTED; }
+    bool reconnect();
+    bool disconnect();
+
+    IPAddress localIP() const { return isConnected() ? IPAddress(127, 0, 0, 1) : IPAddress(); }
+    String macAddress() const { return "24:0A:C4:00:51:3C"; }
+    String SSID() const { return isConnected() ? _ssid : String(); }
+
+    bool softAP(const char* ssid, const char* password = nullptr);
+    bool softAPConfig(IPAddress local, IPAddress gateway, IPAddress subnet);
+    IPAddress softAPIP() const { return _apIP; }
+
+    // 阻塞 --scan-ms，与设备上扫描阻塞调用者一致
+    int16_t scanNetworks();
+    void scanDelete() { scanResults.clear(); }
+    String SSID(uint8_t i) const;
+    int32_t RSSI(uint8_t i) const;
+    wifi_auth_mode_t encryptionType(uint8_t i) const;
+
+    void onEvent(WiFiEventFuncCb cb) { callbacks.push_back(cb); }
+
+private:
+    struct ScanResult {
+        const char* ssid;
+        int32_t rssi;
+        wifi_auth_mode_t auth;
+    };
+
+    volatile wifi_mode_t _mode = WIFI_STA;
+    volatile wl_status_t _status = WL_IDLE_STATUS;
+    String _ssid;
+    String _password;
+    IPAddress _apIP = IPAddress(192, 168, 4, 1);
+    std::vector<ScanResult> scanResults;
+    std::vector<WiFiEventFuncCb> callbacks;
+    uint32_t attempt = 0;
+
+    void connectLater();
+    void fire(arduino_event_id_t event);
+};
+
+extern WiFiClass WiFi;
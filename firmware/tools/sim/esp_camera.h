@@ -0,0 +1,77 @@
+#pragma once
+
+// esp32-camera 替身：类型沿用 tools/host/esp_camera.h，驱动行为见 sim_camera.cpp
+
+#include "../host/esp_camera.h"
+#include <esp_err.h>
+
+typedef enum {
+    CAMERA_GRAB_WHEN_EMPTY,
+    CAMERA_GRAB_LATEST,
+} camera_grab_mode_t;
+
+typedef enum {
+    CAMERA_FB_IN_PSRAM,
+    CAMERA_FB_IN_DRAM,
+} camera_fb_location_t;
+
+typedef enum {
+    LEDC_CHANNEL_0,
+} ledc_channel_t;
+
+typedef enum {
+    LEDC_TIMER_0,
+} ledc_timer_t;
+
+typedef struct {
+    int pin_pwdn;
+    int pin_reset;
+    int pin_xclk;
+    int pin_sccb_sda;
+    int pin_sccb_scl;
+    int pin_d7, pin_d6, pin_d5, pin_d4, pin_d3, pin_d2, pin_d1, pin_d0;
+    int pin_vsync;
+    int pin_href;
+    int pin_pclk;
+    int xclk_freq_hz;
+    ledc_timer_t ledc_timer;
+    ledc_channel_t ledc_channel;
+    pixformat_t pixel_format;
+    framesize_t frame_size;
+    int jpeg_quality;
+    size_t fb_count;
+    camera_fb_location_t fb_location;
+    camera_grab_mode_t grab_mode;
+    int sccb_i2c_port;
+} camera_config_t;
+
+typedef struct {
+    framesize_t framesize;
+    uint8_t quality;
+} camera_status_t;
+
+typedef struct _sensor sensor_t;
+struct _sensor {
+    camera_status_t status;
+    pixformat_t pixformat;
+    int (*set_framesize)(sensor_t* sensor, framesize_t framesize);
+    int (*set_quality)(sensor_t* sensor, int quality);
+    // OV2640：startX 为读出模式（0 UXGA，1 SVGA，2 CIF），offset/total 为该模式坐标中的窗口，
+    // output 为 DSP 缩放后的尺寸；其余参数 OV2640 不使用
+    int (*set_res_raw)(sensor_t* sensor, int startX, int startY, int endX, int endY, int offsetX, int offsetY,
+                       int totalX, int totalY, int outputX, int outputY, bool scale, bool binning);
+};
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+} resolution_info_t;
+
+extern const resolution_info_t resolution[];
+
+esp_err_t esp_camera_init(const camera_config_t* config);
+esp_err_t esp_camera_deinit();
+// 没有新帧时最多阻塞 4 秒（驱动的 FB_GET_TIMEOUT）
+camera_fb_t* esp_camera_fb_get();
+void esp_camera_fb_return(camera_fb_t* fb);
+sensor_t* esp_camera_sensor_get();
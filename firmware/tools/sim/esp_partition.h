@@ -0,0 +1,6 @@
+#pragma once
+
+// 与离线工具共用文件模拟的分区（tools/host/host_partition.cpp），sim_main 注册 events 分区
+
+#include <esp_err.h>
+#include "../host/esp_partition.h"
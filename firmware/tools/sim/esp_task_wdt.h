@@ -0,0 +1,11 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// 任务看门狗：订阅的任务超时未喂狗时打印告警（panic 时退出进程）
+esp_err_t esp_task_wdt_init(uint32_t timeoutSec, bool panic);
+esp_err_t esp_task_wdt_add(void* task);
+esp_err_t esp_task_wdt_delete(void* task);
+esp_err_t esp_task_wdt_reset();
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// 进程启动以来的微秒数（与 micros() 同一时间基准）
+int64_t esp_timer_get_time();
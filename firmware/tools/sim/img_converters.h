@@ -0,0 +1,21 @@
+#pragma once
+
+// esp32-camera 图像转换替身，JPEG 编码用 libjpeg
+
+#include <esp_camera.h>
+
+typedef size_t (*jpg_out_cb)(void* arg, size_t index, const void* data, size_t len);
+
+bool fmt2jpg_cb(uint8_t* src, size_t srcLen, uint16_t width, uint16_t height, pixformat_t format,
+                uint8_t quality, jpg_out_cb cb, void* arg);
+
+typedef enum {
+    JPG_SCALE_NONE,
+    JPG_SCALE_2X,
+    JPG_SCALE_4X,
+    JPG_SCALE_8X,
+    JPG_SCALE_MAX = JPG_SCALE_8X
+} jpg_scale_t;
+
+// JPEG 按 1/2^scale 解码为 RGB565（大端，与摄像头输出相同）
+bool jpg2rgb565(const uint8_t* src, size_t src_len, uint8_t* out, jpg_scale_t scale);
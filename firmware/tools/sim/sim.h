@@ -0,0 +1,65 @@
+#pragma once
+
+// 整机仿真内部接口：启动参数与各替身之间共享的状态
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct SimOptions {
+    const char* fsDir = "sim_fs";        // LittleFS 映射到的主机目录
+    const char* eventsImage = nullptr;   // events 分区的镜像文件，为空时为 <fsDir>.events.bin
+    const char* recording = nullptr;     // 摄像头回放的 .mcfr（RGB565），为空时生成合成画面
+    uint16_t portOffset = 8000;          // 特权端口（<1024）绑定时加上的偏移：80 -> 8080
+    uint32_t sensorFps = 15;             // 20 MHz XCLK 下的传感器帧率，随 XCLK 线性变化
+    uint32_t scanMs = 1500;              // WiFi 扫描阻塞调用者的时长
+    uint32_t connectMs = 800;            // STA 连接到拿到 IP 的时长
+    bool wifiFail = false;               // STA 连接总是失败
+    uint32_t heapSize = 512 * 1024;      // 内部堆大小（主机上指针更宽，比设备略大）
+    uint32_t psramSize = 8 * 1024 * 1024;
+    uint8_t maxConnections = 16;         // 同时打开的 TCP 连接（lwIP MEMP_NUM_TCP_PCB）
+    uint32_t linkKbps = 0;               // 所有 HTTP 连接共享的带宽，0 表示不限
+};
+
+extern SimOptions simOptions;
+
+// 打印并退出（替身检测到固件误用 API 时）
+[[noreturn]] void simFatal(const char* message);
+void simNameThread(const char* name);
+void simAdoptCurrentThread(const char* name);
+void simLog(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+// 堆统计（字节）
+struct SimHeapStats {
+    size_t internalUsed;
+    size_t internalPeak;
+    size_t psramUsed;
+    size_t psramPeak;
+};
+SimHeapStats simHeapStats();
+
+// 不计入堆统计的分配：替身自身的簿记，以及设备上位于栈或静态区的对象
+void* simUntrackedAlloc(size_t size);
+void simUntrackedFree(void* ptr);
+
+template <typename T>
+struct SimUntrackedAllocator {
+    typedef T value_type;
+    SimUntrackedAllocator() = default;
+    template <typename U>
+    SimUntrackedAllocator(const SimUntrackedAllocator<U>&) {}
+    T* allocate(size_t n) { return static_cast<T*>(simUntrackedAlloc(n * sizeof(T))); }
+    void deallocate(T* ptr, size_t) { simUntrackedFree(ptr); }
+    template <typename U>
+    bool operator==(const SimUntrackedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const SimUntrackedAllocator<U>&) const { return false; }
+};
+
+// 传感器 JPEG 输出：RGB565（大端）帧编码为 4:2:2 基线 JPEG
+// @param quality esp32-camera 的 jpeg_quality（0-63，越低质量越高）
+// @return JPEG 字节数，超出 capacity 时为 0（驱动丢弃该帧）
+size_t simEncodeSensorJpeg(const uint8_t* rgb565, int width, int height, int quality, uint8_t* out,
+                           size_t capacity);
+
+// 进程重启时重新执行的命令行
+void simSetArgs(int argc, char** argv);
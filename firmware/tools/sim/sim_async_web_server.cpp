@@ -0,0 +1,670 @@
+// ESPAsyncWebServer 替身的实现：单个 async_tcp 任务轮询所有监听套接字和连接
+#include "ESPAsyncWebServer.h"
+#include "sim.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <linux/sockios.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <mutex>
+
+static const size_t MAX_HEAD_BYTES = 8192;
+static const size_t MAX_BODY_BYTES = 64 * 1024;
+
+struct SimConnection {
+    int fd = -1;
+    sockaddr_in peer = {};
+    AsyncWebServer* server = nullptr;
+    std::string in;
+    size_t bodyStart = 0;        // 请求头结束位置，0 表示请求头未收完
+    size_t bodyLength = 0;
+    AsyncWebServerRequest* request = nullptr;
+    AsyncWebServerResponse* response = nullptr;
+    bool dispatched = false;
+    bool headSent = false;
+    bool bodyDone = false;
+    bool bodyStalled = false;    // 已知长度的响应体这一轮没有数据，等待轮询或超时
+    bool closing = false;
+    uint32_t rxTimeoutMs = 0;
+    uint64_t lastActivityUs = 0; // 最近一次收到数据或发出数据（AsyncTCP 的 _rx_last_packet 也随 ACK 更新）
+    size_t bodySent = 0;
+    std::string out;
+    size_t outPos = 0;
+};
+
+// async_tcp 任务的共享状态
+static std::mutex loopMutex;
+static std::vector<AsyncWebServer*> servers;
+static std::vector<SimConnection*> connections;
+static bool loopStarted = false;
+
+// 所有连接共享的空口带宽（令牌桶，字节）
+static double linkTokens = 0;
+static uint64_t linkLastUs = 0;
+
+static const char* statusText(int code) {
+    switch (code) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 416: return "Range Not Satisfiable";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default: return "";
+    }
+}
+
+static std::string urlDecode(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '+') {
+            out += ' ';
+        } else if (s[i] == '%' && i + 2 < s.size() && isxdigit((unsigned char)s[i + 1]) &&
+                   isxdigit((unsigned char)s[i + 2])) {
+            out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+// ---- 响应 ----
+
+String AsyncWebServerResponse::assembleHead() const {
+    char line[128];
+    snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", _code, statusText(_code));
+    String head(line);
+    head += "Connection: close\r\n";
+    if (_chunked) {
+        head += "Transfer-Encoding: chunked\r\n";
+    } else {
+        head += "Content-Length: " + String((unsigned long)_contentLength) + "\r\n";
+    }
+    if (_contentType.length()) head += "Content-Type: " + _contentType + "\r\n";
+    for (const AsyncWebHeader& h : _headers) {
+        head += h.name() + ": " + h.value() + "\r\n";
+    }
+    head += "\r\n";
+    return head;
+}
+
+AsyncBasicResponse::AsyncBasicResponse(int code, const String& contentType, const String& content)
+    : content(content.c_str(), content.length()) {
+    _code = code;
+    _contentType = contentType;
+    if (_contentType.isEmpty() && content.length()) _contentType = "text/plain";
+    _contentLength = content.length();
+}
+
+AsyncBasicResponse::AsyncBasicResponse(int code, const String& contentType, const uint8_t* data, size_t len)
+    : content((const char*)data, len) {
+    _code = code;
+    _contentType = contentType;
+    _contentLength = len;
+}
+
+size_t AsyncBasicResponse::fillBody(uint8_t* buffer, size_t maxLen) {
+    size_t n = min(maxLen, content.size() - sent);
+    memcpy(buffer, content.data() + sent, n);
+    sent += n;
+    return n;
+}
+
+AsyncCallbackResponse::AsyncCallbackResponse(const String& contentType, size_t len, AwsResponseFiller filler,
+                                             bool chunked)
+    : filler(filler) {
+    _contentType = contentType;
+    _contentLength = len;
+    _chunked = chunked;
+}
+
+size_t AsyncCallbackResponse::fillBody(uint8_t* buffer, size_t maxLen) {
+    if (!_chunked && index >= _contentLength) return 0;
+    size_t n = filler(buffer, maxLen, index);
+    if (n != RESPONSE_TRY_AGAIN) index += n;
+    return n;
+}
+
+AsyncResponseStream::AsyncResponseStream(const String& contentType, size_t bufferSize) {
+    _contentType = contentType;
+    content.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::write(const uint8_t* data, size_t len) {
+    content.append((const char*)data, len);
+    _contentLength = content.size();
+    return len;
+}
+
+size_t AsyncResponseStream::fillBody(uint8_t* buffer, size_t maxLen) {
+    size_t n = min(maxLen, content.size() - sent);
+    memcpy(buffer, content.data() + sent, n);
+    sent += n;
+    return n;
+}
+
+// ---- 请求 ----
+
+AsyncWebServerRequest::AsyncWebServerRequest(SimConnection* conn) : _conn(conn), _client(conn) {}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+    delete _response;
+    free(_tempObject);
+}
+
+const char* AsyncWebServerRequest::methodToString() const {
+    switch (_method) {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_PUT: return "PUT";
+    case HTTP_PATCH: return "PATCH";
+    case HTTP_HEAD: return "HEAD";
+    case HTTP_OPTIONS: return "OPTIONS";
+    default: return "UNKNOWN";
+    }
+}
+
+const String& AsyncWebServerRequest::host() const {
+    static const String empty;
+    AsyncWebHeader* h = getHeader("Host");
+    return h ? h->value() : empty;
+}
+
+void AsyncWebServerRequest::addParams(const std::string& encoded, bool form) {
+    size_t pos = 0;
+    while (pos < encoded.size()) {
+        size_t end = encoded.find('&', pos);
+        if (end == std::string::npos) end = encoded.size();
+        std::string pair = encoded.substr(pos, end - pos);
+        if (!pair.empty()) {
+            size_t eq = pair.find('=');
+            std::string name = urlDecode(pair.substr(0, eq));
+            std::string value = eq == std::string::npos ? "" : urlDecode(pair.substr(eq + 1));
+            _params.emplace_back(new AsyncWebParameter(String(name), String(value), form));
+        }
+        pos = end + 1;
+    }
+}
+
+bool AsyncWebServerRequest::parseHead(const std::string& head) {
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    size_t sp1 = requestLine.find(' ');
+    size_t sp2 = requestLine.rfind(' ');
+    if (sp1 == std::string::npos || sp2 == sp1) return false;
+
+    std::string method = requestLine.substr(0, sp1);
+    static const struct { const char* name; WebRequestMethod method; } METHODS[] = {
+        {"GET", HTTP_GET}, {"POST", HTTP_POST}, {"DELETE", HTTP_DELETE}, {"PUT", HTTP_PUT},
+        {"PATCH", HTTP_PATCH}, {"HEAD", HTTP_HEAD}, {"OPTIONS", HTTP_OPTIONS},
+    };
+    for (const auto& m : METHODS) {
+        if (method == m.name) _method = m.method;
+    }
+    if (!_method) return false;
+
+    std::string target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+    size_t q = target.find('?');
+    _url = String(urlDecode(target.substr(0, q)));
+    if (q != std::string::npos) addParams(target.substr(q + 1), false);
+
+    size_t pos = lineEnd + 2;
+    while (pos < head.size()) {
+        size_t end = head.find("\r\n", pos);
+        if (end == std::string::npos) end = head.size();
+        std::string line = head.substr(pos, end - pos);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            std::string name = line.substr(0, colon);
+            size_t valueStart = line.find_first_not_of(' ', colon + 1);
+            std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+            _headers.emplace_back(new AsyncWebHeader(String(name), String(value)));
+            if (strcasecmp(name.c_str(), "Content-Type") == 0) _contentType = String(value);
+            if (strcasecmp(name.c_str(), "Content-Length") == 0) _contentLength = strtoul(value.c_str(), nullptr, 10);
+        }
+        pos = end + 2;
+    }
+    return true;
+}
+
+void AsyncWebServerRequest::parseFormBody(const std::string& body) {
+    if (_contentType.startsWith("application/x-www-form-urlencoded")) addParams(body, true);
+}
+
+bool AsyncWebServerRequest::hasHeader(const String& name) const {
+    return getHeader(name) != nullptr;
+}
+
+AsyncWebHeader* AsyncWebServerRequest::getHeader(const String& name) const {
+    for (const auto& h : _headers) {
+        if (h->name().equalsIgnoreCase(name)) return h.get();
+    }
+    return nullptr;
+}
+
+AsyncWebHeader* AsyncWebServerRequest::getHeader(size_t index) const {
+    return index < _headers.size() ? _headers[index].get() : nullptr;
+}
+
+bool AsyncWebServerRequest::hasParam(const String& name, bool post, bool file) const {
+    return getParam(name, post, file) != nullptr;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post, bool file) const {
+    for (const auto& p : _params) {
+        if (p->name() == name && p->isPost() == post && p->isFile() == file) return p.get();
+    }
+    return nullptr;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(size_t index) const {
+    return index < _params.size() ? _params[index].get() : nullptr;
+}
+
+bool AsyncWebServerRequest::hasArg(const char* name) const {
+    for (const auto& p : _params) {
+        if (p->name() == name) return true;
+    }
+    return false;
+}
+
+const String& AsyncWebServerRequest::arg(const char* name) const {
+    static const String empty;
+    for (const auto& p : _params) {
+        if (p->name() == name) return p->value();
+    }
+    return empty;
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+    if (_response) {
+        // 原库忽略重复发送并泄漏第二个响应，这里释放它
+        delete response;
+        return;
+    }
+    _response = response;
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+    send(new AsyncBasicResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::redirect(const String& url) {
+    AsyncWebServerResponse* response = beginResponse(302);
+    response->addHeader("Location", url);
+    send(response);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const String& contentType,
+                                                             const String& content) {
+    return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(const String& contentType, size_t len,
+                                                             AwsResponseFiller filler) {
+    return new AsyncCallbackResponse(contentType, len, filler);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse(const String& contentType,
+                                                                    AwsResponseFiller filler) {
+    return new AsyncCallbackResponse(contentType, 0, filler, true);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse_P(int code, const String& contentType,
+                                                               const uint8_t* content, size_t len) {
+    return new AsyncBasicResponse(code, contentType, content, len);
+}
+
+AsyncResponseStream* AsyncWebServerRequest::beginResponseStream(const String& contentType, size_t bufferSize) {
+    return new AsyncResponseStream(contentType, bufferSize);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::takeResponse() {
+    AsyncWebServerResponse* response = _response;
+    _response = nullptr;
+    return response;
+}
+
+void AsyncWebServerRequest::notifyDisconnect() {
+    if (_onDisconnect) _onDisconnect();
+}
+
+// ---- AsyncClient ----
+
+IPAddress AsyncClient::remoteIP() const {
+    return IPAddress(conn->peer.sin_addr.s_addr);
+}
+
+uint16_t AsyncClient::remotePort() const {
+    return ntohs(conn->peer.sin_port);
+}
+
+size_t AsyncClient::space() const {
+    int queued = 0;
+    if (conn->fd < 0 || ioctl(conn->fd, SIOCOUTQ, &queued) < 0) return 0;
+    return queued >= SIM_TCP_SND_BUF ? 0 : SIM_TCP_SND_BUF - queued;
+}
+
+bool AsyncClient::connected() const {
+    return conn->fd >= 0 && !conn->closing;
+}
+
+void AsyncClient::close(bool) {
+    conn->closing = true;
+}
+
+void AsyncClient::setRxTimeout(uint32_t seconds) {
+    conn->rxTimeoutMs = seconds * 1000;
+}
+
+// ---- 路由 ----
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest* request) const {
+    if (!onRequest || !(method & request->method())) return false;
+    if (filter && !filter(request)) return false;
+    const String& url = request->url();
+    if (uri.length() && uri.startsWith("/*.")) {
+        return url.endsWith(uri.substring(uri.indexOf('.')));
+    }
+    if (uri.length() && uri.endsWith("*")) {
+        return url.startsWith(uri.substring(0, uri.length() - 1));
+    }
+    return !uri.length() || uri == url || url.startsWith(uri + "/");
+}
+
+AsyncWebServer::~AsyncWebServer() {
+    end();
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest) {
+    return on(uri, method, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest, ArUploadHandlerFunction,
+                                            ArBodyHandlerFunction onBody) {
+    std::lock_guard<std::mutex> lock(loopMutex);
+    handlers.emplace_back(new AsyncCallbackWebHandler(String(uri), method, onRequest, onBody));
+    return *handlers.back();
+}
+
+AsyncCallbackWebHandler* AsyncWebServer::findHandler(AsyncWebServerRequest* request) {
+    for (auto& h : handlers) {
+        if (h->canHandle(request)) return h.get();
+    }
+    return nullptr;
+}
+
+void AsyncWebServer::handleNotFound(AsyncWebServerRequest* request) {
+    if (notFound) notFound(request);
+    else request->send(404);
+}
+
+// ---- async_tcp 任务 ----
+
+static void closeConnection(SimConnection* c) {
+    if (c->request) {
+        c->request->notifyDisconnect();
+        delete c->request;
+    }
+    delete c->response;
+    if (c->fd >= 0) close(c->fd);
+    delete c;
+}
+
+static void acceptConnections(AsyncWebServer* server) {
+    while (connections.size() < simOptions.maxConnections) {
+        SimConnection* c = new SimConnection();
+        socklen_t len = sizeof(c->peer);
+        c->fd = accept(server->listenFd(), (sockaddr*)&c->peer, &len);
+        if (c->fd < 0) {
+            delete c;
+            return;
+        }
+        fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) | O_NONBLOCK);
+        int one = 1;
+        setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        c->server = server;
+        connections.push_back(c);
+    }
+}
+
+// 请求收完后路由并调用处理函数（在本任务中同步执行）
+static void dispatch(SimConnection* c) {
+    c->dispatched = true;
+    std::string body = c->in.substr(c->bodyStart, c->bodyLength);
+    c->request->parseFormBody(body);
+
+    AsyncCallbackWebHandler* handler = c->server->findHandler(c->request);
+    if (!handler) {
+        c->server->handleNotFound(c->request);
+        return;
+    }
+    if (handler->onBody && !body.empty()) {
+        handler->onBody(c->request, (uint8_t*)&body[0], body.size(), 0, body.size());
+    }
+    handler->onRequest(c->request);
+}
+
+// @return false 时关闭连接
+static bool receive(SimConnection* c) {
+    char buffer[2048];
+    ssize_t n = recv(c->fd, buffer, sizeof(buffer), 0);
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    c->lastActivityUs = esp_timer_get_time();
+    if (c->dispatched) return true;  // 响应期间客户端多发的数据丢弃
+    c->in.append(buffer, n);
+
+    if (!c->bodyStart) {
+        size_t end = c->in.find("\r\n\r\n");
+        if (end == std::string::npos) return c->in.size() <= MAX_HEAD_BYTES;
+        c->bodyStart = end + 4;
+        c->request = new AsyncWebServerRequest(c);
+        if (!c->request->parseHead(c->in.substr(0, end))) {
+            c->request->send(400);
+            c->dispatched = true;
+            return true;
+        }
+        c->bodyLength = c->request->contentLength();
+        if (c->bodyLength > MAX_BODY_BYTES) return false;
+    }
+    if (c->in.size() >= c->bodyStart + c->bodyLength) dispatch(c);
+    return true;
+}
+
+static size_t takeLinkTokens(size_t wanted) {
+    if (!simOptions.linkKbps) return wanted;
+    uint64_t now = esp_timer_get_time();
+    double rate = simOptions.linkKbps * 1000.0 / 8 / 1e6;  // 字节/微秒
+    linkTokens = min(linkTokens + (now - linkLastUs) * rate, (double)SIM_TCP_SND_BUF * 2);
+    linkLastUs = now;
+    if (linkTokens < 1) return 0;
+    size_t n = min(wanted, (size_t)linkTokens);
+    linkTokens -= n;
+    return n;
+}
+
+// 按发送窗口和链路令牌填充一段响应
+// @return 还有待填充的数据且本轮受限时为 true（需要尽快再次轮询）
+static bool fillResponse(SimConnection* c) {
+    if (!c->response || c->bodyDone || c->outPos < c->out.size()) return false;
+
+    AsyncClient client(c);
+    size_t window = client.space();
+    if (window == 0) return false;
+    if (!c->headSent) {
+        c->out = c->response->assembleHead().c_str();
+        c->headSent = true;
+    } else {
+        c->out.clear();
+    }
+    c->outPos = 0;
+
+    size_t budget = takeLinkTokens(window > c->out.size() ? window - c->out.size() : 0);
+    bool chunked = !c->response->bodyKnownLength();
+    size_t framing = chunked ? 12 : 0;
+    if (!chunked) budget = min(budget, c->response->contentLength() - c->bodySent);
+    if (budget <= framing) {
+        if (!chunked && c->bodySent >= c->response->contentLength()) c->bodyDone = true;
+        return !c->bodyDone;
+    }
+
+    std::vector<uint8_t> chunk(budget - framing);
+    size_t n = c->response->fillBody(chunk.data(), chunk.size());
+    if (n == RESPONSE_TRY_AGAIN) return true;
+    if (n > chunk.size()) n = chunk.size();
+
+    if (chunked) {
+        char size[24];
+        snprintf(size, sizeof(size), "%zx\r\n", n);
+        c->out += size;
+        c->out.append((const char*)chunk.data(), n);
+        c->out += "\r\n";
+    } else {
+        c->out.append((const char*)chunk.data(), n);
+    }
+    c->bodySent += n;
+    // 已知长度时不足 Content-Length 的 0 不结束响应（ESPAsyncWebServer 同样只在发满后结束）
+    c->bodyStalled = !chunked && n == 0;
+    if (c->bodyStalled) return false;
+    if (n == 0 || (!chunked && c->bodySent >= c->response->contentLength())) {
+        c->bodyDone = true;
+        if (chunked && n > 0) c->out += "0\r\n\r\n";
+    }
+    return false;
+}
+
+// @return false 时关闭连接
+static bool flush(SimConnection* c) {
+    while (c->outPos < c->out.size()) {
+        ssize_t n = send(c->fd, c->out.data() + c->outPos, c->out.size() - c->outPos, MSG_NOSIGNAL);
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        c->outPos += n;
+        c->lastActivityUs = esp_timer_get_time();
+    }
+    return true;
+}
+
+static void asyncTcpTask(void*) {
+    std::vector<pollfd> fds;
+    while (true) {
+        std::unique_lock<std::mutex> lock(loopMutex);
+        bool busy = false;
+
+        // 处理函数可能稍后才发送响应；已有响应的连接继续填充
+        for (SimConnection* c : connections) {
+            if (c->request && c->dispatched && !c->response) {
+                c->response = c->request->takeResponse();
+            }
+            if (fillResponse(c)) busy = true;
+        }
+
+        fds.clear();
+        for (AsyncWebServer* s : servers) {
+            if (connections.size() < simOptions.maxConnections) fds.push_back({s->listenFd(), POLLIN, 0});
+        }
+        size_t firstConn = fds.size();
+        for (SimConnection* c : connections) {
+            short events = POLLIN;
+            if (c->outPos < c->out.size()) events |= POLLOUT;
+            else if (c->response && !c->bodyDone && !c->bodyStalled) busy = true;
+            else if (c->dispatched && !c->response) busy = true;
+            fds.push_back({c->fd, events, 0});
+        }
+        lock.unlock();
+
+        poll(fds.data(), fds.size(), busy ? 2 : 50);
+
+        lock.lock();
+        for (size_t i = 0; i < firstConn; i++) {
+            if (fds[i].revents & POLLIN) {
+                for (AsyncWebServer* s : servers) {
+                    if (s->listenFd() == fds[i].fd) acceptConnections(s);
+                }
+            }
+        }
+
+        std::vector<SimConnection*> alive;
+        for (size_t i = 0; i < connections.size(); i++) {
+            SimConnection* c = connections[i];
+            short revents = firstConn + i < fds.size() && fds[firstConn + i].fd == c->fd ? fds[firstConn + i].revents : 0;
+            bool ok = !c->closing;
+            if (ok && (revents & (POLLIN | POLLHUP | POLLERR))) ok = receive(c);
+            if (ok && !c->response && c->request && c->dispatched) c->response = c->request->takeResponse();
+            if (ok) fillResponse(c);
+            if (ok) ok = flush(c);
+            // AsyncTCP 的 _poll：接收超时在回调之外关闭连接
+            if (ok && c->rxTimeoutMs && esp_timer_get_time() - c->lastActivityUs >= c->rxTimeoutMs * 1000ULL) {
+                ok = false;
+            }
+            // 响应发完即关闭（Connection: close）
+            if (ok && c->bodyDone && c->outPos >= c->out.size()) ok = false;
+            if (ok) alive.push_back(c);
+            else closeConnection(c);
+        }
+        connections.swap(alive);
+    }
+}
+
+void AsyncWebServer::begin() {
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        simLog("AsyncWebServer: cannot listen on port %u: %s", port, strerror(errno));
+        close(fd);
+        fd = -1;
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    std::lock_guard<std::mutex> lock(loopMutex);
+    servers.push_back(this);
+    if (!loopStarted) {
+        loopStarted = true;
+        linkLastUs = esp_timer_get_time();
+        // 与 AsyncTCP 相同：单个任务处理所有连接
+        xTaskCreateUniversal(asyncTcpTask, "async_tcp", 8192, nullptr, 3, nullptr, tskNO_AFFINITY);
+    }
+}
+
+void AsyncWebServer::end() {
+    std::lock_guard<std::mutex> lock(loopMutex);
+    for (size_t i = 0; i < servers.size(); i++) {
+        if (servers[i] == this) servers.erase(servers.begin() + i);
+    }
+    std::vector<SimConnection*> alive;
+    for (SimConnection* c : connections) {
+        if (c->server == this) closeConnection(c);
+        else alive.push_back(c);
+    }
+    connections.swap(alive);
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
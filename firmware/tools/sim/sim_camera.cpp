@@ -0,0 +1,381 @@
+// esp32-camera 驱动替身
+// - 传感器线程按 --sensor-fps（20 MHz XCLK 时）出帧，帧率随 XCLK 线性变化
+// - GRAB_LATEST：没有空闲缓冲时覆盖队列中最旧的帧；GRAB_WHEN_EMPTY：没有空闲缓冲时丢弃新帧
+// - 帧缓冲按初始化分辨率分配，计入 PSRAM 或内部堆；DRAM 放不下时初始化失败
+// - JPEG 输出：与 esp32-camera 一样每个缓冲只有 宽x高/5 字节，编码结果放不下时丢帧
+// - 画面来自 --recording 回放的 .mcfr（最近邻缩放到当前分辨率），否则为合成场景：
+//   静止背景加传感器噪声，每 20 秒有一个方块从左到右穿过画面
+// - 录制文件或合成场景视为 OV2640 的全幅视场（1600x1200），set_res_raw 开窗后只输出窗口内的画面
+#include <esp_camera.h>
+#include <Arduino.h>
+#include "frame_recording.h"
+#include "sim.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const uint32_t FB_GET_TIMEOUT_MS = 4000;
+static const uint32_t SCENE_PERIOD_MS = 20000;
+static const uint32_t SCENE_MOTION_START_MS = 8000;
+static const uint32_t SCENE_MOTION_MS = 6000;
+
+const resolution_info_t resolution[] = {
+    {96, 96}, {160, 120}, {176, 144}, {240, 176}, {240, 240}, {320, 240}, {400, 296},
+    {480, 320}, {640, 480}, {800, 600}, {1024, 768}, {1280, 720}, {1280, 1024}, {1600, 1200},
+};
+
+static const int SENSOR_WIDTH = 1600;
+static const int SENSOR_HEIGHT = 1200;
+static const int MODE_SCALE[] = {1, 2, 4};          // UXGA、SVGA、CIF
+static const int MODE_HEIGHT[] = {1200, 600, 296};
+
+// 输出画面对应的全幅视场
+struct SensorView {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+struct SimFrameBuffer {
+    camera_fb_t fb;
+    size_t capacity;
+    bool held;     // 已交给应用
+    bool queued;   // 在待取队列中
+};
+
+static std::mutex camMutex;
+static std::condition_variable camCv;
+static std::vector<SimFrameBuffer*> buffers;
+static std::deque<SimFrameBuffer*> queue;
+static camera_config_t activeConfig;
+static sensor_t sensor;
+static SensorView view = {0, 0, SENSOR_WIDTH, SENSOR_HEIGHT};
+static bool initialized = false;
+static bool running = false;
+static std::thread sensorThread;
+
+// 回放的录制文件
+static std::vector<uint8_t, SimUntrackedAllocator<uint8_t>> recording;   // 主机文件，不计入仿真堆
+static std::vector<size_t> recordedFrames;   // 每帧像素数据在 recording 中的偏移
+static RecordingHeader recordedHeader;
+static size_t nextRecordedFrame = 0;
+
+static bool loadRecording() {
+    if (!simOptions.recording || !recordedFrames.empty()) return true;
+    FILE* f = fopen(simOptions.recording, "rb");
+    if (!f) {
+        simLog("camera: cannot open %s", simOptions.recording);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    recording.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    size_t got = fread(recording.data(), 1, recording.size(), f);
+    fclose(f);
+
+    if (got < sizeof(RecordingHeader)) return false;
+    memcpy(&recordedHeader, recording.data(), sizeof(recordedHeader));
+    if (!isValidRecordingHeader(recordedHeader) ||
+        (recordedHeader.pixformat != PIXFORMAT_RGB565 && recordedHeader.pixformat != PIXFORMAT_GRAYSCALE)) {
+        simLog("camera: %s is not an RGB565/grayscale .mcfr recording", simOptions.recording);
+        return false;
+    }
+    size_t bpp = recordedHeader.pixformat == PIXFORMAT_GRAYSCALE ? 1 : 2;
+    size_t frameBytes = (size_t)recordedHeader.width * recordedHeader.height * bpp;
+    size_t offset = recordedHeader.headerSize;
+    for (uint32_t i = 0; i < recordedHeader.frameCount; i++) {
+        RecordingFrameHeader fh;
+        if (offset + sizeof(fh) > got) break;
+        memcpy(&fh, recording.data() + offset, sizeof(fh));
+        offset += sizeof(fh);
+        if (fh.length < frameBytes || offset + fh.length > got) break;
+        recordedFrames.push_back(offset);
+        offset += fh.length;
+    }
+    simLog("camera: replaying %zu frames (%ux%u) from %s", recordedFrames.size(), recordedHeader.width,
+           recordedHeader.height, simOptions.recording);
+    return !recordedFrames.empty();
+}
+
+// 驱动为一帧分配的字节数（esp32-camera cam_hal：JPEG 按 1/5 像素数估计）
+static size_t frameCapacity(pixformat_t format, framesize_t size) {
+    size_t pixels = (size_t)resolution[size].width * resolution[size].height;
+    return format == PIXFORMAT_JPEG ? pixels / 5 : pixels * 2;
+}
+
+static inline void storeRGB565(uint8_t* p, uint8_t r, uint8_t g, uint8_t b) {
+    uint16_t v = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+    p[0] = v >> 8;  // 传感器输出大端
+    p[1] = v & 0xFF;
+}
+
+// 输出坐标 i 对应的源坐标：视场 [viewStart, viewStart + viewSize) 映射到全幅 fullSize，再映射到源的 srcSize
+static inline int sourceCoord(int i, int outSize, int viewStart, int viewSize, int fullSize, int srcSize) {
+    return (int)(((int64_t)viewStart * outSize + (int64_t)i * viewSize) * srcSize / ((int64_t)fullSize * outSize));
+}
+
+static void renderRecorded(uint8_t* out, int width, int height, const SensorView& v) {
+    const uint8_t* src = recording.data() + recordedFrames[nextRecordedFrame];
+    nextRecordedFrame = (nextRecordedFrame + 1) % recordedFrames.size();
+    bool gray = recordedHeader.pixformat == PIXFORMAT_GRAYSCALE;
+    for (int y = 0; y < height; y++) {
+        int sy = sourceCoord(y, height, v.y, v.height, SENSOR_HEIGHT, recordedHeader.height);
+        for (int x = 0; x < width; x++) {
+            int sx = sourceCoord(x, width, v.x, v.width, SENSOR_WIDTH, recordedHeader.width);
+            uint8_t* p = out + ((size_t)y * width + x) * 2;
+            if (gray) {
+                uint8_t v = src[(size_t)sy * recordedHeader.width + sx];
+                storeRGB565(p, v, v, v);
+            } else {
+                const uint8_t* s = src + ((size_t)sy * recordedHeader.width + sx) * 2;
+                p[0] = s[0];
+                p[1] = s[1];
+            }
+        }
+    }
+}
+
+static void renderSynthetic(uint8_t* out, int width, int height, const SensorView& v, uint32_t nowMs) {
+    static uint32_t noise = 12345;
+
+    // 场景按输出的像素密度铺满全幅视场，开窗时只画窗口内的部分
+    int sceneWidth = (int)((int64_t)width * SENSOR_WIDTH / v.width);
+    int sceneHeight = (int)((int64_t)height * SENSOR_HEIGHT / v.height);
+    int originX = (int)((int64_t)v.x * sceneWidth / SENSOR_WIDTH);
+    int originY = (int)((int64_t)v.y * sceneHeight / SENSOR_HEIGHT);
+
+    // 运动方块：边长为画面高度的 1/4，按时间从左向右移动
+    uint32_t phase = nowMs % SCENE_PERIOD_MS;
+    int size = sceneHeight / 4;
+    bool visible = false;
+    int objX = 0;
+    if (phase >= SCENE_MOTION_START_MS && phase < SCENE_MOTION_START_MS + SCENE_MOTION_MS) {
+        visible = true;
+        objX = (int)((uint64_t)(phase - SCENE_MOTION_START_MS) * (sceneWidth + size) / SCENE_MOTION_MS) - size;
+    }
+    int objY = sceneHeight / 2 - size / 2;
+
+    for (int y = 0; y < height; y++) {
+        int sy = originY + y;
+        for (int x = 0; x < width; x++) {
+            int sx = originX + x;
+            noise = noise * 1103515245 + 12345;
+            int n = (int)((noise >> 16) & 3) - 1;
+            uint8_t* p = out + ((size_t)y * width + x) * 2;
+            if (visible && sx >= objX && sx < objX + size && sy >= objY && sy < objY + size) {
+                storeRGB565(p, 230, 200 + n, 40);
+                continue;
+            }
+            // 背景：水平渐变加几条竖直条纹，亮度只受噪声影响
+            int base = 60 + sx * 80 / sceneWidth + ((sx / 40) % 2) * 20 + sy * 40 / sceneHeight;
+            int v = constrain(base + n * 4, 0, 255);
+            storeRGB565(p, v, v, v + 10 > 255 ? 255 : v + 10);
+        }
+    }
+}
+
+// 取一个可写的缓冲区，调用时持有 camMutex
+static SimFrameBuffer* acquireBuffer() {
+    for (SimFrameBuffer* b : buffers) {
+        if (!b->held && !b->queued) return b;
+    }
+    if (activeConfig.grab_mode == CAMERA_GRAB_LATEST && !queue.empty()) {
+        SimFrameBuffer* oldest = queue.front();
+        queue.pop_front();
+        oldest->queued = false;
+        return oldest;
+    }
+    return nullptr;
+}
+
+static void sensorLoop() {
+    simNameThread("cam_task");
+    uint64_t intervalUs = 1000000ULL * 20000000ULL /
+                          ((uint64_t)simOptions.sensorFps * (uint64_t)max(activeConfig.xclk_freq_hz, 1000000));
+    uint64_t next = esp_timer_get_time() + intervalUs;
+    std::vector<uint8_t, SimUntrackedAllocator<uint8_t>> scratch;   // 代替传感器 DMA，不计入仿真堆
+    std::vector<uint8_t, SimUntrackedAllocator<uint8_t>> encoded;   // 传感器 JPEG 编码器的输出
+
+    while (true) {
+        int64_t wait = (int64_t)next - esp_timer_get_time();
+        if (wait > 0) delayMicroseconds(wait);
+        next += intervalUs;
+
+        framesize_t size;
+        int quality;
+        SensorView frameView;
+        {
+            std::lock_guard<std::mutex> lock(camMutex);
+            if (!running) return;
+            size = sensor.status.framesize;
+            quality = sensor.status.quality;
+            frameView = view;
+        }
+
+        // 在锁外渲染，再拷进驱动缓冲
+        int width = resolution[size].width;
+        int height = resolution[size].height;
+        size_t len = (size_t)width * height * 2;
+        scratch.resize(len);
+        if (!recordedFrames.empty()) renderRecorded(scratch.data(), width, height, frameView);
+        else renderSynthetic(scratch.data(), width, height, frameView, millis());
+        bool jpeg = activeConfig.pixel_format == PIXFORMAT_JPEG;
+        if (jpeg) {
+            encoded.resize(frameCapacity(PIXFORMAT_JPEG, size));
+            len = simEncodeSensorJpeg(scratch.data(), width, height, quality, encoded.data(), encoded.size());
+            if (len == 0) {
+                simLog("cam_hal: FB-OVF");
+                continue;
+            }
+        }
+        const uint8_t* frame = jpeg ? encoded.data() : scratch.data();
+
+        std::lock_guard<std::mutex> lock(camMutex);
+        if (!running) return;
+        SimFrameBuffer* b = acquireBuffer();
+        if (!b) continue;  // 应用没有及时归还缓冲，丢帧
+        memcpy(b->fb.buf, frame, min(len, b->capacity));
+        b->fb.len = min(len, b->capacity);
+        b->fb.width = width;
+        b->fb.height = height;
+        b->fb.format = activeConfig.pixel_format;
+        int64_t now = esp_timer_get_time();
+        b->fb.timestamp.tv_sec = now / 1000000;
+        b->fb.timestamp.tv_usec = now % 1000000;
+        b->queued = true;
+        queue.push_back(b);
+        camCv.notify_all();
+    }
+}
+
+static int setFramesize(sensor_t* s, framesize_t size) {
+    if (size >= FRAMESIZE_INVALID) return -1;
+    std::lock_guard<std::mutex> lock(camMutex);
+    if (buffers.empty() || frameCapacity(activeConfig.pixel_format, size) > buffers[0]->capacity) return -1;
+    s->status.framesize = size;
+    view = {0, 0, SENSOR_WIDTH, SENSOR_HEIGHT};   // 与 OV2640 一样恢复全幅视场
+    return 0;
+}
+
+// 与 OV2640 set_window 的约束相同：窗口在模式范围内，宽高以 4 像素为单位，DSP 只能缩小
+static int setResRaw(sensor_t* s, int startX, int startY, int endX, int endY, int offsetX, int offsetY,
+                     int totalX, int totalY, int outputX, int outputY, bool scale, bool binning) {
+    (void)startY, (void)endX, (void)endY, (void)scale, (void)binning;
+    if (startX < 0 || startX > 2) return -1;
+    int modeScale = MODE_SCALE[startX];
+    if (offsetX < 0 || offsetY < 0 || totalX <= 0 || totalY <= 0 || (totalX & 3) || (totalY & 3) ||
+        offsetX + totalX > SENSOR_WIDTH / modeScale || offsetY + totalY > MODE_HEIGHT[startX] ||
+        outputX > totalX || outputY > totalY) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(camMutex);
+    // 输出尺寸须与驱动按 status.framesize 分配和标注的帧一致
+    if (outputX != resolution[s->status.framesize].width || outputY != resolution[s->status.framesize].height) {
+        return -1;
+    }
+    view = {offsetX * modeScale, offsetY * modeScale, totalX * modeScale, totalY * modeScale};
+    return 0;
+}
+
+static int setQuality(sensor_t* s, int quality) {
+    s->status.quality = quality;
+    return 0;
+}
+
+static void freeBuffers() {
+    for (SimFrameBuffer* b : buffers) {
+        heap_caps_free(b->fb.buf);
+        delete b;
+    }
+    buffers.clear();
+    queue.clear();
+}
+
+esp_err_t esp_camera_init(const camera_config_t* config) {
+    if (initialized) return ESP_ERR_INVALID_STATE;
+    if (!config || config->frame_size >= FRAMESIZE_INVALID || config->fb_count == 0 ||
+        (config->pixel_format != PIXFORMAT_RGB565 && config->pixel_format != PIXFORMAT_GRAYSCALE &&
+         config->pixel_format != PIXFORMAT_JPEG)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!loadRecording()) return ESP_FAIL;
+
+    size_t capacity = frameCapacity(config->pixel_format, config->frame_size);
+    uint32_t caps = config->fb_location == CAMERA_FB_IN_DRAM ? (MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA)
+                                                             : MALLOC_CAP_SPIRAM;
+    for (size_t i = 0; i < config->fb_count; i++) {
+        // 内部堆没有上限检查，这里按最大空闲块模拟 DMA 缓冲分配失败
+        uint8_t* buf = nullptr;
+        if (!(caps & MALLOC_CAP_INTERNAL) || capacity <= heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL)) {
+            buf = (uint8_t*)heap_caps_malloc(capacity, caps);
+        }
+        if (!buf) {
+            simLog("cam_hal: frame buffer %zu (%zu bytes) allocation failed in %s", i, capacity,
+                   config->fb_location == CAMERA_FB_IN_DRAM ? "DRAM" : "PSRAM");
+            freeBuffers();
+            return ESP_ERR_NO_MEM;
+        }
+        SimFrameBuffer* b = new SimFrameBuffer();
+        b->fb.buf = buf;
+        b->capacity = capacity;
+        buffers.push_back(b);
+    }
+
+    activeConfig = *config;
+    sensor = {};
+    sensor.status.framesize = config->frame_size;
+    sensor.status.quality = config->jpeg_quality;
+    sensor.pixformat = config->pixel_format;
+    sensor.set_framesize = setFramesize;
+    sensor.set_quality = setQuality;
+    sensor.set_res_raw = setResRaw;
+    view = {0, 0, SENSOR_WIDTH, SENSOR_HEIGHT};
+
+    running = true;
+    initialized = true;
+    sensorThread = std::thread(sensorLoop);
+    return ESP_OK;
+}
+
+esp_err_t esp_camera_deinit() {
+    if (!initialized) return ESP_ERR_INVALID_STATE;
+    {
+        std::lock_guard<std::mutex> lock(camMutex);
+        running = false;
+        camCv.notify_all();
+    }
+    sensorThread.join();
+    std::lock_guard<std::mutex> lock(camMutex);
+    freeBuffers();
+    initialized = false;
+    return ESP_OK;
+}
+
+camera_fb_t* esp_camera_fb_get() {
+    std::unique_lock<std::mutex> lock(camMutex);
+    if (!initialized) return nullptr;
+    if (!camCv.wait_for(lock, std::chrono::milliseconds(FB_GET_TIMEOUT_MS),
+                        [] { return !queue.empty() || !running; }) || queue.empty()) {
+        simLog("cam_hal: EV-VSYNC-OVF / fb_get timeout");
+        return nullptr;
+    }
+    SimFrameBuffer* b = queue.front();
+    queue.pop_front();
+    b->queued = false;
+    b->held = true;
+    return &b->fb;
+}
+
+void esp_camera_fb_return(camera_fb_t* fb) {
+    std::lock_guard<std::mutex> lock(camMutex);
+    for (SimFrameBuffer* b : buffers) {
+        if (&b->fb == fb) b->held = false;
+    }
+}
+
+sensor_t* esp_camera_sensor_get() {
+    return initialized ? &sensor : nullptr;
+}
@@ -0,0 +1,376 @@
+// FreeRTOS 替身的实现：每个任务一个线程
+#include "Arduino.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sim.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SimTask {
+    std::string name;
+    UBaseType_t priority = 0;
+    BaseType_t core = tskNO_AFFINITY;
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t notifyValue = 0;
+    bool notifyPending = false;
+};
+
+// 队列与各类信号量共用：信号量的条目大小为 0，只计数
+struct SimQueue {
+    enum Kind { QUEUE, MUTEX, RECURSIVE_MUTEX, SEMAPHORE };
+
+    Kind kind;
+    UBaseType_t capacity;
+    UBaseType_t itemSize;
+    UBaseType_t count = 0;
+    std::deque<std::vector<uint8_t>> items;
+    SimTask* owner = nullptr;
+    UBaseType_t depth = 0;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+struct TaskExit {};
+
+static thread_local SimTask* currentTask = nullptr;
+
+// 按 FreeRTOS 语义等待：portMAX_DELAY 无限等待，0 不等待
+template <typename Pred>
+static bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t ticks, Pred ready) {
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, ready);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+static SimTask* self() {
+    if (!currentTask) {
+        // 不是由 xTaskCreate 创建的线程（如进程主线程），首次使用时登记
+        currentTask = new SimTask();
+        currentTask->name = "sim";
+    }
+    return currentTask;
+}
+
+void simAdoptCurrentThread(const char* name) {
+    self()->name = name;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    (void)stackDepth;
+    SimTask* task = new SimTask();
+    task->name = name ? name : "";
+    task->priority = priority;
+    task->core = core;
+    if (handle) *handle = task;
+
+    std::thread([fn, param, task]() {
+        currentTask = task;
+        simNameThread(task->name.c_str());
+        try {
+            fn(param);
+        } catch (const TaskExit&) {
+        }
+        // 任务句柄可能仍被其他任务持有（通知），不释放
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreateUniversal(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                                UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, core);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task && task != currentTask) {
+        simFatal("vTaskDelete of another task is not supported");
+    }
+    throw TaskExit();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+    *previousWake += increment;
+    int32_t remaining = (int32_t)(*previousWake - xTaskGetTickCount());
+    if (remaining > 0) vTaskDelay(remaining);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return self();
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+    return (task ? task : self())->name.c_str();
+}
+
+BaseType_t xPortGetCoreID() {
+    SimTask* task = self();
+    return task->core == tskNO_AFFINITY ? 0 : task->core;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    BaseType_t result = pdPASS;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        switch (action) {
+        case eSetBits:
+            task->notifyValue |= value;
+            break;
+        case eIncrement:
+            task->notifyValue++;
+            break;
+        case eSetValueWithOverwrite:
+            task->notifyValue = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->notifyPending) result = pdFAIL;
+            else task->notifyValue = value;
+            break;
+        case eNoAction:
+            break;
+        }
+        task->notifyPending = true;
+    }
+    task->cv.notify_all();
+    return result;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t ticks) {
+    SimTask* task = self();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    if (!task->notifyPending) task->notifyValue &= ~clearOnEntry;
+
+    bool notified = waitFor(task->cv, lock, ticks, [task]() { return task->notifyPending; });
+    if (value) *value = task->notifyValue;
+    if (!notified) return pdFALSE;
+    task->notifyPending = false;
+    task->notifyValue &= ~clearOnExit;
+    return pdTRUE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    xTaskNotifyGive(task);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    SimTask* task = self();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    waitFor(task->cv, lock, ticks, [task]() { return task->notifyValue > 0; });
+    uint32_t value = task->notifyValue;
+    if (value > 0) task->notifyValue = clearOnExit ? 0 : value - 1;
+    task->notifyPending = task->notifyValue > 0;
+    return value;
+}
+
+// ---- 队列 ----
+
+static SimQueue* createQueue(SimQueue::Kind kind, UBaseType_t capacity, UBaseType_t itemSize, UBaseType_t count) {
+    SimQueue* q = new SimQueue();
+    q->kind = kind;
+    q->capacity = capacity;
+    q->itemSize = itemSize;
+    q->count = count;
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    return createQueue(SimQueue::QUEUE, length, itemSize, 0);
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+static BaseType_t queueSend(QueueHandle_t q, const void* item, TickType_t ticks, bool front) {
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!waitFor(q->notFull, lock, ticks, [q]() { return q->count < q->capacity; })) {
+        return errQUEUE_FULL;
+    }
+    if (q->itemSize) {
+        std::vector<uint8_t> data((const uint8_t*)item, (const uint8_t*)item + q->itemSize);
+        if (front) q->items.push_front(std::move(data));
+        else q->items.push_back(std::move(data));
+    }
+    q->count++;
+    lock.unlock();
+    q->notEmpty.notify_one();
+    return pdTRUE;
+}
+
+static BaseType_t queueReceive(QueueHandle_t q, void* item, TickType_t ticks, bool remove) {
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!waitFor(q->notEmpty, lock, ticks, [q]() { return q->count > 0; })) {
+        return errQUEUE_EMPTY;
+    }
+    if (q->itemSize) {
+        memcpy(item, q->items.front().data(), q->itemSize);
+        if (remove) q->items.pop_front();
+    }
+    if (!remove) return pdTRUE;
+    q->count--;
+    lock.unlock();
+    q->notFull.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    return queueSend(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    return queueSend(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    return queueSend(queue, item, ticks, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return queueSend(queue, item, 0, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item) {
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->count > 0) {
+            memcpy(queue->items.back().data(), item, queue->itemSize);
+            return pdPASS;
+        }
+    }
+    return queueSend(queue, item, 0, false);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return queueReceive(queue, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return queueReceive(queue, item, ticks, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->capacity - queue->count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->items.clear();
+        queue->count = 0;
+    }
+    queue->notFull.notify_all();
+    return pdPASS;
+}
+
+// ---- 信号量 ----
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return createQueue(SimQueue::MUTEX, 1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    return createQueue(SimQueue::RECURSIVE_MUTEX, 1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return createQueue(SimQueue::SEMAPHORE, 1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount) {
+    return createQueue(SimQueue::SEMAPHORE, maxCount, 0, initialCount);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    delete sem;
+}
+
+// 信号量的计数是可取的份数：take 对应接收，give 对应发送
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    if (queueReceive(sem, nullptr, ticks, true) != pdTRUE) return pdFALSE;
+    if (sem->kind == SimQueue::MUTEX) {
+        std::lock_guard<std::mutex> lock(sem->mutex);
+        sem->owner = self();
+    }
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    if (sem->kind == SimQueue::MUTEX) {
+        std::lock_guard<std::mutex> lock(sem->mutex);
+        // FreeRTOS 中只有持有者能归还互斥锁，这里直接报错以暴露误用
+        if (sem->owner != self()) simFatal("xSemaphoreGive on a mutex not held by this task");
+        sem->owner = nullptr;
+    }
+    return queueSend(sem, nullptr, 0, false);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return queueSend(sem, nullptr, 0, false);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks) {
+    SimTask* task = self();
+    std::unique_lock<std::mutex> lock(sem->mutex);
+    if (sem->owner == task) {
+        sem->depth++;
+        return pdTRUE;
+    }
+    if (!waitFor(sem->notEmpty, lock, ticks, [sem]() { return sem->count > 0; })) return pdFALSE;
+    sem->count--;
+    sem->owner = task;
+    sem->depth = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+    std::unique_lock<std::mutex> lock(sem->mutex);
+    if (sem->owner != self()) return pdFALSE;
+    if (--sem->depth > 0) return pdTRUE;
+    sem->owner = nullptr;
+    sem->count++;
+    lock.unlock();
+    sem->notEmpty.notify_one();
+    return pdTRUE;
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem) {
+    return uxQueueMessagesWaiting(sem);
+}
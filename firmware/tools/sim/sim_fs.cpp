@@ -0,0 +1,219 @@
+#include <LittleFS.h>
+#include "sim.h"
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const size_t LITTLEFS_TOTAL_BYTES = 896 * 1024;   // partitions.csv 的 spiffs 分区（0xE0000）
+static const size_t LITTLEFS_BLOCK_SIZE = 4096;
+
+LittleFSFS LittleFS;
+
+struct SimFileImpl {
+    FILE* fp = nullptr;
+    std::string path;      // 设备上的路径
+    std::string hostPath;
+    bool directory = false;
+    std::vector<std::string> entries;
+    size_t nextEntry = 0;
+    fs::FS* fs = nullptr;
+
+    ~SimFileImpl() {
+        if (fp) fclose(fp);
+    }
+};
+
+// ---- File ----
+
+File::operator bool() const {
+    return impl && (impl->fp || impl->directory);
+}
+
+size_t File::write(const uint8_t* data, size_t len) {
+    if (!impl || !impl->fp) return 0;
+    return fwrite(data, 1, len, impl->fp);
+}
+
+int File::available() {
+    if (!impl || !impl->fp) return 0;
+    return (int)(size() - position());
+}
+
+int File::read() {
+    if (!impl || !impl->fp) return -1;
+    return fgetc(impl->fp);
+}
+
+int File::peek() {
+    if (!impl || !impl->fp) return -1;
+    int c = fgetc(impl->fp);
+    if (c >= 0) ungetc(c, impl->fp);
+    return c;
+}
+
+size_t File::read(uint8_t* buffer, size_t len) {
+    if (!impl || !impl->fp) return 0;
+    return fread(buffer, 1, len, impl->fp);
+}
+
+void File::flush() {
+    if (impl && impl->fp) fflush(impl->fp);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!impl || !impl->fp) return false;
+    static const int WHENCE[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+    return fseek(impl->fp, pos, WHENCE[mode]) == 0;
+}
+
+size_t File::position() const {
+    if (!impl || !impl->fp) return 0;
+    long pos = ftell(impl->fp);
+    return pos < 0 ? 0 : pos;
+}
+
+size_t File::size() const {
+    if (!impl || !impl->fp) return 0;
+    fflush(impl->fp);
+    struct stat st;
+    return fstat(fileno(impl->fp), &st) == 0 ? st.st_size : 0;
+}
+
+void File::close() {
+    if (!impl) return;
+    if (impl->fp) fclose(impl->fp);
+    impl->fp = nullptr;
+    impl->directory = false;
+}
+
+const char* File::name() const {
+    if (!impl) return "";
+    size_t slash = impl->path.rfind('/');
+    return impl->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+const char* File::path() const {
+    return impl ? impl->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+    return impl && impl->directory;
+}
+
+File File::openNextFile(const char* mode) {
+    if (!impl || !impl->directory || impl->nextEntry >= impl->entries.size()) return File();
+    std::string child = impl->path;
+    if (child.empty() || child.back() != '/') child += '/';
+    child += impl->entries[impl->nextEntry++];
+    return impl->fs->open(child.c_str(), mode);
+}
+
+void File::rewindDirectory() {
+    if (impl) impl->nextEntry = 0;
+}
+
+// ---- FS ----
+
+std::string fs::FS::hostPath(const char* path) const {
+    std::string p = path ? path : "";
+    if (p.empty() || p[0] != '/') p = "/" + p;
+    return root + p;
+}
+
+File fs::FS::open(const char* path, const char* mode, bool create) {
+    if (root.empty()) return File();
+    auto impl = std::make_shared<SimFileImpl>();
+    impl->path = path;
+    impl->hostPath = hostPath(path);
+    impl->fs = this;
+
+    struct stat st;
+    if (stat(impl->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        DIR* dir = opendir(impl->hostPath.c_str());
+        if (!dir) return File();
+        while (dirent* entry = readdir(dir)) {
+            if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..")) impl->entries.push_back(entry->d_name);
+        }
+        closedir(dir);
+        std::sort(impl->entries.begin(), impl->entries.end());
+        impl->directory = true;
+        return File(impl);
+    }
+
+    if (create && mode[0] != 'r') {
+        std::string parent = impl->hostPath.substr(0, impl->hostPath.rfind('/'));
+        ::mkdir(parent.c_str(), 0755);
+    }
+    std::string hostMode = mode;
+    hostMode.insert(1, "b");
+    impl->fp = fopen(impl->hostPath.c_str(), hostMode.c_str());
+    if (!impl->fp) return File();
+    return File(impl);
+}
+
+bool fs::FS::exists(const char* path) {
+    struct stat st;
+    return !root.empty() && stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool fs::FS::remove(const char* path) {
+    return !root.empty() && unlink(hostPath(path).c_str()) == 0;
+}
+
+bool fs::FS::rename(const char* from, const char* to) {
+    return !root.empty() && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool fs::FS::mkdir(const char* path) {
+    return !root.empty() && (::mkdir(hostPath(path).c_str(), 0755) == 0 || errno == EEXIST);
+}
+
+bool fs::FS::rmdir(const char* path) {
+    return !root.empty() && ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+// ---- LittleFS ----
+
+bool LittleFSFS::begin(bool formatOnFail, const char*, uint8_t, const char*) {
+    struct stat st;
+    if (stat(simOptions.fsDir, &st) != 0) {
+        if (!formatOnFail || ::mkdir(simOptions.fsDir, 0755) != 0) return false;
+        simLog("LittleFS: formatted %s", simOptions.fsDir);
+    } else if (!S_ISDIR(st.st_mode)) {
+        return false;
+    }
+    char* resolved = realpath(simOptions.fsDir, nullptr);
+    root = resolved;
+    free(resolved);
+    return true;
+}
+
+bool LittleFSFS::format() {
+    if (root.empty()) return false;
+    std::string command = "rm -rf '" + root + "'/*";
+    return system(command.c_str()) == 0;
+}
+
+size_t LittleFSFS::totalBytes() {
+    return LITTLEFS_TOTAL_BYTES;
+}
+
+// 按块向上取整，近似 LittleFS 的占用
+static size_t usedBlocks(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return 0;
+    if (!S_ISDIR(st.st_mode)) return (st.st_size + LITTLEFS_BLOCK_SIZE - 1) / LITTLEFS_BLOCK_SIZE;
+    size_t blocks = 1;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return blocks;
+    while (dirent* entry = readdir(dir)) {
+        if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..")) blocks += usedBlocks(path + "/" + entry->d_name);
+    }
+    closedir(dir);
+    return blocks;
+}
+
+size_t LittleFSFS::usedBytes() {
+    return root.empty() ? 0 : usedBlocks(root) * LITTLEFS_BLOCK_SIZE;
+}
@@ -0,0 +1,191 @@
+// fmt2jpg_cb 替身：libjpeg 编码，按块回调输出（与 esp32-camera 的 JPEG 编码器一样不缓存整张图）
+// jpg2rgb565 替身：libjpeg 按 DCT 缩放解码
+// 传感器 JPEG 输出也由这里编码
+#include <img_converters.h>
+#include <Arduino.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <jpeglib.h>
+#include <vector>
+#include "sim.h"
+
+static const size_t OUT_CHUNK = 1024;
+
+namespace {
+
+struct CallbackDest {
+    jpeg_destination_mgr pub;
+    jpg_out_cb cb;
+    void* arg;
+    size_t index;
+    bool failed;
+    JOCTET buffer[OUT_CHUNK];
+};
+
+struct ErrorManager {
+    jpeg_error_mgr pub;
+    jmp_buf jump;
+};
+
+}  // namespace
+
+static void initDestination(j_compress_ptr cinfo) {
+    CallbackDest* dest = (CallbackDest*)cinfo->dest;
+    dest->pub.next_output_byte = dest->buffer;
+    dest->pub.free_in_buffer = OUT_CHUNK;
+}
+
+static bool emit(CallbackDest* dest, size_t len) {
+    if (dest->failed || len == 0) return !dest->failed;
+    if (dest->cb(dest->arg, dest->index, dest->buffer, len) != len) {
+        dest->failed = true;
+        return false;
+    }
+    dest->index += len;
+    return true;
+}
+
+static boolean emptyOutputBuffer(j_compress_ptr cinfo) {
+    CallbackDest* dest = (CallbackDest*)cinfo->dest;
+    emit(dest, OUT_CHUNK);
+    dest->pub.next_output_byte = dest->buffer;
+    dest->pub.free_in_buffer = OUT_CHUNK;
+    return TRUE;
+}
+
+static void termDestination(j_compress_ptr cinfo) {
+    CallbackDest* dest = (CallbackDest*)cinfo->dest;
+    emit(dest, OUT_CHUNK - dest->pub.free_in_buffer);
+}
+
+static void errorExit(j_common_ptr cinfo) {
+    longjmp(((ErrorManager*)cinfo->err)->jump, 1);
+}
+
+// RGB565（大端）或灰度编码为基线 JPEG
+// @param sensorSampling 亮度 2x1 采样（4:2:2，OV2640 硬件编码器的输出），否则用 libjpeg 默认的 4:2:0
+static bool compress(const uint8_t* src, uint16_t width, uint16_t height, bool gray, int quality,
+                     bool sensorSampling, uint8_t* row, jpg_out_cb cb, void* arg) {
+    jpeg_compress_struct cinfo;
+    ErrorManager err;
+    CallbackDest dest = {};
+
+    cinfo.err = jpeg_std_error(&err.pub);
+    err.pub.error_exit = errorExit;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_compress(&cinfo);
+        return false;
+    }
+    jpeg_create_compress(&cinfo);
+
+    dest.pub.init_destination = initDestination;
+    dest.pub.empty_output_buffer = emptyOutputBuffer;
+    dest.pub.term_destination = termDestination;
+    dest.cb = cb;
+    dest.arg = arg;
+    cinfo.dest = &dest.pub;
+
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = gray ? 1 : 3;
+    cinfo.in_color_space = gray ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, constrain(quality, 1, 100), TRUE);
+    if (sensorSampling && !gray) {
+        cinfo.comp_info[0].h_samp_factor = 2;
+        cinfo.comp_info[0].v_samp_factor = 1;
+    }
+    jpeg_start_compress(&cinfo, TRUE);
+
+    while (cinfo.next_scanline < cinfo.image_height && !dest.failed) {
+        const uint8_t* line = src + (size_t)cinfo.next_scanline * width * (gray ? 1 : 2);
+        JSAMPROW rowPtr = (JSAMPROW)line;
+        if (!gray) {
+            // RGB565 大端 -> RGB888
+            for (int x = 0; x < width; x++) {
+                uint16_t v = (line[x * 2] << 8) | line[x * 2 + 1];
+                row[x * 3] = ((v >> 11) & 0x1F) << 3;
+                row[x * 3 + 1] = ((v >> 5) & 0x3F) << 2;
+                row[x * 3 + 2] = (v & 0x1F) << 3;
+            }
+            rowPtr = row;
+        }
+        jpeg_write_scanlines(&cinfo, &rowPtr, 1);
+    }
+    if (!dest.failed) jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return !dest.failed;
+}
+
+bool fmt2jpg_cb(uint8_t* src, size_t srcLen, uint16_t width, uint16_t height, pixformat_t format,
+                uint8_t quality, jpg_out_cb cb, void* arg) {
+    bool gray = format == PIXFORMAT_GRAYSCALE;
+    if ((!gray && format != PIXFORMAT_RGB565) || srcLen < (size_t)width * height * (gray ? 1 : 2)) {
+        return false;
+    }
+    // 行缓冲计入仿真堆，与设备上的软件编码器一样
+    std::vector<uint8_t> row(gray ? 0 : (size_t)width * 3);
+    return compress(src, width, height, gray, quality, false, row.data(), cb, arg);
+}
+
+namespace {
+
+struct BufferSink {
+    uint8_t* out;
+    size_t capacity;
+    size_t length;
+};
+
+}  // namespace
+
+static size_t bufferSinkWrite(void* arg, size_t index, const void* data, size_t len) {
+    BufferSink* sink = (BufferSink*)arg;
+    if (index + len > sink->capacity) return 0;
+    memcpy(sink->out + index, data, len);
+    sink->length = index + len;
+    return len;
+}
+
+size_t simEncodeSensorJpeg(const uint8_t* rgb565, int width, int height, int quality, uint8_t* out,
+                           size_t capacity) {
+    // 传感器质量 0-63 越低越好，折算为 libjpeg 的 1-100
+    int libQuality = constrain(100 - quality * 3 / 2, 10, 100);
+    std::vector<uint8_t, SimUntrackedAllocator<uint8_t>> row((size_t)width * 3);
+    BufferSink sink = {out, capacity, 0};
+    if (!compress(rgb565, width, height, false, libQuality, true, row.data(), bufferSinkWrite, &sink)) return 0;
+    return sink.length;
+}
+
+bool jpg2rgb565(const uint8_t* src, size_t src_len, uint8_t* out, jpg_scale_t scale) {
+    jpeg_decompress_struct cinfo;
+    ErrorManager err;
+    cinfo.err = jpeg_std_error(&err.pub);
+    err.pub.error_exit = errorExit;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, src, src_len);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1 << scale;
+    jpeg_start_decompress(&cinfo);
+
+    std::vector<uint8_t, SimUntrackedAllocator<uint8_t>> row((size_t)cinfo.output_width * 3);
+    uint8_t* dst = out;
+    while (cinfo.output_scanline < cinfo.output_height) {
+        uint8_t* rowPtr = row.data();
+        jpeg_read_scanlines(&cinfo, &rowPtr, 1);
+        for (uint32_t x = 0; x < cinfo.output_width; x++) {
+            const uint8_t* p = &row[x * 3];
+            uint16_t c = ((p[0] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[2] >> 3);
+            *dst++ = c >> 8;
+            *dst++ = c & 0xFF;
+        }
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
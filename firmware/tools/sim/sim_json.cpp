@@ -0,0 +1,603 @@
+#include <ArduinoJson.h>
+#include <ctype.h>
+
+static const size_t SLOT_SIZE = 16;   // 32 位 ArduinoJson 6 的 VariantSlot
+static const int MAX_NESTING = 10;    // ARDUINOJSON_DEFAULT_NESTING_LIMIT
+
+// ---- 文档 ----
+
+JsonDocument::JsonDocument(size_t capacity) : _capacity(capacity) {
+    _root.doc = this;
+}
+
+void JsonDocument::clear() {
+    _root = JsonNode();
+    _root.doc = this;
+    nodes.clear();
+    copiedKeys.clear();
+    used = 0;
+    _overflowed = false;
+}
+
+bool JsonDocument::charge(size_t bytes) {
+    if (used + bytes > _capacity) {
+        if (!_overflowed) simLog("ArduinoJson: document overflow (capacity %zu, used %zu)", _capacity, used);
+        _overflowed = true;
+        return false;
+    }
+    used += bytes;
+    return true;
+}
+
+JsonNode* JsonDocument::newNode(JsonNode::Type type) {
+    if (!charge(SLOT_SIZE)) return nullptr;
+    nodes.emplace_back();
+    nodes.back().type = type;
+    nodes.back().doc = this;
+    return &nodes.back();
+}
+
+// 键总是复制（替身不依赖调用者字符串的生命周期），只有原库也会复制的键才计入容量
+const char* JsonDocument::saveKey(const char* key, bool copy) {
+    if (copy && !charge(strlen(key) + 1)) return nullptr;
+    copiedKeys.emplace_back(key);
+    return copiedKeys.back().c_str();
+}
+
+static JsonNode* findMember(JsonNode* object, const char* key) {
+    if (!object || object->type != JsonNode::Object) return nullptr;
+    for (size_t i = 0; i < object->keys.size(); i++) {
+        if (strcmp(object->keys[i], key) == 0) return object->children[i];
+    }
+    return nullptr;
+}
+
+// 写入路径：null 节点转为对象，缺少的成员新建
+static JsonNode* getOrAddMember(JsonNode* object, const char* key, bool copyKey = false) {
+    if (!object) return nullptr;
+    if (object->type == JsonNode::Null) object->type = JsonNode::Object;
+    if (object->type != JsonNode::Object) return nullptr;
+    JsonNode* member = findMember(object, key);
+    if (member) return member;
+    JsonNode* node = object->doc->newNode(JsonNode::Null);
+    if (!node) return nullptr;
+    const char* savedKey = object->doc->saveKey(key, copyKey);
+    if (!savedKey) return nullptr;
+    object->keys.push_back(savedKey);
+    object->children.push_back(node);
+    return node;
+}
+
+static JsonNode* addElement(JsonNode* array) {
+    if (!array) return nullptr;
+    if (array->type == JsonNode::Null) array->type = JsonNode::Array;
+    if (array->type != JsonNode::Array) return nullptr;
+    JsonNode* node = array->doc->newNode(JsonNode::Null);
+    if (node) array->children.push_back(node);
+    return node;
+}
+
+JsonVariant JsonDocument::operator[](const char* key) {
+    return JsonVariant(getOrAddMember(&_root, key));
+}
+
+JsonVariant JsonDocument::operator[](const String& key) {
+    return JsonVariant(getOrAddMember(&_root, key.c_str(), true));
+}
+
+JsonObject JsonDocument::createNestedObject(const char* key) {
+    return JsonObject(&_root).createNestedObject(key);
+}
+
+JsonArray JsonDocument::createNestedArray(const char* key) {
+    return JsonObject(&_root).createNestedArray(key);
+}
+
+// ---- 值 ----
+
+static void resetValue(JsonNode* node, JsonNode::Type type) {
+    node->type = type;
+    node->str.clear();
+    node->keys.clear();
+    node->children.clear();
+}
+
+void JsonVariant::set(bool value) {
+    if (!node) return;
+    resetValue(node, JsonNode::Bool);
+    node->b = value;
+}
+
+void JsonVariant::setSigned(long long value) {
+    if (!node) return;
+    if (value >= 0) {
+        setUnsigned(value);
+        return;
+    }
+    resetValue(node, JsonNode::Int);
+    node->i = value;
+}
+
+void JsonVariant::setUnsigned(unsigned long long value) {
+    if (!node) return;
+    resetValue(node, JsonNode::UInt);
+    node->u = value;
+}
+
+void JsonVariant::set(float value) {
+    set((double)value);
+}
+
+void JsonVariant::set(double value) {
+    if (!node) return;
+    resetValue(node, JsonNode::Double);
+    node->f = value;
+}
+
+void JsonVariant::setString(const char* value, bool copy) {
+    if (!node) return;
+    if (!value) {
+        resetValue(node, JsonNode::Null);
+        return;
+    }
+    if (copy && !node->doc->charge(strlen(value) + 1)) {
+        resetValue(node, JsonNode::Null);
+        return;
+    }
+    resetValue(node, JsonNode::Str);
+    node->str = value;
+}
+
+JsonVariant JsonVariant::operator[](const char* key) const {
+    return JsonVariant(findMember(node, key));
+}
+
+JsonVariant JsonVariant::operator[](size_t index) const {
+    return JsonArray(node)[index];
+}
+
+JsonVariant::operator JsonObject() const {
+    return JsonObject(node && node->type == JsonNode::Object ? node : nullptr);
+}
+
+JsonVariant::operator JsonArray() const {
+    return JsonArray(node && node->type == JsonNode::Array ? node : nullptr);
+}
+
+bool JsonVariant::isNumber() const {
+    return node && (node->type == JsonNode::Int || node->type == JsonNode::UInt || node->type == JsonNode::Double);
+}
+
+double JsonVariant::numberOr(double fallback) const {
+    if (!isNumber()) return fallback;
+    switch (node->type) {
+    case JsonNode::Int: return (double)node->i;
+    case JsonNode::UInt: return (double)node->u;
+    default: return node->f;
+    }
+}
+
+const char* JsonVariant::operator|(const char* fallback) const {
+    return node && node->type == JsonNode::Str ? node->str.c_str() : fallback;
+}
+
+bool JsonVariant::operator|(bool fallback) const {
+    return node && node->type == JsonNode::Bool ? node->b : fallback;
+}
+
+template <>
+const char* JsonVariant::as<const char*>() const {
+    return *this | (const char*)nullptr;
+}
+
+template <>
+String JsonVariant::as<String>() const {
+    return String(*this | "");
+}
+
+template <>
+bool JsonVariant::as<bool>() const {
+    if (node && node->type == JsonNode::Bool) return node->b;
+    return numberOr(0) != 0;
+}
+
+template <>
+int JsonVariant::as<int>() const {
+    return (int)numberOr(0);
+}
+
+template <>
+long JsonVariant::as<long>() const {
+    return (long)numberOr(0);
+}
+
+template <>
+unsigned int JsonVariant::as<unsigned int>() const {
+    return (unsigned int)numberOr(0);
+}
+
+template <>
+unsigned long JsonVariant::as<unsigned long>() const {
+    return (unsigned long)numberOr(0);
+}
+
+template <>
+float JsonVariant::as<float>() const {
+    return (float)numberOr(0);
+}
+
+template <>
+double JsonVariant::as<double>() const {
+    return numberOr(0);
+}
+
+template <>
+JsonObject JsonVariant::as<JsonObject>() const {
+    return *this;
+}
+
+template <>
+JsonArray JsonVariant::as<JsonArray>() const {
+    return *this;
+}
+
+// ---- 对象与数组 ----
+
+bool JsonObject::containsKey(const char* key) const {
+    return findMember(node, key) != nullptr;
+}
+
+JsonVariant JsonObject::operator[](const char* key) const {
+    return JsonVariant(getOrAddMember(node, key));
+}
+
+JsonObject JsonObject::createNestedObject(const char* key) const {
+    JsonNode* member = getOrAddMember(node, key);
+    if (!member) return JsonObject();
+    resetValue(member, JsonNode::Object);
+    return JsonObject(member);
+}
+
+JsonArray JsonObject::createNestedArray(const char* key) const {
+    JsonNode* member = getOrAddMember(node, key);
+    if (!member) return JsonArray();
+    resetValue(member, JsonNode::Array);
+    return JsonArray(member);
+}
+
+JsonNode* JsonArray::append() const {
+    return addElement(node);
+}
+
+JsonObject JsonArray::createNestedObject() const {
+    JsonNode* item = append();
+    if (!item) return JsonObject();
+    item->type = JsonNode::Object;
+    return JsonObject(item);
+}
+
+JsonArray JsonArray::createNestedArray() const {
+    JsonNode* item = append();
+    if (!item) return JsonArray();
+    item->type = JsonNode::Array;
+    return JsonArray(item);
+}
+
+JsonVariant JsonArray::operator[](size_t index) const {
+    return JsonVariant(index < size() ? node->children[index] : nullptr);
+}
+
+// ---- 序列化 ----
+
+static void writeString(std::string& out, const char* s) {
+    out += '"';
+    for (; *s; s++) {
+        switch (*s) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default: out += *s;
+        }
+    }
+    out += '"';
+}
+
+// 与原库一致：最多 9 位小数，去掉末尾的 0，绝对值很大或很小时用指数形式
+static void writeDouble(std::string& out, double value) {
+    if (isnan(value) || isinf(value)) {
+        out += "null";
+        return;
+    }
+    char buf[40];
+    double magnitude = fabs(value);
+    if (magnitude >= 1e7 || (magnitude > 0 && magnitude < 1e-5)) {
+        snprintf(buf, sizeof(buf), "%.9e", value);
+        std::string s(buf);
+        size_t e = s.find('e');
+        std::string mantissa = s.substr(0, e);
+        mantissa.erase(mantissa.find_last_not_of('0') + 1);
+        if (mantissa.back() == '.') mantissa.pop_back();
+        out += mantissa + 'e' + std::to_string(atoi(s.c_str() + e + 1));
+        return;
+    }
+    snprintf(buf, sizeof(buf), "%.9f", value);
+    std::string s(buf);
+    s.erase(s.find_last_not_of('0') + 1);
+    if (s.back() == '.') s.pop_back();
+    out += s;
+}
+
+static void writeNode(std::string& out, const JsonNode* node) {
+    switch (node->type) {
+    case JsonNode::Null: out += "null"; break;
+    case JsonNode::Bool: out += node->b ? "true" : "false"; break;
+    case JsonNode::Int: out += std::to_string(node->i); break;
+    case JsonNode::UInt: out += std::to_string(node->u); break;
+    case JsonNode::Double: writeDouble(out, node->f); break;
+    case JsonNode::Str: writeString(out, node->str.c_str()); break;
+    case JsonNode::Array:
+        out += '[';
+        for (size_t i = 0; i < node->children.size(); i++) {
+            if (i) out += ',';
+            writeNode(out, node->children[i]);
+        }
+        out += ']';
+        break;
+    case JsonNode::Object:
+        out += '{';
+        for (size_t i = 0; i < node->children.size(); i++) {
+            if (i) out += ',';
+            writeString(out, node->keys[i]);
+            out += ':';
+            writeNode(out, node->children[i]);
+        }
+        out += '}';
+        break;
+    }
+}
+
+static std::string serialize(JsonDocument& doc) {
+    std::string out;
+    writeNode(out, doc.root());
+    return out;
+}
+
+size_t serializeJson(JsonDocument& doc, String& output) {
+    std::string json = serialize(doc);
+    output = String(json);
+    return json.size();
+}
+
+size_t serializeJson(JsonDocument& doc, Print& output) {
+    std::string json = serialize(doc);
+    return output.write((const uint8_t*)json.data(), json.size());
+}
+
+size_t serializeJson(JsonDocument& doc, char* output, size_t size) {
+    std::string json = serialize(doc);
+    if (!size) return 0;
+    size_t n = min(json.size(), size - 1);
+    memcpy(output, json.data(), n);
+    output[n] = 0;
+    return n;
+}
+
+size_t measureJson(JsonDocument& doc) {
+    return serialize(doc).size();
+}
+
+// ---- 反序列化 ----
+
+namespace {
+
+class Parser {
+public:
+    Parser(JsonDocument& doc, const char* p, const char* end) : doc(doc), p(p), end(end) {}
+
+    DeserializationError parse() {
+        doc.clear();
+        skipSpace();
+        if (p >= end) return DeserializationError::EmptyInput;
+        return parseValue(doc.root(), 0);
+    }
+
+private:
+    JsonDocument& doc;
+    const char* p;
+    const char* end;
+
+    void skipSpace() {
+        while (p < end && isspace((unsigned char)*p)) p++;
+    }
+
+    DeserializationError parseValue(JsonNode* node, int depth) {
+        skipSpace();
+        if (p >= end) return DeserializationError::IncompleteInput;
+        if (*p == '{' || *p == '[') {
+            if (depth >= MAX_NESTING) return DeserializationError::TooDeep;
+            return *p == '{' ? parseObject(node, depth + 1) : parseArray(node, depth + 1);
+        }
+        if (*p == '"') {
+            std::string s;
+            DeserializationError err = parseString(s);
+            if (err) return err;
+            if (!doc.charge(s.size() + 1)) return DeserializationError::NoMemory;
+            node->type = JsonNode::Str;
+            node->str = s.c_str();
+            return DeserializationError::Ok;
+        }
+        if (matchWord("true")) {
+            node->type = JsonNode::Bool;
+            node->b = true;
+            return DeserializationError::Ok;
+        }
+        if (matchWord("false")) {
+            node->type = JsonNode::Bool;
+            node->b = false;
+            return DeserializationError::Ok;
+        }
+        if (matchWord("null")) {
+            node->type = JsonNode::Null;
+            return DeserializationError::Ok;
+        }
+        return parseNumber(node);
+    }
+
+    bool matchWord(const char* word) {
+        size_t n = strlen(word);
+        if ((size_t)(end - p) < n || strncmp(p, word, n) != 0) return false;
+        p += n;
+        return true;
+    }
+
+    DeserializationError parseNumber(JsonNode* node) {
+        const char* start = p;
+        bool isFloat = false;
+        if (p < end && (*p == '-' || *p == '+')) p++;
+        while (p < end && (isdigit((unsigned char)*p) || *p == '.' || *p == 'e' || *p == 'E' ||
+                           ((*p == '-' || *p == '+') && (p[-1] == 'e' || p[-1] == 'E')))) {
+            if (!isdigit((unsigned char)*p)) isFloat = true;
+            p++;
+        }
+        if (p == start || (p == start + 1 && !isdigit((unsigned char)*start))) {
+            return DeserializationError::InvalidInput;
+        }
+        std::string text(start, p);
+        if (isFloat) {
+            node->type = JsonNode::Double;
+            node->f = strtod(text.c_str(), nullptr);
+        } else if (text[0] == '-') {
+            node->type = JsonNode::Int;
+            node->i = strtoll(text.c_str(), nullptr, 10);
+        } else {
+            node->type = JsonNode::UInt;
+            node->u = strtoull(text.c_str(), nullptr, 10);
+        }
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError parseString(std::string& out) {
+        p++;  // 开头的引号
+        while (p < end && *p != '"') {
+            if (*p != '\\') {
+                out += *p++;
+                continue;
+            }
+            if (++p >= end) return DeserializationError::IncompleteInput;
+            switch (*p) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                if (end - p < 5) return DeserializationError::IncompleteInput;
+                unsigned code = strtoul(std::string(p + 1, p + 5).c_str(), nullptr, 16);
+                // 只处理基本多文种平面，按 UTF-8 编码
+                if (code < 0x80) {
+                    out += (char)code;
+                } else if (code < 0x800) {
+                    out += (char)(0xC0 | (code >> 6));
+                    out += (char)(0x80 | (code & 0x3F));
+                } else {
+                    out += (char)(0xE0 | (code >> 12));
+                    out += (char)(0x80 | ((code >> 6) & 0x3F));
+                    out += (char)(0x80 | (code & 0x3F));
+                }
+                p += 4;
+                break;
+            }
+            default: out += *p;
+            }
+            p++;
+        }
+        if (p >= end) return DeserializationError::IncompleteInput;
+        p++;  // 结尾的引号
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError parseObject(JsonNode* node, int depth) {
+        p++;
+        node->type = JsonNode::Object;
+        skipSpace();
+        if (p < end && *p == '}') {
+            p++;
+            return DeserializationError::Ok;
+        }
+        while (true) {
+            skipSpace();
+            if (p >= end) return DeserializationError::IncompleteInput;
+            if (*p != '"') return DeserializationError::InvalidInput;
+            std::string key;
+            DeserializationError err = parseString(key);
+            if (err) return err;
+            skipSpace();
+            if (p >= end) return DeserializationError::IncompleteInput;
+            if (*p++ != ':') return DeserializationError::InvalidInput;
+            JsonNode* member = getOrAddMember(node, key.c_str(), true);
+            if (!member) return DeserializationError::NoMemory;
+            err = parseValue(member, depth);
+            if (err) return err;
+            skipSpace();
+            if (p >= end) return DeserializationError::IncompleteInput;
+            if (*p == '}') {
+                p++;
+                return DeserializationError::Ok;
+            }
+            if (*p++ != ',') return DeserializationError::InvalidInput;
+        }
+    }
+
+    DeserializationError parseArray(JsonNode* node, int depth) {
+        p++;
+        node->type = JsonNode::Array;
+        skipSpace();
+        if (p < end && *p == ']') {
+            p++;
+            return DeserializationError::Ok;
+        }
+        while (true) {
+            JsonNode* item = addElement(node);
+            if (!item) return DeserializationError::NoMemory;
+            DeserializationError err = parseValue(item, depth);
+            if (err) return err;
+            skipSpace();
+            if (p >= end) return DeserializationError::IncompleteInput;
+            if (*p == ']') {
+                p++;
+                return DeserializationError::Ok;
+            }
+            if (*p++ != ',') return DeserializationError::InvalidInput;
+        }
+    }
+};
+
+}  // namespace
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length) {
+    return Parser(doc, input, input + length).parse();
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input) {
+    return deserializeJson(doc, input, input ? strlen(input) : 0);
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, const String& input) {
+    return deserializeJson(doc, input.c_str(), input.length());
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, Stream& input) {
+    std::string text;
+    int c;
+    while ((c = input.read()) >= 0) text += (char)c;
+    return deserializeJson(doc, text.data(), text.size());
+}
+
+const char* DeserializationError::c_str() const {
+    static const char* const NAMES[] = {"Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "TooDeep"};
+    return NAMES[_code];
+}
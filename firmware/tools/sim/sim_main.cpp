@@ -0,0 +1,82 @@
+// 整机仿真入口：解析参数后像 arduino-esp32 的 loopTask 一样执行 setup() 和 loop()
+//
+// 用法: firmware_sim [选项]
+//   --fs-dir DIR          LittleFS 映射的主机目录（默认 sim_fs，重启后保留）
+//   --events-image FILE   events 分区的镜像文件（默认 <fs-dir>.events.bin，重启后保留）
+//   --recording FILE      用 .mcfr 录制代替合成画面
+//   --port-offset N       特权端口的偏移（默认 8000：HTTP 8080、RTSP 8554、DNS 8053）
+//   --sensor-fps N        20 MHz XCLK 下的传感器帧率（默认 15）
+//   --scan-ms N           WiFi 扫描阻塞时长（默认 1500）
+//   --connect-ms N        STA 连接耗时（默认 800）
+//   --wifi-fail           STA 连接总是失败（停留在配网模式）
+//   --heap-kb N           内部堆大小（默认 512）
+//   --psram-kb N          PSRAM 大小（默认 8192）
+//   --max-connections N   同时打开的 TCP 连接上限（默认 16）
+//   --link-kbps N         HTTP 连接共享的带宽上限（默认不限）
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <string>
+#include "config.h"
+#include "sim.h"
+
+static const uint32_t EVENTS_PARTITION_BYTES = 0x60000;   // partitions.csv 的 events 分区
+
+void setup();
+void loop();
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [--fs-dir DIR] [--events-image FILE] [--recording FILE] [--port-offset N]\n"
+            "          [--sensor-fps N] [--scan-ms N] [--connect-ms N] [--wifi-fail] [--heap-kb N]\n"
+            "          [--psram-kb N] [--max-connections N] [--link-kbps N]\n",
+            prog);
+}
+
+static bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--wifi-fail") == 0) {
+            simOptions.wifiFail = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const char* value = argv[++i];
+        unsigned long n = strtoul(value, nullptr, 10);
+        if (strcmp(arg, "--fs-dir") == 0) simOptions.fsDir = value;
+        else if (strcmp(arg, "--events-image") == 0) simOptions.eventsImage = value;
+        else if (strcmp(arg, "--recording") == 0) simOptions.recording = value;
+        else if (strcmp(arg, "--port-offset") == 0) simOptions.portOffset = n;
+        else if (strcmp(arg, "--sensor-fps") == 0 && n > 0) simOptions.sensorFps = n;
+        else if (strcmp(arg, "--scan-ms") == 0) simOptions.scanMs = n;
+        else if (strcmp(arg, "--connect-ms") == 0) simOptions.connectMs = n;
+        else if (strcmp(arg, "--heap-kb") == 0 && n > 0) simOptions.heapSize = n * 1024;
+        else if (strcmp(arg, "--psram-kb") == 0) simOptions.psramSize = n * 1024;
+        else if (strcmp(arg, "--max-connections") == 0 && n > 0 && n <= 255) simOptions.maxConnections = n;
+        else if (strcmp(arg, "--link-kbps") == 0) simOptions.linkKbps = n;
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseArgs(argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    std::string eventsImage = simOptions.eventsImage ? simOptions.eventsImage
+                                                     : std::string(simOptions.fsDir) + ".events.bin";
+    if (!hostPartitionAdd(EVENT_PARTITION_LABEL, (esp_partition_subtype_t)EVENT_PARTITION_SUBTYPE,
+                          EVENTS_PARTITION_BYTES, eventsImage.c_str())) {
+        fprintf(stderr, "Cannot open partition image %s\n", eventsImage.c_str());
+        return 1;
+    }
+    simSetArgs(argc, argv);
+    simAdoptCurrentThread("loopTask");
+    simNameThread("loopTask");
+
+    setup();
+    while (true) {
+        loop();
+    }
+}
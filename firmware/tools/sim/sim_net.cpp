@@ -0,0 +1,62 @@
+#include <AsyncUDP.h>
+#include <ESPmDNS.h>
+#include "sim.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+MDNSResponder MDNS;
+
+bool MDNSResponder::begin(const char* hostName) {
+    simLog("mDNS: %s.local (not announced in simulation)", hostName);
+    return true;
+}
+
+bool MDNSResponder::addService(const char* service, const char* proto, uint16_t port) {
+    simLog("mDNS: _%s._%s port %u", service, proto, port);
+    return true;
+}
+
+size_t AsyncUDPPacket::write(const uint8_t* data, size_t len) {
+    ssize_t n = sendto(fd, data, len, 0, (const sockaddr*)&from, sizeof(from));
+    return n < 0 ? 0 : n;
+}
+
+bool AsyncUDP::listen(uint16_t port) {
+    close();
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    running = true;
+    receiver = std::thread([this]() {
+        simNameThread("udp_rx");
+        uint8_t buffer[1500];
+        while (running) {
+            pollfd p = {fd, POLLIN, 0};
+            if (poll(&p, 1, 100) <= 0) continue;
+            sockaddr_in from;
+            socklen_t fromLen = sizeof(from);
+            ssize_t n = recvfrom(fd, buffer, sizeof(buffer), 0, (sockaddr*)&from, &fromLen);
+            if (n <= 0 || !handler) continue;
+            AsyncUDPPacket packet(fd, from, buffer, n);
+            handler(packet);
+        }
+    });
+    return true;
+}
+
+void AsyncUDP::close() {
+    if (!running) return;
+    running = false;
+    receiver.join();
+    ::close(fd);
+    fd = -1;
+}
@@ -0,0 +1,504 @@
+// Arduino/ESP-IDF 运行时替身：时间、串口、堆统计、看门狗、特权端口映射、重启
+#include "Arduino.h"
+#include "sim.h"
+#include <arpa/inet.h>
+#include <malloc.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+SimOptions simOptions;
+HardwareSerial Serial;
+EspClass ESP;
+
+static const auto startTime = std::chrono::steady_clock::now();
+static std::mutex outputMutex;
+static std::vector<char*> restartArgs;
+
+// ---- 时间 ----
+
+int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long millis() {
+    return (unsigned long)(uint32_t)(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)(uint32_t)esp_timer_get_time();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char*, const char*) {
+    simLog("configTime: GMT%+ld, NTP %s (host clock used)", gmtOffsetSec / 3600, server1);
+    (void)daylightOffsetSec;
+}
+
+uint32_t esp_random() {
+    static std::mutex mutex;
+    static std::mt19937 rng(std::random_device{}());
+    std::lock_guard<std::mutex> lock(mutex);
+    return rng();
+}
+
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+const char* esp_err_to_name(esp_err_t err) {
+    switch (err) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    default: return "UNKNOWN_ERROR";
+    }
+}
+
+// ---- 日志与进程控制 ----
+
+void simLog(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    std::lock_guard<std::mutex> lock(outputMutex);
+    fprintf(stdout, "[SIM] %s\n", buffer);
+    fflush(stdout);
+}
+
+void simFatal(const char* message) {
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        fprintf(stderr, "[SIM] FATAL (%s): %s\n", pcTaskGetName(nullptr), message);
+    }
+    abort();
+}
+
+void simNameThread(const char* name) {
+    char shortName[16];
+    strlcpy(shortName, name, sizeof(shortName));
+    pthread_setname_np(pthread_self(), shortName);
+}
+
+void simSetArgs(int argc, char** argv) {
+    restartArgs.assign(argv, argv + argc);
+    restartArgs.push_back(nullptr);
+}
+
+void EspClass::restart() {
+    simLog("ESP.restart(): re-executing firmware");
+    fflush(stdout);
+    // 监听套接字随 exec 关闭（FD_CLOEXEC 之外的也一并关闭），端口可立即重新绑定
+    for (int fd = 3; fd < 1024; fd++) close(fd);
+    execv("/proc/self/exe", restartArgs.data());
+    simFatal("restart failed");
+}
+
+// ---- 串口 ----
+
+size_t Print::write(const uint8_t* data, size_t len) {
+    size_t n = 0;
+    while (n < len && write(data[n])) n++;
+    return n;
+}
+
+size_t Print::println(const char* str) {
+    size_t n = write(str);
+    return n + write("\n");
+}
+
+size_t Print::printf(const char* format, ...) {
+    char stackBuffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    if ((size_t)len < sizeof(stackBuffer)) return write((const uint8_t*)stackBuffer, len);
+
+    std::vector<char> buffer(len + 1);
+    va_start(args, format);
+    vsnprintf(buffer.data(), buffer.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)buffer.data(), len);
+}
+
+size_t Stream::readBytes(uint8_t* buffer, size_t len) {
+    size_t n = 0;
+    while (n < len) {
+        int c = read();
+        if (c < 0) break;
+        buffer[n++] = (uint8_t)c;
+    }
+    return n;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    size_t n = fwrite(data, 1, len, stdout);
+    fflush(stdout);
+    return n;
+}
+
+// ---- String ----
+
+String::String(double v, unsigned int decimals) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, v);
+    s = buffer;
+}
+
+String String::substring(size_t from, size_t to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= s.size()) return String();
+    return String(s.substr(from, min(to, s.size()) - from));
+}
+
+int String::indexOf(char c, size_t from) const {
+    size_t pos = s.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const char* str, size_t from) const {
+    size_t pos = s.find(str, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+}
+
+void String::replace(const String& from, const String& to) {
+    if (from.s.empty()) return;
+    size_t pos = 0;
+    while ((pos = s.find(from.s, pos)) != std::string::npos) {
+        s.replace(pos, from.s.size(), to.s);
+        pos += to.s.size();
+    }
+}
+
+void String::toLowerCase() {
+    for (char& c : s) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : s) c = toupper((unsigned char)c);
+}
+
+void String::trim() {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    size_t end = s.find_last_not_of(" \t\r\n");
+    s = begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+}
+
+// ---- 堆 ----
+// 链接时用 --wrap 接管 malloc 系列，operator new/delete 也转到这里，统计固件和替身的全部堆分配
+// MALLOC_CAP_SPIRAM / ps_malloc 的分配另外登记，计入 PSRAM 而不是内部堆
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+}
+
+static std::atomic<size_t> heapUsed(0);    // 全部分配（含 PSRAM）
+static std::atomic<size_t> psramUsed(0);
+static std::atomic<size_t> internalPeak(0);
+static std::atomic<size_t> psramPeak(0);
+static std::mutex psramMutex;
+// 登记表本身不走 __wrap_malloc，否则在持锁时增删节点会重入 untrackPsram
+typedef std::unordered_map<void*, size_t, std::hash<void*>, std::equal_to<void*>,
+                           SimUntrackedAllocator<std::pair<void* const, size_t>>> PsramBlockMap;
+static PsramBlockMap* psramBlocks = nullptr;
+
+static void updatePeak(std::atomic<size_t>& peak, size_t value) {
+    size_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+static void trackAlloc(void* ptr) {
+    if (!ptr) return;
+    size_t used = heapUsed.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed) + malloc_usable_size(ptr);
+    updatePeak(internalPeak, used - psramUsed.load(std::memory_order_relaxed));
+}
+
+// @return 该块是否登记为 PSRAM（已从登记中移除）
+static bool untrackPsram(void* ptr) {
+    if (psramUsed.load(std::memory_order_relaxed) == 0) return false;
+    std::lock_guard<std::mutex> lock(psramMutex);
+    auto it = psramBlocks->find(ptr);
+    if (it == psramBlocks->end()) return false;
+    psramUsed -= it->second;
+    psramBlocks->erase(it);
+    return true;
+}
+
+static void trackFree(void* ptr) {
+    if (!ptr) return;
+    untrackPsram(ptr);
+    heapUsed.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+}
+
+extern "C" {
+void* __wrap_malloc(size_t size) {
+    void* ptr = __real_malloc(size);
+    trackAlloc(ptr);
+    return ptr;
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    void* ptr = __real_calloc(n, size);
+    trackAlloc(ptr);
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    if (ptr) heapUsed.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+    void* result = __real_realloc(ptr, size);
+    if (!result && ptr) {
+        heapUsed.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+        return nullptr;
+    }
+    trackAlloc(result);
+    return result;
+}
+
+void __wrap_free(void* ptr) {
+    trackFree(ptr);
+    __real_free(ptr);
+}
+}
+
+void* operator new(size_t size) {
+    void* ptr = __wrap_malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return __wrap_malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return __wrap_malloc(size ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept { __wrap_free(ptr); }
+void operator delete[](void* ptr) noexcept { __wrap_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { __wrap_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { __wrap_free(ptr); }
+
+static void* psramAlloc(size_t size, bool zero) {
+    void* ptr = zero ? __real_calloc(1, size) : __real_malloc(size);
+    if (!ptr) return nullptr;
+    size_t usable = malloc_usable_size(ptr);
+    {
+        std::lock_guard<std::mutex> lock(psramMutex);
+        if (psramUsed + usable > simOptions.psramSize) {
+            __real_free(ptr);
+            return nullptr;
+        }
+        if (!psramBlocks) psramBlocks = new (__real_malloc(sizeof(PsramBlockMap))) PsramBlockMap();
+        (*psramBlocks)[ptr] = usable;
+        psramUsed += usable;
+    }
+    heapUsed.fetch_add(usable, std::memory_order_relaxed);
+    updatePeak(psramPeak, psramUsed.load(std::memory_order_relaxed));
+    return ptr;
+}
+
+void* simUntrackedAlloc(size_t size) {
+    void* ptr = __real_malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void simUntrackedFree(void* ptr) {
+    __real_free(ptr);
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? psramAlloc(size, false) : __wrap_malloc(size);
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? psramAlloc(n * size, true) : __wrap_calloc(n, size);
+}
+
+void heap_caps_free(void* ptr) {
+    __wrap_free(ptr);
+}
+
+void* ps_malloc(size_t size) {
+    return psramAlloc(size, false);
+}
+
+SimHeapStats simHeapStats() {
+    SimHeapStats stats;
+    stats.psramUsed = psramUsed.load();
+    stats.internalUsed = heapUsed.load() - stats.psramUsed;
+    stats.internalPeak = internalPeak.load();
+    stats.psramPeak = psramPeak.load();
+    return stats;
+}
+
+static uint32_t remaining(size_t size, size_t used) {
+    return used >= size ? 0 : (uint32_t)(size - used);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    SimHeapStats stats = simHeapStats();
+    if (caps & MALLOC_CAP_SPIRAM) return remaining(simOptions.psramSize, stats.psramUsed);
+    return remaining(simOptions.heapSize, stats.internalUsed);
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    SimHeapStats stats = simHeapStats();
+    if (caps & MALLOC_CAP_SPIRAM) return remaining(simOptions.psramSize, stats.psramPeak);
+    return remaining(simOptions.heapSize, stats.internalPeak);
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+uint32_t EspClass::getFreeHeap() { return heap_caps_get_free_size(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getMinFreeHeap() { return heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getMaxAllocHeap() { return heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getHeapSize() { return simOptions.heapSize; }
+uint32_t EspClass::getFreePsram() { return heap_caps_get_free_size(MALLOC_CAP_SPIRAM); }
+uint32_t EspClass::getMinFreePsram() { return heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM); }
+uint32_t EspClass::getPsramSize() { return simOptions.psramSize; }
+
+// ---- 特权端口映射 ----
+// 固件按设备端口绑定（HTTP 80、RTSP 554、DNS 53），主机上加偏移后绑定
+
+extern "C" int __real_bind(int fd, const struct sockaddr* addr, socklen_t len);
+
+extern "C" int __wrap_bind(int fd, const struct sockaddr* addr, socklen_t len) {
+    if (addr->sa_family != AF_INET || len < sizeof(sockaddr_in)) return __real_bind(fd, addr, len);
+
+    sockaddr_in mapped = *(const sockaddr_in*)addr;
+    uint16_t port = ntohs(mapped.sin_port);
+    if (port > 0 && port < 1024) {
+        mapped.sin_port = htons(port + simOptions.portOffset);
+        simLog("port %u -> %u", port, port + simOptions.portOffset);
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    return __real_bind(fd, (const sockaddr*)&mapped, sizeof(mapped));
+}
+
+// ---- 任务看门狗 ----
+
+struct WdtEntry {
+    TaskHandle_t task;
+    uint32_t lastFeedMs;
+    bool reported;
+};
+
+static std::mutex wdtMutex;
+static std::vector<WdtEntry> wdtTasks;
+static uint32_t wdtTimeoutMs = 5000;
+static bool wdtPanic = false;
+static bool wdtStarted = false;
+
+static void wdtMonitor() {
+    simNameThread("task_wdt");
+    while (true) {
+        delay(250);
+        std::lock_guard<std::mutex> lock(wdtMutex);
+        uint32_t now = millis();
+        for (WdtEntry& e : wdtTasks) {
+            if (now - e.lastFeedMs < wdtTimeoutMs || e.reported) continue;
+            e.reported = true;
+            simLog("Task watchdog got triggered: '%s' not fed for %u ms", pcTaskGetName(e.task),
+                   (unsigned)(now - e.lastFeedMs));
+            if (wdtPanic) simFatal("task watchdog");
+        }
+    }
+}
+
+esp_err_t esp_task_wdt_init(uint32_t timeoutSec, bool panic) {
+    std::lock_guard<std::mutex> lock(wdtMutex);
+    wdtTimeoutMs = timeoutSec * 1000;
+    wdtPanic = panic;
+    if (!wdtStarted) {
+        wdtStarted = true;
+        std::thread(wdtMonitor).detach();
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_add(void* task) {
+    TaskHandle_t handle = task ? (TaskHandle_t)task : xTaskGetCurrentTaskHandle();
+    std::lock_guard<std::mutex> lock(wdtMutex);
+    wdtTasks.push_back({handle, (uint32_t)millis(), false});
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_delete(void* task) {
+    TaskHandle_t handle = task ? (TaskHandle_t)task : xTaskGetCurrentTaskHandle();
+    std::lock_guard<std::mutex> lock(wdtMutex);
+    for (size_t i = 0; i < wdtTasks.size(); i++) {
+        if (wdtTasks[i].task == handle) {
+            wdtTasks.erase(wdtTasks.begin() + i);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_task_wdt_reset() {
+    TaskHandle_t handle = xTaskGetCurrentTaskHandle();
+    std::lock_guard<std::mutex> lock(wdtMutex);
+    for (WdtEntry& e : wdtTasks) {
+        if (e.task == handle) {
+            e.lastFeedMs = millis();
+            e.reported = false;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
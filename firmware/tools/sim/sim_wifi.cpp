@@ -0,0 +1,99 @@
+#include <WiFi.h>
+#include "sim.h"
+#include <thread>
+
+WiFiClass WiFi;
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buf);
+}
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+    _mode = mode;
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+    _ssid = ssid ? ssid : "";
+    _password = password ? password : "";
+    if (_status == WL_CONNECTED) fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    _status = WL_DISCONNECTED;
+    connectLater();
+    return _status;
+}
+
+bool WiFiClass::reconnect() {
+    if (_ssid.isEmpty()) return false;
+    _status = WL_DISCONNECTED;
+    connectLater();
+    return true;
+}
+
+bool WiFiClass::disconnect() {
+    bool wasConnected = _status == WL_CONNECTED;
+    attempt++;
+    _status = WL_DISCONNECTED;
+    if (wasConnected) fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    return true;
+}
+
+// 只有最后一次 begin/reconnect 的结果生效
+void WiFiClass::connectLater() {
+    uint32_t current = ++attempt;
+    std::thread([this, current]() {
+        simNameThread("sys_evt");
+        delay(simOptions.connectMs);
+        if (current != attempt) return;
+        if (simOptions.wifiFail || _ssid.isEmpty()) {
+            _status = WL_CONNECT_FAILED;
+            fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+            return;
+        }
+        simLog("WiFi: connected to \"%s\"", _ssid.c_str());
+        _status = WL_CONNECTED;
+        fire(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+        fire(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    }).detach();
+}
+
+void WiFiClass::fire(arduino_event_id_t event) {
+    arduino_event_info_t info = {};
+    for (auto& cb : callbacks) cb(event, info);
+}
+
+bool WiFiClass::softAP(const char* ssid, const char*) {
+    simLog("WiFi: soft AP \"%s\" started", ssid);
+    return true;
+}
+
+bool WiFiClass::softAPConfig(IPAddress local, IPAddress, IPAddress) {
+    _apIP = local;
+    return true;
+}
+
+int16_t WiFiClass::scanNetworks() {
+    static const ScanResult NETWORKS[] = {
+        {"HomeNet", -48, WIFI_AUTH_WPA2_PSK},
+        {"Office-5F", -61, WIFI_AUTH_WPA_WPA2_PSK},
+        {"CoffeeShop", -70, WIFI_AUTH_OPEN},
+        {"IoT-Lab", -77, WIFI_AUTH_WPA2_PSK},
+        {"Neighbor", -86, WIFI_AUTH_WPA2_PSK},
+    };
+    delay(simOptions.scanMs);
+    scanResults.assign(std::begin(NETWORKS), std::end(NETWORKS));
+    return scanResults.size();
+}
+
+String WiFiClass::SSID(uint8_t i) const {
+    return i < scanResults.size() ? String(scanResults[i].ssid) : String();
+}
+
+int32_t WiFiClass::RSSI(uint8_t i) const {
+    return i < scanResults.size() ? scanResults[i].rssi : 0;
+}
+
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t i) const {
+    return i < scanResults.size() ? scanResults[i].auth : WIFI_AUTH_OPEN;
+}